@@ -11,8 +11,8 @@ namespace CommonUtilities
 		// Default constructor: there is no AABB, both min and max points are the zero vector.
 		AABB3D();
 
-		// Copy constructor.
-		AABB3D(const AABB3D<T>& aAABB3D);
+		AABB3D(const AABB3D<T>& aAABB3D) = default;
+		AABB3D& operator=(const AABB3D<T>& aAABB3D) = default;
 
 		// Constructor taking the positions of the minimum and maximum corners.
 		AABB3D(const Vector3<T>& aMin, const Vector3<T>& aMax);
@@ -36,13 +36,6 @@ namespace CommonUtilities
 		myMaxPoint = { 0, 0, 0 };
 	}
 
-	template<typename T>
-	inline AABB3D<T>::AABB3D(const AABB3D<T>& aAABB3D)
-	{
-		myMinPoint = aAABB3D.myMinPoint;
-		myMaxPoint = aAABB3D.myMaxPoint;
-	}
-
 	template<typename T>
 	inline AABB3D<T>::AABB3D(const Vector3<T>& aMin, const Vector3<T>& aMax)
 	{
@@ -0,0 +1,350 @@
+#include "pch.h"
+#include "Animation.h"
+#include "Maths.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    const float SmallestThreeRange = 0.70710678f;
+
+    uint16_t FloatToHalf(float aValue)
+    {
+        uint32_t bits;
+        memcpy(&bits, &aValue, sizeof(bits));
+
+        const uint32_t sign = (bits >> 16) & 0x8000;
+        const uint32_t floatExponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+        const int exponent = static_cast<int>(floatExponent) - 127 + 15;
+
+        if (floatExponent == 0xff)
+        {
+            return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+        }
+        if (exponent >= 31)
+        {
+            return static_cast<uint16_t>(sign | 0x7c00);
+        }
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+            {
+                return static_cast<uint16_t>(sign);
+            }
+
+            mantissa |= 0x800000;
+            const int shift = 14 - exponent;
+            uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1)
+            {
+                ++half;
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        // A carry out of the mantissa correctly bumps the exponent.
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000)
+        {
+            ++half;
+        }
+        return static_cast<uint16_t>(half);
+    }
+
+    float HalfToFloat(uint16_t aHalf)
+    {
+        const uint32_t sign = static_cast<uint32_t>(aHalf & 0x8000) << 16;
+        const uint32_t exponent = (aHalf >> 10) & 0x1f;
+        const uint32_t mantissa = aHalf & 0x3ff;
+
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            const float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+            return sign ? -value : value;
+        }
+        else if (exponent == 31)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // Drops the largest component (recomputed from the unit length on decode) and stores the other
+    // three in 15 bits each. The index of the dropped component goes in the top bits of the first two.
+    void EncodeRotation(const CU::Quaternion<float>& aRotation, uint16_t* someOutKey)
+    {
+        float components[4] = { aRotation[1], aRotation[2], aRotation[3], aRotation[0] };
+
+        int largest = 0;
+        for (int i = 1; i < 4; ++i)
+        {
+            if (fabsf(components[i]) > fabsf(components[largest]))
+            {
+                largest = i;
+            }
+        }
+
+        const float sign = components[largest] < 0 ? -1.0f : 1.0f;
+        int outIndex = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+
+            const float normalized = CU::Clamp(0.0f, 1.0f, (components[i] * sign / SmallestThreeRange) * 0.5f + 0.5f);
+            someOutKey[outIndex++] = static_cast<uint16_t>(normalized * 32767.0f + 0.5f);
+        }
+
+        someOutKey[0] |= static_cast<uint16_t>((largest & 1) << 15);
+        someOutKey[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+    }
+
+    CU::Quaternion<float> DecodeRotation(const uint16_t* someKey)
+    {
+        const int largest = (someKey[0] >> 15) | ((someKey[1] >> 15) << 1);
+
+        float components[4];
+        float sumSqr = 0;
+        int inIndex = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i == largest)
+            {
+                continue;
+            }
+
+            const float quantized = static_cast<float>(someKey[inIndex++] & 0x7fff) * (1.0f / 32767.0f);
+            components[i] = (quantized * 2.0f - 1.0f) * SmallestThreeRange;
+            sumSqr += components[i] * components[i];
+        }
+        components[largest] = sqrtf(CU::Max(0.0f, 1.0f - sumSqr));
+
+        return CU::Quaternion<float>(components[3], components[0], components[1], components[2]);
+    }
+
+    void AdvanceAndSample(CU::AnimationInstance* someInstances, int aCount, float aDeltaTime)
+    {
+        for (int i = 0; i < aCount; ++i)
+        {
+            CU::AnimationInstance& instance = someInstances[i];
+            if (instance.myClip == nullptr)
+            {
+                continue;
+            }
+
+            const float duration = instance.myClip->GetDuration();
+            instance.myTime += aDeltaTime;
+            if (instance.myIsLooping && duration > 0)
+            {
+                instance.myTime = fmodf(instance.myTime, duration);
+                if (instance.myTime < 0)
+                {
+                    instance.myTime += duration;
+                }
+            }
+            else
+            {
+                instance.myTime = CU::Clamp(0.0f, duration, instance.myTime);
+            }
+
+            instance.myClip->Sample(instance.myTime, instance.myCursor, instance.myPose);
+        }
+    }
+}
+
+void CommonUtilities::AnimationPose::Resize(int aBoneCount)
+{
+    myRotations.resize(aBoneCount, Quaternion<float>(1, 0, 0, 0));
+    myTranslations.resize(aBoneCount);
+}
+
+void CommonUtilities::AnimationCursor::Reset(int aBoneCount)
+{
+    myRotationKeys.assign(aBoneCount, 0);
+    myTranslationKeys.assign(aBoneCount, 0);
+}
+
+CommonUtilities::AnimationClip::AnimationClip(int aBoneCount, float aDuration)
+    : myRotationTracks(aBoneCount), myTranslationTracks(aBoneCount), myBoneCount(aBoneCount), myDuration(aDuration)
+{
+}
+
+void CommonUtilities::AnimationClip::SetRotationTrack(int aBone, const float* someTimes, const Quaternion<float>* someRotations, int aKeyCount)
+{
+    assert(aBone >= 0 && aBone < myBoneCount && "Out of range.");
+    assert(myRotationTracks[aBone].myKeyCount == 0 && "Track already set.");
+
+    TrackRange& track = myRotationTracks[aBone];
+    track.myFirstKey = static_cast<uint32_t>(myRotationTimes.size());
+    track.myKeyCount = static_cast<uint32_t>(aKeyCount);
+
+    myRotationTimes.insert(myRotationTimes.end(), someTimes, someTimes + aKeyCount);
+    myRotationKeys.resize(myRotationKeys.size() + aKeyCount * 3);
+    for (int i = 0; i < aKeyCount; ++i)
+    {
+        assert((i == 0 || someTimes[i - 1] <= someTimes[i]) && "Keys must be sorted by time.");
+        EncodeRotation(someRotations[i].Normalized(), &myRotationKeys[(track.myFirstKey + i) * 3]);
+    }
+}
+
+void CommonUtilities::AnimationClip::SetTranslationTrack(int aBone, const float* someTimes, const Vector3<float>* someTranslations, int aKeyCount)
+{
+    assert(aBone >= 0 && aBone < myBoneCount && "Out of range.");
+    assert(myTranslationTracks[aBone].myKeyCount == 0 && "Track already set.");
+
+    TrackRange& track = myTranslationTracks[aBone];
+    track.myFirstKey = static_cast<uint32_t>(myTranslationTimes.size());
+    track.myKeyCount = static_cast<uint32_t>(aKeyCount);
+
+    myTranslationTimes.insert(myTranslationTimes.end(), someTimes, someTimes + aKeyCount);
+    myTranslationKeys.resize(myTranslationKeys.size() + aKeyCount * 3);
+    for (int i = 0; i < aKeyCount; ++i)
+    {
+        assert((i == 0 || someTimes[i - 1] <= someTimes[i]) && "Keys must be sorted by time.");
+        uint16_t* key = &myTranslationKeys[(track.myFirstKey + i) * 3];
+        key[0] = FloatToHalf(someTranslations[i].x);
+        key[1] = FloatToHalf(someTranslations[i].y);
+        key[2] = FloatToHalf(someTranslations[i].z);
+    }
+}
+
+int CommonUtilities::AnimationClip::GetBoneCount() const
+{
+    return myBoneCount;
+}
+
+float CommonUtilities::AnimationClip::GetDuration() const
+{
+    return myDuration;
+}
+
+uint32_t CommonUtilities::AnimationClip::FindKey(const float* someTimes, uint32_t aKeyCount, uint32_t aCursorKey, float aTime)
+{
+    uint32_t key = aCursorKey < aKeyCount ? aCursorKey : 0;
+
+    if (someTimes[key] > aTime)
+    {
+        // Went backwards (looped or seeked), fall back to a binary search.
+        const float* upper = std::upper_bound(someTimes, someTimes + aKeyCount, aTime);
+        return upper == someTimes ? 0 : static_cast<uint32_t>(upper - someTimes - 1);
+    }
+
+    while (key + 1 < aKeyCount && someTimes[key + 1] <= aTime)
+    {
+        ++key;
+    }
+    return key;
+}
+
+void CommonUtilities::AnimationClip::Sample(float aTime, AnimationCursor& aCursor, AnimationPose& aOutPose) const
+{
+    if (aCursor.myRotationKeys.size() != static_cast<size_t>(myBoneCount))
+    {
+        aCursor.Reset(myBoneCount);
+    }
+    aOutPose.Resize(myBoneCount);
+
+    for (int bone = 0; bone < myBoneCount; ++bone)
+    {
+        const TrackRange& track = myRotationTracks[bone];
+        if (track.myKeyCount == 0)
+        {
+            aOutPose.myRotations[bone] = Quaternion<float>(1, 0, 0, 0);
+            continue;
+        }
+
+        const float* times = &myRotationTimes[track.myFirstKey];
+        const uint16_t* keys = &myRotationKeys[track.myFirstKey * 3];
+        const uint32_t key = FindKey(times, track.myKeyCount, aCursor.myRotationKeys[bone], aTime);
+        aCursor.myRotationKeys[bone] = key;
+
+        if (key + 1 >= track.myKeyCount || aTime <= times[key])
+        {
+            aOutPose.myRotations[bone] = DecodeRotation(&keys[key * 3]);
+            continue;
+        }
+
+        const float alpha = (aTime - times[key]) / (times[key + 1] - times[key]);
+        aOutPose.myRotations[bone] = Quaternion<float>::FastSlerp(DecodeRotation(&keys[key * 3]), DecodeRotation(&keys[(key + 1) * 3]), alpha);
+    }
+
+    for (int bone = 0; bone < myBoneCount; ++bone)
+    {
+        const TrackRange& track = myTranslationTracks[bone];
+        if (track.myKeyCount == 0)
+        {
+            aOutPose.myTranslations[bone] = Vector3<float>();
+            continue;
+        }
+
+        const float* times = &myTranslationTimes[track.myFirstKey];
+        const uint16_t* keys = &myTranslationKeys[track.myFirstKey * 3];
+        const uint32_t key = FindKey(times, track.myKeyCount, aCursor.myTranslationKeys[bone], aTime);
+        aCursor.myTranslationKeys[bone] = key;
+
+        const uint16_t* first = &keys[key * 3];
+        const Vector3<float> from(HalfToFloat(first[0]), HalfToFloat(first[1]), HalfToFloat(first[2]));
+        if (key + 1 >= track.myKeyCount || aTime <= times[key])
+        {
+            aOutPose.myTranslations[bone] = from;
+            continue;
+        }
+
+        const uint16_t* second = &keys[(key + 1) * 3];
+        const Vector3<float> to(HalfToFloat(second[0]), HalfToFloat(second[1]), HalfToFloat(second[2]));
+        const float alpha = (aTime - times[key]) / (times[key + 1] - times[key]);
+        aOutPose.myTranslations[bone] = Lerp(from, to, alpha);
+    }
+}
+
+void CommonUtilities::BlendPoses(const AnimationPose& aFrom, const AnimationPose& aTo, float aWeight, AnimationPose& aOutPose)
+{
+    assert(aFrom.myRotations.size() == aTo.myRotations.size() && "Poses are from different skeletons.");
+
+    const int boneCount = static_cast<int>(aFrom.myRotations.size());
+    aOutPose.Resize(boneCount);
+    Quaternion<float>::NlerpBatch(aFrom.myRotations.data(), aTo.myRotations.data(), aWeight, aOutPose.myRotations.data(), boneCount);
+    for (int bone = 0; bone < boneCount; ++bone)
+    {
+        aOutPose.myTranslations[bone] = Lerp(aFrom.myTranslations[bone], aTo.myTranslations[bone], aWeight);
+    }
+}
+
+void CommonUtilities::UpdateAnimationInstances(AnimationInstance* someInstances, int aCount, float aDeltaTime, int aThreadCount)
+{
+    const int threadCount = Clamp(1, Max(1, aCount), aThreadCount);
+    if (threadCount == 1)
+    {
+        AdvanceAndSample(someInstances, aCount, aDeltaTime);
+        return;
+    }
+
+    const int perThread = (aCount + threadCount - 1) / threadCount;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount - 1);
+    for (int first = perThread; first < aCount; first += perThread)
+    {
+        workers.emplace_back(AdvanceAndSample, someInstances + first, Min(perThread, aCount - first), aDeltaTime);
+    }
+
+    AdvanceAndSample(someInstances, Min(perThread, aCount), aDeltaTime);
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "Quaternion.hpp"
+
+namespace CommonUtilities
+{
+	// Local rotation and translation of every bone in a skeleton.
+	struct AnimationPose
+	{
+		void Resize(int aBoneCount);
+
+		std::vector<Quaternion<float>> myRotations;
+		std::vector<Vector3<float>> myTranslations;
+	};
+
+	// Remembers the last key used on every track of a clip, so sampling forward in time only
+	// has to step to the next key instead of searching the whole track.
+	class AnimationCursor
+	{
+	public:
+		void Reset(int aBoneCount);
+
+	private:
+		friend class AnimationClip;
+
+		std::vector<uint32_t> myRotationKeys;
+		std::vector<uint32_t> myTranslationKeys;
+	};
+
+	// Keyframe tracks for a skeleton. Keys of all tracks live in shared arrays, rotations are stored
+	// as 48 bit smallest-three quaternions and translations as half floats.
+	class AnimationClip
+	{
+	public:
+		AnimationClip(int aBoneCount, float aDuration);
+
+		// Sets the rotation keys of a bone. The times must be sorted and each track can only be set once.
+		void SetRotationTrack(int aBone, const float* someTimes, const Quaternion<float>* someRotations, int aKeyCount);
+
+		// Sets the translation keys of a bone. The times must be sorted and each track can only be set once.
+		void SetTranslationTrack(int aBone, const float* someTimes, const Vector3<float>* someTranslations, int aKeyCount);
+
+		int GetBoneCount() const;
+		float GetDuration() const;
+
+		// Samples every bone at aTime into aOutPose. aCursor is reset if it was made for another bone count.
+		void Sample(float aTime, AnimationCursor& aCursor, AnimationPose& aOutPose) const;
+
+	private:
+		struct TrackRange
+		{
+			uint32_t myFirstKey = 0;
+			uint32_t myKeyCount = 0;
+		};
+
+		static uint32_t FindKey(const float* someTimes, uint32_t aKeyCount, uint32_t aCursorKey, float aTime);
+
+		std::vector<TrackRange> myRotationTracks;
+		std::vector<TrackRange> myTranslationTracks;
+		std::vector<float> myRotationTimes;
+		std::vector<uint16_t> myRotationKeys;
+		std::vector<float> myTranslationTimes;
+		std::vector<uint16_t> myTranslationKeys;
+		int myBoneCount;
+		float myDuration;
+	};
+
+	// One playing clip on one skeleton.
+	struct AnimationInstance
+	{
+		const AnimationClip* myClip = nullptr;
+		float myTime = 0;
+		bool myIsLooping = true;
+		AnimationCursor myCursor;
+		AnimationPose myPose;
+	};
+
+	// Blends two poses of the same skeleton, aWeight 0 gives aFrom and 1 gives aTo.
+	void BlendPoses(const AnimationPose& aFrom, const AnimationPose& aTo, float aWeight, AnimationPose& aOutPose);
+
+	// Advances every instance by aDeltaTime and samples its clip. The instances are split evenly
+	// over aThreadCount threads, the calling thread takes the first share.
+	void UpdateAnimationInstances(AnimationInstance* someInstances, int aCount, float aDeltaTime, int aThreadCount = 1);
+}
+
+namespace CU = CommonUtilities;
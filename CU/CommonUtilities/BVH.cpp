@@ -0,0 +1,723 @@
+#include "pch.h"
+#include "BVH.h"
+#include "Maths.h"
+#include <assert.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    const int MaxBinCount = 64;
+    // Deepest level a node is built on. Ranges that would not reach single triangles within it by halving
+    // are split at the median, so the traversal stacks sized from it can not overflow.
+    const int MaxDepth = 64;
+    // Binary traversal pushes at most one node per level.
+    const int StackSize = MaxDepth;
+    const uint32_t ParallelBuildThreshold = 8192;
+
+    struct Bounds
+    {
+        float myMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float myMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void Grow(const float* aPoint)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                myMin[axis] = CU::Min(myMin[axis], aPoint[axis]);
+                myMax[axis] = CU::Max(myMax[axis], aPoint[axis]);
+            }
+        }
+
+        void Grow(const Bounds& aBounds)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                myMin[axis] = CU::Min(myMin[axis], aBounds.myMin[axis]);
+                myMax[axis] = CU::Max(myMax[axis], aBounds.myMax[axis]);
+            }
+        }
+
+        float SurfaceArea() const
+        {
+            const float x = myMax[0] - myMin[0];
+            const float y = myMax[1] - myMin[1];
+            const float z = myMax[2] - myMin[2];
+            return (x < 0 || y < 0 || z < 0) ? 0.0f : 2.0f * (x * y + y * z + z * x);
+        }
+    };
+
+    struct Bin
+    {
+        Bounds myBounds;
+        uint32_t myCount = 0;
+    };
+
+    // Levels needed below a range of aCount triangles when every split halves it.
+    int MedianSplitDepth(uint32_t aCount)
+    {
+        int depth = 0;
+        while ((1ull << depth) < aCount)
+        {
+            ++depth;
+        }
+        return depth;
+    }
+
+    float SurfaceArea(const float* aMin, const float* aMax)
+    {
+        const float x = aMax[0] - aMin[0];
+        const float y = aMax[1] - aMin[1];
+        const float z = aMax[2] - aMin[2];
+        return 2.0f * (x * y + y * z + z * x);
+    }
+
+    // Slab test against a node's bounds, aOutTEnter is only valid when true is returned.
+    bool IntersectNodeBounds(const CU::Ray<float>& aRay, const float* aMin, const float* aMax, float aMaxDistance, float& aOutTEnter)
+    {
+        const CU::AABB3D<float> box({ aMin[0], aMin[1], aMin[2] }, { aMax[0], aMax[1], aMax[2] });
+        float tExit;
+        return CU::IntersectionAABBRay(box, aRay, aOutTEnter, tExit) && aOutTEnter <= aMaxDistance;
+    }
+}
+
+struct CommonUtilities::BVH::BuildNode
+{
+    Bounds myBounds;
+    std::unique_ptr<BuildNode> myLeft;
+    std::unique_ptr<BuildNode> myRight;
+    uint32_t myFirst = 0;
+    uint32_t myCount = 0;
+};
+
+struct CommonUtilities::BVH::BuildContext
+{
+    std::vector<Bounds> myTriangleBounds;
+    std::vector<Vector3<float>> myCentroids;
+    std::vector<uint32_t> myIndices;
+    int myMaxLeafSize;
+    int myBinCount;
+};
+
+void CommonUtilities::BVH::Build(const Triangle<float>* someTriangles, int aTriangleCount, const BVHBuildSettings& aSettings)
+{
+    TriangleBatch triangles;
+    triangles.Resize(aTriangleCount);
+    for (int i = 0; i < aTriangleCount; ++i)
+    {
+        triangles.Set(i, someTriangles[i].GetPoint1(), someTriangles[i].GetPoint2(), someTriangles[i].GetPoint3());
+    }
+
+    mySourceIndices.clear();
+    BuildFromTriangles(triangles, aSettings);
+}
+
+void CommonUtilities::BVH::Build(const Vector3<float>* someVertices, const uint32_t* someIndices, int anIndexCount, const BVHBuildSettings& aSettings)
+{
+    assert(anIndexCount % 3 == 0 && "Index count must be a multiple of three.");
+
+    const int triangleCount = anIndexCount / 3;
+    TriangleBatch triangles;
+    triangles.Resize(triangleCount);
+    for (int i = 0; i < triangleCount; ++i)
+    {
+        triangles.Set(i, someVertices[someIndices[i * 3]], someVertices[someIndices[i * 3 + 1]], someVertices[someIndices[i * 3 + 2]]);
+    }
+
+    mySourceIndices.assign(someIndices, someIndices + anIndexCount);
+    BuildFromTriangles(triangles, aSettings);
+}
+
+void CommonUtilities::BVH::BuildFromTriangles(const TriangleBatch& someTriangles, const BVHBuildSettings& aSettings)
+{
+    myNodes.clear();
+    myWideNodes4.clear();
+    myWideNodes8.clear();
+    myTriangles.Clear();
+    myTriangleIndices.clear();
+    myWideNodeWidth = 0;
+
+    const uint32_t triangleCount = static_cast<uint32_t>(someTriangles.Size());
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    BuildContext context;
+    context.myMaxLeafSize = Max(1, aSettings.myMaxLeafSize);
+    context.myBinCount = Clamp(2, MaxBinCount, aSettings.myBinCount);
+    context.myTriangleBounds.resize(triangleCount);
+    context.myCentroids.resize(triangleCount);
+    context.myIndices.resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; ++i)
+    {
+        const Vector3<float> p1 = someTriangles.GetPoint1(i);
+        const Vector3<float> p2 = someTriangles.GetPoint2(i);
+        const Vector3<float> p3 = someTriangles.GetPoint3(i);
+
+        Bounds& bounds = context.myTriangleBounds[i];
+        bounds.Grow(&p1.x);
+        bounds.Grow(&p2.x);
+        bounds.Grow(&p3.x);
+
+        context.myCentroids[i] = Vector3<float>(
+            (bounds.myMin[0] + bounds.myMax[0]) * 0.5f,
+            (bounds.myMin[1] + bounds.myMax[1]) * 0.5f,
+            (bounds.myMin[2] + bounds.myMax[2]) * 0.5f);
+        context.myIndices[i] = i;
+    }
+
+    BuildNode root;
+    BuildRange(context, root, 0, triangleCount, 0, Max(1, aSettings.myThreadCount));
+
+    myNodes.reserve(triangleCount * 2);
+    Flatten(root);
+
+    myTriangleIndices = context.myIndices;
+    myTriangles.Resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; ++i)
+    {
+        myTriangles.Set(i, someTriangles, myTriangleIndices[i]);
+    }
+
+    if (aSettings.myBuildWideNodes)
+    {
+        BuildWideNodes(aSettings.myWideNodeWidth);
+    }
+}
+
+void CommonUtilities::BVH::BuildRange(BuildContext& aContext, BuildNode& aNode, uint32_t aFirst, uint32_t aCount, int aDepth, int aThreadBudget)
+{
+    uint32_t* indices = &aContext.myIndices[aFirst];
+
+    Bounds centroidBounds;
+    for (uint32_t i = 0; i < aCount; ++i)
+    {
+        aNode.myBounds.Grow(aContext.myTriangleBounds[indices[i]]);
+        centroidBounds.Grow(&aContext.myCentroids[indices[i]].x);
+    }
+
+    aNode.myFirst = aFirst;
+    aNode.myCount = aCount;
+    if (aCount <= 1)
+    {
+        return;
+    }
+
+    assert(aDepth + MedianSplitDepth(aCount) <= MaxDepth && "BVH range is deeper than the traversal stacks allow.");
+    if (aDepth + MedianSplitDepth(aCount) == MaxDepth)
+    {
+        // Only halving still fits, split at the centroid median of the widest axis.
+        if (aCount <= static_cast<uint32_t>(aContext.myMaxLeafSize))
+        {
+            return;
+        }
+
+        int axis = 0;
+        for (int i = 1; i < 3; ++i)
+        {
+            if (centroidBounds.myMax[i] - centroidBounds.myMin[i] > centroidBounds.myMax[axis] - centroidBounds.myMin[axis])
+            {
+                axis = i;
+            }
+        }
+
+        const Vector3<float>* centroids = aContext.myCentroids.data();
+        std::nth_element(indices, indices + aCount / 2, indices + aCount, [=](uint32_t aLeft, uint32_t aRight)
+        {
+            return (&centroids[aLeft].x)[axis] < (&centroids[aRight].x)[axis];
+        });
+
+        aNode.myLeft.reset(new BuildNode());
+        aNode.myRight.reset(new BuildNode());
+        BuildRange(aContext, *aNode.myLeft, aFirst, aCount / 2, aDepth + 1, 1);
+        BuildRange(aContext, *aNode.myRight, aFirst + aCount / 2, aCount - aCount / 2, aDepth + 1, 1);
+        return;
+    }
+
+    const int binCount = aContext.myBinCount;
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    int bestSplit = 0;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float extent = centroidBounds.myMax[axis] - centroidBounds.myMin[axis];
+        if (extent <= 0)
+        {
+            continue;
+        }
+
+        Bin bins[MaxBinCount];
+        const float scale = binCount / extent;
+        for (uint32_t i = 0; i < aCount; ++i)
+        {
+            const float centroid = (&aContext.myCentroids[indices[i]].x)[axis];
+            const int bin = Min(binCount - 1, static_cast<int>((centroid - centroidBounds.myMin[axis]) * scale));
+            bins[bin].myBounds.Grow(aContext.myTriangleBounds[indices[i]]);
+            ++bins[bin].myCount;
+        }
+
+        float rightArea[MaxBinCount];
+        uint32_t rightCount[MaxBinCount];
+        Bounds right;
+        uint32_t count = 0;
+        for (int bin = binCount - 1; bin > 0; --bin)
+        {
+            right.Grow(bins[bin].myBounds);
+            count += bins[bin].myCount;
+            rightArea[bin - 1] = right.SurfaceArea();
+            rightCount[bin - 1] = count;
+        }
+
+        Bounds left;
+        count = 0;
+        for (int split = 0; split < binCount - 1; ++split)
+        {
+            left.Grow(bins[split].myBounds);
+            count += bins[split].myCount;
+            if (count == 0 || rightCount[split] == 0)
+            {
+                continue;
+            }
+
+            const float cost = count * left.SurfaceArea() + rightCount[split] * rightArea[split];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    const float leafCost = aCount * aNode.myBounds.SurfaceArea();
+    const float traversalCost = aNode.myBounds.SurfaceArea();
+    if (aCount <= static_cast<uint32_t>(aContext.myMaxLeafSize) && (bestAxis == -1 || traversalCost + bestCost >= leafCost))
+    {
+        return;
+    }
+
+    uint32_t leftCount = aCount / 2;
+    if (bestAxis != -1)
+    {
+        const float minimum = centroidBounds.myMin[bestAxis];
+        const float scale = binCount / (centroidBounds.myMax[bestAxis] - minimum);
+        const Vector3<float>* centroids = aContext.myCentroids.data();
+        uint32_t* middle = std::partition(indices, indices + aCount, [=](uint32_t anIndex)
+        {
+            const float centroid = (&centroids[anIndex].x)[bestAxis];
+            return Min(binCount - 1, static_cast<int>((centroid - minimum) * scale)) <= bestSplit;
+        });
+        leftCount = static_cast<uint32_t>(middle - indices);
+    }
+
+    aNode.myLeft.reset(new BuildNode());
+    aNode.myRight.reset(new BuildNode());
+
+    if (aThreadBudget > 1 && aCount >= ParallelBuildThreshold)
+    {
+        const int leftBudget = aThreadBudget / 2;
+        std::thread leftThread(BuildRange, std::ref(aContext), std::ref(*aNode.myLeft), aFirst, leftCount, aDepth + 1, leftBudget);
+        BuildRange(aContext, *aNode.myRight, aFirst + leftCount, aCount - leftCount, aDepth + 1, aThreadBudget - leftBudget);
+        leftThread.join();
+    }
+    else
+    {
+        BuildRange(aContext, *aNode.myLeft, aFirst, leftCount, aDepth + 1, 1);
+        BuildRange(aContext, *aNode.myRight, aFirst + leftCount, aCount - leftCount, aDepth + 1, 1);
+    }
+}
+
+uint32_t CommonUtilities::BVH::Flatten(const BuildNode& aNode)
+{
+    const uint32_t index = static_cast<uint32_t>(myNodes.size());
+    myNodes.emplace_back();
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        myNodes[index].myMin[axis] = aNode.myBounds.myMin[axis];
+        myNodes[index].myMax[axis] = aNode.myBounds.myMax[axis];
+    }
+
+    if (!aNode.myLeft)
+    {
+        myNodes[index].myLeftOrFirst = aNode.myFirst;
+        myNodes[index].myCount = aNode.myCount;
+        return index;
+    }
+
+    Flatten(*aNode.myLeft);
+    const uint32_t right = Flatten(*aNode.myRight);
+    myNodes[index].myLeftOrFirst = right;
+    myNodes[index].myCount = 0;
+    return index;
+}
+
+void CommonUtilities::BVH::Refit(const Triangle<float>* someTriangles)
+{
+    for (int i = 0; i < myTriangles.Size(); ++i)
+    {
+        const Triangle<float>& triangle = someTriangles[myTriangleIndices[i]];
+        myTriangles.Set(i, triangle.GetPoint1(), triangle.GetPoint2(), triangle.GetPoint3());
+    }
+
+    RefitNodes();
+}
+
+void CommonUtilities::BVH::Refit(const Vector3<float>* someVertices)
+{
+    assert(mySourceIndices.size() == static_cast<size_t>(myTriangles.Size()) * 3 && "The BVH was not built from an index buffer.");
+
+    for (int i = 0; i < myTriangles.Size(); ++i)
+    {
+        const uint32_t* indices = &mySourceIndices[myTriangleIndices[i] * 3];
+        myTriangles.Set(i, someVertices[indices[0]], someVertices[indices[1]], someVertices[indices[2]]);
+    }
+
+    RefitNodes();
+}
+
+void CommonUtilities::BVH::RefitNodes()
+{
+    // Children are always stored after their parent, so a reverse sweep sees them first.
+    for (size_t i = myNodes.size(); i-- > 0;)
+    {
+        Node& node = myNodes[i];
+        Bounds bounds;
+        if (node.myCount > 0)
+        {
+            for (uint32_t triangleIndex = node.myLeftOrFirst; triangleIndex < node.myLeftOrFirst + node.myCount; ++triangleIndex)
+            {
+                const Vector3<float> p1 = myTriangles.GetPoint1(triangleIndex);
+                const Vector3<float> p2 = myTriangles.GetPoint2(triangleIndex);
+                const Vector3<float> p3 = myTriangles.GetPoint3(triangleIndex);
+                bounds.Grow(&p1.x);
+                bounds.Grow(&p2.x);
+                bounds.Grow(&p3.x);
+            }
+        }
+        else
+        {
+            const Node& left = myNodes[i + 1];
+            const Node& right = myNodes[node.myLeftOrFirst];
+            bounds.Grow(left.myMin);
+            bounds.Grow(left.myMax);
+            bounds.Grow(right.myMin);
+            bounds.Grow(right.myMax);
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            node.myMin[axis] = bounds.myMin[axis];
+            node.myMax[axis] = bounds.myMax[axis];
+        }
+    }
+
+    if (myWideNodeWidth != 0)
+    {
+        BuildWideNodes(myWideNodeWidth);
+    }
+}
+
+void CommonUtilities::BVH::BuildWideNodes(int aWidth)
+{
+    assert((aWidth == 4 || aWidth == 8) && "Wide nodes are 4 or 8 wide.");
+
+    myWideNodes4.clear();
+    myWideNodes8.clear();
+    myWideNodeWidth = aWidth == 8 ? 8 : 4;
+    if (myNodes.empty())
+    {
+        return;
+    }
+
+    if (myWideNodeWidth == 8)
+    {
+        myWideNodes8.reserve(myNodes.size() / 4 + 1);
+        CollapseToWide(myWideNodes8, 0);
+    }
+    else
+    {
+        myWideNodes4.reserve(myNodes.size() / 2 + 1);
+        CollapseToWide(myWideNodes4, 0);
+    }
+}
+
+template<int Width>
+uint32_t CommonUtilities::BVH::CollapseToWide(std::vector<WideNode<Width>>& someWideNodes, uint32_t aNode)
+{
+    uint32_t children[Width] = { aNode };
+    int childCount = 1;
+    if (myNodes[aNode].myCount == 0)
+    {
+        children[0] = aNode + 1;
+        children[1] = myNodes[aNode].myLeftOrFirst;
+        childCount = 2;
+    }
+
+    // Pulls up the grandchildren of the largest interior child until all lanes are used.
+    while (childCount < Width)
+    {
+        int largest = -1;
+        float largestArea = -1;
+        for (int i = 0; i < childCount; ++i)
+        {
+            const Node& child = myNodes[children[i]];
+            const float area = SurfaceArea(child.myMin, child.myMax);
+            if (child.myCount == 0 && area > largestArea)
+            {
+                largest = i;
+                largestArea = area;
+            }
+        }
+
+        if (largest == -1)
+        {
+            break;
+        }
+
+        const uint32_t node = children[largest];
+        children[largest] = node + 1;
+        children[childCount++] = myNodes[node].myLeftOrFirst;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(someWideNodes.size());
+    someWideNodes.emplace_back();
+    someWideNodes[index].myValidMask = (1 << childCount) - 1;
+
+    for (int lane = 0; lane < Width; ++lane)
+    {
+        if (lane >= childCount)
+        {
+            someWideNodes[index].myBounds.Set(lane, AABB3D<float>());
+            someWideNodes[index].myChildren[lane] = 0;
+            someWideNodes[index].myCounts[lane] = 0;
+            continue;
+        }
+
+        const Node& child = myNodes[children[lane]];
+        someWideNodes[index].myBounds.Set(lane, AABB3D<float>(
+            Vector3<float>(child.myMin[0], child.myMin[1], child.myMin[2]),
+            Vector3<float>(child.myMax[0], child.myMax[1], child.myMax[2])));
+
+        if (child.myCount > 0)
+        {
+            someWideNodes[index].myChildren[lane] = child.myLeftOrFirst;
+            someWideNodes[index].myCounts[lane] = child.myCount;
+        }
+        else
+        {
+            const uint32_t wideChild = CollapseToWide(someWideNodes, children[lane]);
+            someWideNodes[index].myChildren[lane] = wideChild;
+            someWideNodes[index].myCounts[lane] = 0;
+        }
+    }
+
+    return index;
+}
+
+bool CommonUtilities::BVH::IntersectRay(const Ray<float>& aRay, BVHHit& aOutHit, float aMaxDistance) const
+{
+    BVHHit hit;
+    hit.myDistance = aMaxDistance;
+    const bool found = Intersect(aRay, hit, false);
+    if (found)
+    {
+        aOutHit = hit;
+    }
+    return found;
+}
+
+bool CommonUtilities::BVH::IntersectsRay(const Ray<float>& aRay, float aMaxDistance) const
+{
+    BVHHit hit;
+    hit.myDistance = aMaxDistance;
+    return Intersect(aRay, hit, true);
+}
+
+int CommonUtilities::BVH::GetNodeCount() const
+{
+    return static_cast<int>(myNodes.size());
+}
+
+int CommonUtilities::BVH::GetTriangleCount() const
+{
+    return myTriangles.Size();
+}
+
+bool CommonUtilities::BVH::Intersect(const Ray<float>& aRay, BVHHit& aHit, bool anAnyHit) const
+{
+    if (myWideNodeWidth == 8)
+    {
+        return TraverseWide(myWideNodes8, aRay, aHit, anAnyHit);
+    }
+    if (myWideNodeWidth == 4)
+    {
+        return TraverseWide(myWideNodes4, aRay, aHit, anAnyHit);
+    }
+    return Traverse(aRay, aHit, anAnyHit);
+}
+
+bool CommonUtilities::BVH::IntersectLeaf(const Ray<float>& aRay, uint32_t aFirst, uint32_t aCount, BVHHit& aHit) const
+{
+    int index;
+    if (!IntersectionTriangleRay(myTriangles, static_cast<int>(aFirst), static_cast<int>(aCount), aRay, index, aHit.myDistance, aHit.myU, aHit.myV))
+    {
+        return false;
+    }
+
+    aHit.myTriangle = static_cast<int>(myTriangleIndices[index]);
+    return true;
+}
+
+bool CommonUtilities::BVH::Traverse(const Ray<float>& aRay, BVHHit& aHit, bool anAnyHit) const
+{
+    float tEnter;
+    if (myNodes.empty() || !IntersectNodeBounds(aRay, myNodes[0].myMin, myNodes[0].myMax, aHit.myDistance, tEnter))
+    {
+        return false;
+    }
+
+    uint32_t stackNodes[StackSize];
+    float stackDistances[StackSize];
+    int stackCount = 0;
+
+    bool found = false;
+    uint32_t nodeIndex = 0;
+    while (true)
+    {
+        const Node& node = myNodes[nodeIndex];
+        if (node.myCount > 0)
+        {
+            if (IntersectLeaf(aRay, node.myLeftOrFirst, node.myCount, aHit))
+            {
+                found = true;
+                if (anAnyHit)
+                {
+                    return true;
+                }
+            }
+        }
+        else
+        {
+            const uint32_t left = nodeIndex + 1;
+            const uint32_t right = node.myLeftOrFirst;
+            float tLeft;
+            float tRight;
+            const bool hitLeft = IntersectNodeBounds(aRay, myNodes[left].myMin, myNodes[left].myMax, aHit.myDistance, tLeft);
+            const bool hitRight = IntersectNodeBounds(aRay, myNodes[right].myMin, myNodes[right].myMax, aHit.myDistance, tRight);
+
+            if (hitLeft && hitRight)
+            {
+                assert(stackCount < StackSize && "BVH traversal stack overflow.");
+                const bool leftFirst = tLeft <= tRight;
+                stackNodes[stackCount] = leftFirst ? right : left;
+                stackDistances[stackCount] = leftFirst ? tRight : tLeft;
+                ++stackCount;
+                nodeIndex = leftFirst ? left : right;
+                continue;
+            }
+            if (hitLeft || hitRight)
+            {
+                nodeIndex = hitLeft ? left : right;
+                continue;
+            }
+        }
+
+        // Pop the next node that can still be closer than the current hit.
+        bool popped = false;
+        while (stackCount > 0)
+        {
+            --stackCount;
+            if (stackDistances[stackCount] <= aHit.myDistance)
+            {
+                nodeIndex = stackNodes[stackCount];
+                popped = true;
+                break;
+            }
+        }
+        if (!popped)
+        {
+            return found;
+        }
+    }
+}
+
+template<int Width>
+bool CommonUtilities::BVH::TraverseWide(const std::vector<WideNode<Width>>& someWideNodes, const Ray<float>& aRay, BVHHit& aHit, bool anAnyHit) const
+{
+    if (someWideNodes.empty())
+    {
+        return false;
+    }
+
+    // Every wide node on the path leaves at most Width - 1 children on the stack.
+    const int stackSize = (Width - 1) * MaxDepth + 1;
+    uint32_t stackNodes[stackSize];
+    float stackDistances[stackSize];
+    int stackCount = 1;
+    stackNodes[0] = 0;
+    stackDistances[0] = -FLT_MAX;
+
+    bool found = false;
+    while (stackCount > 0)
+    {
+        --stackCount;
+        if (stackDistances[stackCount] > aHit.myDistance)
+        {
+            continue;
+        }
+
+        const WideNode<Width>& node = someWideNodes[stackNodes[stackCount]];
+        float tEnter[Width];
+        int mask = IntersectionAABBRay(node.myBounds, aRay, tEnter) & node.myValidMask;
+
+        // Sort the hit lanes front to back.
+        int lanes[Width];
+        int laneCount = 0;
+        for (int lane = 0; lane < Width; ++lane)
+        {
+            if ((mask & (1 << lane)) == 0 || tEnter[lane] > aHit.myDistance)
+            {
+                continue;
+            }
+
+            int position = laneCount++;
+            while (position > 0 && tEnter[lanes[position - 1]] > tEnter[lane])
+            {
+                lanes[position] = lanes[position - 1];
+                --position;
+            }
+            lanes[position] = lane;
+        }
+
+        for (int i = 0; i < laneCount; ++i)
+        {
+            const int lane = lanes[i];
+            if (node.myCounts[lane] > 0 && IntersectLeaf(aRay, node.myChildren[lane], node.myCounts[lane], aHit))
+            {
+                found = true;
+                if (anAnyHit)
+                {
+                    return true;
+                }
+            }
+        }
+
+        // Push back to front so the nearest child is popped first.
+        for (int i = laneCount - 1; i >= 0; --i)
+        {
+            const int lane = lanes[i];
+            if (node.myCounts[lane] == 0)
+            {
+                assert(stackCount < stackSize && "BVH traversal stack overflow.");
+                stackNodes[stackCount] = node.myChildren[lane];
+                stackDistances[stackCount] = tEnter[lane];
+                ++stackCount;
+            }
+        }
+    }
+
+    return found;
+}
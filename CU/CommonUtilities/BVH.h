@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "Triangle.hpp"
+#include "Ray.hpp"
+#include "IntersectionSIMD.hpp"
+
+namespace CommonUtilities
+{
+	struct BVHHit
+	{
+		// Index of the triangle in the array or index buffer the BVH was built from.
+		int myTriangle = -1;
+		float myDistance = FLT_MAX;
+		// Barycentric coordinates of the hit, the point is (1 - u - v) * p1 + u * p2 + v * p3.
+		float myU = 0;
+		float myV = 0;
+	};
+
+	struct BVHBuildSettings
+	{
+		// Ranges with this many triangles or fewer become leaves when splitting does not pay off.
+		int myMaxLeafSize = 4;
+		// Number of SAH bins per axis.
+		int myBinCount = 16;
+		// Threads used to build the top of the tree, the calling thread counts as one.
+		int myThreadCount = 1;
+		// Also builds a wide tree that is traversed with SIMD slab tests.
+		bool myBuildWideNodes = false;
+		// Children per wide node, 4 (one SSE slab test) or 8 (one AVX slab test, two SSE ones without AVX).
+		int myWideNodeWidth = 4;
+	};
+
+	// Bounding volume hierarchy over a triangle mesh, built with binned SAH. Nodes are stored
+	// depth first in a flat array so the left child always directly follows its parent. Ranges
+	// deep enough to risk overflowing the traversal stacks are split at the median instead.
+	class BVH
+	{
+	public:
+		void Build(const Triangle<float>* someTriangles, int aTriangleCount, const BVHBuildSettings& aSettings = BVHBuildSettings());
+		void Build(const Vector3<float>* someVertices, const uint32_t* someIndices, int anIndexCount, const BVHBuildSettings& aSettings = BVHBuildSettings());
+
+		// Updates the bounds for moved triangles without changing the tree layout. The triangle
+		// count (or index buffer for the indexed version) must be the same as in Build.
+		void Refit(const Triangle<float>* someTriangles);
+		void Refit(const Vector3<float>* someVertices);
+
+		// Finds the closest triangle hit by aRay within aMaxDistance.
+		bool IntersectRay(const Ray<float>& aRay, BVHHit& aOutHit, float aMaxDistance = FLT_MAX) const;
+
+		// Returns whether any triangle is hit within aMaxDistance, stopping at the first hit found.
+		bool IntersectsRay(const Ray<float>& aRay, float aMaxDistance = FLT_MAX) const;
+
+		int GetNodeCount() const;
+		int GetTriangleCount() const;
+
+	private:
+		struct Node
+		{
+			float myMin[3];
+			// Leaf: first triangle. Interior: index of the right child, the left child is the next node.
+			uint32_t myLeftOrFirst;
+			float myMax[3];
+			// Leaf: triangle count. Interior: 0.
+			uint32_t myCount;
+		};
+		static_assert(sizeof(Node) == 32, "BVH nodes are expected to be 32 bytes.");
+
+		template<int Width>
+		struct WideNode
+		{
+			AABBPacket<Width> myBounds;
+			// Leaf lanes: first triangle. Interior lanes: wide node index.
+			uint32_t myChildren[Width];
+			// Leaf lanes: triangle count. Interior lanes: 0.
+			uint32_t myCounts[Width];
+			int myValidMask;
+		};
+
+		struct BuildNode;
+		struct BuildContext;
+
+		void BuildFromTriangles(const TriangleBatch& someTriangles, const BVHBuildSettings& aSettings);
+		static void BuildRange(BuildContext& aContext, BuildNode& aNode, uint32_t aFirst, uint32_t aCount, int aDepth, int aThreadBudget);
+		uint32_t Flatten(const BuildNode& aNode);
+		void RefitNodes();
+		void BuildWideNodes(int aWidth);
+		template<int Width>
+		uint32_t CollapseToWide(std::vector<WideNode<Width>>& someWideNodes, uint32_t aNode);
+
+		bool Intersect(const Ray<float>& aRay, BVHHit& aHit, bool anAnyHit) const;
+		bool IntersectLeaf(const Ray<float>& aRay, uint32_t aFirst, uint32_t aCount, BVHHit& aHit) const;
+		bool Traverse(const Ray<float>& aRay, BVHHit& aHit, bool anAnyHit) const;
+		template<int Width>
+		bool TraverseWide(const std::vector<WideNode<Width>>& someWideNodes, const Ray<float>& aRay, BVHHit& aHit, bool anAnyHit) const;
+
+		std::vector<Node> myNodes;
+		std::vector<WideNode<4>> myWideNodes4;
+		std::vector<WideNode<8>> myWideNodes8;
+		TriangleBatch myTriangles;
+		// Maps the leaf order of myTriangles to the triangle index of the source data.
+		std::vector<uint32_t> myTriangleIndices;
+		std::vector<uint32_t> mySourceIndices;
+		// 0 when there are no wide nodes, otherwise 4 or 8.
+		int myWideNodeWidth = 0;
+	};
+}
+
+namespace CU = CommonUtilities;
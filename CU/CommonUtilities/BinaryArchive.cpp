@@ -0,0 +1,271 @@
+#include "pch.h"
+#include "BinaryArchive.h"
+#include <assert.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const unsigned char Magic[] = { 'C', 'U', 'A', 'R' };
+    const uint16_t FormatVersion = 1;
+    // Written in the writer's byte order, reads back as 0x0201 on a machine of the other order.
+    const uint16_t ByteOrderMark = 0x0102;
+    const size_t HeaderSize = sizeof(Magic) + sizeof(uint16_t) * 2 + sizeof(uint32_t);
+}
+
+CommonUtilities::ArchiveWriter::ArchiveWriter(int aChunkSize)
+{
+    assert(aChunkSize > 0 && "Archives need a chunk buffer.");
+    myBuffer.resize(static_cast<size_t>(aChunkSize));
+}
+
+CommonUtilities::ArchiveWriter::~ArchiveWriter()
+{
+    Close();
+}
+
+bool CommonUtilities::ArchiveWriter::Open(const char* aPath, uint32_t aVersion)
+{
+    Close();
+    myStream.open(aPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!myStream)
+    {
+        return false;
+    }
+
+    myBufferSize = 0;
+    myByteCount = 0;
+    WriteBytes(Magic, sizeof(Magic));
+    WriteValue(FormatVersion);
+    WriteValue(ByteOrderMark);
+    WriteValue(aVersion);
+    return true;
+}
+
+bool CommonUtilities::ArchiveWriter::Close()
+{
+    if (!myStream.is_open())
+    {
+        return true;
+    }
+
+    // The file stream buffers too, so failures can first show when it is closed.
+    Flush();
+    myStream.close();
+    return !myStream.fail();
+}
+
+bool CommonUtilities::ArchiveWriter::IsOpen() const
+{
+    return myStream.is_open();
+}
+
+bool CommonUtilities::ArchiveWriter::IsValid() const
+{
+    return static_cast<bool>(myStream);
+}
+
+void CommonUtilities::ArchiveWriter::WriteBytes(const void* someData, size_t aSize)
+{
+    assert(myStream.is_open() && "Open the archive before writing.");
+    myByteCount += aSize;
+    if (!myStream)
+    {
+        return;
+    }
+
+    if (aSize > myBuffer.size() - myBufferSize)
+    {
+        Flush();
+        // Payloads as large as a chunk skip the buffer.
+        if (aSize >= myBuffer.size())
+        {
+            myStream.write(static_cast<const char*>(someData), static_cast<std::streamsize>(aSize));
+            return;
+        }
+    }
+    std::memcpy(myBuffer.data() + myBufferSize, someData, aSize);
+    myBufferSize += aSize;
+}
+
+uint64_t CommonUtilities::ArchiveWriter::GetByteCount() const
+{
+    return myByteCount;
+}
+
+void CommonUtilities::ArchiveWriter::Flush()
+{
+    myStream.write(myBuffer.data(), static_cast<std::streamsize>(myBufferSize));
+    myBufferSize = 0;
+}
+
+CommonUtilities::ArchiveReader::ArchiveReader(const void* someData, size_t aSize)
+    : myData(static_cast<const unsigned char*>(someData))
+    , mySize(aSize)
+{
+    if (aSize < HeaderSize || std::memcmp(myData, Magic, sizeof(Magic)) != 0)
+    {
+        Fail();
+        return;
+    }
+    myPosition = sizeof(Magic);
+
+    uint16_t formatVersion;
+    uint16_t byteOrderMark;
+    ReadBytes(&formatVersion, sizeof(formatVersion));
+    ReadBytes(&byteOrderMark, sizeof(byteOrderMark));
+    mySwapped = byteOrderMark != ByteOrderMark;
+    if (mySwapped)
+    {
+        formatVersion = static_cast<uint16_t>((formatVersion >> 8) | (formatVersion << 8));
+    }
+
+    if (formatVersion != FormatVersion || (mySwapped && byteOrderMark != 0x0201))
+    {
+        Fail();
+        return;
+    }
+    ReadScalars(&myVersion, 1);
+}
+
+bool CommonUtilities::ArchiveReader::IsValid() const
+{
+    return myValid;
+}
+
+void CommonUtilities::ArchiveReader::Fail()
+{
+    myValid = false;
+    myPosition = mySize;
+}
+
+uint32_t CommonUtilities::ArchiveReader::GetVersion() const
+{
+    return myVersion;
+}
+
+bool CommonUtilities::ArchiveReader::IsSwapped() const
+{
+    return mySwapped;
+}
+
+size_t CommonUtilities::ArchiveReader::GetRemaining() const
+{
+    return mySize - myPosition;
+}
+
+void CommonUtilities::ArchiveReader::ReadBytes(void* someData, size_t aSize)
+{
+    if (aSize > mySize - myPosition)
+    {
+        Fail();
+        std::memset(someData, 0, aSize);
+        return;
+    }
+    std::memcpy(someData, myData + myPosition, aSize);
+    myPosition += aSize;
+}
+
+CommonUtilities::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool CommonUtilities::MappedFile::Open(const char* aPath)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(aPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (data == nullptr)
+    {
+        if (mapping != nullptr)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    myFile = file;
+    myMapping = mapping;
+    myData = data;
+    mySize = static_cast<size_t>(size.QuadPart);
+#else
+    const int file = open(aPath, O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the file is closed.
+    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    myData = data;
+    mySize = static_cast<size_t>(status.st_size);
+#endif
+    return true;
+}
+
+void CommonUtilities::MappedFile::Close()
+{
+    if (myData == nullptr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(myData);
+    CloseHandle(static_cast<HANDLE>(myMapping));
+    CloseHandle(static_cast<HANDLE>(myFile));
+    myFile = nullptr;
+    myMapping = nullptr;
+#else
+    munmap(const_cast<void*>(myData), mySize);
+#endif
+    myData = nullptr;
+    mySize = 0;
+}
+
+const void* CommonUtilities::MappedFile::GetData() const
+{
+    return myData;
+}
+
+size_t CommonUtilities::MappedFile::GetSize() const
+{
+    return mySize;
+}
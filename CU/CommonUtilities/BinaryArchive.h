@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace CommonUtilities
+{
+	// Writes a binary archive to a file through a fixed size chunk buffer, which is written out whenever it is
+	// full. Values are stored in the byte order of the writing machine, the header records which one so a
+	// reader on the other order can swap. The header also holds a version the caller picks, so readers can
+	// tell old data layouts from new ones. Serialization.hpp writes the math types and containers.
+	class ArchiveWriter
+	{
+	public:
+		static const int DefaultChunkSize = 1 << 16;
+
+		explicit ArchiveWriter(int aChunkSize = DefaultChunkSize);
+		ArchiveWriter(const ArchiveWriter& aWriter) = delete;
+		ArchiveWriter& operator=(const ArchiveWriter& aWriter) = delete;
+		~ArchiveWriter();
+
+		// Starts a new archive, replacing any file at aPath.
+		bool Open(const char* aPath, uint32_t aVersion = 0);
+		// Writes what is left in the buffer, returns false if any write failed. Writes themselves report
+		// nothing, so a full disk only shows here or in IsValid: check one of them before trusting the file.
+		bool Close();
+		bool IsOpen() const;
+		// False once a write to the file has failed, later writes are then skipped. Failures in the last
+		// writes may only be found by Close.
+		bool IsValid() const;
+
+		void WriteBytes(const void* someData, size_t aSize);
+
+		// Writes a single number.
+		template<typename T>
+		void WriteValue(const T& aValue);
+
+		// Bytes written so far, the header included.
+		uint64_t GetByteCount() const;
+
+	private:
+		void Flush();
+
+		std::ofstream myStream;
+		std::vector<char> myBuffer;
+		size_t myBufferSize = 0;
+		uint64_t myByteCount = 0;
+	};
+
+	// Reads an archive from memory, such as a MappedFile, copying straight from it into the values read.
+	// Reading past the end or a header that does not match marks the reader as failed, after which every read
+	// gives zeroes. Check IsValid once done instead of after every read.
+	class ArchiveReader
+	{
+	public:
+		ArchiveReader(const void* someData, size_t aSize);
+
+		bool IsValid() const;
+		// Marks the data as bad, for checks made while reading values.
+		void Fail();
+
+		// The version passed to ArchiveWriter::Open.
+		uint32_t GetVersion() const;
+		// Whether the archive was written on a machine of the other byte order.
+		bool IsSwapped() const;
+
+		size_t GetRemaining() const;
+
+		void ReadBytes(void* someData, size_t aSize);
+
+		// Reads aCount values that each are a single number, fixing their byte order if needed.
+		template<typename T>
+		void ReadScalars(T* someValues, size_t aCount);
+
+		// Reads a single number.
+		template<typename T>
+		T ReadValue();
+
+	private:
+		const unsigned char* myData;
+		size_t mySize;
+		size_t myPosition = 0;
+		uint32_t myVersion = 0;
+		bool mySwapped = false;
+		bool myValid = true;
+	};
+
+	// A read-only memory mapping of a whole file, closed when destroyed.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile& aFile) = delete;
+		MappedFile& operator=(const MappedFile& aFile) = delete;
+		~MappedFile();
+
+		// Returns false when the file can not be opened or is empty.
+		bool Open(const char* aPath);
+		void Close();
+
+		const void* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const void* myData = nullptr;
+		size_t mySize = 0;
+		// The file and mapping handles on Windows, unused elsewhere.
+		void* myFile = nullptr;
+		void* myMapping = nullptr;
+	};
+
+	template<typename T>
+	inline void ArchiveWriter::WriteValue(const T& aValue)
+	{
+		WriteBytes(&aValue, sizeof(T));
+	}
+
+	template<typename T>
+	inline void ArchiveReader::ReadScalars(T* someValues, size_t aCount)
+	{
+		ReadBytes(someValues, sizeof(T) * aCount);
+		if (mySwapped && sizeof(T) > 1)
+		{
+			unsigned char* bytes = reinterpret_cast<unsigned char*>(someValues);
+			for (size_t i = 0; i < aCount; ++i, bytes += sizeof(T))
+			{
+				for (size_t j = 0; j < sizeof(T) / 2; ++j)
+				{
+					const unsigned char byte = bytes[j];
+					bytes[j] = bytes[sizeof(T) - 1 - j];
+					bytes[sizeof(T) - 1 - j] = byte;
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	inline T ArchiveReader::ReadValue()
+	{
+		T value;
+		ReadScalars(&value, 1);
+		return value;
+	}
+}
+
+namespace CU = CommonUtilities;
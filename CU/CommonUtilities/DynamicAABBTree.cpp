@@ -0,0 +1,428 @@
+#include "pch.h"
+#include "DynamicAABBTree.h"
+#include "Maths.h"
+
+namespace
+{
+    CommonUtilities::AABB3D<float> Union(const CommonUtilities::AABB3D<float>& anAABB, const CommonUtilities::AABB3D<float>& anOtherAABB)
+    {
+        return CommonUtilities::AABB3D<float>(
+            { CommonUtilities::Min(anAABB.myMinPoint.x, anOtherAABB.myMinPoint.x), CommonUtilities::Min(anAABB.myMinPoint.y, anOtherAABB.myMinPoint.y), CommonUtilities::Min(anAABB.myMinPoint.z, anOtherAABB.myMinPoint.z) },
+            { CommonUtilities::Max(anAABB.myMaxPoint.x, anOtherAABB.myMaxPoint.x), CommonUtilities::Max(anAABB.myMaxPoint.y, anOtherAABB.myMaxPoint.y), CommonUtilities::Max(anAABB.myMaxPoint.z, anOtherAABB.myMaxPoint.z) });
+    }
+
+    // Half the surface area, the factor does not matter when comparing costs.
+    float Area(const CommonUtilities::AABB3D<float>& anAABB)
+    {
+        const CommonUtilities::Vector3<float> size = anAABB.myMaxPoint - anAABB.myMinPoint;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    bool Contains(const CommonUtilities::AABB3D<float>& anAABB, const CommonUtilities::AABB3D<float>& anInnerAABB)
+    {
+        return anAABB.myMinPoint.x <= anInnerAABB.myMinPoint.x && anAABB.myMinPoint.y <= anInnerAABB.myMinPoint.y && anAABB.myMinPoint.z <= anInnerAABB.myMinPoint.z &&
+            anInnerAABB.myMaxPoint.x <= anAABB.myMaxPoint.x && anInnerAABB.myMaxPoint.y <= anAABB.myMaxPoint.y && anInnerAABB.myMaxPoint.z <= anAABB.myMaxPoint.z;
+    }
+
+    CommonUtilities::AABB3D<float> Expand(const CommonUtilities::AABB3D<float>& anAABB, const float aMargin)
+    {
+        const CommonUtilities::Vector3<float> margin(aMargin, aMargin, aMargin);
+        return CommonUtilities::AABB3D<float>(anAABB.myMinPoint - margin, anAABB.myMaxPoint + margin);
+    }
+}
+
+CommonUtilities::DynamicAABBTree::DynamicAABBTree(float aMargin, float aDisplacementMultiplier)
+    : myMargin(aMargin)
+    , myDisplacementMultiplier(aDisplacementMultiplier)
+{
+}
+
+int CommonUtilities::DynamicAABBTree::CreateProxy(const AABB3D<float>& anAABB, int aUserData)
+{
+    const int proxy = AllocateNode();
+    Node& node = myNodes[proxy];
+    MakeFatAABB(anAABB, Vector3<float>(0.0f, 0.0f, 0.0f), node.myAABB);
+    node.myUserData = aUserData;
+    node.myHeight = 0;
+
+    InsertLeaf(proxy);
+    BufferMove(proxy);
+    ++myProxyCount;
+    return proxy;
+}
+
+void CommonUtilities::DynamicAABBTree::DestroyProxy(int aProxy)
+{
+    assert(aProxy >= 0 && aProxy < static_cast<int>(myNodes.size()) && myNodes[aProxy].IsLeaf() && "Invalid proxy.");
+
+    if (myNodes[aProxy].myMoved)
+    {
+        for (int& proxy : myMoveBuffer)
+        {
+            if (proxy == aProxy)
+            {
+                proxy = NullNode;
+            }
+        }
+    }
+
+    RemoveLeaf(aProxy);
+    FreeNode(aProxy);
+    --myProxyCount;
+}
+
+bool CommonUtilities::DynamicAABBTree::MoveProxy(int aProxy, const AABB3D<float>& anAABB, const Vector3<float>& aDisplacement)
+{
+    assert(aProxy >= 0 && aProxy < static_cast<int>(myNodes.size()) && myNodes[aProxy].IsLeaf() && "Invalid proxy.");
+
+    AABB3D<float> fatAABB;
+    if (!NeedsReinsert(aProxy, anAABB, aDisplacement, fatAABB))
+    {
+        return false;
+    }
+
+    RemoveLeaf(aProxy);
+    myNodes[aProxy].myAABB = fatAABB;
+    InsertLeaf(aProxy);
+    BufferMove(aProxy);
+    return true;
+}
+
+int CommonUtilities::DynamicAABBTree::UpdateProxies(const int* someProxies, const AABB3D<float>* someAABBs, const Vector3<float>* someDisplacements, int aCount)
+{
+    // The fat boxes are checked without touching the tree first, most proxies usually stay inside theirs.
+    myReinsertBuffer.clear();
+    const Vector3<float> noDisplacement(0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < aCount; ++i)
+    {
+        const int proxy = someProxies[i];
+        assert(proxy >= 0 && proxy < static_cast<int>(myNodes.size()) && myNodes[proxy].IsLeaf() && "Invalid proxy.");
+
+        const Vector3<float>& displacement = someDisplacements != nullptr ? someDisplacements[i] : noDisplacement;
+        if (myNodes[proxy].myQueued)
+        {
+            // Listed again, it is already out of the tree and only takes the later box.
+            MakeFatAABB(someAABBs[i], displacement, myNodes[proxy].myAABB);
+            continue;
+        }
+
+        AABB3D<float> fatAABB;
+        if (NeedsReinsert(proxy, someAABBs[i], displacement, fatAABB))
+        {
+            RemoveLeaf(proxy);
+            myNodes[proxy].myAABB = fatAABB;
+            myNodes[proxy].myQueued = true;
+            myReinsertBuffer.push_back(proxy);
+        }
+    }
+
+    for (const int proxy : myReinsertBuffer)
+    {
+        myNodes[proxy].myQueued = false;
+        InsertLeaf(proxy);
+        BufferMove(proxy);
+    }
+    return static_cast<int>(myReinsertBuffer.size());
+}
+
+int CommonUtilities::DynamicAABBTree::GetUserData(int aProxy) const
+{
+    assert(aProxy >= 0 && aProxy < static_cast<int>(myNodes.size()) && "Invalid proxy.");
+    return myNodes[aProxy].myUserData;
+}
+
+const CommonUtilities::AABB3D<float>& CommonUtilities::DynamicAABBTree::GetFatAABB(int aProxy) const
+{
+    assert(aProxy >= 0 && aProxy < static_cast<int>(myNodes.size()) && "Invalid proxy.");
+    return myNodes[aProxy].myAABB;
+}
+
+int CommonUtilities::DynamicAABBTree::GetProxyCount() const
+{
+    return myProxyCount;
+}
+
+int CommonUtilities::DynamicAABBTree::GetHeight() const
+{
+    return myRoot == NullNode ? 0 : myNodes[myRoot].myHeight;
+}
+
+float CommonUtilities::DynamicAABBTree::GetAreaRatio() const
+{
+    if (myRoot == NullNode)
+    {
+        return 0.0f;
+    }
+
+    float totalArea = 0.0f;
+    for (const Node& node : myNodes)
+    {
+        if (node.myHeight >= 0)
+        {
+            totalArea += Area(node.myAABB);
+        }
+    }
+
+    const float rootArea = Area(myNodes[myRoot].myAABB);
+    return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+}
+
+void CommonUtilities::DynamicAABBTree::Validate() const
+{
+    if (myRoot != NullNode)
+    {
+        assert(myNodes[myRoot].myParentOrNext == NullNode && "The root has a parent.");
+        const int leafCount = ValidateNode(myRoot);
+        assert(leafCount == myProxyCount && "Proxy count does not match the leaves in the tree.");
+        (void)leafCount;
+    }
+
+    int freeCount = 0;
+    for (int index = myFreeList; index != NullNode; index = myNodes[index].myParentOrNext)
+    {
+        assert(myNodes[index].myHeight == -1 && "A node in the free list is in use.");
+        ++freeCount;
+    }
+    assert(freeCount + (myRoot == NullNode ? 0 : 2 * myProxyCount - 1) == static_cast<int>(myNodes.size()) && "Nodes are leaking.");
+    (void)freeCount;
+}
+
+int CommonUtilities::DynamicAABBTree::AllocateNode()
+{
+    if (myFreeList == NullNode)
+    {
+        myNodes.emplace_back();
+        return static_cast<int>(myNodes.size()) - 1;
+    }
+
+    const int node = myFreeList;
+    myFreeList = myNodes[node].myParentOrNext;
+    myNodes[node] = Node();
+    return node;
+}
+
+void CommonUtilities::DynamicAABBTree::FreeNode(int aNode)
+{
+    myNodes[aNode].myParentOrNext = myFreeList;
+    myNodes[aNode].myHeight = -1;
+    myFreeList = aNode;
+}
+
+void CommonUtilities::DynamicAABBTree::InsertLeaf(int aLeaf)
+{
+    if (myRoot == NullNode)
+    {
+        myRoot = aLeaf;
+        myNodes[aLeaf].myParentOrNext = NullNode;
+        return;
+    }
+
+    // Walks down towards the sibling that is cheapest to pair with. Pairing with a node costs the area of the
+    // new parent, and every ancestor on the way grows by the leaf (the inheritance cost).
+    const AABB3D<float> leafAABB = myNodes[aLeaf].myAABB;
+    int index = myRoot;
+    while (!myNodes[index].IsLeaf())
+    {
+        const Node& node = myNodes[index];
+        const float area = Area(node.myAABB);
+        const float combinedArea = Area(Union(node.myAABB, leafAABB));
+
+        const float cost = 2.0f * combinedArea;
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        const int children[2] = { node.myChild1, node.myChild2 };
+        for (int i = 0; i < 2; ++i)
+        {
+            const Node& child = myNodes[children[i]];
+            const float unionArea = Area(Union(child.myAABB, leafAABB));
+            childCosts[i] = (child.IsLeaf() ? unionArea : unionArea - Area(child.myAABB)) + inheritanceCost;
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1])
+        {
+            break;
+        }
+        index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+    }
+
+    const int sibling = index;
+    const int oldParent = myNodes[sibling].myParentOrNext;
+    const int newParent = AllocateNode();
+    myNodes[newParent].myParentOrNext = oldParent;
+    myNodes[newParent].myAABB = Union(leafAABB, myNodes[sibling].myAABB);
+    myNodes[newParent].myHeight = myNodes[sibling].myHeight + 1;
+    myNodes[newParent].myChild1 = sibling;
+    myNodes[newParent].myChild2 = aLeaf;
+    myNodes[sibling].myParentOrNext = newParent;
+    myNodes[aLeaf].myParentOrNext = newParent;
+
+    if (oldParent == NullNode)
+    {
+        myRoot = newParent;
+    }
+    else if (myNodes[oldParent].myChild1 == sibling)
+    {
+        myNodes[oldParent].myChild1 = newParent;
+    }
+    else
+    {
+        myNodes[oldParent].myChild2 = newParent;
+    }
+
+    for (index = myNodes[aLeaf].myParentOrNext; index != NullNode; index = myNodes[index].myParentOrNext)
+    {
+        index = Balance(index);
+        UpdateFromChildren(index);
+    }
+}
+
+void CommonUtilities::DynamicAABBTree::RemoveLeaf(int aLeaf)
+{
+    if (aLeaf == myRoot)
+    {
+        myRoot = NullNode;
+        return;
+    }
+
+    const int parent = myNodes[aLeaf].myParentOrNext;
+    const int grandParent = myNodes[parent].myParentOrNext;
+    const int sibling = myNodes[parent].myChild1 == aLeaf ? myNodes[parent].myChild2 : myNodes[parent].myChild1;
+
+    myNodes[sibling].myParentOrNext = grandParent;
+    FreeNode(parent);
+
+    if (grandParent == NullNode)
+    {
+        myRoot = sibling;
+        return;
+    }
+
+    if (myNodes[grandParent].myChild1 == parent)
+    {
+        myNodes[grandParent].myChild1 = sibling;
+    }
+    else
+    {
+        myNodes[grandParent].myChild2 = sibling;
+    }
+
+    for (int index = grandParent; index != NullNode; index = myNodes[index].myParentOrNext)
+    {
+        index = Balance(index);
+        UpdateFromChildren(index);
+    }
+}
+
+int CommonUtilities::DynamicAABBTree::Balance(int aNode)
+{
+    // Rotates the higher child up when the child heights differ by more than one, its higher
+    // grandchild stays with it and the other one moves down to aNode.
+    Node& a = myNodes[aNode];
+    if (a.IsLeaf())
+    {
+        return aNode;
+    }
+
+    const int balance = myNodes[a.myChild2].myHeight - myNodes[a.myChild1].myHeight;
+    if (balance >= -1 && balance <= 1)
+    {
+        return aNode;
+    }
+
+    const bool rotateSecond = balance > 1;
+    const int up = rotateSecond ? a.myChild2 : a.myChild1;
+    const int stay = rotateSecond ? a.myChild1 : a.myChild2;
+    Node& upNode = myNodes[up];
+
+    const int upChild1 = upNode.myChild1;
+    const int upChild2 = upNode.myChild2;
+    const bool keepFirst = myNodes[upChild1].myHeight > myNodes[upChild2].myHeight;
+    const int keep = keepFirst ? upChild1 : upChild2;
+    const int moveDown = keepFirst ? upChild2 : upChild1;
+
+    // up takes aNode's place.
+    upNode.myParentOrNext = a.myParentOrNext;
+    if (upNode.myParentOrNext == NullNode)
+    {
+        myRoot = up;
+    }
+    else if (myNodes[upNode.myParentOrNext].myChild1 == aNode)
+    {
+        myNodes[upNode.myParentOrNext].myChild1 = up;
+    }
+    else
+    {
+        myNodes[upNode.myParentOrNext].myChild2 = up;
+    }
+
+    // aNode keeps its other child and gets moveDown in place of up.
+    a.myParentOrNext = up;
+    a.myChild1 = stay;
+    a.myChild2 = moveDown;
+    myNodes[moveDown].myParentOrNext = aNode;
+    UpdateFromChildren(aNode);
+
+    upNode.myChild1 = aNode;
+    upNode.myChild2 = keep;
+    UpdateFromChildren(up);
+    return up;
+}
+
+void CommonUtilities::DynamicAABBTree::UpdateFromChildren(int aNode)
+{
+    Node& node = myNodes[aNode];
+    const Node& child1 = myNodes[node.myChild1];
+    const Node& child2 = myNodes[node.myChild2];
+    node.myHeight = 1 + Max(child1.myHeight, child2.myHeight);
+    node.myAABB = Union(child1.myAABB, child2.myAABB);
+}
+
+void CommonUtilities::DynamicAABBTree::MakeFatAABB(const AABB3D<float>& anAABB, const Vector3<float>& aDisplacement, AABB3D<float>& aOutFatAABB) const
+{
+    aOutFatAABB = Expand(anAABB, myMargin);
+
+    // Stretched along the movement so the proxy can keep moving the same way for a few updates.
+    const Vector3<float> stretch = aDisplacement * myDisplacementMultiplier;
+    (stretch.x < 0.0f ? aOutFatAABB.myMinPoint.x : aOutFatAABB.myMaxPoint.x) += stretch.x;
+    (stretch.y < 0.0f ? aOutFatAABB.myMinPoint.y : aOutFatAABB.myMaxPoint.y) += stretch.y;
+    (stretch.z < 0.0f ? aOutFatAABB.myMinPoint.z : aOutFatAABB.myMaxPoint.z) += stretch.z;
+}
+
+bool CommonUtilities::DynamicAABBTree::NeedsReinsert(int aProxy, const AABB3D<float>& anAABB, const Vector3<float>& aDisplacement, AABB3D<float>& aOutFatAABB) const
+{
+    MakeFatAABB(anAABB, aDisplacement, aOutFatAABB);
+
+    // Also reinserted when the old fat box is far larger than needed, for example after the object slowed down.
+    const AABB3D<float>& treeAABB = myNodes[aProxy].myAABB;
+    return !Contains(treeAABB, anAABB) || !Contains(Expand(aOutFatAABB, 4.0f * myMargin), treeAABB);
+}
+
+void CommonUtilities::DynamicAABBTree::BufferMove(int aProxy)
+{
+    if (!myNodes[aProxy].myMoved)
+    {
+        myNodes[aProxy].myMoved = true;
+        myMoveBuffer.push_back(aProxy);
+    }
+}
+
+int CommonUtilities::DynamicAABBTree::ValidateNode(int aNode) const
+{
+    const Node& node = myNodes[aNode];
+    if (node.IsLeaf())
+    {
+        assert(node.myHeight == 0 && "Leaves must have height 0.");
+        return 1;
+    }
+
+    const Node& child1 = myNodes[node.myChild1];
+    const Node& child2 = myNodes[node.myChild2];
+    assert(child1.myParentOrNext == aNode && child2.myParentOrNext == aNode && "Child has the wrong parent.");
+    assert(node.myHeight == 1 + Max(child1.myHeight, child2.myHeight) && "Node height is wrong.");
+    assert(Contains(node.myAABB, child1.myAABB) && Contains(node.myAABB, child2.myAABB) && "Node does not contain its children.");
+    (void)child1;
+    (void)child2;
+
+    return ValidateNode(node.myChild1) + ValidateNode(node.myChild2);
+}
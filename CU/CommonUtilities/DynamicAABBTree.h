@@ -0,0 +1,226 @@
+#pragma once
+
+#include <assert.h>
+#include <vector>
+#include "Vector3.hpp"
+#include "AABB3D.hpp"
+#include "Ray.hpp"
+#include "Intersection.hpp"
+
+namespace CommonUtilities
+{
+	// Broadphase tree over moving boxes. Every proxy is stored with a fattened box so small movements do
+	// not touch the tree, leaves are inserted next to the sibling that grows the tree surface the least and
+	// the tree is kept balanced with rotations. Nodes live in one array and are referred to by index.
+	class DynamicAABBTree
+	{
+	public:
+		static const int NullNode = -1;
+
+		// aMargin is added on every side of the proxy boxes, aDisplacementMultiplier scales how far the
+		// boxes are stretched in the direction an object is moving.
+		explicit DynamicAABBTree(float aMargin = 0.1f, float aDisplacementMultiplier = 4.0f);
+
+		// Adds a box and returns the proxy id used to refer to it.
+		int CreateProxy(const AABB3D<float>& anAABB, int aUserData);
+		void DestroyProxy(int aProxy);
+
+		// Moves a proxy to anAABB. The tree is only changed when anAABB leaves the fat box or the fat box has
+		// become much larger than needed. Returns whether the proxy was reinserted.
+		bool MoveProxy(int aProxy, const AABB3D<float>& anAABB, const Vector3<float>& aDisplacement);
+
+		// Moves aCount proxies at once, someDisplacements may be null. All proxies that have to be reinserted
+		// are removed before any is inserted again. A proxy listed more than once ends up at its last box.
+		// Returns the number of reinserted proxies.
+		int UpdateProxies(const int* someProxies, const AABB3D<float>* someAABBs, const Vector3<float>* someDisplacements, int aCount);
+
+		int GetUserData(int aProxy) const;
+		const AABB3D<float>& GetFatAABB(int aProxy) const;
+
+		// Calls aCallback(aUserDataA, aUserDataB) once for every overlapping pair of fat boxes where at least one
+		// proxy was created or reinserted since the last call.
+		template<typename Callback>
+		void UpdatePairs(Callback&& aCallback);
+
+		// Calls aCallback(aProxy) for every proxy whose fat box overlaps anAABB. Return false from aCallback to stop.
+		template<typename Callback>
+		void Query(const AABB3D<float>& anAABB, Callback&& aCallback) const;
+
+		// Calls aCallback(aProxy, aDistance) for proxies whose fat box aRay enters within aMaxDistance, aDistance is
+		// where it enters. aCallback returns the new max distance, so it can clip the ray to its closest hit, or
+		// 0 to stop.
+		template<typename Callback>
+		void RayCast(const Ray<float>& aRay, float aMaxDistance, Callback&& aCallback) const;
+
+		int GetProxyCount() const;
+		int GetHeight() const;
+
+		// Sum of the surface of all nodes divided by the surface of the root, lower is a better tree.
+		float GetAreaRatio() const;
+
+		// Asserts that links, heights and boxes of the whole tree are consistent.
+		void Validate() const;
+
+	private:
+		static const int StackSize = 256;
+
+		struct Node
+		{
+			bool IsLeaf() const
+			{
+				return myChild1 == NullNode;
+			}
+
+			AABB3D<float> myAABB;
+			int myUserData = -1;
+			// Parent while in use, next free node while in the free list.
+			int myParentOrNext = NullNode;
+			int myChild1 = NullNode;
+			int myChild2 = NullNode;
+			// Leaves are 0, free nodes -1.
+			int myHeight = -1;
+			bool myMoved = false;
+			// Removed from the tree by UpdateProxies and waiting to be inserted again.
+			bool myQueued = false;
+		};
+
+		static bool Overlaps(const AABB3D<float>& anAABB, const AABB3D<float>& anOtherAABB);
+
+		int AllocateNode();
+		void FreeNode(int aNode);
+		void InsertLeaf(int aLeaf);
+		void RemoveLeaf(int aLeaf);
+		int Balance(int aNode);
+		void UpdateFromChildren(int aNode);
+		void MakeFatAABB(const AABB3D<float>& anAABB, const Vector3<float>& aDisplacement, AABB3D<float>& aOutFatAABB) const;
+		bool NeedsReinsert(int aProxy, const AABB3D<float>& anAABB, const Vector3<float>& aDisplacement, AABB3D<float>& aOutFatAABB) const;
+		void BufferMove(int aProxy);
+		int ValidateNode(int aNode) const;
+
+		std::vector<Node> myNodes;
+		std::vector<int> myMoveBuffer;
+		std::vector<int> myReinsertBuffer;
+		int myRoot = NullNode;
+		int myFreeList = NullNode;
+		int myProxyCount = 0;
+		float myMargin;
+		float myDisplacementMultiplier;
+	};
+
+	inline bool DynamicAABBTree::Overlaps(const AABB3D<float>& anAABB, const AABB3D<float>& anOtherAABB)
+	{
+		return anAABB.myMinPoint.x <= anOtherAABB.myMaxPoint.x && anAABB.myMaxPoint.x >= anOtherAABB.myMinPoint.x &&
+			anAABB.myMinPoint.y <= anOtherAABB.myMaxPoint.y && anAABB.myMaxPoint.y >= anOtherAABB.myMinPoint.y &&
+			anAABB.myMinPoint.z <= anOtherAABB.myMaxPoint.z && anAABB.myMaxPoint.z >= anOtherAABB.myMinPoint.z;
+	}
+
+	template<typename Callback>
+	void DynamicAABBTree::UpdatePairs(Callback&& aCallback)
+	{
+		for (const int proxy : myMoveBuffer)
+		{
+			if (proxy == NullNode)
+			{
+				continue;
+			}
+
+			Query(myNodes[proxy].myAABB, [&](const int anOther)
+			{
+				// A pair of two moved proxies is reported from the one with the lower id only.
+				if (anOther != proxy && (!myNodes[anOther].myMoved || proxy < anOther))
+				{
+					aCallback(myNodes[proxy].myUserData, myNodes[anOther].myUserData);
+				}
+				return true;
+			});
+		}
+
+		for (const int proxy : myMoveBuffer)
+		{
+			if (proxy != NullNode)
+			{
+				myNodes[proxy].myMoved = false;
+			}
+		}
+		myMoveBuffer.clear();
+	}
+
+	template<typename Callback>
+	void DynamicAABBTree::Query(const AABB3D<float>& anAABB, Callback&& aCallback) const
+	{
+		if (myRoot == NullNode)
+		{
+			return;
+		}
+
+		int stack[StackSize];
+		int stackSize = 0;
+		stack[stackSize++] = myRoot;
+		while (stackSize > 0)
+		{
+			const int index = stack[--stackSize];
+			const Node& node = myNodes[index];
+			if (!Overlaps(node.myAABB, anAABB))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				if (!aCallback(index))
+				{
+					return;
+				}
+			}
+			else
+			{
+				assert(stackSize + 2 <= StackSize && "DynamicAABBTree query stack overflow.");
+				stack[stackSize++] = node.myChild1;
+				stack[stackSize++] = node.myChild2;
+			}
+		}
+	}
+
+	template<typename Callback>
+	void DynamicAABBTree::RayCast(const Ray<float>& aRay, float aMaxDistance, Callback&& aCallback) const
+	{
+		if (myRoot == NullNode)
+		{
+			return;
+		}
+
+		int stack[StackSize];
+		int stackSize = 0;
+		stack[stackSize++] = myRoot;
+		while (stackSize > 0)
+		{
+			const int index = stack[--stackSize];
+			const Node& node = myNodes[index];
+
+			float tEnter;
+			float tExit;
+			if (!IntersectionAABBRay(node.myAABB, aRay, tEnter, tExit) || tEnter > aMaxDistance)
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				const float maxDistance = aCallback(index, tEnter);
+				if (maxDistance <= 0.0f)
+				{
+					return;
+				}
+				aMaxDistance = maxDistance < aMaxDistance ? maxDistance : aMaxDistance;
+			}
+			else
+			{
+				assert(stackSize + 2 <= StackSize && "DynamicAABBTree ray cast stack overflow.");
+				stack[stackSize++] = node.myChild1;
+				stack[stackSize++] = node.myChild2;
+			}
+		}
+	}
+}
+
+namespace CU = CommonUtilities;
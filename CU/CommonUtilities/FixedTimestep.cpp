@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "FixedTimestep.h"
+#include "Timer.h"
+#include <assert.h>
+
+int CommonUtilities::FixedTimestep::AddSubsystem(int aTicksPerSecond, int aMaxTicksPerFrame)
+{
+    assert(aTicksPerSecond > 0 && "Subsystems must tick at least once per second.");
+    assert(aMaxTicksPerFrame > 0 && "Subsystems must be allowed at least one tick per frame.");
+
+    Subsystem subsystem;
+    subsystem.myTicksPerSecond = aTicksPerSecond;
+    subsystem.myMaxTicksPerFrame = aMaxTicksPerFrame;
+    subsystem.myAccumulator = 0;
+    subsystem.myTickCount = 0;
+    subsystem.myTotalTickCount = 0;
+    subsystem.myDroppedNanoseconds = 0;
+    mySubsystems.push_back(subsystem);
+    return static_cast<int>(mySubsystems.size()) - 1;
+}
+
+void CommonUtilities::FixedTimestep::Update(const Timer& aTimer)
+{
+    Advance(aTimer.GetDeltaNanoseconds());
+}
+
+void CommonUtilities::FixedTimestep::Advance(int64_t aNanoseconds)
+{
+    assert(aNanoseconds >= 0 && "Time can not go backwards.");
+
+    for (Subsystem& subsystem : mySubsystems)
+    {
+        // Frames longer than the tick limit are cut first so the product below can not overflow.
+        const int64_t maxNanoseconds = (subsystem.myMaxTicksPerFrame + 1) * NanosecondsPerSecond / subsystem.myTicksPerSecond;
+        int64_t nanoseconds = aNanoseconds;
+        if (nanoseconds > maxNanoseconds)
+        {
+            subsystem.myDroppedNanoseconds += nanoseconds - maxNanoseconds;
+            nanoseconds = maxNanoseconds;
+        }
+
+        subsystem.myAccumulator += nanoseconds * subsystem.myTicksPerSecond;
+        int64_t ticks = subsystem.myAccumulator / NanosecondsPerSecond;
+        subsystem.myAccumulator -= ticks * NanosecondsPerSecond;
+
+        if (ticks > subsystem.myMaxTicksPerFrame)
+        {
+            subsystem.myDroppedNanoseconds += (ticks - subsystem.myMaxTicksPerFrame) * NanosecondsPerSecond / subsystem.myTicksPerSecond;
+            ticks = subsystem.myMaxTicksPerFrame;
+        }
+
+        subsystem.myTickCount = static_cast<int>(ticks);
+        subsystem.myTotalTickCount += ticks;
+    }
+}
+
+int CommonUtilities::FixedTimestep::GetTickCount(int aSubsystem) const
+{
+    return mySubsystems[aSubsystem].myTickCount;
+}
+
+float CommonUtilities::FixedTimestep::GetAlpha(int aSubsystem) const
+{
+    return static_cast<float>(static_cast<double>(mySubsystems[aSubsystem].myAccumulator) / NanosecondsPerSecond);
+}
+
+float CommonUtilities::FixedTimestep::GetStepTime(int aSubsystem) const
+{
+    return 1.0f / mySubsystems[aSubsystem].myTicksPerSecond;
+}
+
+int64_t CommonUtilities::FixedTimestep::GetStepNanoseconds(int aSubsystem) const
+{
+    return NanosecondsPerSecond / mySubsystems[aSubsystem].myTicksPerSecond;
+}
+
+int64_t CommonUtilities::FixedTimestep::GetTotalTickCount(int aSubsystem) const
+{
+    return mySubsystems[aSubsystem].myTotalTickCount;
+}
+
+int64_t CommonUtilities::FixedTimestep::GetDroppedNanoseconds(int aSubsystem) const
+{
+    return mySubsystems[aSubsystem].myDroppedNanoseconds;
+}
+
+void CommonUtilities::FixedTimestep::Reset()
+{
+    for (Subsystem& subsystem : mySubsystems)
+    {
+        subsystem.myAccumulator = 0;
+        subsystem.myTickCount = 0;
+        subsystem.myTotalTickCount = 0;
+        subsystem.myDroppedNanoseconds = 0;
+    }
+}
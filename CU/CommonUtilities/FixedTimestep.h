@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace CommonUtilities
+{
+	class Timer;
+
+	// Turns variable frame times into fixed simulation ticks for any number of subsystems running at their
+	// own rates from the same clock. Time is accumulated as integer nanoseconds times the tick rate, so a
+	// subsystem ticks exactly aTicksPerSecond times per second of clock time, with no rounding drift.
+	//
+	//	fixedTimestep.Update(timer);
+	//	for (int tick = 0; tick < fixedTimestep.GetTickCount(physics); ++tick)
+	//		physicsWorld.Step(fixedTimestep.GetStepTime(physics));
+	//	renderer.Render(fixedTimestep.GetAlpha(physics));
+	class FixedTimestep
+	{
+	public:
+		FixedTimestep() = default;
+
+		// Adds a subsystem and returns its index. At most aMaxTicksPerFrame ticks are run per frame, time
+		// beyond that is dropped so a slow frame cannot make the next frames slower (spiral of death).
+		int AddSubsystem(int aTicksPerSecond, int aMaxTicksPerFrame = 8);
+
+		// Adds the delta time of aTimer's last Update.
+		void Update(const Timer& aTimer);
+		void Advance(int64_t aNanoseconds);
+
+		// Ticks to run this frame.
+		int GetTickCount(int aSubsystem) const;
+
+		// How far the clock is between the last tick and the next, 0 to 1, for interpolating rendered state.
+		float GetAlpha(int aSubsystem) const;
+
+		float GetStepTime(int aSubsystem) const;
+		int64_t GetStepNanoseconds(int aSubsystem) const;
+
+		// Ticks run since the subsystem was added, including this frame's.
+		int64_t GetTotalTickCount(int aSubsystem) const;
+
+		// Clock time that was dropped by the tick limit.
+		int64_t GetDroppedNanoseconds(int aSubsystem) const;
+
+		void Reset();
+
+	private:
+		static const int64_t NanosecondsPerSecond = 1000000000;
+
+		struct Subsystem
+		{
+			int64_t myTicksPerSecond;
+			int myMaxTicksPerFrame;
+			// Nanoseconds times myTicksPerSecond, a tick is due for every NanosecondsPerSecond.
+			int64_t myAccumulator;
+			int myTickCount;
+			int64_t myTotalTickCount;
+			int64_t myDroppedNanoseconds;
+		};
+
+		std::vector<Subsystem> mySubsystems;
+	};
+}
+
+namespace CU = CommonUtilities;
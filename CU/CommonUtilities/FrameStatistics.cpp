@@ -0,0 +1,234 @@
+#include "pch.h"
+#include "FrameStatistics.h"
+#include <assert.h>
+#include <math.h>
+
+CommonUtilities::FrameStatistics::FrameStatistics(int aWindowSize)
+    : myFrames(aWindowSize > 0 ? aWindowSize : 1, 0.0f)
+    , myBuckets(BucketCount, 0)
+{
+    assert(aWindowSize > 0 && "Frame statistics window must hold at least one frame.");
+    for (int threshold = 0; threshold < MaxHitchThresholds; ++threshold)
+    {
+        myHitchThresholds[threshold] = 0.0f;
+        myHitchCounts[threshold] = 0;
+        myTotalHitchCounts[threshold] = 0;
+    }
+}
+
+void CommonUtilities::FrameStatistics::AddFrame(float aDeltaTime)
+{
+    if (myFrameCount == static_cast<int>(myFrames.size()))
+    {
+        Count(myFrames[myNextFrame], -1);
+    }
+    else
+    {
+        ++myFrameCount;
+    }
+
+    myFrames[myNextFrame] = aDeltaTime;
+    myNextFrame = myNextFrame + 1 == static_cast<int>(myFrames.size()) ? 0 : myNextFrame + 1;
+    Count(aDeltaTime, 1);
+
+    for (int threshold = 0; threshold < myHitchThresholdCount; ++threshold)
+    {
+        if (aDeltaTime > myHitchThresholds[threshold])
+        {
+            ++myTotalHitchCounts[threshold];
+        }
+    }
+}
+
+int CommonUtilities::FrameStatistics::AddHitchThreshold(float aSeconds)
+{
+    assert(myHitchThresholdCount < MaxHitchThresholds && "Too many hitch thresholds.");
+    const int threshold = myHitchThresholdCount++;
+    myHitchThresholds[threshold] = aSeconds;
+    myHitchCounts[threshold] = 0;
+    myTotalHitchCounts[threshold] = 0;
+
+    // Counts the frames already in the window.
+    for (int frame = 0; frame < myFrameCount; ++frame)
+    {
+        if (myFrames[frame] > aSeconds)
+        {
+            ++myHitchCounts[threshold];
+        }
+    }
+    return threshold;
+}
+
+void CommonUtilities::FrameStatistics::Reset()
+{
+    for (uint32_t& bucket : myBuckets)
+    {
+        bucket = 0;
+    }
+    myNextFrame = 0;
+    myFrameCount = 0;
+    mySum = 0.0;
+    mySumSqr = 0.0;
+    for (int threshold = 0; threshold < myHitchThresholdCount; ++threshold)
+    {
+        myHitchCounts[threshold] = 0;
+        myTotalHitchCounts[threshold] = 0;
+    }
+}
+
+int CommonUtilities::FrameStatistics::GetFrameCount() const
+{
+    return myFrameCount;
+}
+
+int CommonUtilities::FrameStatistics::GetWindowSize() const
+{
+    return static_cast<int>(myFrames.size());
+}
+
+float CommonUtilities::FrameStatistics::GetMin() const
+{
+    if (myFrameCount == 0)
+    {
+        return 0.0f;
+    }
+
+    // The window is only scanned when asked, so AddFrame does not have to track what leaves it.
+    float min = myFrames[0];
+    for (int frame = 1; frame < myFrameCount; ++frame)
+    {
+        min = myFrames[frame] < min ? myFrames[frame] : min;
+    }
+    return min;
+}
+
+float CommonUtilities::FrameStatistics::GetMax() const
+{
+    if (myFrameCount == 0)
+    {
+        return 0.0f;
+    }
+
+    float max = myFrames[0];
+    for (int frame = 1; frame < myFrameCount; ++frame)
+    {
+        max = myFrames[frame] > max ? myFrames[frame] : max;
+    }
+    return max;
+}
+
+float CommonUtilities::FrameStatistics::GetMean() const
+{
+    return myFrameCount > 0 ? static_cast<float>(mySum / myFrameCount) : 0.0f;
+}
+
+float CommonUtilities::FrameStatistics::GetStandardDeviation() const
+{
+    if (myFrameCount == 0)
+    {
+        return 0.0f;
+    }
+
+    const double mean = mySum / myFrameCount;
+    const double variance = mySumSqr / myFrameCount - mean * mean;
+    return variance > 0.0 ? static_cast<float>(sqrt(variance)) : 0.0f;
+}
+
+float CommonUtilities::FrameStatistics::GetPercentile(float aPercentile) const
+{
+    if (myFrameCount == 0)
+    {
+        return 0.0f;
+    }
+
+    const float fraction = aPercentile < 0.0f ? 0.0f : (aPercentile > 100.0f ? 1.0f : aPercentile / 100.0f);
+    uint32_t rank = static_cast<uint32_t>(ceil(fraction * myFrameCount));
+    rank = rank < 1 ? 1 : rank;
+
+    uint32_t seen = 0;
+    int bucket = 0;
+    for (; bucket < BucketCount - 1; ++bucket)
+    {
+        seen += myBuckets[bucket];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+
+    // A bucket can end past the slowest frame, which is known exactly.
+    const float value = (static_cast<float>(GetBucketEnd(bucket)) + 1.0f) / 1000000.0f;
+    const float max = GetMax();
+    return value < max ? value : max;
+}
+
+int CommonUtilities::FrameStatistics::GetHitchCount(int aThreshold) const
+{
+    assert(aThreshold >= 0 && aThreshold < myHitchThresholdCount && "Hitch threshold does not exist.");
+    return myHitchCounts[aThreshold];
+}
+
+int64_t CommonUtilities::FrameStatistics::GetTotalHitchCount(int aThreshold) const
+{
+    assert(aThreshold >= 0 && aThreshold < myHitchThresholdCount && "Hitch threshold does not exist.");
+    return myTotalHitchCounts[aThreshold];
+}
+
+uint32_t CommonUtilities::FrameStatistics::ToMicroseconds(float aSeconds)
+{
+    const float microseconds = aSeconds * 1000000.0f;
+    if (!(microseconds > 0.0f))
+    {
+        return 0;
+    }
+    return microseconds < 4294967295.0f ? static_cast<uint32_t>(microseconds) : 0xFFFFFFFF;
+}
+
+int CommonUtilities::FrameStatistics::GetBucket(uint32_t aMicroseconds)
+{
+    if (aMicroseconds < SubBucketCount)
+    {
+        return static_cast<int>(aMicroseconds);
+    }
+
+    int highestBit = 0;
+    for (int step = 16; step > 0; step >>= 1)
+    {
+        if ((aMicroseconds >> (highestBit + step)) != 0)
+        {
+            highestBit += step;
+        }
+    }
+
+    // Every power of two gets SubBucketCount buckets from the bits below the highest one.
+    const int shift = highestBit - SubBucketBits;
+    const int subBucket = static_cast<int>(aMicroseconds >> shift) - SubBucketCount;
+    return (shift + 1) * SubBucketCount + subBucket;
+}
+
+uint32_t CommonUtilities::FrameStatistics::GetBucketEnd(int aBucket)
+{
+    if (aBucket < SubBucketCount)
+    {
+        return static_cast<uint32_t>(aBucket);
+    }
+
+    const int shift = aBucket / SubBucketCount - 1;
+    const uint32_t start = static_cast<uint32_t>(SubBucketCount + aBucket % SubBucketCount) << shift;
+    return start + ((1u << shift) - 1);
+}
+
+void CommonUtilities::FrameStatistics::Count(float aDeltaTime, int aDirection)
+{
+    myBuckets[GetBucket(ToMicroseconds(aDeltaTime))] += aDirection;
+    mySum += aDirection * static_cast<double>(aDeltaTime);
+    mySumSqr += aDirection * static_cast<double>(aDeltaTime) * aDeltaTime;
+
+    for (int threshold = 0; threshold < myHitchThresholdCount; ++threshold)
+    {
+        if (aDeltaTime > myHitchThresholds[threshold])
+        {
+            myHitchCounts[threshold] += aDirection;
+        }
+    }
+}
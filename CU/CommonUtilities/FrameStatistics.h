@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace CommonUtilities
+{
+	// Statistics over the last frames. Every frame time is kept in a ring of the window size and counted in a
+	// histogram with logarithmic buckets (HDR style: 32 linear sub buckets per power of two of microseconds,
+	// about 3% precision), so percentiles need no sorting. Memory is allocated once in the constructor,
+	// AddFrame never allocates.
+	class FrameStatistics
+	{
+	public:
+		static const int MaxHitchThresholds = 4;
+
+		explicit FrameStatistics(int aWindowSize = 300);
+
+		// Adds a frame time in seconds. When the window is full the oldest frame is removed.
+		void AddFrame(float aDeltaTime);
+
+		// Frames longer than aSeconds are counted as hitches. Returns the index for GetHitchCount.
+		int AddHitchThreshold(float aSeconds);
+
+		void Reset();
+
+		int GetFrameCount() const;
+		int GetWindowSize() const;
+
+		// The statistics below are over the frames in the window and 0 when it is empty.
+		float GetMin() const;
+		float GetMax() const;
+		float GetMean() const;
+		float GetStandardDeviation() const;
+
+		// Frame time that aPercentile (0 to 100) percent of the frames are at or below, for example 99 for p99.
+		// Rounded up to the end of its histogram bucket, frames over about 71 minutes share the last bucket.
+		float GetPercentile(float aPercentile) const;
+
+		// Hitches in the window and since the last Reset.
+		int GetHitchCount(int aThreshold) const;
+		int64_t GetTotalHitchCount(int aThreshold) const;
+
+	private:
+		static const int SubBucketBits = 5;
+		static const int SubBucketCount = 1 << SubBucketBits;
+		static const int BucketCount = (32 - SubBucketBits + 1) * SubBucketCount;
+
+		static uint32_t ToMicroseconds(float aSeconds);
+		static int GetBucket(uint32_t aMicroseconds);
+		static uint32_t GetBucketEnd(int aBucket);
+
+		void Count(float aDeltaTime, int aDirection);
+
+		std::vector<float> myFrames;
+		std::vector<uint32_t> myBuckets;
+		int myNextFrame = 0;
+		int myFrameCount = 0;
+		// Running sums of the window, double so removing frames does not drift noticeably.
+		double mySum = 0.0;
+		double mySumSqr = 0.0;
+
+		float myHitchThresholds[MaxHitchThresholds];
+		int myHitchCounts[MaxHitchThresholds];
+		int64_t myTotalHitchCounts[MaxHitchThresholds];
+		int myHitchThresholdCount = 0;
+	};
+}
+
+namespace CU = CommonUtilities;
@@ -0,0 +1,480 @@
+#include "pch.h"
+#include "Frustum.h"
+#include "IntersectionSIMD.hpp"
+#include "Maths.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Objects per thread are rounded to this so threads never share a mask word.
+    const int BitsPerWord = 32;
+
+    struct FrustumPlanes
+    {
+        float myNormalX[CommonUtilities::Frustum::PlaneCount];
+        float myNormalY[CommonUtilities::Frustum::PlaneCount];
+        float myNormalZ[CommonUtilities::Frustum::PlaneCount];
+        float myDistance[CommonUtilities::Frustum::PlaneCount];
+    };
+
+    class SphereTester
+    {
+    public:
+        SphereTester(const FrustumPlanes& somePlanes, const CommonUtilities::SphereArrays& someSpheres)
+            : myPlanes(somePlanes)
+            , mySpheres(someSpheres)
+        {
+        }
+
+        int Test1(const int anIndex) const
+        {
+            const float x = mySpheres.myCenterX[anIndex];
+            const float y = mySpheres.myCenterY[anIndex];
+            const float z = mySpheres.myCenterZ[anIndex];
+            const float negativeRadius = -mySpheres.myRadius[anIndex];
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                const float distance = myPlanes.myNormalX[plane] * x + myPlanes.myNormalY[plane] * y + myPlanes.myNormalZ[plane] * z + myPlanes.myDistance[plane];
+                if (distance < negativeRadius)
+                {
+                    return 0;
+                }
+            }
+            return 1;
+        }
+
+#if defined(CU_SIMD_SSE)
+        int Test4(const int anIndex) const
+        {
+            const __m128 x = _mm_loadu_ps(mySpheres.myCenterX + anIndex);
+            const __m128 y = _mm_loadu_ps(mySpheres.myCenterY + anIndex);
+            const __m128 z = _mm_loadu_ps(mySpheres.myCenterZ + anIndex);
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(mySpheres.myRadius + anIndex));
+
+            __m128 visible = _mm_cmpeq_ps(x, x);
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(myPlanes.myNormalX[plane]), x), _mm_mul_ps(_mm_set1_ps(myPlanes.myNormalY[plane]), y)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(myPlanes.myNormalZ[plane]), z), _mm_set1_ps(myPlanes.myDistance[plane])));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            return _mm_movemask_ps(visible);
+        }
+#endif
+
+#if defined(CU_SIMD_AVX)
+        int Test8(const int anIndex) const
+        {
+            const __m256 x = _mm256_loadu_ps(mySpheres.myCenterX + anIndex);
+            const __m256 y = _mm256_loadu_ps(mySpheres.myCenterY + anIndex);
+            const __m256 z = _mm256_loadu_ps(mySpheres.myCenterZ + anIndex);
+            const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(mySpheres.myRadius + anIndex));
+
+            __m256 visible = _mm256_cmp_ps(x, x, _CMP_EQ_OQ);
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                const __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myPlanes.myNormalX[plane]), x), _mm256_mul_ps(_mm256_set1_ps(myPlanes.myNormalY[plane]), y)),
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myPlanes.myNormalZ[plane]), z), _mm256_set1_ps(myPlanes.myDistance[plane])));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            return _mm256_movemask_ps(visible);
+        }
+#endif
+
+    private:
+        FrustumPlanes myPlanes;
+        CommonUtilities::SphereArrays mySpheres;
+    };
+
+    // A box is outside a plane when its center is further behind it than the box reaches along the
+    // plane normal, which is the extents dotted with the absolute normal.
+    class AABBTester
+    {
+    public:
+        AABBTester(const FrustumPlanes& somePlanes, const CommonUtilities::AABBArrays& someAABBs)
+            : myPlanes(somePlanes)
+            , myAABBs(someAABBs)
+        {
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                myAbsoluteNormals.myNormalX[plane] = std::fabs(somePlanes.myNormalX[plane]);
+                myAbsoluteNormals.myNormalY[plane] = std::fabs(somePlanes.myNormalY[plane]);
+                myAbsoluteNormals.myNormalZ[plane] = std::fabs(somePlanes.myNormalZ[plane]);
+                myAbsoluteNormals.myDistance[plane] = 0.0f;
+            }
+        }
+
+        int Test1(const int anIndex) const
+        {
+            const float x = myAABBs.myCenterX[anIndex];
+            const float y = myAABBs.myCenterY[anIndex];
+            const float z = myAABBs.myCenterZ[anIndex];
+            const float extentX = myAABBs.myExtentX[anIndex];
+            const float extentY = myAABBs.myExtentY[anIndex];
+            const float extentZ = myAABBs.myExtentZ[anIndex];
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                const float distance = myPlanes.myNormalX[plane] * x + myPlanes.myNormalY[plane] * y + myPlanes.myNormalZ[plane] * z + myPlanes.myDistance[plane];
+                const float reach = myAbsoluteNormals.myNormalX[plane] * extentX + myAbsoluteNormals.myNormalY[plane] * extentY + myAbsoluteNormals.myNormalZ[plane] * extentZ;
+                if (distance + reach < 0.0f)
+                {
+                    return 0;
+                }
+            }
+            return 1;
+        }
+
+#if defined(CU_SIMD_SSE)
+        int Test4(const int anIndex) const
+        {
+            const __m128 x = _mm_loadu_ps(myAABBs.myCenterX + anIndex);
+            const __m128 y = _mm_loadu_ps(myAABBs.myCenterY + anIndex);
+            const __m128 z = _mm_loadu_ps(myAABBs.myCenterZ + anIndex);
+            const __m128 extentX = _mm_loadu_ps(myAABBs.myExtentX + anIndex);
+            const __m128 extentY = _mm_loadu_ps(myAABBs.myExtentY + anIndex);
+            const __m128 extentZ = _mm_loadu_ps(myAABBs.myExtentZ + anIndex);
+
+            __m128 visible = _mm_cmpeq_ps(x, x);
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(myPlanes.myNormalX[plane]), x), _mm_mul_ps(_mm_set1_ps(myPlanes.myNormalY[plane]), y)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(myPlanes.myNormalZ[plane]), z), _mm_set1_ps(myPlanes.myDistance[plane])));
+                const __m128 reach = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(myAbsoluteNormals.myNormalX[plane]), extentX), _mm_mul_ps(_mm_set1_ps(myAbsoluteNormals.myNormalY[plane]), extentY)),
+                    _mm_mul_ps(_mm_set1_ps(myAbsoluteNormals.myNormalZ[plane]), extentZ));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+            }
+            return _mm_movemask_ps(visible);
+        }
+#endif
+
+#if defined(CU_SIMD_AVX)
+        int Test8(const int anIndex) const
+        {
+            const __m256 x = _mm256_loadu_ps(myAABBs.myCenterX + anIndex);
+            const __m256 y = _mm256_loadu_ps(myAABBs.myCenterY + anIndex);
+            const __m256 z = _mm256_loadu_ps(myAABBs.myCenterZ + anIndex);
+            const __m256 extentX = _mm256_loadu_ps(myAABBs.myExtentX + anIndex);
+            const __m256 extentY = _mm256_loadu_ps(myAABBs.myExtentY + anIndex);
+            const __m256 extentZ = _mm256_loadu_ps(myAABBs.myExtentZ + anIndex);
+
+            __m256 visible = _mm256_cmp_ps(x, x, _CMP_EQ_OQ);
+            for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+            {
+                const __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myPlanes.myNormalX[plane]), x), _mm256_mul_ps(_mm256_set1_ps(myPlanes.myNormalY[plane]), y)),
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myPlanes.myNormalZ[plane]), z), _mm256_set1_ps(myPlanes.myDistance[plane])));
+                const __m256 reach = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myAbsoluteNormals.myNormalX[plane]), extentX), _mm256_mul_ps(_mm256_set1_ps(myAbsoluteNormals.myNormalY[plane]), extentY)),
+                    _mm256_mul_ps(_mm256_set1_ps(myAbsoluteNormals.myNormalZ[plane]), extentZ));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+            return _mm256_movemask_ps(visible);
+        }
+#endif
+
+    private:
+        FrustumPlanes myPlanes;
+        FrustumPlanes myAbsoluteNormals;
+        CommonUtilities::AABBArrays myAABBs;
+    };
+
+    // Calls aVisitor(blockFirst, mask) for consecutive blocks of [aFirst, anEnd), using the widest
+    // test that fits. Blocks never cross a multiple of BitsPerWord when aFirst is one.
+    template<typename Tester, typename Visitor>
+    void VisitBlocks(const Tester& aTester, const int aFirst, const int anEnd, Visitor& aVisitor)
+    {
+        int index = aFirst;
+#if defined(CU_SIMD_AVX)
+        for (; index + 8 <= anEnd; index += 8)
+        {
+            aVisitor(index, aTester.Test8(index));
+        }
+#endif
+#if defined(CU_SIMD_SSE)
+        for (; index + 4 <= anEnd; index += 4)
+        {
+            aVisitor(index, aTester.Test4(index));
+        }
+#endif
+        for (; index < anEnd; ++index)
+        {
+            aVisitor(index, aTester.Test1(index));
+        }
+    }
+
+    class MaskWriter
+    {
+    public:
+        explicit MaskWriter(uint32_t* someOutMask)
+            : myMask(someOutMask)
+        {
+        }
+
+        void operator()(const int anIndex, const int aBits)
+        {
+            myMask[anIndex / BitsPerWord] |= static_cast<uint32_t>(aBits) << (anIndex % BitsPerWord);
+        }
+
+    private:
+        uint32_t* myMask;
+    };
+
+    class IndexWriter
+    {
+    public:
+        explicit IndexWriter(int* someOutIndices)
+            : myIndices(someOutIndices)
+            , myCount(0)
+        {
+        }
+
+        void operator()(const int anIndex, int aBits)
+        {
+            for (int index = anIndex; aBits != 0; ++index, aBits >>= 1)
+            {
+                myIndices[myCount] = index;
+                myCount += aBits & 1;
+            }
+        }
+
+        int GetCount() const
+        {
+            return myCount;
+        }
+
+    private:
+        int* myIndices;
+        int myCount;
+    };
+
+    template<typename Tester>
+    void CullRangeToMask(const Tester& aTester, const int aFirst, const int anEnd, uint32_t* someOutMask)
+    {
+        std::fill(someOutMask + aFirst / BitsPerWord, someOutMask + (anEnd + BitsPerWord - 1) / BitsPerWord, 0u);
+        MaskWriter writer(someOutMask);
+        VisitBlocks(aTester, aFirst, anEnd, writer);
+    }
+
+    template<typename Tester>
+    void CullRangeToIndices(const Tester& aTester, const int aFirst, const int anEnd, int* someOutIndices, int* aOutCount)
+    {
+        IndexWriter writer(someOutIndices);
+        VisitBlocks(aTester, aFirst, anEnd, writer);
+        *aOutCount = writer.GetCount();
+    }
+
+    int GetObjectsPerThread(const int aCount, const int aThreadCount)
+    {
+        const int perThread = (aCount + aThreadCount - 1) / aThreadCount;
+        return (perThread + BitsPerWord - 1) / BitsPerWord * BitsPerWord;
+    }
+
+    FrustumPlanes MakeFrustumPlanes(const CommonUtilities::Vector3<float>* someNormals, const float* someDistances)
+    {
+        FrustumPlanes planes;
+        for (int plane = 0; plane < CommonUtilities::Frustum::PlaneCount; ++plane)
+        {
+            planes.myNormalX[plane] = someNormals[plane].x;
+            planes.myNormalY[plane] = someNormals[plane].y;
+            planes.myNormalZ[plane] = someNormals[plane].z;
+            planes.myDistance[plane] = someDistances[plane];
+        }
+        return planes;
+    }
+
+    SphereTester MakeTester(const FrustumPlanes& somePlanes, const CommonUtilities::SphereArrays& someSpheres)
+    {
+        return SphereTester(somePlanes, someSpheres);
+    }
+
+    AABBTester MakeTester(const FrustumPlanes& somePlanes, const CommonUtilities::AABBArrays& someAABBs)
+    {
+        return AABBTester(somePlanes, someAABBs);
+    }
+}
+
+CommonUtilities::Frustum::Frustum()
+{
+    for (int plane = 0; plane < PlaneCount; ++plane)
+    {
+        SetPlane(plane, 0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+CommonUtilities::Frustum::Frustum(const Matrix4x4<float>& aViewProjection)
+{
+    InitWithViewProjection(aViewProjection);
+}
+
+void CommonUtilities::Frustum::InitWithViewProjection(const Matrix4x4<float>& aViewProjection)
+{
+    // With row vectors clip = (x, y, z, 1) * M, so every clip coordinate is a position dotted with a column.
+    const Matrix4x4<float>& m = aViewProjection;
+    SetPlane(Left, m(1, 4) + m(1, 1), m(2, 4) + m(2, 1), m(3, 4) + m(3, 1), m(4, 4) + m(4, 1));
+    SetPlane(Right, m(1, 4) - m(1, 1), m(2, 4) - m(2, 1), m(3, 4) - m(3, 1), m(4, 4) - m(4, 1));
+    SetPlane(Bottom, m(1, 4) + m(1, 2), m(2, 4) + m(2, 2), m(3, 4) + m(3, 2), m(4, 4) + m(4, 2));
+    SetPlane(Top, m(1, 4) - m(1, 2), m(2, 4) - m(2, 2), m(3, 4) - m(3, 2), m(4, 4) - m(4, 2));
+    SetPlane(Near, m(1, 3), m(2, 3), m(3, 3), m(4, 3));
+    SetPlane(Far, m(1, 4) - m(1, 3), m(2, 4) - m(2, 3), m(3, 4) - m(3, 3), m(4, 4) - m(4, 3));
+}
+
+void CommonUtilities::Frustum::InitWithPlanes(const Plane<float>* somePlanes)
+{
+    for (int plane = 0; plane < PlaneCount; ++plane)
+    {
+        const Vector3<float>& normal = somePlanes[plane].GetNormal();
+        SetPlane(plane, -normal.x, -normal.y, -normal.z, normal.Dot(somePlanes[plane].GetPoint()));
+    }
+}
+
+CommonUtilities::PlaneVolume<float> CommonUtilities::Frustum::GetPlaneVolume() const
+{
+    PlaneVolume<float> volume;
+    for (int plane = 0; plane < PlaneCount; ++plane)
+    {
+        const Vector3<float>& normal = myNormals[plane];
+        volume.AddPlane(Plane<float>(normal * -myDistances[plane], normal * -1.0f));
+    }
+    return volume;
+}
+
+bool CommonUtilities::Frustum::IsInside(const Vector3<float>& aPosition) const
+{
+    for (int plane = 0; plane < PlaneCount; ++plane)
+    {
+        if (myNormals[plane].Dot(aPosition) + myDistances[plane] < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CommonUtilities::Frustum::IsVisible(const Sphere<float>& aSphere) const
+{
+    const SphereArrays spheres = { &aSphere.GetCenter().x, &aSphere.GetCenter().y, &aSphere.GetCenter().z, &aSphere.GetRadius() };
+    return SphereTester(MakeFrustumPlanes(myNormals, myDistances), spheres).Test1(0) != 0;
+}
+
+bool CommonUtilities::Frustum::IsVisible(const AABB3D<float>& anAABB) const
+{
+    const Vector3<float> center = (anAABB.myMinPoint + anAABB.myMaxPoint) * 0.5f;
+    const Vector3<float> extent = (anAABB.myMaxPoint - anAABB.myMinPoint) * 0.5f;
+    const AABBArrays aabbs = { &center.x, &center.y, &center.z, &extent.x, &extent.y, &extent.z };
+    return AABBTester(MakeFrustumPlanes(myNormals, myDistances), aabbs).Test1(0) != 0;
+}
+
+void CommonUtilities::Frustum::CullSpheres(const SphereArrays& someSpheres, int aCount, uint32_t* someOutMask, int aThreadCount) const
+{
+    CullToMask(someSpheres, aCount, someOutMask, aThreadCount);
+}
+
+int CommonUtilities::Frustum::CullSpheresToIndices(const SphereArrays& someSpheres, int aCount, int* someOutIndices, int aThreadCount) const
+{
+    return CullToIndices(someSpheres, aCount, someOutIndices, aThreadCount);
+}
+
+void CommonUtilities::Frustum::CullAABBs(const AABBArrays& someAABBs, int aCount, uint32_t* someOutMask, int aThreadCount) const
+{
+    CullToMask(someAABBs, aCount, someOutMask, aThreadCount);
+}
+
+int CommonUtilities::Frustum::CullAABBsToIndices(const AABBArrays& someAABBs, int aCount, int* someOutIndices, int aThreadCount) const
+{
+    return CullToIndices(someAABBs, aCount, someOutIndices, aThreadCount);
+}
+
+const CommonUtilities::Vector3<float>& CommonUtilities::Frustum::GetNormal(const int aPlane) const
+{
+    assert(aPlane >= 0 && aPlane < PlaneCount && "Plane index out of range.");
+    return myNormals[aPlane];
+}
+
+float CommonUtilities::Frustum::GetDistance(const int aPlane) const
+{
+    assert(aPlane >= 0 && aPlane < PlaneCount && "Plane index out of range.");
+    return myDistances[aPlane];
+}
+
+template<typename Arrays>
+void CommonUtilities::Frustum::CullToMask(const Arrays& someObjects, int aCount, uint32_t* someOutMask, int aThreadCount) const
+{
+    const auto tester = MakeTester(MakeFrustumPlanes(myNormals, myDistances), someObjects);
+
+    const int perThread = GetObjectsPerThread(aCount, Max(1, aThreadCount));
+    if (perThread >= aCount)
+    {
+        CullRangeToMask(tester, 0, aCount, someOutMask);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (int first = perThread; first < aCount; first += perThread)
+    {
+        workers.emplace_back(CullRangeToMask<decltype(tester)>, std::cref(tester), first, Min(first + perThread, aCount), someOutMask);
+    }
+    CullRangeToMask(tester, 0, perThread, someOutMask);
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+template<typename Arrays>
+int CommonUtilities::Frustum::CullToIndices(const Arrays& someObjects, int aCount, int* someOutIndices, int aThreadCount) const
+{
+    const auto tester = MakeTester(MakeFrustumPlanes(myNormals, myDistances), someObjects);
+
+    const int perThread = GetObjectsPerThread(aCount, Max(1, aThreadCount));
+    if (perThread >= aCount)
+    {
+        int count;
+        CullRangeToIndices(tester, 0, aCount, someOutIndices, &count);
+        return count;
+    }
+
+    // Every thread compacts its own range in place, the ranges are then moved together.
+    const int threadCount = (aCount + perThread - 1) / perThread;
+    std::vector<int> counts(threadCount);
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount - 1);
+    for (int thread = 1; thread < threadCount; ++thread)
+    {
+        const int first = thread * perThread;
+        workers.emplace_back(CullRangeToIndices<decltype(tester)>, std::cref(tester), first, Min(first + perThread, aCount), someOutIndices + first, &counts[thread]);
+    }
+    CullRangeToIndices(tester, 0, perThread, someOutIndices, &counts[0]);
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    int count = counts[0];
+    for (int thread = 1; thread < threadCount; ++thread)
+    {
+        const int* first = someOutIndices + thread * perThread;
+        std::copy(first, first + counts[thread], someOutIndices + count);
+        count += counts[thread];
+    }
+    return count;
+}
+
+void CommonUtilities::Frustum::SetPlane(const int aPlane, const float aX, const float aY, const float aZ, const float aDistance)
+{
+    // Normalized so the distance to the plane can be compared against sphere radii.
+    const float length = std::sqrt(aX * aX + aY * aY + aZ * aZ);
+    const float scale = length > 0.0f ? 1.0f / length : 1.0f;
+    myNormals[aPlane] = Vector3<float>(aX * scale, aY * scale, aZ * scale);
+    myDistances[aPlane] = aDistance * scale;
+}
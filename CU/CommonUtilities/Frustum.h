@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include "Vector3.hpp"
+#include "Matrix4x4.hpp"
+#include "Plane.hpp"
+#include "PlaneVolume.hpp"
+#include "AABB3D.hpp"
+#include "Sphere.hpp"
+#include "IntersectionSIMD.hpp"
+
+namespace CommonUtilities
+{
+	// Six planes stored as (normal, distance) with the normals pointing into the frustum, a point p is
+	// inside a plane when normal.Dot(p) + distance >= 0. The batch tests run 8 objects per step with AVX,
+	// 4 with SSE and one at a time otherwise. They are conservative: objects crossing a plane count as visible.
+	class Frustum
+	{
+	public:
+		enum PlaneIndex
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			PlaneCount
+		};
+
+		// Default constructor: every plane accepts everything.
+		Frustum();
+
+		// Extracts the planes from a view-projection matrix using row vectors (clip = position * matrix) and
+		// a depth range of 0 to w.
+		explicit Frustum(const Matrix4x4<float>& aViewProjection);
+
+		void InitWithViewProjection(const Matrix4x4<float>& aViewProjection);
+
+		// Init from six planes in PlaneIndex order. Plane normals point out of the volume, as in PlaneVolume.
+		void InitWithPlanes(const Plane<float>* somePlanes);
+
+		// Returns a PlaneVolume with the same planes.
+		PlaneVolume<float> GetPlaneVolume() const;
+
+		bool IsInside(const Vector3<float>& aPosition) const;
+		bool IsVisible(const Sphere<float>& aSphere) const;
+		bool IsVisible(const AABB3D<float>& anAABB) const;
+
+		// Writes one bit per sphere to someOutMask, bit i % 32 of word i / 32 is set when sphere i is visible.
+		// someOutMask must hold (aCount + 31) / 32 words. The work is split over aThreadCount threads.
+		void CullSpheres(const SphereArrays& someSpheres, int aCount, uint32_t* someOutMask, int aThreadCount = 1) const;
+
+		// Writes the indices of the visible spheres in increasing order to someOutIndices and returns how many
+		// there are. someOutIndices must hold aCount indices, the threaded version uses all of it as scratch.
+		int CullSpheresToIndices(const SphereArrays& someSpheres, int aCount, int* someOutIndices, int aThreadCount = 1) const;
+
+		// Same as CullSpheres for boxes.
+		void CullAABBs(const AABBArrays& someAABBs, int aCount, uint32_t* someOutMask, int aThreadCount = 1) const;
+
+		// Same as CullSpheresToIndices for boxes.
+		int CullAABBsToIndices(const AABBArrays& someAABBs, int aCount, int* someOutIndices, int aThreadCount = 1) const;
+
+		const Vector3<float>& GetNormal(const int aPlane) const;
+		float GetDistance(const int aPlane) const;
+
+	private:
+		template<typename Arrays>
+		void CullToMask(const Arrays& someObjects, int aCount, uint32_t* someOutMask, int aThreadCount) const;
+		template<typename Arrays>
+		int CullToIndices(const Arrays& someObjects, int aCount, int* someOutIndices, int aThreadCount) const;
+
+		void SetPlane(const int aPlane, const float aX, const float aY, const float aZ, const float aDistance);
+
+		Vector3<float> myNormals[PlaneCount];
+		float myDistances[PlaneCount];
+	};
+}
+
+namespace CU = CommonUtilities;
@@ -25,11 +25,16 @@ namespace CommonUtilities
 		void Fill();
 		void Clear();
 		void Insert(T aObject, const int& aIndex);
+		// Sets the element count, new elements are default constructed.
+		void Resize(const int& aCount);
 
 		const int& Size() const;
 		const int& ReservedSize() const;
 
 		T* GetElementAtIndex(const int& anIndex);
+		// The elements, stored back to back.
+		T* GetData();
+		const T* GetData() const;
 		const int GetIndexOfElement(T aObject);
 
 	private:
@@ -199,6 +204,23 @@ namespace CommonUtilities
 		myArray[aIndex] = aObject;
 	}
 
+	template<typename T>
+	void GrowingArray<T>::Resize(const int& aCount)
+	{
+		assert(aCount >= 0 && "Size can not be negative.");
+
+		// Add expects room for one more element than the count.
+		if (aCount >= mySize)
+		{
+			Reserve(aCount + 1);
+		}
+		for (int i = myElementCount; i < aCount; ++i)
+		{
+			myArray[i] = T();
+		}
+		myElementCount = aCount;
+	}
+
 	template<typename T>
 	const int& GrowingArray<T>::Size() const
 	{
@@ -217,6 +239,19 @@ namespace CommonUtilities
 		assert(anIndex >= 0 && anIndex < mySize && "Out of bounds.");
 		return myArray[anIndex];
 	}
+
+	template<typename T>
+	T* GrowingArray<T>::GetData()
+	{
+		return myArray;
+	}
+
+	template<typename T>
+	const T* GrowingArray<T>::GetData() const
+	{
+		return myArray;
+	}
+
 	template<typename T>
 	const int GrowingArray<T>::GetIndexOfElement(T aObject)
 	{
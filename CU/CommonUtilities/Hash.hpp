@@ -4,7 +4,7 @@
 
 namespace CommonUtilities
 {
-	uint32_t Hash(const uint8_t* aBuffer, int aCount)
+	inline uint32_t Hash(const uint8_t* aBuffer, int aCount)
 	{
 		const uint32_t FNVOffsetBasis = 2166136261U;
 		const uint32_t FNVPrime = 16777619U;
@@ -19,15 +19,28 @@ namespace CommonUtilities
 		return val;
 	}
 
-	uint32_t Hash(int aInt)
+	inline uint32_t Hash(int aInt)
 	{
 		return Hash(reinterpret_cast<const uint8_t*>(&aInt), sizeof(int));
 	}
 
-	uint32_t Hash(const std::string& aString)
+	inline uint32_t Hash(const std::string& aString)
 	{
 		return Hash(reinterpret_cast<const uint8_t*>(aString.c_str()), aString.size());
 	}
+
+	// Hash of an integer grid cell. The coordinates are combined with large primes and the
+	// result is finished with the MurmurHash3 mix so nearby cells spread over all bits.
+	inline uint32_t Hash(int32_t aX, int32_t aY, int32_t aZ)
+	{
+		uint32_t val = static_cast<uint32_t>(aX) * 73856093U ^ static_cast<uint32_t>(aY) * 19349663U ^ static_cast<uint32_t>(aZ) * 83492791U;
+		val ^= val >> 16;
+		val *= 0x85EBCA6BU;
+		val ^= val >> 13;
+		val *= 0xC2B2AE35U;
+		val ^= val >> 16;
+		return val;
+	}
 }
 
 namespace CU = CommonUtilities;
\ No newline at end of file
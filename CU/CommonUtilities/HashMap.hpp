@@ -44,6 +44,15 @@ namespace CommonUtilities
 		//Som ovan, men returnerar en icke-const-pekare.
 		Value* Get(const Key& aKey);
 
+		int GetCapacity() const;
+
+		// Removes every element.
+		void Clear();
+
+		// Calls aFunction(key, value) for every element.
+		template<typename Function>
+		void ForEach(const Function& aFunction) const;
+
 	private:
 		std::vector<HashSet<Key, Value>> myArray;
 		const int myCapacity = 0;
@@ -157,7 +166,7 @@ namespace CommonUtilities
 	const Value* HashMap<Key, Value>::Get(const Key& aKey) const
 	{
 		if (myCapacity == 0)
-			return false;
+			return nullptr;
 
 		int hashIndex = Hash(aKey) % myCapacity;
 
@@ -186,7 +195,7 @@ namespace CommonUtilities
 	Value* HashMap<Key, Value>::Get(const Key& aKey)
 	{
 		if (myCapacity == 0)
-			return false;
+			return nullptr;
 
 		int hashIndex = Hash(aKey) % myCapacity;
 
@@ -212,6 +221,34 @@ namespace CommonUtilities
 
 		return nullptr;
 	}
+
+	template <class Key, class Value>
+	int HashMap<Key, Value>::GetCapacity() const
+	{
+		return myCapacity;
+	}
+
+	template <class Key, class Value>
+	void HashMap<Key, Value>::Clear()
+	{
+		for (HashSet<Key, Value>& hashSet : myArray)
+		{
+			hashSet.myState = eState::Empty;
+		}
+	}
+
+	template <class Key, class Value>
+	template <typename Function>
+	void HashMap<Key, Value>::ForEach(const Function& aFunction) const
+	{
+		for (const HashSet<Key, Value>& hashSet : myArray)
+		{
+			if (hashSet.myState == eState::InUse)
+			{
+				aFunction(hashSet.myKey, hashSet.myValue);
+			}
+		}
+	}
 }
 
 namespace CU = CommonUtilities;
\ No newline at end of file
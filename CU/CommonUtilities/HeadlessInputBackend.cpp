@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "HeadlessInputBackend.h"
+#include "Input.h"
+#include <assert.h>
+
+CommonUtilities::HeadlessInputBackend::HeadlessInputBackend(Input& anInput)
+    : myEvents(anInput.GetEventRing())
+{
+}
+
+void CommonUtilities::HeadlessInputBackend::SetTime(int64_t aNanoseconds)
+{
+    myTime = aNanoseconds;
+}
+
+void CommonUtilities::HeadlessInputBackend::Advance(int64_t aNanoseconds)
+{
+    assert(aNanoseconds >= 0 && "Time can not go backwards.");
+    myTime += aNanoseconds;
+}
+
+int64_t CommonUtilities::HeadlessInputBackend::GetTime() const
+{
+    return myTime;
+}
+
+bool CommonUtilities::HeadlessInputBackend::PressKey(int aKeyCode)
+{
+    return Push(InputEventType::KeyDown, aKeyCode, 0, 0);
+}
+
+bool CommonUtilities::HeadlessInputBackend::ReleaseKey(int aKeyCode)
+{
+    return Push(InputEventType::KeyUp, aKeyCode, 0, 0);
+}
+
+bool CommonUtilities::HeadlessInputBackend::MoveMouse(int anX, int aY)
+{
+    return Push(InputEventType::MouseMove, 0, anX, aY);
+}
+
+bool CommonUtilities::HeadlessInputBackend::Push(InputEventType aType, int aKey, int anX, int aY)
+{
+    assert(aKey >= 0 && aKey < 256 && "Key codes are below 256.");
+
+    InputEvent event;
+    event.myTimestamp = myTime;
+    event.myType = aType;
+    event.myKey = static_cast<uint8_t>(aKey);
+    event.myX = anX;
+    event.myY = aY;
+    return myEvents.Push(event);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "InputEvent.h"
+
+namespace CommonUtilities
+{
+	class Input;
+
+	// Feeds an Input without a window, for tests and tools on any platform. Events are stamped with a clock
+	// the caller advances, so runs are repeatable.
+	class HeadlessInputBackend
+	{
+	public:
+		explicit HeadlessInputBackend(Input& anInput);
+
+		void SetTime(int64_t aNanoseconds);
+		void Advance(int64_t aNanoseconds);
+		int64_t GetTime() const;
+
+		// Each returns false when the event was dropped because the ring is full.
+		bool PressKey(int aKeyCode);
+		bool ReleaseKey(int aKeyCode);
+		bool MoveMouse(int anX, int aY);
+
+	private:
+		bool Push(InputEventType aType, int aKey, int anX, int aY);
+
+		InputEventRing& myEvents;
+		int64_t myTime = 0;
+	};
+}
+
+namespace CU = CommonUtilities;
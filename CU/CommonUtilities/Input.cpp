@@ -1,105 +1,144 @@
 #include "pch.h"
 #include "Input.h"
-#include <windowsx.h>
+#include "InputRecording.h"
 
+bool CommonUtilities::InputSnapshot::IsKeyDown(const int& aKeyCode) const
+{
+    return myDownKeys[aKeyCode];
+}
 
-CommonUtilities::Input::Input()
-    : myMousePoint(Point(0, 0))
+bool CommonUtilities::InputSnapshot::IsKeyPressed(const int& aKeyCode) const
 {
+    return myPressedKeys[aKeyCode];
 }
 
-bool CommonUtilities::Input::IsKeyDown(const int& aKeyCode) const
+bool CommonUtilities::InputSnapshot::IsKeyUp(const int& aKeyCode) const
 {
-    return myKeyState[aKeyCode].myIsDown;
+    return myUpKeys[aKeyCode];
 }
 
-bool CommonUtilities::Input::IsKeyPressed(const int& aKeyCode) const
+const CU::Point& CommonUtilities::InputSnapshot::GetMousePosition() const
 {
-    return myKeyState[aKeyCode].myIsPressed;
+    return myMousePosition;
 }
 
-bool CommonUtilities::Input::IsKeyUp(const int& aKeyCode) const
+const CU::Point& CommonUtilities::InputSnapshot::GetMouseDelta() const
 {
-    return myKeyState[aKeyCode].myIsUp;
+    return myMouseDelta;
 }
 
-CU::Point CommonUtilities::Input::GetMousePosition() const
+const std::bitset<CommonUtilities::InputSnapshot::KeyCount>& CommonUtilities::InputSnapshot::GetDownKeys() const
 {
-    return myMousePoint;
+    return myDownKeys;
 }
 
-bool CommonUtilities::Input::UpdateEvents(UINT message, WPARAM wParam, LPARAM lParam)
+const std::bitset<CommonUtilities::InputSnapshot::KeyCount>& CommonUtilities::InputSnapshot::GetPressedKeys() const
 {
-    for (int i = 0; i < 254; ++i)
-    {
-        myKeyState[i].myIsUp = false;
-        myKeyState[i].myIsDown = false;
-    }
+    return myPressedKeys;
+}
+
+const std::bitset<CommonUtilities::InputSnapshot::KeyCount>& CommonUtilities::InputSnapshot::GetUpKeys() const
+{
+    return myUpKeys;
+}
+
+CommonUtilities::Input::Input(int anEventCapacity)
+    : myEvents(anEventCapacity)
+{
+}
+
+CU::InputEventRing& CommonUtilities::Input::GetEventRing()
+{
+    return myEvents;
+}
 
-    switch (message)
+void CommonUtilities::Input::Update()
+{
+    // Only the edges are per frame, held keys and the mouse position carry over.
+    mySnapshot.myDownKeys.reset();
+    mySnapshot.myUpKeys.reset();
+    const Point previousPosition = mySnapshot.myMousePosition;
+
+    myEventCount = 0;
+    const int capacity = myEvents.GetCapacity();
+    InputEvent event;
+    while (myEventCount < capacity && myEvents.Pop(event))
     {
-    case WM_KEYDOWN:
-        if (myKeyState[wParam].myIsPressed == false)
-        {
-            myKeyState[wParam].myIsDown = true;
-        }
-        myKeyState[wParam].myIsPressed = true;
-        return true;
-
-    case WM_KEYUP:
-        myKeyState[wParam].myIsUp = true;
-        myKeyState[wParam].myIsDown = false;
-        myKeyState[wParam].myIsPressed = false;
-        return true;
-
-    case WM_MOUSEMOVE:
-        myMousePoint.SetX(GET_X_LPARAM(lParam));
-        myMousePoint.SetY(GET_Y_LPARAM(lParam));
-        return true;
-
-    case WM_LBUTTONDOWN:
-        if (myKeyState[VK_LBUTTON].myIsPressed == false)
+        Apply(event);
+        ++myEventCount;
+        if (myRecorder != nullptr)
         {
-            myKeyState[VK_LBUTTON].myIsDown = true;
+            myRecorder->Record(event);
         }
-        myKeyState[VK_LBUTTON].myIsPressed = true;
-        return true;
+    }
+    if (myRecorder != nullptr)
+    {
+        myRecorder->EndFrame();
+    }
 
-    case WM_RBUTTONDOWN:
-        myKeyState[VK_LBUTTON].myIsUp = true;
-        myKeyState[VK_LBUTTON].myIsDown = false;
-        myKeyState[VK_LBUTTON].myIsPressed = false;
-        return true;
+    mySnapshot.myMouseDelta.SetX(mySnapshot.myMousePosition.GetX() - previousPosition.GetX());
+    mySnapshot.myMouseDelta.SetY(mySnapshot.myMousePosition.GetY() - previousPosition.GetY());
+}
 
-    case WM_MBUTTONDOWN:
-        if (myKeyState[VK_MBUTTON].myIsPressed == false)
-        {
-            myKeyState[VK_MBUTTON].myIsDown = true;
-        }
-        myKeyState[VK_MBUTTON].myIsPressed = true;
-        return true;
+const CU::InputSnapshot& CommonUtilities::Input::GetSnapshot() const
+{
+    return mySnapshot;
+}
+
+bool CommonUtilities::Input::IsKeyDown(const int& aKeyCode) const
+{
+    return mySnapshot.IsKeyDown(aKeyCode);
+}
+
+bool CommonUtilities::Input::IsKeyPressed(const int& aKeyCode) const
+{
+    return mySnapshot.IsKeyPressed(aKeyCode);
+}
 
-    case WM_LBUTTONUP:
-        myKeyState[VK_MBUTTON].myIsUp = true;
-        myKeyState[VK_MBUTTON].myIsDown = false;
-        myKeyState[VK_MBUTTON].myIsPressed = false;
-        return true;
+bool CommonUtilities::Input::IsKeyUp(const int& aKeyCode) const
+{
+    return mySnapshot.IsKeyUp(aKeyCode);
+}
 
-    case WM_RBUTTONUP:
-        if (myKeyState[VK_RBUTTON].myIsPressed == false)
+CU::Point CommonUtilities::Input::GetMousePosition() const
+{
+    return mySnapshot.myMousePosition;
+}
+
+int CommonUtilities::Input::GetEventCount() const
+{
+    return myEventCount;
+}
+
+void CommonUtilities::Input::SetRecorder(InputRecorder* aRecorder)
+{
+    myRecorder = aRecorder;
+}
+
+void CommonUtilities::Input::Apply(const InputEvent& anEvent)
+{
+    switch (anEvent.myType)
+    {
+    case InputEventType::KeyDown:
+        // Held keys repeat their key down messages, only the first one is a key down.
+        if (!mySnapshot.myPressedKeys[anEvent.myKey])
         {
-            myKeyState[VK_RBUTTON].myIsDown = true;
+            mySnapshot.myDownKeys.set(anEvent.myKey);
         }
-        myKeyState[VK_RBUTTON].myIsPressed = true;
-        return true;
+        mySnapshot.myPressedKeys.set(anEvent.myKey);
+        break;
 
-    case WM_MBUTTONUP:
-        myKeyState[VK_RBUTTON].myIsUp = true;
-        myKeyState[VK_RBUTTON].myIsDown = false;
-        myKeyState[VK_RBUTTON].myIsPressed = false;
-        return true;
+    case InputEventType::KeyUp:
+        if (mySnapshot.myPressedKeys[anEvent.myKey])
+        {
+            mySnapshot.myUpKeys.set(anEvent.myKey);
+        }
+        mySnapshot.myPressedKeys.reset(anEvent.myKey);
+        break;
 
-    default:
-        return false;
+    case InputEventType::MouseMove:
+        mySnapshot.myMousePosition.SetX(anEvent.myX);
+        mySnapshot.myMousePosition.SetY(anEvent.myY);
+        break;
     }
-}
\ No newline at end of file
+}
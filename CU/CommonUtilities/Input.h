@@ -1,39 +1,89 @@
 #pragma once
 
+#include "InputEvent.h"
 #include "Point.h"
-#include <Windows.h>
-#include <vector>
+#include <bitset>
 
 namespace CommonUtilities
 {
-	struct KeyState
+	class InputRecorder;
+
+	// The key and mouse state of one frame. Keys that went down and up within the frame report both.
+	class InputSnapshot
 	{
-		bool myIsDown = false;
-		bool myIsPressed = false;
-		bool myIsUp = false;
+	public:
+		static const int KeyCount = 256;
+
+		// The key went down during the frame.
+		bool IsKeyDown(const int& aKeyCode) const;
+		// The key is held at the end of the frame.
+		bool IsKeyPressed(const int& aKeyCode) const;
+		// The key was released during the frame.
+		bool IsKeyUp(const int& aKeyCode) const;
+
+		const Point& GetMousePosition() const;
+		// How far the mouse moved during the frame.
+		const Point& GetMouseDelta() const;
+
+		const std::bitset<KeyCount>& GetDownKeys() const;
+		const std::bitset<KeyCount>& GetPressedKeys() const;
+		const std::bitset<KeyCount>& GetUpKeys() const;
+
+	private:
+		friend class Input;
+
+		std::bitset<KeyCount> myDownKeys;
+		std::bitset<KeyCount> myPressedKeys;
+		std::bitset<KeyCount> myUpKeys;
+		Point myMousePosition = Point(0, 0);
+		Point myMouseDelta = Point(0, 0);
 	};
 
+	// Builds one InputSnapshot per frame from the events a backend (Win32InputBackend, HeadlessInputBackend)
+	// pushed since the last frame. Events are only collected in between, so the per event cost is a ring push
+	// and the state is the same however many events arrive during the frame.
 	class Input
 	{
 	public:
-		Input();
+		// Mouse buttons use the Windows virtual key codes, so VK_LBUTTON and these are interchangeable.
+		static const int LeftMouseButton = 0x01;
+		static const int RightMouseButton = 0x02;
+		static const int MiddleMouseButton = 0x04;
+
+		explicit Input(int anEventCapacity = 1024);
+		Input(const Input& anInput) = delete;
+		Input& operator=(const Input& anInput) = delete;
+
+		// Backends push their events here.
+		InputEventRing& GetEventRing();
+
+		// Applies the pushed events to a new snapshot, call once per frame before reading input. At most a
+		// ring's worth of events is applied, the rest wait for the next frame.
+		void Update();
+
+		const InputSnapshot& GetSnapshot() const;
+
 		bool IsKeyDown(const int& aKeyCode) const;
 		bool IsKeyPressed(const int& aKeyCode) const;
 		bool IsKeyUp(const int& aKeyCode) const;
 
 		Point GetMousePosition() const;
 
-		bool UpdateEvents(UINT message, WPARAM wParam, LPARAM lParam);
+		// Events applied by the last Update.
+		int GetEventCount() const;
 
-	private:
-		KeyState myKeyState[254];
+		// Every Update writes the events it applies and the end of the frame to aRecorder, pass nullptr to stop.
+		// Check aRecorder's IsValid or Close to know whether the whole recording reached the file.
+		void SetRecorder(InputRecorder* aRecorder);
 
-		bool myLeftMousePressed = false;
-		bool myRightMousePressed = false;
-		bool myMiddleMousePressed = false;
+	private:
+		void Apply(const InputEvent& anEvent);
 
-		Point myMousePoint;
+		InputEventRing myEvents;
+		InputSnapshot mySnapshot;
+		int myEventCount = 0;
+		InputRecorder* myRecorder = nullptr;
 	};
 }
 
-namespace CU = CommonUtilities;
\ No newline at end of file
+namespace CU = CommonUtilities;
@@ -0,0 +1,30 @@
+#include "pch.h"
+#include "InputEvent.h"
+#include <assert.h>
+
+CommonUtilities::InputEventRing::InputEventRing(int aCapacity)
+    : myMask(0)
+    , myWriteCount(0)
+    , myDroppedCount(0)
+    , myReadCount(0)
+{
+    assert(aCapacity > 0 && "The input event ring needs room for at least one event.");
+    int capacity = 1;
+    while (capacity < aCapacity)
+    {
+        capacity <<= 1;
+    }
+
+    myEvents.resize(static_cast<size_t>(capacity));
+    myMask = static_cast<uint64_t>(capacity) - 1;
+}
+
+int CommonUtilities::InputEventRing::GetCapacity() const
+{
+    return static_cast<int>(myMask) + 1;
+}
+
+uint64_t CommonUtilities::InputEventRing::GetDroppedCount() const
+{
+    return myDroppedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace CommonUtilities
+{
+	enum class InputEventType : uint8_t
+	{
+		KeyDown,
+		KeyUp,
+		MouseMove
+	};
+
+	// One key or mouse change. Mouse buttons are keys, with the Windows virtual key codes (see Input).
+	struct InputEvent
+	{
+		// Nanoseconds, from GetInputTimestamp unless a backend sets its own clock.
+		int64_t myTimestamp;
+		int myX;
+		int myY;
+		InputEventType myType;
+		uint8_t myKey;
+	};
+
+	inline int64_t GetInputTimestamp()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Fixed size queue of input events between one producer (a backend, usually the window thread) and one
+	// consumer (Input::Update). Neither side locks: each only writes its own count and publishes it with a
+	// release store. Events pushed while the ring is full are dropped and counted.
+	class InputEventRing
+	{
+	public:
+		// The capacity is rounded up to a power of two.
+		explicit InputEventRing(int aCapacity = 1024);
+		InputEventRing(const InputEventRing& aRing) = delete;
+		InputEventRing& operator=(const InputEventRing& aRing) = delete;
+
+		// Producer side.
+		bool Push(const InputEvent& anEvent);
+
+		// Consumer side, returns false when the ring is empty.
+		bool Pop(InputEvent& anEvent);
+
+		int GetCapacity() const;
+		uint64_t GetDroppedCount() const;
+
+	private:
+		std::vector<InputEvent> myEvents;
+		uint64_t myMask;
+		// The counts are written by different threads, so they are kept on separate cache lines.
+		alignas(64) std::atomic<uint64_t> myWriteCount;
+		std::atomic<uint64_t> myDroppedCount;
+		alignas(64) std::atomic<uint64_t> myReadCount;
+	};
+
+	inline bool InputEventRing::Push(const InputEvent& anEvent)
+	{
+		const uint64_t index = myWriteCount.load(std::memory_order_relaxed);
+		if (index - myReadCount.load(std::memory_order_acquire) > myMask)
+		{
+			myDroppedCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		myEvents[index & myMask] = anEvent;
+		myWriteCount.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool InputEventRing::Pop(InputEvent& anEvent)
+	{
+		const uint64_t index = myReadCount.load(std::memory_order_relaxed);
+		if (index == myWriteCount.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		anEvent = myEvents[index & myMask];
+		myReadCount.store(index + 1, std::memory_order_release);
+		return true;
+	}
+}
+
+namespace CU = CommonUtilities;
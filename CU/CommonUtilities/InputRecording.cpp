@@ -0,0 +1,274 @@
+#include "pch.h"
+#include "InputRecording.h"
+#include "Input.h"
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    const unsigned char Magic[] = { 'C', 'U', 'I', 'R' };
+    const unsigned char Version = 1;
+    const size_t HeaderSize = sizeof(Magic) + 1;
+
+    // The first byte of every record, the event types keep their InputEventType value.
+    const unsigned char EndFrameTag = 3;
+
+    // Small differences of either sign become small unsigned numbers: 0, -1, 1, -2, ... map to 0, 1, 2, 3, ...
+    uint64_t ZigZagEncode(int64_t aValue)
+    {
+        return (static_cast<uint64_t>(aValue) << 1) ^ static_cast<uint64_t>(aValue >> 63);
+    }
+
+    int64_t ZigZagDecode(uint64_t aValue)
+    {
+        return static_cast<int64_t>(aValue >> 1) ^ -static_cast<int64_t>(aValue & 1);
+    }
+}
+
+CommonUtilities::InputRecorder::~InputRecorder()
+{
+    Close();
+}
+
+bool CommonUtilities::InputRecorder::Open(const char* aPath)
+{
+    Close();
+    myStream.open(aPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!myStream)
+    {
+        return false;
+    }
+
+    myBufferSize = 0;
+    myByteCount = 0;
+    myTimestamp = 0;
+    myX = 0;
+    myY = 0;
+
+    std::memcpy(myBuffer, Magic, sizeof(Magic));
+    myBuffer[sizeof(Magic)] = Version;
+    myBufferSize = static_cast<int>(HeaderSize);
+    myByteCount = HeaderSize;
+    return true;
+}
+
+bool CommonUtilities::InputRecorder::Close()
+{
+    if (!myStream.is_open())
+    {
+        return true;
+    }
+
+    // The file stream buffers too, so failures can first show when it is closed.
+    Flush();
+    myStream.close();
+    return !myStream.fail();
+}
+
+bool CommonUtilities::InputRecorder::IsOpen() const
+{
+    return myStream.is_open();
+}
+
+bool CommonUtilities::InputRecorder::IsValid() const
+{
+    return static_cast<bool>(myStream);
+}
+
+void CommonUtilities::InputRecorder::Record(const InputEvent& anEvent)
+{
+    if (!myStream.is_open() || !myStream)
+    {
+        return;
+    }
+    if (myBufferSize + MaxRecordSize > BufferSize)
+    {
+        Flush();
+    }
+
+    const int startSize = myBufferSize;
+    myBuffer[myBufferSize++] = static_cast<unsigned char>(anEvent.myType);
+    WriteVarint(ZigZagEncode(anEvent.myTimestamp - myTimestamp));
+    myTimestamp = anEvent.myTimestamp;
+
+    if (anEvent.myType == InputEventType::MouseMove)
+    {
+        WriteVarint(ZigZagEncode(static_cast<int64_t>(anEvent.myX) - myX));
+        WriteVarint(ZigZagEncode(static_cast<int64_t>(anEvent.myY) - myY));
+        myX = anEvent.myX;
+        myY = anEvent.myY;
+    }
+    else
+    {
+        myBuffer[myBufferSize++] = anEvent.myKey;
+    }
+    myByteCount += static_cast<uint64_t>(myBufferSize - startSize);
+}
+
+bool CommonUtilities::InputRecorder::EndFrame()
+{
+    if (!myStream.is_open() || !myStream)
+    {
+        return false;
+    }
+    if (myBufferSize == BufferSize)
+    {
+        Flush();
+    }
+    myBuffer[myBufferSize++] = EndFrameTag;
+    ++myByteCount;
+    return static_cast<bool>(myStream);
+}
+
+uint64_t CommonUtilities::InputRecorder::GetByteCount() const
+{
+    return myByteCount;
+}
+
+void CommonUtilities::InputRecorder::Flush()
+{
+    // A failed write leaves the stream failed, which IsValid, EndFrame and Close report.
+    myStream.write(reinterpret_cast<const char*>(myBuffer), myBufferSize);
+    myBufferSize = 0;
+}
+
+void CommonUtilities::InputRecorder::WriteVarint(uint64_t aValue)
+{
+    // Seven bits per byte, the high bit tells that more bytes follow.
+    while (aValue >= 0x80)
+    {
+        myBuffer[myBufferSize++] = static_cast<unsigned char>(aValue | 0x80);
+        aValue >>= 7;
+    }
+    myBuffer[myBufferSize++] = static_cast<unsigned char>(aValue);
+}
+
+bool CommonUtilities::InputReplay::Open(const char* aPath)
+{
+    myData.clear();
+    Rewind();
+
+    std::ifstream stream(aPath, std::ios::in | std::ios::binary);
+    if (!stream)
+    {
+        return false;
+    }
+    myData.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+
+    if (myData.size() < HeaderSize || std::memcmp(myData.data(), Magic, sizeof(Magic)) != 0 || myData[sizeof(Magic)] != Version)
+    {
+        myData.clear();
+        return false;
+    }
+    myPosition = HeaderSize;
+    return true;
+}
+
+bool CommonUtilities::InputReplay::PlayFrame(Input& anInput)
+{
+    if (IsFinished() || myHasOverflowed)
+    {
+        return false;
+    }
+
+    // The whole frame is decoded even when the ring fills up, positions and timestamps are differences.
+    InputEventRing& events = anInput.GetEventRing();
+    bool isComplete = true;
+    while (myPosition < myData.size())
+    {
+        const unsigned char tag = myData[myPosition++];
+        if (tag == EndFrameTag)
+        {
+            return FinishFrame(isComplete);
+        }
+
+        InputEvent event;
+        event.myType = static_cast<InputEventType>(tag);
+        event.myKey = 0;
+
+        uint64_t value;
+        if (tag > static_cast<unsigned char>(InputEventType::MouseMove) || !ReadVarint(value))
+        {
+            break;
+        }
+        myTimestamp += ZigZagDecode(value);
+        event.myTimestamp = myTimestamp;
+
+        if (event.myType == InputEventType::MouseMove)
+        {
+            uint64_t y;
+            if (!ReadVarint(value) || !ReadVarint(y))
+            {
+                break;
+            }
+            myX += static_cast<int>(ZigZagDecode(value));
+            myY += static_cast<int>(ZigZagDecode(y));
+        }
+        else
+        {
+            if (myPosition == myData.size())
+            {
+                break;
+            }
+            event.myKey = myData[myPosition++];
+        }
+        event.myX = event.myType == InputEventType::MouseMove ? myX : 0;
+        event.myY = event.myType == InputEventType::MouseMove ? myY : 0;
+        isComplete = events.Push(event) && isComplete;
+    }
+
+    // A log cut off mid frame, from a crash for instance, ends with the events that were complete.
+    myPosition = myData.size();
+    return FinishFrame(isComplete);
+}
+
+void CommonUtilities::InputReplay::Rewind()
+{
+    myPosition = myData.empty() ? 0 : HeaderSize;
+    myTimestamp = 0;
+    myX = 0;
+    myY = 0;
+    myPlayedFrameCount = 0;
+    myHasOverflowed = false;
+}
+
+bool CommonUtilities::InputReplay::IsFinished() const
+{
+    return myPosition >= myData.size();
+}
+
+int CommonUtilities::InputReplay::GetPlayedFrameCount() const
+{
+    return myPlayedFrameCount;
+}
+
+bool CommonUtilities::InputReplay::HasOverflowed() const
+{
+    return myHasOverflowed;
+}
+
+bool CommonUtilities::InputReplay::FinishFrame(bool anIsComplete)
+{
+    if (!anIsComplete)
+    {
+        myHasOverflowed = true;
+        return false;
+    }
+    ++myPlayedFrameCount;
+    return true;
+}
+
+bool CommonUtilities::InputReplay::ReadVarint(uint64_t& aValue)
+{
+    aValue = 0;
+    for (int shift = 0; shift < 64 && myPosition < myData.size(); shift += 7)
+    {
+        const unsigned char byte = myData[myPosition++];
+        aValue |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "InputEvent.h"
+#include <fstream>
+#include <vector>
+
+namespace CommonUtilities
+{
+	class Input;
+
+	// Writes the events an Input applies, frame by frame, to a binary log (see Input::SetRecorder). Each event
+	// stores its type, the timestamp as a difference to the previous event and mouse positions as differences
+	// to the previous position, all as variable length integers, so a mouse move usually takes 4 to 6 bytes.
+	// Events are encoded into a fixed buffer that is written out when full, recording never allocates.
+	class InputRecorder
+	{
+	public:
+		InputRecorder() = default;
+		InputRecorder(const InputRecorder& aRecorder) = delete;
+		InputRecorder& operator=(const InputRecorder& aRecorder) = delete;
+		~InputRecorder();
+
+		// Starts a new log, replacing any file at aPath.
+		bool Open(const char* aPath);
+		// Writes what is left in the buffer, returns false if any write failed.
+		bool Close();
+		bool IsOpen() const;
+		// False once a write to the file has failed (a full disk for instance), the log then ends at the last
+		// buffer written out and nothing more is recorded. Failures in the last writes may only be found by Close.
+		bool IsValid() const;
+
+		void Record(const InputEvent& anEvent);
+		// Returns false when the recording has failed, see IsValid.
+		bool EndFrame();
+
+		// Bytes recorded so far, including those still in the buffer.
+		uint64_t GetByteCount() const;
+
+	private:
+		static const int BufferSize = 1 << 14;
+		// The longest record, a mouse move: a tag and three 10 byte integers.
+		static const int MaxRecordSize = 31;
+
+		void Flush();
+		void WriteVarint(uint64_t aValue);
+
+		std::ofstream myStream;
+		unsigned char myBuffer[BufferSize];
+		int myBufferSize = 0;
+		uint64_t myByteCount = 0;
+		int64_t myTimestamp = 0;
+		int myX = 0;
+		int myY = 0;
+	};
+
+	// Plays an InputRecorder log back into an Input, one recorded frame per PlayFrame, so the same frames see
+	// the same input on every run. Needs no window, the events go through the same ring and Update as live ones.
+	//
+	//	while (replay.PlayFrame(input))
+	//	{
+	//		input.Update();
+	//		game.Update(input);
+	//	}
+	class InputReplay
+	{
+	public:
+		InputReplay() = default;
+
+		// Reads the whole log, returns false when it can not be read or is not an input log of this version.
+		bool Open(const char* aPath);
+
+		// Pushes the next frame's events to anInput's event ring, call before anInput.Update. Returns false
+		// when every frame has been played, or when the ring could not take the whole frame (see
+		// HasOverflowed), which an Input with a smaller ring than the recorded one can run into.
+		bool PlayFrame(Input& anInput);
+
+		// Starts over from the first frame.
+		void Rewind();
+
+		bool IsFinished() const;
+		int GetPlayedFrameCount() const;
+
+		// A frame was played only in part because the ring was full. The replay stops there, the frames after
+		// it would no longer see the recorded input.
+		bool HasOverflowed() const;
+
+	private:
+		bool ReadVarint(uint64_t& aValue);
+		bool FinishFrame(bool anIsComplete);
+
+		std::vector<unsigned char> myData;
+		size_t myPosition = 0;
+		int64_t myTimestamp = 0;
+		int myX = 0;
+		int myY = 0;
+		int myPlayedFrameCount = 0;
+		bool myHasOverflowed = false;
+	};
+}
+
+namespace CU = CommonUtilities;
@@ -6,8 +6,9 @@
 #include "Ray.hpp"
 #include "Vector3.hpp"
 #include "Triangle.hpp"
-#include "Maths.hpp"
+#include "Maths.h"
 #include <array>
+#include <cmath>
 
 namespace CommonUtilities
 {
@@ -29,183 +30,203 @@ namespace CommonUtilities
 		return true;
 	}
 
+	// Slab test: clips the ray against the three pairs of axis aligned planes using the ray's inverse
+	// direction. aOutTEnter and aOutTExit are the distances (in direction lengths) where the ray enters
+	// and leaves the box, aOutTEnter is negative when the origin is inside the box.
+	template<typename T>
+	bool IntersectionAABBRay(const AABB3D<T>& aAABB, const Ray<T>& aRay, T& aOutTEnter, T& aOutTExit)
+	{
+		const Vector3<T>& origin = aRay.GetOrigin();
+		const Vector3<T>& inverseDirection = aRay.GetInverseDirection();
+
+		T t0 = (aAABB.myMinPoint.x - origin.x) * inverseDirection.x;
+		T t1 = (aAABB.myMaxPoint.x - origin.x) * inverseDirection.x;
+		T tEnter = Min(t0, t1);
+		T tExit = Max(t0, t1);
+
+		t0 = (aAABB.myMinPoint.y - origin.y) * inverseDirection.y;
+		t1 = (aAABB.myMaxPoint.y - origin.y) * inverseDirection.y;
+		tEnter = Max(tEnter, Min(t0, t1));
+		tExit = Min(tExit, Max(t0, t1));
+
+		t0 = (aAABB.myMinPoint.z - origin.z) * inverseDirection.z;
+		t1 = (aAABB.myMaxPoint.z - origin.z) * inverseDirection.z;
+		tEnter = Max(tEnter, Min(t0, t1));
+		tExit = Min(tExit, Max(t0, t1));
+
+		aOutTEnter = tEnter;
+		aOutTExit = tExit;
+		return tExit >= Max(tEnter, static_cast<T>(0));
+	}
+
 	template<typename T>
 	bool IntersectionAABBRay(const AABB3D<T>& aAABB, const Ray<T>& aRay)
 	{
-		Plane<T> planes[6];
-		// Right
-		planes[0] = Plane<T>(
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMaxPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMinPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMinPoint.y, aAABB.myMinPoint.z));
-		// Front
-		planes[1] = Plane<T>(
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMaxPoint.y, aAABB.myMinPoint.z),
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMinPoint.y, aAABB.myMinPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMinPoint.y, aAABB.myMinPoint.z));
-		// Left
-		planes[2] = Plane<T>(
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMaxPoint.y, aAABB.myMinPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMinPoint.y, aAABB.myMinPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMinPoint.y, aAABB.myMaxPoint.z));
-		// Back
-		planes[3] = Plane<T>(
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMaxPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMinPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMinPoint.y, aAABB.myMaxPoint.z));
-		// Up
-		planes[4] = Plane<T>(
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMaxPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMaxPoint.y, aAABB.myMinPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMaxPoint.y, aAABB.myMinPoint.z));
-		// Down
-		planes[5] = Plane<T>(
-			Vector3<T>(aAABB.myMaxPoint.x, aAABB.myMinPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMinPoint.y, aAABB.myMaxPoint.z),
-			Vector3<T>(aAABB.myMinPoint.x, aAABB.myMinPoint.y, aAABB.myMinPoint.z));
-
-
-		for (int i = 0; i < 6; i++)
+		T tEnter;
+		T tExit;
+		return IntersectionAABBRay(aAABB, aRay, tEnter, tExit);
+	}
+
+	// Ray/sphere test for a normalized ray direction, as Ray::InitWithOriginAndPoint makes it. aOutTEnter and
+	// aOutTExit are the distances along the ray where it enters and leaves the sphere, aOutTEnter is negative
+	// when the origin is inside. The half chord is found from the distance between the sphere center and its
+	// projection on the ray, which loses less precision than r * r - (e.e - a * a) for far away spheres.
+	template<typename T>
+	bool IntersectionSphereRay(const Sphere<T>& aSphere, const Ray<T>& aRay, T& aOutTEnter, T& aOutTExit)
+	{
+		const Vector3<T>& direction = aRay.GetDirection();
+		const Vector3<T> toCenter = aSphere.GetCenter() - aRay.GetOrigin();
+		const T projection = toCenter.Dot(direction);
+		const T halfChordSqr = aSphere.GetRadiusSqr() - (toCenter - direction * projection).LengthSqr();
+		if (halfChordSqr < 0)
 		{
-			const T dnDot = aRay.GetDirection().Dot(planes[i].GetNormal());
-			bool isInside = planes[i].IsInside(aRay.GetOrigin());
-
-			if ((isInside && dnDot <= 0) || (!isInside && dnDot >= 0))
-			{
-				continue; // Parallel or wrong side
-			}
-
-			T planeD = planes[i].GetPoint().Dot(planes[i].GetNormal());
-			T length = (planeD - aRay.GetOrigin().Dot(planes[i].GetNormal())) / dnDot;
-
-			CU::Vector3<T> hit = aRay.GetOrigin() + aRay.GetDirection() * length;
-
-			bool hitSucceed = true;
-			for (int x = 0; x < 6; x++)
-			{
-				if (x != i)
-				{
-					if (!planes[x].IsInside(hit))
-					{
-						hitSucceed = false;
-						break;
-					}
-				}
-			}
-			if (hitSucceed)
-			{
-				return true;
-			}
+			return false; // The line misses the sphere.
 		}
 
-		return false;
+		const T halfChord = std::sqrt(halfChordSqr);
+		aOutTEnter = projection - halfChord;
+		aOutTExit = projection + halfChord;
+		return aOutTExit >= 0;
 	}
 
+	// Same as above, aOutNormal is the unit surface normal at the first hit in front of the origin. That is
+	// the exit point when the origin is inside the sphere, the normal still points away from the center.
 	template<typename T>
-	bool IntersectionSphereRay(const Sphere<T>& aSphere, const Ray<T>& aRay)
+	bool IntersectionSphereRay(const Sphere<T>& aSphere, const Ray<T>& aRay, T& aOutTEnter, T& aOutTExit, Vector3<T>& aOutNormal)
 	{
-		Vector3<T> e = aSphere.GetCenter() - aRay.GetOrigin();
-
-		T a = e.Dot(aRay.GetDirection().GetNormalized());
-		T eSqr = e.LengthSqr();
-		T rSqr = aSphere.GetRadiusSqr();
-		T aSqr = a * a;
-		T fSqr = rSqr - (eSqr + aSqr);
-		if (rSqr - (eSqr - aSqr) < 0.0f)
-		{
-			return false; // INVALID
-		}
-		if (eSqr < aSqr)
+		if (!IntersectionSphereRay(aSphere, aRay, aOutTEnter, aOutTExit))
 		{
-			return true; // INSIDE
+			return false;
 		}
+
+		const T distance = aOutTEnter >= 0 ? aOutTEnter : aOutTExit;
+		aOutNormal = (aRay.GetOrigin() + aRay.GetDirection() * distance - aSphere.GetCenter()) * (static_cast<T>(1) / aSphere.GetRadius());
 		return true;
 	}
 
 	template<typename T>
-	bool IntersectionTriangleRay(const Triangle<T>& aTriangle, const Ray<T>& aRay, const CU::Vector3f& outVector)
+	bool IntersectionSphereRay(const Sphere<T>& aSphere, const Ray<T>& aRay)
 	{
-		const float EPSILON = 0.0000001f;
-
-		Vector3f vertex0 = aTriangle.GetPoint1();
-		Vector3f vertex1 = aTriangle.GetPoint2();;
-		Vector3f vertex2 = aTriangle.GetPoint3();
-		Vector3f edge1, edge2, h, s, q;
-		float a, f, u, v;
-
-		edge1 = vertex1 - vertex0;
-		edge2 = vertex2 - vertex0;
-
-		h = aRay.GetDirection().Cross(edge2);
-		a = edge1.Dot(h);
+		T tEnter;
+		T tExit;
+		return IntersectionSphereRay(aSphere, aRay, tEnter, tExit);
+	}
 
-		if (a > -EPSILON && a < EPSILON)
-			return false;
+	// The overlap tests below compare squared distances, none of them takes a square root. Touching
+	// volumes count as overlapping.
 
-		f = 1.0f / a;
-		s = aRay.GetOrigin() - vertex0;
-		u = f * s.Dot(h);
+	template<typename T>
+	bool IntersectionSphereSphere(const Sphere<T>& aSphere, const Sphere<T>& anOtherSphere)
+	{
+		const T radiusSum = aSphere.GetRadius() + anOtherSphere.GetRadius();
+		return (aSphere.GetCenter() - anOtherSphere.GetCenter()).LengthSqr() <= radiusSum * radiusSum;
+	}
 
-		if (u < 0.0f || u > 1.0f)
-			return false;
+	template<typename T>
+	bool IntersectionAABBAABB(const AABB3D<T>& anAABB, const AABB3D<T>& anOtherAABB)
+	{
+		return anAABB.myMinPoint.x <= anOtherAABB.myMaxPoint.x && anAABB.myMaxPoint.x >= anOtherAABB.myMinPoint.x &&
+			anAABB.myMinPoint.y <= anOtherAABB.myMaxPoint.y && anAABB.myMaxPoint.y >= anOtherAABB.myMinPoint.y &&
+			anAABB.myMinPoint.z <= anOtherAABB.myMaxPoint.z && anAABB.myMaxPoint.z >= anOtherAABB.myMinPoint.z;
+	}
 
-		q = s.Cross(edge1);
-		v = f * aRay.GetDirection().Dot(q);
+	// Compares the squared distance from the sphere center to the closest point of the box with the radius.
+	template<typename T>
+	bool IntersectionSphereAABB(const Sphere<T>& aSphere, const AABB3D<T>& anAABB)
+	{
+		const Vector3<T>& center = aSphere.GetCenter();
+		const Vector3<T> closest(
+			Clamp(anAABB.myMinPoint.x, anAABB.myMaxPoint.x, center.x),
+			Clamp(anAABB.myMinPoint.y, anAABB.myMaxPoint.y, center.y),
+			Clamp(anAABB.myMinPoint.z, anAABB.myMaxPoint.z, center.z));
+		return (closest - center).LengthSqr() <= aSphere.GetRadiusSqr();
+	}
 
-		if (v < 0.0f || u + v > 1.0f)
-			return false;
+	template<typename T>
+	bool IntersectionAABBSphere(const AABB3D<T>& anAABB, const Sphere<T>& aSphere)
+	{
+		return IntersectionSphereAABB(aSphere, anAABB);
+	}
 
-		float t = f * edge2.Dot(q);
-		if (t > EPSILON)
-		{
-			outVector = aRay.GetOrigin() + aRay.GetDirection() * t;
-			return true;
-		}
-		else
-			return false;
+	// Whether any part of the sphere is inside the plane, as in Plane::IsInside. The normal does not have to
+	// be normalized: the signed distance d = n.(c - p) is compared as d * d <= r * r * n.n when positive.
+	template<typename T>
+	bool IntersectionSpherePlane(const Sphere<T>& aSphere, const Plane<T>& aPlane)
+	{
+		const T distance = (aSphere.GetCenter() - aPlane.GetPoint()).Dot(aPlane.GetNormal());
+		return distance <= 0 || distance * distance <= aSphere.GetRadiusSqr() * aPlane.GetNormal().LengthSqr();
 	}
 
+	// Moller-Trumbore ray/triangle test. On a hit aOutDistance is the distance along the ray (in direction
+	// lengths) and aOutU, aOutV are the barycentric weights of aPoint2 and aPoint3.
 	template<typename T>
-	bool IntersectionTriangleRay(const std::array<Vector3<T>, 3>& aTriangleVertices, const Ray<T>& aRay, CU::Vector3f& outVector)
+	bool IntersectionTriangleRay(const Vector3<T>& aPoint1, const Vector3<T>& aPoint2, const Vector3<T>& aPoint3, const Ray<T>& aRay,
+		T& aOutDistance, T& aOutU, T& aOutV)
 	{
-		const float EPSILON = 0.0000001f;
+		const T epsilon = static_cast<T>(0.0000001);
 
-		Vector3f vertex0 = aTriangleVertices[0];
-		Vector3f vertex1 = aTriangleVertices[1];
-		Vector3f vertex2 = aTriangleVertices[2];
-		Vector3f edge1, edge2, h, s, q;
-		float a, f, u, v;
+		const Vector3<T> edge1 = aPoint2 - aPoint1;
+		const Vector3<T> edge2 = aPoint3 - aPoint1;
 
-		edge1 = vertex1 - vertex0;
-		edge2 = vertex2 - vertex0;
+		const Vector3<T> h = aRay.GetDirection().Cross(edge2);
+		const T a = edge1.Dot(h);
 
-		h = aRay.GetDirection().Cross(edge2);
-		a = edge1.Dot(h);
+		if (a > -epsilon && a < epsilon)
+			return false;
+
+		const T f = static_cast<T>(1) / a;
+		const Vector3<T> s = aRay.GetOrigin() - aPoint1;
+		const T u = f * s.Dot(h);
 
-		if (a > -EPSILON && a < EPSILON)
+		if (u < 0 || u > 1)
 			return false;
 
-		f = 1.0f / a;
-		s = aRay.GetOrigin() - vertex0;
-		u = f * s.Dot(h);
+		const Vector3<T> q = s.Cross(edge1);
+		const T v = f * aRay.GetDirection().Dot(q);
 
-		if (u < 0.0f || u > 1.0f)
+		if (v < 0 || u + v > 1)
 			return false;
 
-		q = s.Cross(edge1);
-		v = f * aRay.GetDirection().Dot(q);
+		const T t = f * edge2.Dot(q);
+		if (t <= epsilon)
+			return false;
 
-		if (v < 0.0f || u + v > 1.0f)
+		aOutDistance = t;
+		aOutU = u;
+		aOutV = v;
+		return true;
+	}
+
+	template<typename T>
+	bool IntersectionTriangleRay(const Triangle<T>& aTriangle, const Ray<T>& aRay, T& aOutDistance, T& aOutU, T& aOutV)
+	{
+		return IntersectionTriangleRay(aTriangle.GetPoint1(), aTriangle.GetPoint2(), aTriangle.GetPoint3(), aRay, aOutDistance, aOutU, aOutV);
+	}
+
+	template<typename T>
+	bool IntersectionTriangleRay(const Triangle<T>& aTriangle, const Ray<T>& aRay, Vector3<T>& outVector)
+	{
+		T t;
+		T u;
+		T v;
+		if (!IntersectionTriangleRay(aTriangle.GetPoint1(), aTriangle.GetPoint2(), aTriangle.GetPoint3(), aRay, t, u, v))
 			return false;
 
-		float t = f * edge2.Dot(q);
-		if (t > EPSILON)
-		{
-			outVector = aRay.GetOrigin() + aRay.GetDirection() * t;
-			return true;
-		}
-		else
+		outVector = aRay.GetOrigin() + aRay.GetDirection() * t;
+		return true;
+	}
+
+	template<typename T>
+	bool IntersectionTriangleRay(const std::array<Vector3<T>, 3>& aTriangleVertices, const Ray<T>& aRay, Vector3<T>& outVector)
+	{
+		T t;
+		T u;
+		T v;
+		if (!IntersectionTriangleRay(aTriangleVertices[0], aTriangleVertices[1], aTriangleVertices[2], aRay, t, u, v))
 			return false;
+
+		outVector = aRay.GetOrigin() + aRay.GetDirection() * t;
+		return true;
 	}
 }
 
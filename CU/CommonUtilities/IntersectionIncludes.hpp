@@ -8,4 +8,9 @@
 #include "LineVolume.hpp"
 #include "Plane.hpp"
 #include "PlaneVolume.hpp"
-#include "Intersection.hpp"
\ No newline at end of file
+#include "Intersection.hpp"
+#include "IntersectionSIMD.hpp"
+#include "Frustum.h"
+#include "DynamicAABBTree.h"
+#include "SpatialHashGrid.hpp"
+#include "LooseOctree.h"
\ No newline at end of file
@@ -0,0 +1,1106 @@
+#pragma once
+
+#include "AABB3D.hpp"
+#include "Ray.hpp"
+#include "Sphere.hpp"
+#include "Plane.hpp"
+#include "Triangle.hpp"
+#include "Intersection.hpp"
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX__)
+#define CU_SIMD_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CU_SIMD_SSE
+#endif
+
+#if defined(CU_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(CU_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+// Packet versions of the tests in Intersection.hpp. Packets hold their members as structure of
+// arrays so one SSE (4 wide) or AVX (8 wide) register covers the same component of every element.
+// The tests return a bitmask with bit i set when element i hits. Without SSE/AVX the scalar tests
+// are used per element.
+namespace CommonUtilities
+{
+	template<int Width>
+	struct RayPacket
+	{
+		// Stores aRay in lane aIndex.
+		void Set(const int aIndex, const Ray<float>& aRay)
+		{
+			myOriginX[aIndex] = aRay.GetOrigin().x;
+			myOriginY[aIndex] = aRay.GetOrigin().y;
+			myOriginZ[aIndex] = aRay.GetOrigin().z;
+			myInverseDirectionX[aIndex] = aRay.GetInverseDirection().x;
+			myInverseDirectionY[aIndex] = aRay.GetInverseDirection().y;
+			myInverseDirectionZ[aIndex] = aRay.GetInverseDirection().z;
+		}
+
+		alignas(32) float myOriginX[Width];
+		alignas(32) float myOriginY[Width];
+		alignas(32) float myOriginZ[Width];
+		alignas(32) float myInverseDirectionX[Width];
+		alignas(32) float myInverseDirectionY[Width];
+		alignas(32) float myInverseDirectionZ[Width];
+	};
+
+	template<int Width>
+	struct AABBPacket
+	{
+		// Stores aAABB in lane aIndex.
+		void Set(const int aIndex, const AABB3D<float>& aAABB)
+		{
+			myMinX[aIndex] = aAABB.myMinPoint.x;
+			myMinY[aIndex] = aAABB.myMinPoint.y;
+			myMinZ[aIndex] = aAABB.myMinPoint.z;
+			myMaxX[aIndex] = aAABB.myMaxPoint.x;
+			myMaxY[aIndex] = aAABB.myMaxPoint.y;
+			myMaxZ[aIndex] = aAABB.myMaxPoint.z;
+		}
+
+		alignas(32) float myMinX[Width];
+		alignas(32) float myMinY[Width];
+		alignas(32) float myMinZ[Width];
+		alignas(32) float myMaxX[Width];
+		alignas(32) float myMaxY[Width];
+		alignas(32) float myMaxZ[Width];
+	};
+
+	// Spheres stored as structure of arrays, element i is (myCenterX[i], myCenterY[i], myCenterZ[i]) with myRadius[i].
+	struct SphereArrays
+	{
+		const float* myCenterX = nullptr;
+		const float* myCenterY = nullptr;
+		const float* myCenterZ = nullptr;
+		const float* myRadius = nullptr;
+	};
+
+	// Boxes stored as structure of arrays as center and half size per axis.
+	struct AABBArrays
+	{
+		const float* myCenterX = nullptr;
+		const float* myCenterY = nullptr;
+		const float* myCenterZ = nullptr;
+		const float* myExtentX = nullptr;
+		const float* myExtentY = nullptr;
+		const float* myExtentZ = nullptr;
+	};
+
+	// Triangles stored as structure of arrays, each as its first vertex and the two edges from it,
+	// which is the form the ray test needs.
+	struct TriangleBatch
+	{
+		void Add(const Vector3<float>& aPoint1, const Vector3<float>& aPoint2, const Vector3<float>& aPoint3)
+		{
+			Resize(Size() + 1);
+			Set(Size() - 1, aPoint1, aPoint2, aPoint3);
+		}
+
+		void Add(const Triangle<float>& aTriangle)
+		{
+			Add(aTriangle.GetPoint1(), aTriangle.GetPoint2(), aTriangle.GetPoint3());
+		}
+
+		void Set(const int aIndex, const Vector3<float>& aPoint1, const Vector3<float>& aPoint2, const Vector3<float>& aPoint3)
+		{
+			myVertex0X[aIndex] = aPoint1.x;
+			myVertex0Y[aIndex] = aPoint1.y;
+			myVertex0Z[aIndex] = aPoint1.z;
+			myEdge1X[aIndex] = aPoint2.x - aPoint1.x;
+			myEdge1Y[aIndex] = aPoint2.y - aPoint1.y;
+			myEdge1Z[aIndex] = aPoint2.z - aPoint1.z;
+			myEdge2X[aIndex] = aPoint3.x - aPoint1.x;
+			myEdge2Y[aIndex] = aPoint3.y - aPoint1.y;
+			myEdge2Z[aIndex] = aPoint3.z - aPoint1.z;
+		}
+
+		// Copies triangle aSourceIndex of aSource into aIndex without recomputing the edges.
+		void Set(const int aIndex, const TriangleBatch& aSource, const int aSourceIndex)
+		{
+			myVertex0X[aIndex] = aSource.myVertex0X[aSourceIndex];
+			myVertex0Y[aIndex] = aSource.myVertex0Y[aSourceIndex];
+			myVertex0Z[aIndex] = aSource.myVertex0Z[aSourceIndex];
+			myEdge1X[aIndex] = aSource.myEdge1X[aSourceIndex];
+			myEdge1Y[aIndex] = aSource.myEdge1Y[aSourceIndex];
+			myEdge1Z[aIndex] = aSource.myEdge1Z[aSourceIndex];
+			myEdge2X[aIndex] = aSource.myEdge2X[aSourceIndex];
+			myEdge2Y[aIndex] = aSource.myEdge2Y[aSourceIndex];
+			myEdge2Z[aIndex] = aSource.myEdge2Z[aSourceIndex];
+		}
+
+		Vector3<float> GetPoint1(const int aIndex) const
+		{
+			return Vector3<float>(myVertex0X[aIndex], myVertex0Y[aIndex], myVertex0Z[aIndex]);
+		}
+
+		Vector3<float> GetPoint2(const int aIndex) const
+		{
+			return Vector3<float>(myVertex0X[aIndex] + myEdge1X[aIndex], myVertex0Y[aIndex] + myEdge1Y[aIndex], myVertex0Z[aIndex] + myEdge1Z[aIndex]);
+		}
+
+		Vector3<float> GetPoint3(const int aIndex) const
+		{
+			return Vector3<float>(myVertex0X[aIndex] + myEdge2X[aIndex], myVertex0Y[aIndex] + myEdge2Y[aIndex], myVertex0Z[aIndex] + myEdge2Z[aIndex]);
+		}
+
+		void Resize(const int aSize)
+		{
+			const size_t size = static_cast<size_t>(aSize);
+			myVertex0X.resize(size);
+			myVertex0Y.resize(size);
+			myVertex0Z.resize(size);
+			myEdge1X.resize(size);
+			myEdge1Y.resize(size);
+			myEdge1Z.resize(size);
+			myEdge2X.resize(size);
+			myEdge2Y.resize(size);
+			myEdge2Z.resize(size);
+		}
+
+		void Clear()
+		{
+			Resize(0);
+		}
+
+		int Size() const
+		{
+			return static_cast<int>(myVertex0X.size());
+		}
+
+		std::vector<float> myVertex0X;
+		std::vector<float> myVertex0Y;
+		std::vector<float> myVertex0Z;
+		std::vector<float> myEdge1X;
+		std::vector<float> myEdge1Y;
+		std::vector<float> myEdge1Z;
+		std::vector<float> myEdge2X;
+		std::vector<float> myEdge2Y;
+		std::vector<float> myEdge2Z;
+	};
+
+	using RayPacket4 = RayPacket<4>;
+	using RayPacket8 = RayPacket<8>;
+	using AABBPacket4 = AABBPacket<4>;
+	using AABBPacket8 = AABBPacket<8>;
+
+	namespace detail
+	{
+		// Slab test of 4 lanes. Each lane has its own box bounds and ray.
+		inline int SlabTest4(
+			const float* someMinX, const float* someMinY, const float* someMinZ,
+			const float* someMaxX, const float* someMaxY, const float* someMaxZ,
+			const float* someOriginX, const float* someOriginY, const float* someOriginZ,
+			const float* someInverseX, const float* someInverseY, const float* someInverseZ,
+			float* someOutTEnter)
+		{
+#if defined(CU_SIMD_SSE)
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(someMinX), _mm_loadu_ps(someOriginX)), _mm_loadu_ps(someInverseX));
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(someMaxX), _mm_loadu_ps(someOriginX)), _mm_loadu_ps(someInverseX));
+			__m128 tEnter = _mm_min_ps(t0, t1);
+			__m128 tExit = _mm_max_ps(t0, t1);
+
+			t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(someMinY), _mm_loadu_ps(someOriginY)), _mm_loadu_ps(someInverseY));
+			t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(someMaxY), _mm_loadu_ps(someOriginY)), _mm_loadu_ps(someInverseY));
+			tEnter = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+			tExit = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+
+			t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(someMinZ), _mm_loadu_ps(someOriginZ)), _mm_loadu_ps(someInverseZ));
+			t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(someMaxZ), _mm_loadu_ps(someOriginZ)), _mm_loadu_ps(someInverseZ));
+			tEnter = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+			tExit = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+
+			if (someOutTEnter != nullptr)
+			{
+				_mm_storeu_ps(someOutTEnter, tEnter);
+			}
+			return _mm_movemask_ps(_mm_cmple_ps(_mm_max_ps(tEnter, _mm_setzero_ps()), tExit));
+#else
+			int mask = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				const AABB3D<float> box({ someMinX[i], someMinY[i], someMinZ[i] }, { someMaxX[i], someMaxY[i], someMaxZ[i] });
+				const Vector3<float> origin(someOriginX[i], someOriginY[i], someOriginZ[i]);
+				const Ray<float> ray(origin, { 1.0f / someInverseX[i], 1.0f / someInverseY[i], 1.0f / someInverseZ[i] });
+				float tEnter;
+				float tExit;
+				if (IntersectionAABBRay(box, ray, tEnter, tExit))
+				{
+					mask |= 1 << i;
+				}
+				if (someOutTEnter != nullptr)
+				{
+					someOutTEnter[i] = tEnter;
+				}
+			}
+			return mask;
+#endif
+		}
+
+		// Same as SlabTest4 for 8 lanes.
+		inline int SlabTest8(
+			const float* someMinX, const float* someMinY, const float* someMinZ,
+			const float* someMaxX, const float* someMaxY, const float* someMaxZ,
+			const float* someOriginX, const float* someOriginY, const float* someOriginZ,
+			const float* someInverseX, const float* someInverseY, const float* someInverseZ,
+			float* someOutTEnter)
+		{
+#if defined(CU_SIMD_AVX)
+			__m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(someMinX), _mm256_loadu_ps(someOriginX)), _mm256_loadu_ps(someInverseX));
+			__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(someMaxX), _mm256_loadu_ps(someOriginX)), _mm256_loadu_ps(someInverseX));
+			__m256 tEnter = _mm256_min_ps(t0, t1);
+			__m256 tExit = _mm256_max_ps(t0, t1);
+
+			t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(someMinY), _mm256_loadu_ps(someOriginY)), _mm256_loadu_ps(someInverseY));
+			t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(someMaxY), _mm256_loadu_ps(someOriginY)), _mm256_loadu_ps(someInverseY));
+			tEnter = _mm256_max_ps(tEnter, _mm256_min_ps(t0, t1));
+			tExit = _mm256_min_ps(tExit, _mm256_max_ps(t0, t1));
+
+			t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(someMinZ), _mm256_loadu_ps(someOriginZ)), _mm256_loadu_ps(someInverseZ));
+			t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(someMaxZ), _mm256_loadu_ps(someOriginZ)), _mm256_loadu_ps(someInverseZ));
+			tEnter = _mm256_max_ps(tEnter, _mm256_min_ps(t0, t1));
+			tExit = _mm256_min_ps(tExit, _mm256_max_ps(t0, t1));
+
+			if (someOutTEnter != nullptr)
+			{
+				_mm256_storeu_ps(someOutTEnter, tEnter);
+			}
+			return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_max_ps(tEnter, _mm256_setzero_ps()), tExit, _CMP_LE_OQ));
+#else
+			const int low = SlabTest4(
+				someMinX, someMinY, someMinZ, someMaxX, someMaxY, someMaxZ,
+				someOriginX, someOriginY, someOriginZ, someInverseX, someInverseY, someInverseZ,
+				someOutTEnter);
+			const int high = SlabTest4(
+				someMinX + 4, someMinY + 4, someMinZ + 4, someMaxX + 4, someMaxY + 4, someMaxZ + 4,
+				someOriginX + 4, someOriginY + 4, someOriginZ + 4, someInverseX + 4, someInverseY + 4, someInverseZ + 4,
+				someOutTEnter != nullptr ? someOutTEnter + 4 : nullptr);
+			return low | (high << 4);
+#endif
+		}
+
+		const float TriangleEpsilon = 0.0000001f;
+
+		// Keeps the closest of the lanes in aMask, lane i holds triangle aFirst + i.
+		inline bool ReduceTriangleHits(int aMask, const int aFirst, const float* someT, const float* someU, const float* someV,
+			int& aOutIndex, float& aInOutDistance, float& aOutU, float& aOutV)
+		{
+			bool found = false;
+			for (int lane = 0; aMask != 0; ++lane, aMask >>= 1)
+			{
+				if ((aMask & 1) != 0 && someT[lane] < aInOutDistance)
+				{
+					aOutIndex = aFirst + lane;
+					aInOutDistance = someT[lane];
+					aOutU = someU[lane];
+					aOutV = someV[lane];
+					found = true;
+				}
+			}
+			return found;
+		}
+
+		// Moller-Trumbore on a single triangle of a batch, same as the packet versions below.
+		inline bool TriangleTest1(const TriangleBatch& someTriangles, const int anIndex, const Ray<float>& aRay, float& aOutT, float& aOutU, float& aOutV)
+		{
+			const Vector3<float>& origin = aRay.GetOrigin();
+			const Vector3<float>& direction = aRay.GetDirection();
+			const Vector3<float> edge1(someTriangles.myEdge1X[anIndex], someTriangles.myEdge1Y[anIndex], someTriangles.myEdge1Z[anIndex]);
+			const Vector3<float> edge2(someTriangles.myEdge2X[anIndex], someTriangles.myEdge2Y[anIndex], someTriangles.myEdge2Z[anIndex]);
+
+			const Vector3<float> h = direction.Cross(edge2);
+			const float a = edge1.Dot(h);
+			if (a > -TriangleEpsilon && a < TriangleEpsilon)
+			{
+				return false;
+			}
+
+			const float f = 1.0f / a;
+			const Vector3<float> s = origin - someTriangles.GetPoint1(anIndex);
+			const float u = f * s.Dot(h);
+			if (u < 0.0f || u > 1.0f)
+			{
+				return false;
+			}
+
+			const Vector3<float> q = s.Cross(edge1);
+			const float v = f * direction.Dot(q);
+			if (v < 0.0f || u + v > 1.0f)
+			{
+				return false;
+			}
+
+			aOutT = f * edge2.Dot(q);
+			aOutU = u;
+			aOutV = v;
+			return aOutT > TriangleEpsilon;
+		}
+
+#if defined(CU_SIMD_SSE)
+		// Moller-Trumbore on triangles anIndex to anIndex + 3. Returns the mask of lanes that hit
+		// closer than aMaxDistance and stores t, u and v of every lane.
+		inline int TriangleTest4(const TriangleBatch& someTriangles, const int anIndex, const Ray<float>& aRay, const float aMaxDistance,
+			float* someOutT, float* someOutU, float* someOutV)
+		{
+			const __m128 directionX = _mm_set1_ps(aRay.GetDirection().x);
+			const __m128 directionY = _mm_set1_ps(aRay.GetDirection().y);
+			const __m128 directionZ = _mm_set1_ps(aRay.GetDirection().z);
+
+			const __m128 edge1X = _mm_loadu_ps(&someTriangles.myEdge1X[anIndex]);
+			const __m128 edge1Y = _mm_loadu_ps(&someTriangles.myEdge1Y[anIndex]);
+			const __m128 edge1Z = _mm_loadu_ps(&someTriangles.myEdge1Z[anIndex]);
+			const __m128 edge2X = _mm_loadu_ps(&someTriangles.myEdge2X[anIndex]);
+			const __m128 edge2Y = _mm_loadu_ps(&someTriangles.myEdge2Y[anIndex]);
+			const __m128 edge2Z = _mm_loadu_ps(&someTriangles.myEdge2Z[anIndex]);
+
+			const __m128 hX = _mm_sub_ps(_mm_mul_ps(directionY, edge2Z), _mm_mul_ps(directionZ, edge2Y));
+			const __m128 hY = _mm_sub_ps(_mm_mul_ps(directionZ, edge2X), _mm_mul_ps(directionX, edge2Z));
+			const __m128 hZ = _mm_sub_ps(_mm_mul_ps(directionX, edge2Y), _mm_mul_ps(directionY, edge2X));
+			const __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1X, hX), _mm_mul_ps(edge1Y, hY)), _mm_mul_ps(edge1Z, hZ));
+			const __m128 f = _mm_div_ps(_mm_set1_ps(1.0f), a);
+
+			const __m128 sX = _mm_sub_ps(_mm_set1_ps(aRay.GetOrigin().x), _mm_loadu_ps(&someTriangles.myVertex0X[anIndex]));
+			const __m128 sY = _mm_sub_ps(_mm_set1_ps(aRay.GetOrigin().y), _mm_loadu_ps(&someTriangles.myVertex0Y[anIndex]));
+			const __m128 sZ = _mm_sub_ps(_mm_set1_ps(aRay.GetOrigin().z), _mm_loadu_ps(&someTriangles.myVertex0Z[anIndex]));
+			const __m128 u = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sX, hX), _mm_mul_ps(sY, hY)), _mm_mul_ps(sZ, hZ)));
+
+			const __m128 qX = _mm_sub_ps(_mm_mul_ps(sY, edge1Z), _mm_mul_ps(sZ, edge1Y));
+			const __m128 qY = _mm_sub_ps(_mm_mul_ps(sZ, edge1X), _mm_mul_ps(sX, edge1Z));
+			const __m128 qZ = _mm_sub_ps(_mm_mul_ps(sX, edge1Y), _mm_mul_ps(sY, edge1X));
+			const __m128 v = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX), _mm_mul_ps(directionY, qY)), _mm_mul_ps(directionZ, qZ)));
+			const __m128 t = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2X, qX), _mm_mul_ps(edge2Y, qY)), _mm_mul_ps(edge2Z, qZ)));
+
+			const __m128 epsilon = _mm_set1_ps(TriangleEpsilon);
+			const __m128 absA = _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+			__m128 hit = _mm_cmpge_ps(absA, epsilon);
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(u, _mm_setzero_ps()));
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(v, _mm_setzero_ps()));
+			hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+			hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, epsilon));
+			hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_set1_ps(aMaxDistance)));
+
+			_mm_storeu_ps(someOutT, t);
+			_mm_storeu_ps(someOutU, u);
+			_mm_storeu_ps(someOutV, v);
+			return _mm_movemask_ps(hit);
+		}
+#endif
+
+#if defined(CU_SIMD_AVX)
+		// Same as TriangleTest4 for 8 triangles.
+		inline int TriangleTest8(const TriangleBatch& someTriangles, const int anIndex, const Ray<float>& aRay, const float aMaxDistance,
+			float* someOutT, float* someOutU, float* someOutV)
+		{
+			const __m256 directionX = _mm256_set1_ps(aRay.GetDirection().x);
+			const __m256 directionY = _mm256_set1_ps(aRay.GetDirection().y);
+			const __m256 directionZ = _mm256_set1_ps(aRay.GetDirection().z);
+
+			const __m256 edge1X = _mm256_loadu_ps(&someTriangles.myEdge1X[anIndex]);
+			const __m256 edge1Y = _mm256_loadu_ps(&someTriangles.myEdge1Y[anIndex]);
+			const __m256 edge1Z = _mm256_loadu_ps(&someTriangles.myEdge1Z[anIndex]);
+			const __m256 edge2X = _mm256_loadu_ps(&someTriangles.myEdge2X[anIndex]);
+			const __m256 edge2Y = _mm256_loadu_ps(&someTriangles.myEdge2Y[anIndex]);
+			const __m256 edge2Z = _mm256_loadu_ps(&someTriangles.myEdge2Z[anIndex]);
+
+			const __m256 hX = _mm256_sub_ps(_mm256_mul_ps(directionY, edge2Z), _mm256_mul_ps(directionZ, edge2Y));
+			const __m256 hY = _mm256_sub_ps(_mm256_mul_ps(directionZ, edge2X), _mm256_mul_ps(directionX, edge2Z));
+			const __m256 hZ = _mm256_sub_ps(_mm256_mul_ps(directionX, edge2Y), _mm256_mul_ps(directionY, edge2X));
+			const __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edge1X, hX), _mm256_mul_ps(edge1Y, hY)), _mm256_mul_ps(edge1Z, hZ));
+			const __m256 f = _mm256_div_ps(_mm256_set1_ps(1.0f), a);
+
+			const __m256 sX = _mm256_sub_ps(_mm256_set1_ps(aRay.GetOrigin().x), _mm256_loadu_ps(&someTriangles.myVertex0X[anIndex]));
+			const __m256 sY = _mm256_sub_ps(_mm256_set1_ps(aRay.GetOrigin().y), _mm256_loadu_ps(&someTriangles.myVertex0Y[anIndex]));
+			const __m256 sZ = _mm256_sub_ps(_mm256_set1_ps(aRay.GetOrigin().z), _mm256_loadu_ps(&someTriangles.myVertex0Z[anIndex]));
+			const __m256 u = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sX, hX), _mm256_mul_ps(sY, hY)), _mm256_mul_ps(sZ, hZ)));
+
+			const __m256 qX = _mm256_sub_ps(_mm256_mul_ps(sY, edge1Z), _mm256_mul_ps(sZ, edge1Y));
+			const __m256 qY = _mm256_sub_ps(_mm256_mul_ps(sZ, edge1X), _mm256_mul_ps(sX, edge1Z));
+			const __m256 qZ = _mm256_sub_ps(_mm256_mul_ps(sX, edge1Y), _mm256_mul_ps(sY, edge1X));
+			const __m256 v = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(directionX, qX), _mm256_mul_ps(directionY, qY)), _mm256_mul_ps(directionZ, qZ)));
+			const __m256 t = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edge2X, qX), _mm256_mul_ps(edge2Y, qY)), _mm256_mul_ps(edge2Z, qZ)));
+
+			const __m256 epsilon = _mm256_set1_ps(TriangleEpsilon);
+			const __m256 absA = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+			__m256 hit = _mm256_cmp_ps(absA, epsilon, _CMP_GE_OQ);
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_GE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, epsilon, _CMP_GT_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_set1_ps(aMaxDistance), _CMP_LT_OQ));
+
+			_mm256_storeu_ps(someOutT, t);
+			_mm256_storeu_ps(someOutU, u);
+			_mm256_storeu_ps(someOutV, v);
+			return _mm256_movemask_ps(hit);
+		}
+#endif
+
+		template<int Width>
+		struct Broadcast
+		{
+			alignas(32) float myValues[Width];
+
+			explicit Broadcast(const float aValue)
+			{
+				for (int i = 0; i < Width; ++i)
+				{
+					myValues[i] = aValue;
+				}
+			}
+		};
+
+		// Distance to the first hit in front of the origin of a ray with a normalized direction, as in
+		// IntersectionSphereRay, for sphere anIndex.
+		inline bool SphereRayTest1(const SphereArrays& someSpheres, const int anIndex, const Ray<float>& aRay, float& aOutT)
+		{
+			const Sphere<float> sphere(Vector3<float>(someSpheres.myCenterX[anIndex], someSpheres.myCenterY[anIndex], someSpheres.myCenterZ[anIndex]), someSpheres.myRadius[anIndex]);
+			float tEnter;
+			float tExit;
+			if (!IntersectionSphereRay(sphere, aRay, tEnter, tExit))
+			{
+				return false;
+			}
+			aOutT = tEnter >= 0.0f ? tEnter : tExit;
+			return true;
+		}
+
+#if defined(CU_SIMD_SSE)
+		// Spheres anIndex to anIndex + 3. Returns the mask of lanes hit closer than aMaxDistance and stores
+		// the hit distance of every lane. Most spheres miss the ray line, when all lanes do the square root
+		// is skipped and nothing is stored.
+		inline int SphereRayTest4(const SphereArrays& someSpheres, const int anIndex, const Ray<float>& aRay, const float aMaxDistance, float* someOutT)
+		{
+			const __m128 directionX = _mm_set1_ps(aRay.GetDirection().x);
+			const __m128 directionY = _mm_set1_ps(aRay.GetDirection().y);
+			const __m128 directionZ = _mm_set1_ps(aRay.GetDirection().z);
+
+			const __m128 toCenterX = _mm_sub_ps(_mm_loadu_ps(someSpheres.myCenterX + anIndex), _mm_set1_ps(aRay.GetOrigin().x));
+			const __m128 toCenterY = _mm_sub_ps(_mm_loadu_ps(someSpheres.myCenterY + anIndex), _mm_set1_ps(aRay.GetOrigin().y));
+			const __m128 toCenterZ = _mm_sub_ps(_mm_loadu_ps(someSpheres.myCenterZ + anIndex), _mm_set1_ps(aRay.GetOrigin().z));
+			const __m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCenterX, directionX), _mm_mul_ps(toCenterY, directionY)), _mm_mul_ps(toCenterZ, directionZ));
+
+			const __m128 offsetX = _mm_sub_ps(toCenterX, _mm_mul_ps(directionX, projection));
+			const __m128 offsetY = _mm_sub_ps(toCenterY, _mm_mul_ps(directionY, projection));
+			const __m128 offsetZ = _mm_sub_ps(toCenterZ, _mm_mul_ps(directionZ, projection));
+			const __m128 radius = _mm_loadu_ps(someSpheres.myRadius + anIndex);
+			const __m128 halfChordSqr = _mm_sub_ps(_mm_mul_ps(radius, radius),
+				_mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ)));
+
+			const __m128 lineHit = _mm_cmpge_ps(halfChordSqr, _mm_setzero_ps());
+			if (_mm_movemask_ps(lineHit) == 0)
+			{
+				return 0;
+			}
+
+			const __m128 halfChord = _mm_sqrt_ps(_mm_max_ps(halfChordSqr, _mm_setzero_ps()));
+			const __m128 tEnter = _mm_sub_ps(projection, halfChord);
+			const __m128 tExit = _mm_add_ps(projection, halfChord);
+			const __m128 enterInFront = _mm_cmpge_ps(tEnter, _mm_setzero_ps());
+			const __m128 t = _mm_or_ps(_mm_and_ps(enterInFront, tEnter), _mm_andnot_ps(enterInFront, tExit));
+
+			__m128 hit = _mm_and_ps(lineHit, _mm_cmpge_ps(t, _mm_setzero_ps()));
+			hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_set1_ps(aMaxDistance)));
+
+			_mm_storeu_ps(someOutT, t);
+			return _mm_movemask_ps(hit);
+		}
+#endif
+
+#if defined(CU_SIMD_AVX)
+		// Same as SphereRayTest4 for 8 spheres.
+		inline int SphereRayTest8(const SphereArrays& someSpheres, const int anIndex, const Ray<float>& aRay, const float aMaxDistance, float* someOutT)
+		{
+			const __m256 directionX = _mm256_set1_ps(aRay.GetDirection().x);
+			const __m256 directionY = _mm256_set1_ps(aRay.GetDirection().y);
+			const __m256 directionZ = _mm256_set1_ps(aRay.GetDirection().z);
+
+			const __m256 toCenterX = _mm256_sub_ps(_mm256_loadu_ps(someSpheres.myCenterX + anIndex), _mm256_set1_ps(aRay.GetOrigin().x));
+			const __m256 toCenterY = _mm256_sub_ps(_mm256_loadu_ps(someSpheres.myCenterY + anIndex), _mm256_set1_ps(aRay.GetOrigin().y));
+			const __m256 toCenterZ = _mm256_sub_ps(_mm256_loadu_ps(someSpheres.myCenterZ + anIndex), _mm256_set1_ps(aRay.GetOrigin().z));
+			const __m256 projection = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(toCenterX, directionX), _mm256_mul_ps(toCenterY, directionY)), _mm256_mul_ps(toCenterZ, directionZ));
+
+			const __m256 offsetX = _mm256_sub_ps(toCenterX, _mm256_mul_ps(directionX, projection));
+			const __m256 offsetY = _mm256_sub_ps(toCenterY, _mm256_mul_ps(directionY, projection));
+			const __m256 offsetZ = _mm256_sub_ps(toCenterZ, _mm256_mul_ps(directionZ, projection));
+			const __m256 radius = _mm256_loadu_ps(someSpheres.myRadius + anIndex);
+			const __m256 halfChordSqr = _mm256_sub_ps(_mm256_mul_ps(radius, radius),
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(offsetX, offsetX), _mm256_mul_ps(offsetY, offsetY)), _mm256_mul_ps(offsetZ, offsetZ)));
+
+			const __m256 lineHit = _mm256_cmp_ps(halfChordSqr, _mm256_setzero_ps(), _CMP_GE_OQ);
+			if (_mm256_movemask_ps(lineHit) == 0)
+			{
+				return 0;
+			}
+
+			const __m256 halfChord = _mm256_sqrt_ps(_mm256_max_ps(halfChordSqr, _mm256_setzero_ps()));
+			const __m256 tEnter = _mm256_sub_ps(projection, halfChord);
+			const __m256 tExit = _mm256_add_ps(projection, halfChord);
+			const __m256 t = _mm256_blendv_ps(tExit, tEnter, _mm256_cmp_ps(tEnter, _mm256_setzero_ps(), _CMP_GE_OQ));
+
+			__m256 hit = _mm256_and_ps(lineHit, _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_set1_ps(aMaxDistance), _CMP_LT_OQ));
+
+			_mm256_storeu_ps(someOutT, t);
+			return _mm256_movemask_ps(hit);
+		}
+#endif
+
+		// Keeps the closest of the lanes in aMask, lane i holds sphere aFirst + i.
+		inline void ReduceSphereHits(int aMask, const int aFirst, const float* someT, int& aOutIndex, float& aInOutDistance)
+		{
+			for (int lane = 0; aMask != 0; ++lane, aMask >>= 1)
+			{
+				if ((aMask & 1) != 0 && someT[lane] < aInOutDistance)
+				{
+					aOutIndex = aFirst + lane;
+					aInOutDistance = someT[lane];
+				}
+			}
+		}
+
+		// Squared distance from a point to a box given as center and half size, per axis the distance is
+		// how far the point is outside the extent.
+		inline float PointAABBDistanceSqr(const float aX, const float aY, const float aZ,
+			const float aCenterX, const float aCenterY, const float aCenterZ,
+			const float anExtentX, const float anExtentY, const float anExtentZ)
+		{
+			const float dx = Max(Abs(aX - aCenterX) - anExtentX, 0.0f);
+			const float dy = Max(Abs(aY - aCenterY) - anExtentY, 0.0f);
+			const float dz = Max(Abs(aZ - aCenterZ) - anExtentZ, 0.0f);
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+#if defined(CU_SIMD_SSE)
+		inline __m128 PointAABBDistanceSqr4(const __m128 aX, const __m128 aY, const __m128 aZ,
+			const __m128 aCenterX, const __m128 aCenterY, const __m128 aCenterZ,
+			const __m128 anExtentX, const __m128 anExtentY, const __m128 anExtentZ)
+		{
+			const __m128 sign = _mm_set1_ps(-0.0f);
+			const __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(aX, aCenterX)), anExtentX), _mm_setzero_ps());
+			const __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(aY, aCenterY)), anExtentY), _mm_setzero_ps());
+			const __m128 dz = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(aZ, aCenterZ)), anExtentZ), _mm_setzero_ps());
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		}
+#endif
+
+#if defined(CU_SIMD_AVX)
+		inline __m256 PointAABBDistanceSqr8(const __m256 aX, const __m256 aY, const __m256 aZ,
+			const __m256 aCenterX, const __m256 aCenterY, const __m256 aCenterZ,
+			const __m256 anExtentX, const __m256 anExtentY, const __m256 anExtentZ)
+		{
+			const __m256 sign = _mm256_set1_ps(-0.0f);
+			const __m256 dx = _mm256_max_ps(_mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(aX, aCenterX)), anExtentX), _mm256_setzero_ps());
+			const __m256 dy = _mm256_max_ps(_mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(aY, aCenterY)), anExtentY), _mm256_setzero_ps());
+			const __m256 dz = _mm256_max_ps(_mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(aZ, aCenterZ)), anExtentZ), _mm256_setzero_ps());
+			return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		}
+#endif
+
+		// The overlap testers below test one volume against element anIndex (Test1), anIndex to anIndex + 3
+		// (Test4) or anIndex to anIndex + 7 (Test8) of a structure of arrays and return a bit per element.
+
+		class SphereSphereTester
+		{
+		public:
+			SphereSphereTester(const Sphere<float>& aSphere, const SphereArrays& someSpheres)
+				: myX(aSphere.GetCenter().x)
+				, myY(aSphere.GetCenter().y)
+				, myZ(aSphere.GetCenter().z)
+				, myRadius(aSphere.GetRadius())
+				, mySpheres(someSpheres)
+			{
+			}
+
+			int Test1(const int anIndex) const
+			{
+				const float dx = mySpheres.myCenterX[anIndex] - myX;
+				const float dy = mySpheres.myCenterY[anIndex] - myY;
+				const float dz = mySpheres.myCenterZ[anIndex] - myZ;
+				const float radiusSum = mySpheres.myRadius[anIndex] + myRadius;
+				return dx * dx + dy * dy + dz * dz <= radiusSum * radiusSum ? 1 : 0;
+			}
+
+#if defined(CU_SIMD_SSE)
+			int Test4(const int anIndex) const
+			{
+				const __m128 dx = _mm_sub_ps(_mm_loadu_ps(mySpheres.myCenterX + anIndex), _mm_set1_ps(myX));
+				const __m128 dy = _mm_sub_ps(_mm_loadu_ps(mySpheres.myCenterY + anIndex), _mm_set1_ps(myY));
+				const __m128 dz = _mm_sub_ps(_mm_loadu_ps(mySpheres.myCenterZ + anIndex), _mm_set1_ps(myZ));
+				const __m128 radiusSum = _mm_add_ps(_mm_loadu_ps(mySpheres.myRadius + anIndex), _mm_set1_ps(myRadius));
+				const __m128 distanceSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				return _mm_movemask_ps(_mm_cmple_ps(distanceSqr, _mm_mul_ps(radiusSum, radiusSum)));
+			}
+#endif
+
+#if defined(CU_SIMD_AVX)
+			int Test8(const int anIndex) const
+			{
+				const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(mySpheres.myCenterX + anIndex), _mm256_set1_ps(myX));
+				const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(mySpheres.myCenterY + anIndex), _mm256_set1_ps(myY));
+				const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(mySpheres.myCenterZ + anIndex), _mm256_set1_ps(myZ));
+				const __m256 radiusSum = _mm256_add_ps(_mm256_loadu_ps(mySpheres.myRadius + anIndex), _mm256_set1_ps(myRadius));
+				const __m256 distanceSqr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+				return _mm256_movemask_ps(_mm256_cmp_ps(distanceSqr, _mm256_mul_ps(radiusSum, radiusSum), _CMP_LE_OQ));
+			}
+#endif
+
+		private:
+			float myX;
+			float myY;
+			float myZ;
+			float myRadius;
+			SphereArrays mySpheres;
+		};
+
+		// Boxes overlap when on every axis their centers are no further apart than the extents together.
+		class AABBAABBTester
+		{
+		public:
+			AABBAABBTester(const AABB3D<float>& anAABB, const AABBArrays& someAABBs)
+				: myX((anAABB.myMinPoint.x + anAABB.myMaxPoint.x) * 0.5f)
+				, myY((anAABB.myMinPoint.y + anAABB.myMaxPoint.y) * 0.5f)
+				, myZ((anAABB.myMinPoint.z + anAABB.myMaxPoint.z) * 0.5f)
+				, myExtentX((anAABB.myMaxPoint.x - anAABB.myMinPoint.x) * 0.5f)
+				, myExtentY((anAABB.myMaxPoint.y - anAABB.myMinPoint.y) * 0.5f)
+				, myExtentZ((anAABB.myMaxPoint.z - anAABB.myMinPoint.z) * 0.5f)
+				, myAABBs(someAABBs)
+			{
+			}
+
+			int Test1(const int anIndex) const
+			{
+				return Abs(myAABBs.myCenterX[anIndex] - myX) <= myAABBs.myExtentX[anIndex] + myExtentX &&
+					Abs(myAABBs.myCenterY[anIndex] - myY) <= myAABBs.myExtentY[anIndex] + myExtentY &&
+					Abs(myAABBs.myCenterZ[anIndex] - myZ) <= myAABBs.myExtentZ[anIndex] + myExtentZ ? 1 : 0;
+			}
+
+#if defined(CU_SIMD_SSE)
+			int Test4(const int anIndex) const
+			{
+				const __m128 sign = _mm_set1_ps(-0.0f);
+				const __m128 dx = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(myAABBs.myCenterX + anIndex), _mm_set1_ps(myX)));
+				const __m128 dy = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(myAABBs.myCenterY + anIndex), _mm_set1_ps(myY)));
+				const __m128 dz = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(myAABBs.myCenterZ + anIndex), _mm_set1_ps(myZ)));
+				__m128 hit = _mm_cmple_ps(dx, _mm_add_ps(_mm_loadu_ps(myAABBs.myExtentX + anIndex), _mm_set1_ps(myExtentX)));
+				hit = _mm_and_ps(hit, _mm_cmple_ps(dy, _mm_add_ps(_mm_loadu_ps(myAABBs.myExtentY + anIndex), _mm_set1_ps(myExtentY))));
+				hit = _mm_and_ps(hit, _mm_cmple_ps(dz, _mm_add_ps(_mm_loadu_ps(myAABBs.myExtentZ + anIndex), _mm_set1_ps(myExtentZ))));
+				return _mm_movemask_ps(hit);
+			}
+#endif
+
+#if defined(CU_SIMD_AVX)
+			int Test8(const int anIndex) const
+			{
+				const __m256 sign = _mm256_set1_ps(-0.0f);
+				const __m256 dx = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(myAABBs.myCenterX + anIndex), _mm256_set1_ps(myX)));
+				const __m256 dy = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(myAABBs.myCenterY + anIndex), _mm256_set1_ps(myY)));
+				const __m256 dz = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(myAABBs.myCenterZ + anIndex), _mm256_set1_ps(myZ)));
+				__m256 hit = _mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(myAABBs.myExtentX + anIndex), _mm256_set1_ps(myExtentX)), _CMP_LE_OQ);
+				hit = _mm256_and_ps(hit, _mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(myAABBs.myExtentY + anIndex), _mm256_set1_ps(myExtentY)), _CMP_LE_OQ));
+				hit = _mm256_and_ps(hit, _mm256_cmp_ps(dz, _mm256_add_ps(_mm256_loadu_ps(myAABBs.myExtentZ + anIndex), _mm256_set1_ps(myExtentZ)), _CMP_LE_OQ));
+				return _mm256_movemask_ps(hit);
+			}
+#endif
+
+		private:
+			float myX;
+			float myY;
+			float myZ;
+			float myExtentX;
+			float myExtentY;
+			float myExtentZ;
+			AABBArrays myAABBs;
+		};
+
+		// One sphere against many boxes.
+		class SphereAABBTester
+		{
+		public:
+			SphereAABBTester(const Sphere<float>& aSphere, const AABBArrays& someAABBs)
+				: myX(aSphere.GetCenter().x)
+				, myY(aSphere.GetCenter().y)
+				, myZ(aSphere.GetCenter().z)
+				, myRadiusSqr(aSphere.GetRadiusSqr())
+				, myAABBs(someAABBs)
+			{
+			}
+
+			int Test1(const int anIndex) const
+			{
+				return PointAABBDistanceSqr(myX, myY, myZ,
+					myAABBs.myCenterX[anIndex], myAABBs.myCenterY[anIndex], myAABBs.myCenterZ[anIndex],
+					myAABBs.myExtentX[anIndex], myAABBs.myExtentY[anIndex], myAABBs.myExtentZ[anIndex]) <= myRadiusSqr ? 1 : 0;
+			}
+
+#if defined(CU_SIMD_SSE)
+			int Test4(const int anIndex) const
+			{
+				const __m128 distanceSqr = PointAABBDistanceSqr4(_mm_set1_ps(myX), _mm_set1_ps(myY), _mm_set1_ps(myZ),
+					_mm_loadu_ps(myAABBs.myCenterX + anIndex), _mm_loadu_ps(myAABBs.myCenterY + anIndex), _mm_loadu_ps(myAABBs.myCenterZ + anIndex),
+					_mm_loadu_ps(myAABBs.myExtentX + anIndex), _mm_loadu_ps(myAABBs.myExtentY + anIndex), _mm_loadu_ps(myAABBs.myExtentZ + anIndex));
+				return _mm_movemask_ps(_mm_cmple_ps(distanceSqr, _mm_set1_ps(myRadiusSqr)));
+			}
+#endif
+
+#if defined(CU_SIMD_AVX)
+			int Test8(const int anIndex) const
+			{
+				const __m256 distanceSqr = PointAABBDistanceSqr8(_mm256_set1_ps(myX), _mm256_set1_ps(myY), _mm256_set1_ps(myZ),
+					_mm256_loadu_ps(myAABBs.myCenterX + anIndex), _mm256_loadu_ps(myAABBs.myCenterY + anIndex), _mm256_loadu_ps(myAABBs.myCenterZ + anIndex),
+					_mm256_loadu_ps(myAABBs.myExtentX + anIndex), _mm256_loadu_ps(myAABBs.myExtentY + anIndex), _mm256_loadu_ps(myAABBs.myExtentZ + anIndex));
+				return _mm256_movemask_ps(_mm256_cmp_ps(distanceSqr, _mm256_set1_ps(myRadiusSqr), _CMP_LE_OQ));
+			}
+#endif
+
+		private:
+			float myX;
+			float myY;
+			float myZ;
+			float myRadiusSqr;
+			AABBArrays myAABBs;
+		};
+
+		// One box against many spheres.
+		class AABBSphereTester
+		{
+		public:
+			AABBSphereTester(const AABB3D<float>& anAABB, const SphereArrays& someSpheres)
+				: myX((anAABB.myMinPoint.x + anAABB.myMaxPoint.x) * 0.5f)
+				, myY((anAABB.myMinPoint.y + anAABB.myMaxPoint.y) * 0.5f)
+				, myZ((anAABB.myMinPoint.z + anAABB.myMaxPoint.z) * 0.5f)
+				, myExtentX((anAABB.myMaxPoint.x - anAABB.myMinPoint.x) * 0.5f)
+				, myExtentY((anAABB.myMaxPoint.y - anAABB.myMinPoint.y) * 0.5f)
+				, myExtentZ((anAABB.myMaxPoint.z - anAABB.myMinPoint.z) * 0.5f)
+				, mySpheres(someSpheres)
+			{
+			}
+
+			int Test1(const int anIndex) const
+			{
+				const float radius = mySpheres.myRadius[anIndex];
+				return PointAABBDistanceSqr(mySpheres.myCenterX[anIndex], mySpheres.myCenterY[anIndex], mySpheres.myCenterZ[anIndex],
+					myX, myY, myZ, myExtentX, myExtentY, myExtentZ) <= radius * radius ? 1 : 0;
+			}
+
+#if defined(CU_SIMD_SSE)
+			int Test4(const int anIndex) const
+			{
+				const __m128 radius = _mm_loadu_ps(mySpheres.myRadius + anIndex);
+				const __m128 distanceSqr = PointAABBDistanceSqr4(
+					_mm_loadu_ps(mySpheres.myCenterX + anIndex), _mm_loadu_ps(mySpheres.myCenterY + anIndex), _mm_loadu_ps(mySpheres.myCenterZ + anIndex),
+					_mm_set1_ps(myX), _mm_set1_ps(myY), _mm_set1_ps(myZ),
+					_mm_set1_ps(myExtentX), _mm_set1_ps(myExtentY), _mm_set1_ps(myExtentZ));
+				return _mm_movemask_ps(_mm_cmple_ps(distanceSqr, _mm_mul_ps(radius, radius)));
+			}
+#endif
+
+#if defined(CU_SIMD_AVX)
+			int Test8(const int anIndex) const
+			{
+				const __m256 radius = _mm256_loadu_ps(mySpheres.myRadius + anIndex);
+				const __m256 distanceSqr = PointAABBDistanceSqr8(
+					_mm256_loadu_ps(mySpheres.myCenterX + anIndex), _mm256_loadu_ps(mySpheres.myCenterY + anIndex), _mm256_loadu_ps(mySpheres.myCenterZ + anIndex),
+					_mm256_set1_ps(myX), _mm256_set1_ps(myY), _mm256_set1_ps(myZ),
+					_mm256_set1_ps(myExtentX), _mm256_set1_ps(myExtentY), _mm256_set1_ps(myExtentZ));
+				return _mm256_movemask_ps(_mm256_cmp_ps(distanceSqr, _mm256_mul_ps(radius, radius), _CMP_LE_OQ));
+			}
+#endif
+
+		private:
+			float myX;
+			float myY;
+			float myZ;
+			float myExtentX;
+			float myExtentY;
+			float myExtentZ;
+			SphereArrays mySpheres;
+		};
+
+		// Many spheres against one plane, same test as IntersectionSpherePlane.
+		class SpherePlaneTester
+		{
+		public:
+			SpherePlaneTester(const Plane<float>& aPlane, const SphereArrays& someSpheres)
+				: myNormalX(aPlane.GetNormal().x)
+				, myNormalY(aPlane.GetNormal().y)
+				, myNormalZ(aPlane.GetNormal().z)
+				, myDistance(-aPlane.GetNormal().Dot(aPlane.GetPoint()))
+				, myNormalLengthSqr(aPlane.GetNormal().LengthSqr())
+				, mySpheres(someSpheres)
+			{
+			}
+
+			int Test1(const int anIndex) const
+			{
+				const float distance = myNormalX * mySpheres.myCenterX[anIndex] + myNormalY * mySpheres.myCenterY[anIndex] + myNormalZ * mySpheres.myCenterZ[anIndex] + myDistance;
+				const float radius = mySpheres.myRadius[anIndex];
+				return distance <= 0.0f || distance * distance <= radius * radius * myNormalLengthSqr ? 1 : 0;
+			}
+
+#if defined(CU_SIMD_SSE)
+			int Test4(const int anIndex) const
+			{
+				const __m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(myNormalX), _mm_loadu_ps(mySpheres.myCenterX + anIndex)), _mm_mul_ps(_mm_set1_ps(myNormalY), _mm_loadu_ps(mySpheres.myCenterY + anIndex))),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(myNormalZ), _mm_loadu_ps(mySpheres.myCenterZ + anIndex)), _mm_set1_ps(myDistance)));
+				const __m128 radius = _mm_loadu_ps(mySpheres.myRadius + anIndex);
+				const __m128 reachSqr = _mm_mul_ps(_mm_mul_ps(radius, radius), _mm_set1_ps(myNormalLengthSqr));
+				const __m128 hit = _mm_or_ps(_mm_cmple_ps(distance, _mm_setzero_ps()), _mm_cmple_ps(_mm_mul_ps(distance, distance), reachSqr));
+				return _mm_movemask_ps(hit);
+			}
+#endif
+
+#if defined(CU_SIMD_AVX)
+			int Test8(const int anIndex) const
+			{
+				const __m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myNormalX), _mm256_loadu_ps(mySpheres.myCenterX + anIndex)), _mm256_mul_ps(_mm256_set1_ps(myNormalY), _mm256_loadu_ps(mySpheres.myCenterY + anIndex))),
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(myNormalZ), _mm256_loadu_ps(mySpheres.myCenterZ + anIndex)), _mm256_set1_ps(myDistance)));
+				const __m256 radius = _mm256_loadu_ps(mySpheres.myRadius + anIndex);
+				const __m256 reachSqr = _mm256_mul_ps(_mm256_mul_ps(radius, radius), _mm256_set1_ps(myNormalLengthSqr));
+				const __m256 hit = _mm256_or_ps(_mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LE_OQ), _mm256_cmp_ps(_mm256_mul_ps(distance, distance), reachSqr, _CMP_LE_OQ));
+				return _mm256_movemask_ps(hit);
+			}
+#endif
+
+		private:
+			float myNormalX;
+			float myNormalY;
+			float myNormalZ;
+			float myDistance;
+			float myNormalLengthSqr;
+			SphereArrays mySpheres;
+		};
+
+		// Runs aTester over aCount elements, 8 at a time with AVX, 4 with SSE and then one at a time, and
+		// writes bit i % 32 of word i / 32 for element i. Blocks start at multiples of their width so no
+		// block crosses a word.
+		template<typename Tester>
+		inline void TestToMask(const Tester& aTester, const int aCount, uint32_t* someOutMask)
+		{
+			for (int word = 0; word < (aCount + 31) / 32; ++word)
+			{
+				someOutMask[word] = 0;
+			}
+
+			int index = 0;
+#if defined(CU_SIMD_AVX)
+			for (; index + 8 <= aCount; index += 8)
+			{
+				someOutMask[index / 32] |= static_cast<uint32_t>(aTester.Test8(index)) << (index % 32);
+			}
+#endif
+#if defined(CU_SIMD_SSE)
+			for (; index + 4 <= aCount; index += 4)
+			{
+				someOutMask[index / 32] |= static_cast<uint32_t>(aTester.Test4(index)) << (index % 32);
+			}
+#endif
+			for (; index < aCount; ++index)
+			{
+				someOutMask[index / 32] |= static_cast<uint32_t>(aTester.Test1(index)) << (index % 32);
+			}
+		}
+	}
+
+	// Tests 4 rays against one box. someOutTEnter (4 floats, optional) receives the entry distance per ray.
+	inline int IntersectionAABBRay(const AABB3D<float>& aAABB, const RayPacket4& someRays, float* someOutTEnter = nullptr)
+	{
+		const detail::Broadcast<4> minX(aAABB.myMinPoint.x), minY(aAABB.myMinPoint.y), minZ(aAABB.myMinPoint.z);
+		const detail::Broadcast<4> maxX(aAABB.myMaxPoint.x), maxY(aAABB.myMaxPoint.y), maxZ(aAABB.myMaxPoint.z);
+		return detail::SlabTest4(
+			minX.myValues, minY.myValues, minZ.myValues, maxX.myValues, maxY.myValues, maxZ.myValues,
+			someRays.myOriginX, someRays.myOriginY, someRays.myOriginZ,
+			someRays.myInverseDirectionX, someRays.myInverseDirectionY, someRays.myInverseDirectionZ,
+			someOutTEnter);
+	}
+
+	// Tests 8 rays against one box. someOutTEnter (8 floats, optional) receives the entry distance per ray.
+	inline int IntersectionAABBRay(const AABB3D<float>& aAABB, const RayPacket8& someRays, float* someOutTEnter = nullptr)
+	{
+		const detail::Broadcast<8> minX(aAABB.myMinPoint.x), minY(aAABB.myMinPoint.y), minZ(aAABB.myMinPoint.z);
+		const detail::Broadcast<8> maxX(aAABB.myMaxPoint.x), maxY(aAABB.myMaxPoint.y), maxZ(aAABB.myMaxPoint.z);
+		return detail::SlabTest8(
+			minX.myValues, minY.myValues, minZ.myValues, maxX.myValues, maxY.myValues, maxZ.myValues,
+			someRays.myOriginX, someRays.myOriginY, someRays.myOriginZ,
+			someRays.myInverseDirectionX, someRays.myInverseDirectionY, someRays.myInverseDirectionZ,
+			someOutTEnter);
+	}
+
+	// Tests one ray against 4 boxes. someOutTEnter (4 floats, optional) receives the entry distance per box.
+	inline int IntersectionAABBRay(const AABBPacket4& someAABBs, const Ray<float>& aRay, float* someOutTEnter = nullptr)
+	{
+		const detail::Broadcast<4> originX(aRay.GetOrigin().x), originY(aRay.GetOrigin().y), originZ(aRay.GetOrigin().z);
+		const detail::Broadcast<4> inverseX(aRay.GetInverseDirection().x), inverseY(aRay.GetInverseDirection().y), inverseZ(aRay.GetInverseDirection().z);
+		return detail::SlabTest4(
+			someAABBs.myMinX, someAABBs.myMinY, someAABBs.myMinZ, someAABBs.myMaxX, someAABBs.myMaxY, someAABBs.myMaxZ,
+			originX.myValues, originY.myValues, originZ.myValues, inverseX.myValues, inverseY.myValues, inverseZ.myValues,
+			someOutTEnter);
+	}
+
+	// Tests one ray against 8 boxes. someOutTEnter (8 floats, optional) receives the entry distance per box.
+	inline int IntersectionAABBRay(const AABBPacket8& someAABBs, const Ray<float>& aRay, float* someOutTEnter = nullptr)
+	{
+		const detail::Broadcast<8> originX(aRay.GetOrigin().x), originY(aRay.GetOrigin().y), originZ(aRay.GetOrigin().z);
+		const detail::Broadcast<8> inverseX(aRay.GetInverseDirection().x), inverseY(aRay.GetInverseDirection().y), inverseZ(aRay.GetInverseDirection().z);
+		return detail::SlabTest8(
+			someAABBs.myMinX, someAABBs.myMinY, someAABBs.myMinZ, someAABBs.myMaxX, someAABBs.myMaxY, someAABBs.myMaxZ,
+			originX.myValues, originY.myValues, originZ.myValues, inverseX.myValues, inverseY.myValues, inverseZ.myValues,
+			someOutTEnter);
+	}
+
+	// Tests one ray against triangles aFirst to aFirst + aCount - 1 of someTriangles and keeps the closest hit.
+	// Only hits closer than aInOutDistance count, on a hit it is lowered to the hit distance and aOutIndex,
+	// aOutU and aOutV are set (u and v weight the second and third point). Runs 8 triangles per step with
+	// AVX, 4 with SSE and the rest one at a time.
+	inline bool IntersectionTriangleRay(const TriangleBatch& someTriangles, const int aFirst, const int aCount, const Ray<float>& aRay,
+		int& aOutIndex, float& aInOutDistance, float& aOutU, float& aOutV)
+	{
+		const int end = aFirst + aCount;
+		int index = aFirst;
+		bool found = false;
+
+#if defined(CU_SIMD_SSE) || defined(CU_SIMD_AVX)
+		alignas(32) float t[8];
+		alignas(32) float u[8];
+		alignas(32) float v[8];
+#endif
+#if defined(CU_SIMD_AVX)
+		for (; index + 8 <= end; index += 8)
+		{
+			const int mask = detail::TriangleTest8(someTriangles, index, aRay, aInOutDistance, t, u, v);
+			if (mask != 0)
+			{
+				found |= detail::ReduceTriangleHits(mask, index, t, u, v, aOutIndex, aInOutDistance, aOutU, aOutV);
+			}
+		}
+#endif
+#if defined(CU_SIMD_SSE)
+		for (; index + 4 <= end; index += 4)
+		{
+			const int mask = detail::TriangleTest4(someTriangles, index, aRay, aInOutDistance, t, u, v);
+			if (mask != 0)
+			{
+				found |= detail::ReduceTriangleHits(mask, index, t, u, v, aOutIndex, aInOutDistance, aOutU, aOutV);
+			}
+		}
+#endif
+		for (; index < end; ++index)
+		{
+			float hitT;
+			float hitU;
+			float hitV;
+			if (detail::TriangleTest1(someTriangles, index, aRay, hitT, hitU, hitV) && hitT < aInOutDistance)
+			{
+				aOutIndex = index;
+				aInOutDistance = hitT;
+				aOutU = hitU;
+				aOutV = hitV;
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	// Tests one ray against every triangle of someTriangles, see the ranged version above.
+	inline bool IntersectionTriangleRay(const TriangleBatch& someTriangles, const Ray<float>& aRay,
+		int& aOutIndex, float& aInOutDistance, float& aOutU, float& aOutV)
+	{
+		return IntersectionTriangleRay(someTriangles, 0, someTriangles.Size(), aRay, aOutIndex, aInOutDistance, aOutU, aOutV);
+	}
+
+	// Tests one ray with a normalized direction against aCount spheres and keeps the closest hit in front of
+	// the origin. Only hits closer than aInOutDistance count, on a hit it is lowered to the hit distance,
+	// aOutIndex is set and aOutNormal is the unit normal at the hit as in IntersectionSphereRay. Runs 8
+	// spheres per step with AVX, 4 with SSE and the rest one at a time.
+	inline bool IntersectionSphereRay(const SphereArrays& someSpheres, const int aCount, const Ray<float>& aRay,
+		int& aOutIndex, float& aInOutDistance, Vector3<float>& aOutNormal)
+	{
+		int index = 0;
+		int closest = -1;
+
+#if defined(CU_SIMD_SSE) || defined(CU_SIMD_AVX)
+		alignas(32) float t[8];
+#endif
+#if defined(CU_SIMD_AVX)
+		for (; index + 8 <= aCount; index += 8)
+		{
+			const int mask = detail::SphereRayTest8(someSpheres, index, aRay, aInOutDistance, t);
+			if (mask != 0)
+			{
+				detail::ReduceSphereHits(mask, index, t, closest, aInOutDistance);
+			}
+		}
+#endif
+#if defined(CU_SIMD_SSE)
+		for (; index + 4 <= aCount; index += 4)
+		{
+			const int mask = detail::SphereRayTest4(someSpheres, index, aRay, aInOutDistance, t);
+			if (mask != 0)
+			{
+				detail::ReduceSphereHits(mask, index, t, closest, aInOutDistance);
+			}
+		}
+#endif
+		for (; index < aCount; ++index)
+		{
+			float hitT;
+			if (detail::SphereRayTest1(someSpheres, index, aRay, hitT) && hitT < aInOutDistance)
+			{
+				closest = index;
+				aInOutDistance = hitT;
+			}
+		}
+
+		if (closest < 0)
+		{
+			return false;
+		}
+
+		// The normal is only needed for the closest sphere.
+		const Vector3<float> center(someSpheres.myCenterX[closest], someSpheres.myCenterY[closest], someSpheres.myCenterZ[closest]);
+		aOutNormal = (aRay.GetOrigin() + aRay.GetDirection() * aInOutDistance - center) * (1.0f / someSpheres.myRadius[closest]);
+		aOutIndex = closest;
+		return true;
+	}
+
+	// The overlap batches test one volume against aCount volumes stored as structure of arrays. Bit i % 32 of
+	// word i / 32 of someOutMask is set when element i overlaps, someOutMask must hold (aCount + 31) / 32
+	// words. They give the same results as the scalar tests in Intersection.hpp.
+
+	inline void IntersectionSphereSphere(const Sphere<float>& aSphere, const SphereArrays& someSpheres, const int aCount, uint32_t* someOutMask)
+	{
+		detail::TestToMask(detail::SphereSphereTester(aSphere, someSpheres), aCount, someOutMask);
+	}
+
+	inline void IntersectionAABBAABB(const AABB3D<float>& anAABB, const AABBArrays& someAABBs, const int aCount, uint32_t* someOutMask)
+	{
+		detail::TestToMask(detail::AABBAABBTester(anAABB, someAABBs), aCount, someOutMask);
+	}
+
+	inline void IntersectionSphereAABB(const Sphere<float>& aSphere, const AABBArrays& someAABBs, const int aCount, uint32_t* someOutMask)
+	{
+		detail::TestToMask(detail::SphereAABBTester(aSphere, someAABBs), aCount, someOutMask);
+	}
+
+	inline void IntersectionAABBSphere(const AABB3D<float>& anAABB, const SphereArrays& someSpheres, const int aCount, uint32_t* someOutMask)
+	{
+		detail::TestToMask(detail::AABBSphereTester(anAABB, someSpheres), aCount, someOutMask);
+	}
+
+	// Sets the bits of the spheres that are at least partly inside aPlane.
+	inline void IntersectionSpherePlane(const Plane<float>& aPlane, const SphereArrays& someSpheres, const int aCount, uint32_t* someOutMask)
+	{
+		detail::TestToMask(detail::SpherePlaneTester(aPlane, someSpheres), aCount, someOutMask);
+	}
+}
+
+namespace CU = CommonUtilities;
@@ -0,0 +1,634 @@
+#include "pch.h"
+#include "LooseOctree.h"
+#include "Maths.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    const int DepthBits = 5;
+    const uint64_t DepthMask = (1ull << DepthBits) - 1;
+
+    // Spreads the low 16 bits of aValue so there are two zero bits between each of them.
+    uint64_t SpreadBits(uint32_t aValue)
+    {
+        uint64_t value = aValue & 0xFFFF;
+        value = (value | (value << 16)) & 0x0000FF0000FFull;
+        value = (value | (value << 8)) & 0x00F00F00F00Full;
+        value = (value | (value << 4)) & 0x0C30C30C30C3ull;
+        value = (value | (value << 2)) & 0x249249249249ull;
+        return value;
+    }
+
+    uint32_t CompactBits(uint64_t aValue)
+    {
+        uint64_t value = aValue & 0x249249249249ull;
+        value = (value | (value >> 2)) & 0x0C30C30C30C3ull;
+        value = (value | (value >> 4)) & 0x00F00F00F00Full;
+        value = (value | (value >> 8)) & 0x0000FF0000FFull;
+        value = (value | (value >> 16)) & 0xFFFF;
+        return static_cast<uint32_t>(value);
+    }
+
+    int GetDepth(const uint64_t aKey)
+    {
+        return static_cast<int>(aKey & DepthMask);
+    }
+
+    // Morton code of the cell, aligned so cells at every depth share the bit layout.
+    uint64_t GetAlignedCode(const uint64_t aKey)
+    {
+        return aKey >> DepthBits;
+    }
+
+    int GetAlignShift(const int aDepth)
+    {
+        return 3 * (CommonUtilities::LooseOctree::MaxSupportedDepth - aDepth);
+    }
+
+    bool IsAncestorOrSelf(const uint64_t anAncestor, const uint64_t aKey)
+    {
+        const int depth = GetDepth(anAncestor);
+        const int shift = GetAlignShift(depth);
+        return depth <= GetDepth(aKey) && (GetAlignedCode(anAncestor) >> shift) == (GetAlignedCode(aKey) >> shift);
+    }
+
+    // Key of the cell at aDepth that holds the cell of aKey.
+    uint64_t GetAncestorKey(const uint64_t aKey, const int aDepth)
+    {
+        const int shift = GetAlignShift(aDepth);
+        return (((GetAlignedCode(aKey) >> shift) << shift) << DepthBits) | static_cast<uint64_t>(aDepth);
+    }
+
+    bool Overlaps(const float* aMin, const float* aMax, const CommonUtilities::AABB3D<float>& anAABB)
+    {
+        return aMin[0] <= anAABB.myMaxPoint.x && aMax[0] >= anAABB.myMinPoint.x &&
+            aMin[1] <= anAABB.myMaxPoint.y && aMax[1] >= anAABB.myMinPoint.y &&
+            aMin[2] <= anAABB.myMaxPoint.z && aMax[2] >= anAABB.myMinPoint.z;
+    }
+
+    bool Contains(const CommonUtilities::AABB3D<float>& anAABB, const float* aMin, const float* aMax)
+    {
+        return anAABB.myMinPoint.x <= aMin[0] && aMax[0] <= anAABB.myMaxPoint.x &&
+            anAABB.myMinPoint.y <= aMin[1] && aMax[1] <= anAABB.myMaxPoint.y &&
+            anAABB.myMinPoint.z <= aMin[2] && aMax[2] <= anAABB.myMaxPoint.z;
+    }
+
+    bool RayHitsBox(const CommonUtilities::Ray<float>& aRay, const float aMaxDistance, const float* aMin, const float* aMax)
+    {
+        const CommonUtilities::Vector3<float>& origin = aRay.GetOrigin();
+        const CommonUtilities::Vector3<float>& inverse = aRay.GetInverseDirection();
+
+        float t0 = (aMin[0] - origin.x) * inverse.x;
+        float t1 = (aMax[0] - origin.x) * inverse.x;
+        float tEnter = CommonUtilities::Min(t0, t1);
+        float tExit = CommonUtilities::Max(t0, t1);
+
+        t0 = (aMin[1] - origin.y) * inverse.y;
+        t1 = (aMax[1] - origin.y) * inverse.y;
+        tEnter = CommonUtilities::Max(tEnter, CommonUtilities::Min(t0, t1));
+        tExit = CommonUtilities::Min(tExit, CommonUtilities::Max(t0, t1));
+
+        t0 = (aMin[2] - origin.z) * inverse.z;
+        t1 = (aMax[2] - origin.z) * inverse.z;
+        tEnter = CommonUtilities::Max(tEnter, CommonUtilities::Min(t0, t1));
+        tExit = CommonUtilities::Min(tExit, CommonUtilities::Max(t0, t1));
+
+        return tExit >= CommonUtilities::Max(tEnter, 0.0f) && tEnter <= aMaxDistance;
+    }
+
+    float DistanceSqrToBox(const CommonUtilities::Vector3<float>& aPoint, const float* aMin, const float* aMax)
+    {
+        const float dx = CommonUtilities::Max(CommonUtilities::Max(aMin[0] - aPoint.x, 0.0f), aPoint.x - aMax[0]);
+        const float dy = CommonUtilities::Max(CommonUtilities::Max(aMin[1] - aPoint.y, 0.0f), aPoint.y - aMax[1]);
+        const float dz = CommonUtilities::Max(CommonUtilities::Max(aMin[2] - aPoint.z, 0.0f), aPoint.z - aMax[2]);
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    float FarthestDistanceSqrToBox(const CommonUtilities::Vector3<float>& aPoint, const float* aMin, const float* aMax)
+    {
+        const float dx = CommonUtilities::Max(aPoint.x - aMin[0], aMax[0] - aPoint.x);
+        const float dy = CommonUtilities::Max(aPoint.y - aMin[1], aMax[1] - aPoint.y);
+        const float dz = CommonUtilities::Max(aPoint.z - aMin[2], aMax[2] - aPoint.z);
+        return dx * dx + dy * dy + dz * dz;
+    }
+}
+
+// Clamp and push_back take their arguments by reference, so the constants need definitions.
+const int CommonUtilities::LooseOctree::MaxSupportedDepth;
+const int CommonUtilities::LooseOctree::NullNode;
+
+CommonUtilities::LooseOctree::LooseOctree(int aMaxDepth)
+    : myMaxDepth(Clamp(0, MaxSupportedDepth, aMaxDepth))
+{
+    Clear(AABB3D<float>({ -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f }));
+}
+
+void CommonUtilities::LooseOctree::Build(const AABB3D<float>* someAABBs, const int* someUserData, int aCount, int* someOutHandles)
+{
+    AABB3D<float> world;
+    if (aCount > 0)
+    {
+        world = someAABBs[0];
+        for (int i = 1; i < aCount; ++i)
+        {
+            world.myMinPoint = Vector3<float>(Min(world.myMinPoint.x, someAABBs[i].myMinPoint.x), Min(world.myMinPoint.y, someAABBs[i].myMinPoint.y), Min(world.myMinPoint.z, someAABBs[i].myMinPoint.z));
+            world.myMaxPoint = Vector3<float>(Max(world.myMaxPoint.x, someAABBs[i].myMaxPoint.x), Max(world.myMaxPoint.y, someAABBs[i].myMaxPoint.y), Max(world.myMaxPoint.z, someAABBs[i].myMaxPoint.z));
+        }
+    }
+    SetWorld(world);
+
+    std::vector<std::pair<uint64_t, int>> order(aCount);
+    for (int i = 0; i < aCount; ++i)
+    {
+        order[i] = std::make_pair(GetObjectKey(someAABBs[i]), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    // Objects are stored in node order, so the objects of a node are next to each other in memory.
+    myObjects.resize(aCount);
+    myObjectNodes.resize(aCount);
+    myFreeObjects = NullObject;
+    myObjectCount = aCount;
+    for (int i = 0; i < aCount; ++i)
+    {
+        const int source = order[i].second;
+        const AABB3D<float>& aabb = someAABBs[source];
+        Object& object = myObjects[i];
+        object.myMin[0] = aabb.myMinPoint.x;
+        object.myMin[1] = aabb.myMinPoint.y;
+        object.myMin[2] = aabb.myMinPoint.z;
+        object.myMax[0] = aabb.myMaxPoint.x;
+        object.myMax[1] = aabb.myMaxPoint.y;
+        object.myMax[2] = aabb.myMaxPoint.z;
+        object.myUserData = someUserData != nullptr ? someUserData[source] : source;
+        object.myNext = i + 1 < aCount && order[i + 1].first == order[i].first ? i + 1 : NullObject;
+        if (someOutHandles != nullptr)
+        {
+            someOutHandles[source] = i;
+        }
+    }
+
+    // Emits the nodes depth first, adding the ancestors of every occupied cell. The stack holds the path
+    // from the root to the last node, children are appended after the last child emitted for their parent
+    // so siblings stay in memory order.
+    myNodes.clear();
+    myFreeNodes = NullNode;
+    std::vector<int> path;
+    std::vector<int> lastChildren;
+
+    myNodes.push_back(MakeNode(0, NullNode));
+    path.push_back(0);
+    lastChildren.push_back(NullNode);
+    for (int i = 0; i < aCount;)
+    {
+        const uint64_t key = order[i].first;
+        while (!IsAncestorOrSelf(myNodes[path.back()].myKey, key))
+        {
+            path.pop_back();
+            lastChildren.pop_back();
+        }
+
+        for (int depth = GetDepth(myNodes[path.back()].myKey) + 1; depth <= GetDepth(key); ++depth)
+        {
+            const int index = static_cast<int>(myNodes.size());
+            myNodes.push_back(MakeNode(GetAncestorKey(key, depth), path.back()));
+            if (lastChildren.back() == NullNode)
+            {
+                myNodes[path.back()].myFirstChild = index;
+            }
+            else
+            {
+                myNodes[lastChildren.back()].myNextSibling = index;
+            }
+            lastChildren.back() = index;
+            path.push_back(index);
+            lastChildren.push_back(NullNode);
+        }
+
+        Node& node = myNodes[path.back()];
+        node.myFirstObject = i;
+        while (i < aCount && order[i].first == key)
+        {
+            myObjectNodes[i] = path.back();
+            ++node.myObjectCount;
+            ++i;
+        }
+    }
+    myNodeCount = static_cast<int>(myNodes.size());
+
+    // Objects outside the loose world bounds are in the root, which grows to hold them.
+    for (int index = myNodes[0].myFirstObject; index != NullObject; index = myObjects[index].myNext)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            myNodes[0].myMin[axis] = Min(myNodes[0].myMin[axis], myObjects[index].myMin[axis]);
+            myNodes[0].myMax[axis] = Max(myNodes[0].myMax[axis], myObjects[index].myMax[axis]);
+        }
+    }
+}
+
+void CommonUtilities::LooseOctree::Clear(const AABB3D<float>& aWorldBounds)
+{
+    SetWorld(aWorldBounds);
+    myObjects.clear();
+    myObjectNodes.clear();
+    myFreeObjects = NullObject;
+    myObjectCount = 0;
+    myNodes.clear();
+    myNodes.push_back(MakeNode(0, NullNode));
+    myFreeNodes = NullNode;
+    myNodeCount = 1;
+}
+
+int CommonUtilities::LooseOctree::Insert(const AABB3D<float>& anAABB, int aUserData)
+{
+    const uint64_t key = GetObjectKey(anAABB);
+    const int nodeIndex = FindOrAddNode(key);
+    const int handle = AllocateObject();
+
+    Object& object = myObjects[handle];
+    object.myMin[0] = anAABB.myMinPoint.x;
+    object.myMin[1] = anAABB.myMinPoint.y;
+    object.myMin[2] = anAABB.myMinPoint.z;
+    object.myMax[0] = anAABB.myMaxPoint.x;
+    object.myMax[1] = anAABB.myMaxPoint.y;
+    object.myMax[2] = anAABB.myMaxPoint.z;
+    object.myUserData = aUserData;
+
+    Node& node = myNodes[nodeIndex];
+    object.myNext = node.myFirstObject;
+    node.myFirstObject = handle;
+    ++node.myObjectCount;
+    myObjectNodes[handle] = nodeIndex;
+    ++myObjectCount;
+
+    if (nodeIndex == 0)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            node.myMin[axis] = Min(node.myMin[axis], object.myMin[axis]);
+            node.myMax[axis] = Max(node.myMax[axis], object.myMax[axis]);
+        }
+    }
+    return handle;
+}
+
+void CommonUtilities::LooseOctree::Remove(int aHandle)
+{
+    assert(aHandle >= 0 && aHandle < static_cast<int>(myObjects.size()) && myObjectNodes[aHandle] != NullNode && "Invalid handle.");
+
+    int nodeIndex = myObjectNodes[aHandle];
+    Node& node = myNodes[nodeIndex];
+
+    int* link = &node.myFirstObject;
+    while (*link != aHandle)
+    {
+        link = &myObjects[*link].myNext;
+    }
+    *link = myObjects[aHandle].myNext;
+    --node.myObjectCount;
+
+    myObjects[aHandle].myNext = myFreeObjects;
+    myFreeObjects = aHandle;
+    myObjectNodes[aHandle] = NullNode;
+    --myObjectCount;
+
+    // Drops nodes that are left without objects and children, the root always stays.
+    while (nodeIndex != 0 && myNodes[nodeIndex].myObjectCount == 0 && myNodes[nodeIndex].myFirstChild == NullNode)
+    {
+        const int parent = myNodes[nodeIndex].myParent;
+        FreeNode(nodeIndex);
+        nodeIndex = parent;
+    }
+}
+
+int CommonUtilities::LooseOctree::QueryFrustum(const Frustum& aFrustum, int* someOutUserData, int aMaxCount) const
+{
+    Vector3<float> normals[Frustum::PlaneCount];
+    float distances[Frustum::PlaneCount];
+    for (int plane = 0; plane < Frustum::PlaneCount; ++plane)
+    {
+        normals[plane] = aFrustum.GetNormal(plane);
+        distances[plane] = aFrustum.GetDistance(plane);
+    }
+    return QueryPlanes(normals, distances, Frustum::PlaneCount, someOutUserData, aMaxCount);
+}
+
+int CommonUtilities::LooseOctree::QueryPlaneVolume(const PlaneVolume<float>& aPlaneVolume, int* someOutUserData, int aMaxCount) const
+{
+    // PlaneVolume normals point out of the volume, the queries want them pointing in.
+    const std::vector<Plane<float>>& planes = aPlaneVolume.GetPlanes();
+    std::vector<Vector3<float>> normals(planes.size());
+    std::vector<float> distances(planes.size());
+    for (size_t plane = 0; plane < planes.size(); ++plane)
+    {
+        normals[plane] = planes[plane].GetNormal() * -1.0f;
+        distances[plane] = planes[plane].GetNormal().Dot(planes[plane].GetPoint());
+    }
+    return QueryPlanes(normals.data(), distances.data(), static_cast<int>(planes.size()), someOutUserData, aMaxCount);
+}
+
+int CommonUtilities::LooseOctree::QueryRay(const Ray<float>& aRay, float aMaxDistance, int* someOutUserData, int aMaxCount) const
+{
+    return Traverse(
+        [&](const Node& aNode)
+        {
+            return RayHitsBox(aRay, aMaxDistance, aNode.myMin, aNode.myMax) ? Overlap::Intersects : Overlap::Outside;
+        },
+        [&](const Object& anObject)
+        {
+            return RayHitsBox(aRay, aMaxDistance, anObject.myMin, anObject.myMax);
+        },
+        someOutUserData, aMaxCount);
+}
+
+int CommonUtilities::LooseOctree::QuerySphere(const Sphere<float>& aSphere, int* someOutUserData, int aMaxCount) const
+{
+    const Vector3<float>& center = aSphere.GetCenter();
+    const float radiusSqr = aSphere.GetRadius() * aSphere.GetRadius();
+    return Traverse(
+        [&](const Node& aNode)
+        {
+            if (DistanceSqrToBox(center, aNode.myMin, aNode.myMax) > radiusSqr)
+            {
+                return Overlap::Outside;
+            }
+            return FarthestDistanceSqrToBox(center, aNode.myMin, aNode.myMax) <= radiusSqr ? Overlap::Inside : Overlap::Intersects;
+        },
+        [&](const Object& anObject)
+        {
+            return DistanceSqrToBox(center, anObject.myMin, anObject.myMax) <= radiusSqr;
+        },
+        someOutUserData, aMaxCount);
+}
+
+int CommonUtilities::LooseOctree::QueryAABB(const AABB3D<float>& anAABB, int* someOutUserData, int aMaxCount) const
+{
+    return Traverse(
+        [&](const Node& aNode)
+        {
+            if (!Overlaps(aNode.myMin, aNode.myMax, anAABB))
+            {
+                return Overlap::Outside;
+            }
+            return Contains(anAABB, aNode.myMin, aNode.myMax) ? Overlap::Inside : Overlap::Intersects;
+        },
+        [&](const Object& anObject)
+        {
+            return Overlaps(anObject.myMin, anObject.myMax, anAABB);
+        },
+        someOutUserData, aMaxCount);
+}
+
+int CommonUtilities::LooseOctree::GetObjectCount() const
+{
+    return myObjectCount;
+}
+
+int CommonUtilities::LooseOctree::GetNodeCount() const
+{
+    return myNodeCount;
+}
+
+uint64_t CommonUtilities::LooseOctree::GetObjectKey(const AABB3D<float>& anAABB) const
+{
+    const float center[3] =
+    {
+        (anAABB.myMinPoint.x + anAABB.myMaxPoint.x) * 0.5f,
+        (anAABB.myMinPoint.y + anAABB.myMaxPoint.y) * 0.5f,
+        (anAABB.myMinPoint.z + anAABB.myMaxPoint.z) * 0.5f
+    };
+    const float halfSize = Max(Max(anAABB.myMaxPoint.x - anAABB.myMinPoint.x, anAABB.myMaxPoint.y - anAABB.myMinPoint.y), anAABB.myMaxPoint.z - anAABB.myMinPoint.z) * 0.5f;
+
+    // The deepest level where the object is at most half a cell, that always fits the loose bounds of
+    // the cell holding its center. Objects outside the world may not fit, they move up until they do.
+    int depth = 0;
+    while (depth < myMaxDepth && halfSize <= myWorldSize / static_cast<float>(1 << (depth + 1)) * 0.5f)
+    {
+        ++depth;
+    }
+
+    for (; depth > 0; --depth)
+    {
+        const uint32_t cellCount = 1u << depth;
+        const float cellsPerUnit = static_cast<float>(cellCount) / myWorldSize;
+        uint32_t cell[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float position = std::floor((center[axis] - myWorldMin[axis]) * cellsPerUnit);
+            cell[axis] = static_cast<uint32_t>(Clamp(0.0f, static_cast<float>(cellCount - 1), position));
+        }
+
+        const uint64_t key = GetKey(depth, cell[0], cell[1], cell[2]);
+        float looseMin[3];
+        float looseMax[3];
+        GetLooseBounds(key, looseMin, looseMax);
+        if (looseMin[0] <= anAABB.myMinPoint.x && anAABB.myMaxPoint.x <= looseMax[0] &&
+            looseMin[1] <= anAABB.myMinPoint.y && anAABB.myMaxPoint.y <= looseMax[1] &&
+            looseMin[2] <= anAABB.myMinPoint.z && anAABB.myMaxPoint.z <= looseMax[2])
+        {
+            return key;
+        }
+    }
+    return 0;
+}
+
+uint64_t CommonUtilities::LooseOctree::GetKey(int aDepth, uint32_t aX, uint32_t aY, uint32_t aZ) const
+{
+    const uint64_t code = SpreadBits(aX) | (SpreadBits(aY) << 1) | (SpreadBits(aZ) << 2);
+    return ((code << GetAlignShift(aDepth)) << DepthBits) | static_cast<uint64_t>(aDepth);
+}
+
+void CommonUtilities::LooseOctree::GetLooseBounds(uint64_t aKey, float* aOutMin, float* aOutMax) const
+{
+    const int depth = GetDepth(aKey);
+    const uint64_t code = GetAlignedCode(aKey) >> GetAlignShift(depth);
+    const uint32_t cell[3] = { CompactBits(code), CompactBits(code >> 1), CompactBits(code >> 2) };
+    const float cellSize = myWorldSize / static_cast<float>(1 << depth);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        aOutMin[axis] = myWorldMin[axis] + (static_cast<float>(cell[axis]) - 0.5f) * cellSize;
+        aOutMax[axis] = aOutMin[axis] + 2.0f * cellSize;
+    }
+}
+
+int CommonUtilities::LooseOctree::FindOrAddNode(uint64_t aKey)
+{
+    // Walks down from the root, adding the cells on the way that do not exist yet.
+    int node = 0;
+    for (int depth = 1; depth <= GetDepth(aKey); ++depth)
+    {
+        const uint64_t key = GetAncestorKey(aKey, depth);
+        int child = myNodes[node].myFirstChild;
+        while (child != NullNode && myNodes[child].myKey != key)
+        {
+            child = myNodes[child].myNextSibling;
+        }
+        node = child != NullNode ? child : AllocateNode(key, node);
+    }
+    return node;
+}
+
+int CommonUtilities::LooseOctree::AllocateNode(uint64_t aKey, int aParent)
+{
+    int index = myFreeNodes;
+    if (index == NullNode)
+    {
+        index = static_cast<int>(myNodes.size());
+        myNodes.push_back(MakeNode(aKey, aParent));
+    }
+    else
+    {
+        myFreeNodes = myNodes[index].myNextSibling;
+        myNodes[index] = MakeNode(aKey, aParent);
+    }
+
+    myNodes[index].myNextSibling = myNodes[aParent].myFirstChild;
+    myNodes[aParent].myFirstChild = index;
+    ++myNodeCount;
+    return index;
+}
+
+void CommonUtilities::LooseOctree::FreeNode(int aNode)
+{
+    int* link = &myNodes[myNodes[aNode].myParent].myFirstChild;
+    while (*link != aNode)
+    {
+        link = &myNodes[*link].myNextSibling;
+    }
+    *link = myNodes[aNode].myNextSibling;
+
+    myNodes[aNode].myParent = NullNode;
+    myNodes[aNode].myNextSibling = myFreeNodes;
+    myFreeNodes = aNode;
+    --myNodeCount;
+}
+
+CommonUtilities::LooseOctree::Node CommonUtilities::LooseOctree::MakeNode(uint64_t aKey, int aParent) const
+{
+    Node node;
+    GetLooseBounds(aKey, node.myMin, node.myMax);
+    node.myKey = aKey;
+    node.myParent = aParent;
+    node.myFirstChild = NullNode;
+    node.myNextSibling = NullNode;
+    node.myFirstObject = NullObject;
+    node.myObjectCount = 0;
+    return node;
+}
+
+int CommonUtilities::LooseOctree::AllocateObject()
+{
+    if (myFreeObjects == NullObject)
+    {
+        myObjects.emplace_back();
+        myObjectNodes.push_back(NullNode);
+        return static_cast<int>(myObjects.size()) - 1;
+    }
+
+    const int handle = myFreeObjects;
+    myFreeObjects = myObjects[handle].myNext;
+    return handle;
+}
+
+void CommonUtilities::LooseOctree::SetWorld(const AABB3D<float>& aWorldBounds)
+{
+    // The world is a cube around the bounds so all cells are cubes.
+    const Vector3<float> size = aWorldBounds.myMaxPoint - aWorldBounds.myMinPoint;
+    const Vector3<float> center = (aWorldBounds.myMinPoint + aWorldBounds.myMaxPoint) * 0.5f;
+    myWorldSize = Max(Max(Max(size.x, size.y), size.z), 0.0001f);
+    myWorldMin[0] = center.x - myWorldSize * 0.5f;
+    myWorldMin[1] = center.y - myWorldSize * 0.5f;
+    myWorldMin[2] = center.z - myWorldSize * 0.5f;
+}
+
+int CommonUtilities::LooseOctree::QueryPlanes(const Vector3<float>* someNormals, const float* someDistances, int aPlaneCount, int* someOutUserData, int aMaxCount) const
+{
+    // Distance of the box center to each plane against how far the box reaches along the normal.
+    const auto classify = [&](const float* aMin, const float* aMax)
+    {
+        const Vector3<float> center((aMin[0] + aMax[0]) * 0.5f, (aMin[1] + aMax[1]) * 0.5f, (aMin[2] + aMax[2]) * 0.5f);
+        const Vector3<float> extent((aMax[0] - aMin[0]) * 0.5f, (aMax[1] - aMin[1]) * 0.5f, (aMax[2] - aMin[2]) * 0.5f);
+        Overlap result = Overlap::Inside;
+        for (int plane = 0; plane < aPlaneCount; ++plane)
+        {
+            const Vector3<float>& normal = someNormals[plane];
+            const float distance = normal.Dot(center) + someDistances[plane];
+            const float reach = std::fabs(normal.x) * extent.x + std::fabs(normal.y) * extent.y + std::fabs(normal.z) * extent.z;
+            if (distance + reach < 0.0f)
+            {
+                return Overlap::Outside;
+            }
+            if (distance - reach < 0.0f)
+            {
+                result = Overlap::Intersects;
+            }
+        }
+        return result;
+    };
+
+    return Traverse(
+        [&](const Node& aNode)
+        {
+            return classify(aNode.myMin, aNode.myMax);
+        },
+        [&](const Object& anObject)
+        {
+            return classify(anObject.myMin, anObject.myMax) != Overlap::Outside;
+        },
+        someOutUserData, aMaxCount);
+}
+
+template<typename NodeTest, typename ObjectTest>
+int CommonUtilities::LooseOctree::Traverse(const NodeTest& aNodeTest, const ObjectTest& anObjectTest, int* someOutUserData, int aMaxCount) const
+{
+    int count = 0;
+    // Set while walking a subtree that is inside, its objects are written without tests.
+    int insideRoot = NullNode;
+    int index = 0;
+    while (index != NullNode && count < aMaxCount)
+    {
+        const Node& node = myNodes[index];
+        const Overlap overlap = insideRoot != NullNode ? Overlap::Inside : aNodeTest(node);
+        if (overlap != Overlap::Outside)
+        {
+            if (overlap == Overlap::Inside && insideRoot == NullNode)
+            {
+                insideRoot = index;
+            }
+
+            for (int object = node.myFirstObject; object != NullObject && count < aMaxCount; object = myObjects[object].myNext)
+            {
+                if (overlap == Overlap::Inside || anObjectTest(myObjects[object]))
+                {
+                    someOutUserData[count++] = myObjects[object].myUserData;
+                }
+            }
+
+            if (node.myFirstChild != NullNode)
+            {
+                index = node.myFirstChild;
+                continue;
+            }
+        }
+
+        // The subtree is done, moves on to the next sibling of the node or of its closest ancestor with one.
+        while (index != NullNode)
+        {
+            if (index == insideRoot)
+            {
+                insideRoot = NullNode;
+            }
+            if (myNodes[index].myNextSibling != NullNode)
+            {
+                index = myNodes[index].myNextSibling;
+                break;
+            }
+            index = myNodes[index].myParent;
+        }
+    }
+    return count;
+}
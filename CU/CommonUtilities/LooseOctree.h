@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+#include "AABB3D.hpp"
+#include "Sphere.hpp"
+#include "Ray.hpp"
+#include "PlaneVolume.hpp"
+#include "Frustum.h"
+
+namespace CommonUtilities
+{
+	// Octree where every node bounds twice its cell, so an object always goes to the node of its center at
+	// the depth matching its size and never has to be split. Nodes live in a pool and link to their parent,
+	// first child and next sibling, so Insert and Remove only touch the path to the root. Build emits the
+	// nodes depth first in Morton order, so queries on a built tree walk the pool front to back.
+	class LooseOctree
+	{
+	public:
+		static const int MaxSupportedDepth = 16;
+
+		explicit LooseOctree(int aMaxDepth = 8);
+
+		// Replaces the content with aCount boxes. The world is the box around all of them. someUserData may be
+		// null, then the user data of each object is its index. someOutHandles (optional) receives the handle
+		// of every object for Remove.
+		void Build(const AABB3D<float>* someAABBs, const int* someUserData, int aCount, int* someOutHandles = nullptr);
+
+		// Removes everything and sets the world that later inserts are placed in.
+		void Clear(const AABB3D<float>& aWorldBounds);
+
+		// Adds an object and returns its handle. Objects outside the world are kept in the root.
+		int Insert(const AABB3D<float>& anAABB, int aUserData);
+		void Remove(int aHandle);
+
+		// The queries write the user data of the objects they find to someOutUserData and return how many were
+		// written, stopping when aMaxCount is reached. Objects are reported in node order, not sorted.
+
+		// Objects whose box is at least partly inside all planes. Whole subtrees inside the frustum are written
+		// without testing their objects.
+		int QueryFrustum(const Frustum& aFrustum, int* someOutUserData, int aMaxCount) const;
+		int QueryPlaneVolume(const PlaneVolume<float>& aPlaneVolume, int* someOutUserData, int aMaxCount) const;
+
+		// Objects whose box aRay enters within aMaxDistance.
+		int QueryRay(const Ray<float>& aRay, float aMaxDistance, int* someOutUserData, int aMaxCount) const;
+
+		// Objects whose box overlaps aSphere.
+		int QuerySphere(const Sphere<float>& aSphere, int* someOutUserData, int aMaxCount) const;
+
+		// Objects whose box overlaps anAABB.
+		int QueryAABB(const AABB3D<float>& anAABB, int* someOutUserData, int aMaxCount) const;
+
+		int GetObjectCount() const;
+		int GetNodeCount() const;
+
+	private:
+		static const int NullObject = -1;
+		static const int NullNode = -1;
+
+		struct Node
+		{
+			float myMin[3];
+			float myMax[3];
+			// Morton code of the cell moved to the top bits, the depth in the low bits, so sorting by key
+			// puts the nodes depth first.
+			uint64_t myKey;
+			int myParent;
+			int myFirstChild;
+			// Next child of the same parent, or the next free node.
+			int myNextSibling;
+			int myFirstObject;
+			uint32_t myObjectCount;
+		};
+
+		struct Object
+		{
+			float myMin[3];
+			float myMax[3];
+			int myUserData;
+			// Next object in the same node, or the next free object.
+			int myNext;
+		};
+
+		enum class Overlap
+		{
+			Outside,
+			Intersects,
+			Inside
+		};
+
+		uint64_t GetObjectKey(const AABB3D<float>& anAABB) const;
+		uint64_t GetKey(int aDepth, uint32_t aX, uint32_t aY, uint32_t aZ) const;
+		void GetLooseBounds(uint64_t aKey, float* aOutMin, float* aOutMax) const;
+		int FindOrAddNode(uint64_t aKey);
+		int AllocateNode(uint64_t aKey, int aParent);
+		void FreeNode(int aNode);
+		Node MakeNode(uint64_t aKey, int aParent) const;
+		int AllocateObject();
+		void SetWorld(const AABB3D<float>& aWorldBounds);
+
+		int QueryPlanes(const Vector3<float>* someNormals, const float* someDistances, int aPlaneCount, int* someOutUserData, int aMaxCount) const;
+
+		template<typename NodeTest, typename ObjectTest>
+		int Traverse(const NodeTest& aNodeTest, const ObjectTest& anObjectTest, int* someOutUserData, int aMaxCount) const;
+
+		std::vector<Node> myNodes;
+		std::vector<Object> myObjects;
+		// Node of every object, NullNode for free objects.
+		std::vector<int> myObjectNodes;
+		int myFreeNodes = NullNode;
+		int myNodeCount = 0;
+		int myFreeObjects = NullObject;
+		int myObjectCount = 0;
+		int myMaxDepth;
+		float myWorldMin[3] = { 0.0f, 0.0f, 0.0f };
+		float myWorldSize = 1.0f;
+	};
+}
+
+namespace CU = CommonUtilities;
@@ -13,7 +13,7 @@ namespace CommonUtilities
 			const T m11, const T m12,
 			const T m21, const T m22
 			);
-		Matrix2x2<T>(const Matrix2x2<T>& aMatrix);
+		Matrix2x2<T>(const Matrix2x2<T>& aMatrix) = default;
 
 		T& operator()(const int aRow, const int aColumn);
 		const T& operator()(const int aRow, const int aColumn) const;
@@ -56,15 +56,6 @@ namespace CommonUtilities
 	{
 	}
 
-	template <class T>
-	Matrix2x2<T>::Matrix2x2(const Matrix2x2<T>& aMatrix) :
-		myData{
-			{ aMatrix(1, 1), aMatrix(1, 2) },
-			{ aMatrix(2, 1), aMatrix(2, 2) },
-	}
-	{
-	};
-
 	template <class T>
 	T& Matrix2x2<T>::operator()(const int aRow, const int aColumn)
 	{
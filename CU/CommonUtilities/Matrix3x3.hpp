@@ -17,12 +17,12 @@ namespace CommonUtilities
 			const T m21, const T m22, const T m23,
 			const T m31, const T m32, const T m33
 			);
-		Matrix3x3<T>(const Matrix3x3<T>& aMatrix);
+		Matrix3x3<T>(const Matrix3x3<T>& aMatrix) = default;
 		Matrix3x3<T>(const Matrix4x4<T>& aMatrix);
 
 		T& operator()(const int aRow, const int aColumn);
 		const T& operator()(const int aRow, const int aColumn) const;
-		Matrix3x3<T> operator=(const Matrix3x3<T>& aMatrix);
+		Matrix3x3<T>& operator=(const Matrix3x3<T>& aMatrix) = default;
 
 		T Minor(int aX, int aY) const;
 		T Cofactor(int aX, int aY) const;
@@ -70,16 +70,6 @@ namespace CommonUtilities
 	{
 	}
 
-	template <class T>
-	Matrix3x3<T>::Matrix3x3(const Matrix3x3<T>& aMatrix) :
-		myData{
-			{ aMatrix(1, 1), aMatrix(1, 2), aMatrix(1, 3) },
-			{ aMatrix(2, 1), aMatrix(2, 2), aMatrix(2, 3) },
-			{ aMatrix(3, 1), aMatrix(3, 2), aMatrix(3, 3) }
-	}
-	{
-	};
-
 	template <class T>
 	Matrix3x3<T>::Matrix3x3(const Matrix4x4<T>& aMatrix) :
 		myData{
@@ -240,19 +230,6 @@ namespace CommonUtilities
 		}
 	}
 
-	template <class T>
-	Matrix3x3<T> Matrix3x3<T>::operator=(const Matrix3x3<T>& aMatrix)
-	{
-		for (int row = 1; row <= 3; row++)
-		{
-			for (int col = 1; col <= 3; col++)
-			{
-				(*this)(row, col) = aMatrix(row, col);
-			}
-		}
-		return aMatrix;
-	}
-
 	template <class T>
 	bool operator==(const Matrix3x3<T>& aMatrix0, const Matrix3x3<T>& aMatrix1)
 	{
@@ -21,11 +21,11 @@ namespace CommonUtilities
 			const T m31, const T m32, const T m33, const T m34,
 			const T m41, const T m42, const T m43, const T m44
 			);
-		Matrix4x4<T>(const Matrix4x4<T>& aMatrix);
+		Matrix4x4<T>(const Matrix4x4<T>& aMatrix) = default;
 
 		T& operator()(const int aRow, const int aColumn);
 		const T& operator()(const int aRow, const int aColumn) const;
-		Matrix4x4<T>& operator=(const Matrix4x4<T>& aMatrix);
+		Matrix4x4<T>& operator=(const Matrix4x4<T>& aMatrix) = default;
 
 		Vector4<T> GetRow(const int aRow) const;
 		void SetRow(const int aRow, const Vector4<T>& aValue);
@@ -90,17 +90,6 @@ namespace CommonUtilities
 	{
 	}
 
-	template <class T>
-	Matrix4x4<T>::Matrix4x4(const Matrix4x4<T>& aMatrix) :
-		myData{
-			{ aMatrix(1, 1), aMatrix(1, 2), aMatrix(1, 3), aMatrix(1, 4) },
-			{ aMatrix(2, 1), aMatrix(2, 2), aMatrix(2, 3), aMatrix(2, 4) },
-			{ aMatrix(3, 1), aMatrix(3, 2), aMatrix(3, 3), aMatrix(3, 4) },
-			{ aMatrix(4, 1), aMatrix(4, 2), aMatrix(4, 3), aMatrix(4, 4) }
-	}
-	{
-	};
-
 	template <class T>
 	T& Matrix4x4<T>::operator()(const int aRow, const int aColumn)
 	{
@@ -330,20 +319,6 @@ namespace CommonUtilities
 		}
 	}
 
-	template <class T>
-	Matrix4x4<T>& Matrix4x4<T>::operator=(const Matrix4x4<T>& aMatrix)
-	{
-		for (int row = 1; row <= 4; row++)
-		{
-			for (int col = 1; col <= 4; col++)
-			{
-				(*this)(row, col) = aMatrix(row, col);
-			}
-		}
-
-		return *this;
-	}
-
 	template <class T>
 	bool operator==(const Matrix4x4<T>& aMatrix0, const Matrix4x4<T>& aMatrix1)
 	{
@@ -69,15 +69,7 @@ namespace CommonUtilities
 	template<class T>
 	inline bool Plane<T>::IsInside(const Vector3<T>& aPosition) const
 	{
-		Vector3<T> dir = aPosition - myPoint;
-		if (dir.Dot(GetNormal()) < 0)
-		{
-			return true;
-		}
-		else if (dir.Dot(GetNormal()) > 0)
-		{
-			return false;
-		}
+		return (aPosition - myPoint).Dot(myNormal) <= 0;
 	}
 	template<class T>
 	inline const Vector3<T>& Plane<T>::GetNormal() const
@@ -16,7 +16,8 @@ namespace CommonUtilities
 		void AddPlane(const Plane<T>& aPlane);
 		// Returns whether a point is inside the PlaneVolume: it is inside when the point is on the
 		// plane or on the side the normal is pointing away from for all the planes in thePlaneVolume.
-		bool IsInside(const Vector3<T>& aPosition);
+		bool IsInside(const Vector3<T>& aPosition) const;
+		const std::vector<Plane<T>>& GetPlanes() const;
 	private:
 		std::vector<Plane<T>> myPlaneVolume;
 	};
@@ -31,11 +32,16 @@ namespace CommonUtilities
 		myPlaneVolume.push_back(aPlane);
 	}
 	template<class T>
-	inline bool PlaneVolume<T>::IsInside(const Vector3<T>& aPosition)
+	inline const std::vector<Plane<T>>& PlaneVolume<T>::GetPlanes() const
+	{
+		return myPlaneVolume;
+	}
+	template<class T>
+	inline bool PlaneVolume<T>::IsInside(const Vector3<T>& aPosition) const
 	{
 		for (size_t i = 0; i < myPlaneVolume.size(); i++)
 		{
-			if (myPlaneVolume[i].IsInside(aPosition))
+			if (!myPlaneVolume[i].IsInside(aPosition))
 			{
 				return false;
 			}
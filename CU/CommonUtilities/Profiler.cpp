@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "Profiler.h"
+#include <assert.h>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct ProfileEvent
+    {
+        const char* myName;
+        uint64_t myStart;
+        uint64_t myEnd;
+    };
+
+    struct ThreadBuffer
+    {
+        std::vector<ProfileEvent> myEvents;
+        uint64_t myMask = 0;
+        // Events ever written, the last myEvents.size() of them are kept.
+        std::atomic<uint64_t> myWriteCount{ 0 };
+        // Events before this count were cleared.
+        std::atomic<uint64_t> myClearCount{ 0 };
+        std::string myName;
+        int myThreadId = 0;
+        // Cleared when the owning thread exits, RegisterThread then hands the buffer to the next new thread.
+        bool myIsInUse = true;
+    };
+
+    struct ProfilerState
+    {
+        std::mutex myMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> myBuffers;
+        int myEventsPerThread = 1 << 16;
+        uint64_t myStartTicks = CommonUtilities::Profiler::GetTimestamp();
+        std::chrono::steady_clock::time_point myStartTime = std::chrono::steady_clock::now();
+    };
+
+    ProfilerState& GetState()
+    {
+        static ProfilerState state;
+        return state;
+    }
+
+    thread_local ThreadBuffer* ourThreadBuffer = nullptr;
+
+    // Hands the thread's buffer back when the thread exits. Kept apart from ourThreadBuffer so recording
+    // reads a plain pointer and only registration touches a thread_local with a destructor.
+    struct ThreadBufferRelease
+    {
+        ThreadBuffer* myBuffer = nullptr;
+
+        ~ThreadBufferRelease()
+        {
+            if (myBuffer != nullptr)
+            {
+                std::lock_guard<std::mutex> lock(GetState().myMutex);
+                myBuffer->myIsInUse = false;
+                ourThreadBuffer = nullptr;
+            }
+        }
+    };
+
+    thread_local ThreadBufferRelease ourThreadBufferRelease;
+
+    // A buffer is kept after its thread exits so its events can still be exported, until a new thread
+    // takes it over. Threads spawned per call (the spatial builders' workers) then reuse the same few
+    // buffers instead of adding one each.
+    ThreadBuffer& RegisterThread()
+    {
+        ProfilerState& state = GetState();
+        std::lock_guard<std::mutex> lock(state.myMutex);
+
+        ThreadBuffer* buffer = nullptr;
+        for (const std::unique_ptr<ThreadBuffer>& candidate : state.myBuffers)
+        {
+            if (!candidate->myIsInUse)
+            {
+                buffer = candidate.get();
+                break;
+            }
+        }
+
+        if (buffer == nullptr)
+        {
+            state.myBuffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+            buffer = state.myBuffers.back().get();
+            buffer->myThreadId = static_cast<int>(state.myBuffers.size()) - 1;
+        }
+
+        // A reused buffer keeps the previous thread's events, they show on the new thread's trace row. They are
+        // only dropped when SetEventsPerThread changed the size since.
+        if (buffer->myEvents.size() != static_cast<size_t>(state.myEventsPerThread))
+        {
+            buffer->myClearCount.store(buffer->myWriteCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            buffer->myEvents.resize(static_cast<size_t>(state.myEventsPerThread));
+            buffer->myMask = static_cast<uint64_t>(state.myEventsPerThread) - 1;
+        }
+        buffer->myName = "Thread " + std::to_string(buffer->myThreadId);
+        buffer->myIsInUse = true;
+
+        ourThreadBuffer = buffer;
+        ourThreadBufferRelease.myBuffer = buffer;
+        return *buffer;
+    }
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        return ourThreadBuffer != nullptr ? *ourThreadBuffer : RegisterThread();
+    }
+
+    // Ticks per microsecond from how far the timestamp moved against steady_clock since the start.
+    double GetTicksPerMicrosecond(const ProfilerState& aState)
+    {
+#if defined(CU_PROFILER_TSC)
+        // Waits until at least 10 ms have passed so short sessions still get a usable ratio.
+        std::chrono::steady_clock::time_point now;
+        do
+        {
+            now = std::chrono::steady_clock::now();
+        } while (now - aState.myStartTime < std::chrono::milliseconds(10));
+
+        const uint64_t ticks = CommonUtilities::Profiler::GetTimestamp() - aState.myStartTicks;
+        return static_cast<double>(ticks) / std::chrono::duration<double, std::micro>(now - aState.myStartTime).count();
+#else
+        (void)aState;
+        return 1000.0;
+#endif
+    }
+
+    void WriteEscaped(std::ofstream& aStream, const char* aText)
+    {
+        for (const char* character = aText; *character != '\0'; ++character)
+        {
+            if (*character == '"' || *character == '\\')
+            {
+                aStream << '\\' << *character;
+            }
+            else if (static_cast<unsigned char>(*character) >= 0x20)
+            {
+                aStream << *character;
+            }
+        }
+    }
+}
+
+void CommonUtilities::Profiler::Record(const char* aName, uint64_t aStart, uint64_t anEnd)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const uint64_t index = buffer.myWriteCount.load(std::memory_order_relaxed);
+    ProfileEvent& profileEvent = buffer.myEvents[index & buffer.myMask];
+    profileEvent.myName = aName;
+    profileEvent.myStart = aStart;
+    profileEvent.myEnd = anEnd;
+    buffer.myWriteCount.store(index + 1, std::memory_order_release);
+}
+
+void CommonUtilities::Profiler::SetThreadName(const char* aName)
+{
+    ThreadBuffer& buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(GetState().myMutex);
+    buffer.myName = aName;
+}
+
+void CommonUtilities::Profiler::SetEventsPerThread(int aCount)
+{
+    assert(aCount > 0 && "Profiler needs room for at least one event per thread.");
+    int count = 1;
+    while (count < aCount)
+    {
+        count <<= 1;
+    }
+
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.myMutex);
+    state.myEventsPerThread = count;
+}
+
+void CommonUtilities::Profiler::Clear()
+{
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.myMutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : state.myBuffers)
+    {
+        buffer->myClearCount.store(buffer->myWriteCount.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+bool CommonUtilities::Profiler::ExportChromeTrace(const char* aPath)
+{
+    std::ofstream stream(aPath, std::ios::out | std::ios::trunc);
+    if (!stream.is_open())
+    {
+        return false;
+    }
+
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.myMutex);
+    const double ticksPerMicrosecond = GetTicksPerMicrosecond(state);
+
+    // Chrome trace times are in microseconds, nanosecond precision is kept.
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    std::vector<ProfileEvent> events;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : state.myBuffers)
+    {
+        stream << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->myThreadId << ",\"args\":{\"name\":\"";
+        WriteEscaped(stream, buffer->myName.c_str());
+        stream << "\"}}";
+        first = false;
+
+        // Copies the kept events, then drops the ones the thread may have overwritten during the copy.
+        const uint64_t capacity = buffer->myMask + 1;
+        const uint64_t end = buffer->myWriteCount.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity ? end - capacity : 0;
+        const uint64_t clearCount = buffer->myClearCount.load(std::memory_order_relaxed);
+        begin = begin > clearCount ? begin : clearCount;
+
+        events.clear();
+        for (uint64_t index = begin; index < end; ++index)
+        {
+            events.push_back(buffer->myEvents[index & buffer->myMask]);
+        }
+
+        const uint64_t writtenAfter = buffer->myWriteCount.load(std::memory_order_acquire);
+        const uint64_t firstValid = writtenAfter > capacity ? writtenAfter - capacity : 0;
+        const size_t skip = firstValid > begin ? static_cast<size_t>(firstValid - begin) : 0;
+
+        for (size_t index = skip; index < events.size(); ++index)
+        {
+            const ProfileEvent& profileEvent = events[index];
+            // Signed, the first zone of a thread can start before the profiler state was created.
+            const double start = static_cast<double>(static_cast<int64_t>(profileEvent.myStart - state.myStartTicks)) / ticksPerMicrosecond;
+            const double duration = static_cast<double>(profileEvent.myEnd - profileEvent.myStart) / ticksPerMicrosecond;
+            stream << ",\n{\"name\":\"";
+            WriteEscaped(stream, profileEvent.myName);
+            stream << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->myThreadId << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+        }
+    }
+    stream << "\n]}\n";
+    return stream.good();
+}
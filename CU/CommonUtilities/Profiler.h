@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CU_PROFILER_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CU_PROFILER_TSC
+#endif
+
+// Zones are only recorded when CU_ENABLE_PROFILER is defined, otherwise the macros expand to nothing.
+// aName must outlive the export, string literals and __FUNCTION__ do.
+#if defined(CU_ENABLE_PROFILER)
+#define CU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CU_PROFILE_CONCAT(a, b) CU_PROFILE_CONCAT_INNER(a, b)
+#define CU_PROFILE_SCOPE(aName) const ::CommonUtilities::ProfileScope CU_PROFILE_CONCAT(profileScope, __LINE__)(aName)
+#define CU_PROFILE_FUNCTION() CU_PROFILE_SCOPE(__FUNCTION__)
+#define CU_PROFILE_THREAD_NAME(aName) ::CommonUtilities::Profiler::SetThreadName(aName)
+#else
+#define CU_PROFILE_SCOPE(aName) ((void)0)
+#define CU_PROFILE_FUNCTION() ((void)0)
+#define CU_PROFILE_THREAD_NAME(aName) ((void)0)
+#endif
+
+namespace CommonUtilities
+{
+	// Records timed zones into one ring buffer per thread. Only the owning thread writes to a buffer, so
+	// recording takes no lock: the event is written and then the write count is published. Old events are
+	// overwritten when a buffer is full. Timestamps are TSC ticks on x86 and steady_clock nanoseconds
+	// elsewhere, ticks are converted to time at export from how far both clocks moved since the start.
+	// A thread's buffer is handed to the next new thread once it exits, so memory grows with the number of
+	// threads alive at once rather than every thread ever started.
+	class Profiler
+	{
+	public:
+		Profiler() = delete;
+
+		static uint64_t GetTimestamp();
+
+		// Adds a zone that ran from aStart to anEnd (GetTimestamp values) on the calling thread.
+		static void Record(const char* aName, uint64_t aStart, uint64_t anEnd);
+
+		// Names the calling thread in the exported trace.
+		static void SetThreadName(const char* aName);
+
+		// Ring buffer size in events for threads that have not recorded yet, rounded up to a power of two.
+		static void SetEventsPerThread(int aCount);
+
+		// Drops every recorded event.
+		static void Clear();
+
+		// Writes the recorded zones as Chrome trace event JSON, which chrome://tracing and Perfetto open.
+		// Best called between frames: events overwritten while exporting are left out.
+		static bool ExportChromeTrace(const char* aPath);
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* aName)
+			: myName(aName)
+			, myStart(Profiler::GetTimestamp())
+		{
+		}
+
+		ProfileScope(const ProfileScope& aScope) = delete;
+		ProfileScope& operator=(const ProfileScope& aScope) = delete;
+
+		~ProfileScope()
+		{
+			Profiler::Record(myName, myStart, Profiler::GetTimestamp());
+		}
+
+	private:
+		const char* myName;
+		uint64_t myStart;
+	};
+
+	inline uint64_t Profiler::GetTimestamp()
+	{
+#if defined(CU_PROFILER_TSC)
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+}
+
+namespace CU = CommonUtilities;
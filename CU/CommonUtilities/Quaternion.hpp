@@ -1,4 +1,7 @@
+#pragma once
+
 #include <math.h>
+#include <stddef.h>
 #include "Vector3.hpp"
 #include "Matrix3x3.hpp"
 #include "Matrix4x4.hpp"
@@ -7,28 +10,26 @@
 namespace CommonUtilities
 {
 
+    // Rotation quaternion stored as (x, y, z, w) so a Quaternion<float> is a single 16 byte block
+    // that can be copied with memcpy and loaded straight into a SIMD register.
     template <class T>
     class Quaternion
     {
     public:
         inline Quaternion() {}
 
-        inline Quaternion(const Quaternion<T>& aQuaternion)
-        {
-            myScalar = aQuaternion.myScalar;
-            myVector = aQuaternion.myVector;
-        }
+        inline Quaternion(const Quaternion<T>& aQuaternion) = default;
+
+        inline Quaternion<T>& operator=(const Quaternion<T>& aQuaternion) = default;
 
         inline Quaternion(T aScalar, T aVectorX, T aVectorY, T aVectorZ)
+            : myVector(aVectorX, aVectorY, aVectorZ), myScalar(aScalar)
         {
-            myScalar = aScalar;
-            myVector = Vector3<T>(aVectorX, aVectorY, aVectorZ);
         }
 
         inline Quaternion(T aScalar, const Vector3<T>& aVector)
+            : myVector(aVector), myScalar(aScalar)
         {
-            myScalar = aScalar;
-            myVector = aVector;
         }
 
         inline const T& scalar() const { return myScalar; }
@@ -39,7 +40,8 @@ namespace CommonUtilities
 
         inline void set_vector(const Vector3<T>& aVector) { myVector = aVector; }
 
-        inline Quaternion<T> Inverse() const { return Quaternion<T>(myScalar, -myVector); }
+        // Returns the conjugate, which is the inverse for unit quaternions.
+        inline Quaternion<T> Inverse() const { return Quaternion<T>(myScalar, -myVector.x, -myVector.y, -myVector.z); }
 
         inline Quaternion<T> operator+(const Quaternion<T>& aQuaternion) const
         {
@@ -55,33 +57,83 @@ namespace CommonUtilities
 
         inline Quaternion<T> operator*(const Quaternion<T>& aQuaternion) const
         {
+            const Vector3<T>& a = myVector;
+            const Vector3<T>& b = aQuaternion.myVector;
+            const T s = myScalar;
+            const T t = aQuaternion.myScalar;
             return Quaternion<T>(
-                myScalar * aQuaternion.myScalar - Vector3<T>::DotProduct(myVector, aQuaternion.myVector),
-                myScalar * aQuaternion.myVector + aQuaternion.myScalar * myVector + Vector3<T>::CrossProduct(myVector, aQuaternion.myVector));
+                s * t - a.x * b.x - a.y * b.y - a.z * b.z,
+                s * b.x + t * a.x + a.y * b.z - a.z * b.y,
+                s * b.y + t * a.y + a.z * b.x - a.x * b.z,
+                s * b.z + t * a.z + a.x * b.y - a.y * b.x);
         }
 
+        // Scales the rotation angle by aScalar (q^aScalar), keeping the axis.
         inline Quaternion<T> operator*(T aScalar) const
         {
-            T angle;
-            Vector3<T> axis;
-            ToAngleAxis(&angle, &axis);
-            angle *= aScalar;
+            const Quaternion<T> q = (myScalar >= 0) ? *this : Negated();
+            const T axisLength = q.myVector.Length();
+            if (axisLength == 0)
+            {
+                return Quaternion<T>(1, 0, 0, 0);
+            }
 
-            return Quaternion<T>(cos(0.5f * angle),
-                axis.Normalized() * static_cast<T>(sin(0.5f * angle)));
+            const T halfAngle = static_cast<T>(atan2(axisLength, q.myScalar)) * aScalar;
+            const T scale = static_cast<T>(sin(halfAngle)) / axisLength;
+            return Quaternion<T>(static_cast<T>(cos(halfAngle)), q.myVector * scale);
         }
 
+        // Rotates aVector by this (unit) quaternion.
         inline Vector3<T> operator*(const Vector3<T>& aVector) const
         {
-            T ss = myScalar + myScalar;
-            return ss * Vector3<T>::CrossProduct(myVector, aVector) + (ss * myScalar - 1) * aVector +
-                2 * Vector3<T>::DotProduct(myVector, aVector) * myVector;
+            return RotateVector(aVector);
+        }
+
+        // Rotates aVector by this (unit) quaternion: v + w * t + q x t where t = 2 * (q x v).
+        inline Vector3<T> RotateVector(const Vector3<T>& aVector) const
+        {
+            const T qx = myVector.x, qy = myVector.y, qz = myVector.z, qw = myScalar;
+            const T tx = 2 * (qy * aVector.z - qz * aVector.y);
+            const T ty = 2 * (qz * aVector.x - qx * aVector.z);
+            const T tz = 2 * (qx * aVector.y - qy * aVector.x);
+            return Vector3<T>(
+                aVector.x + qw * tx + (qy * tz - qz * ty),
+                aVector.y + qw * ty + (qz * tx - qx * tz),
+                aVector.z + qw * tz + (qx * ty - qy * tx));
+        }
+
+        // Rotates aCount vectors from someInVectors into someOutVectors. The loop has no branches so
+        // it can be vectorized by the compiler. In and out may point to the same array.
+        inline void RotateVectors(const Vector3<T>* someInVectors, Vector3<T>* someOutVectors, size_t aCount) const
+        {
+            const T qx = myVector.x, qy = myVector.y, qz = myVector.z, qw = myScalar;
+            for (size_t i = 0; i < aCount; ++i)
+            {
+                const T vx = someInVectors[i].x, vy = someInVectors[i].y, vz = someInVectors[i].z;
+                const T tx = 2 * (qy * vz - qz * vy);
+                const T ty = 2 * (qz * vx - qx * vz);
+                const T tz = 2 * (qx * vy - qy * vx);
+                someOutVectors[i].x = vx + qw * tx + (qy * tz - qz * ty);
+                someOutVectors[i].y = vy + qw * ty + (qz * tx - qx * tz);
+                someOutVectors[i].z = vz + qw * tz + (qx * ty - qy * tx);
+            }
+        }
+
+        // Rotates aCount vectors in place.
+        inline void RotateVectors(Vector3<T>* someVectors, size_t aCount) const
+        {
+            RotateVectors(someVectors, someVectors, aCount);
+        }
+
+        inline T LengthSqr() const
+        {
+            return myScalar * myScalar + myVector.x * myVector.x + myVector.y * myVector.y + myVector.z * myVector.z;
         }
 
         inline T Normalize()
         {
-            T length = sqrt(myScalar * myScalar + Vector3<T>::DotProduct(myVector, myVector));
-            T scale = (1 / length);
+            const T length = static_cast<T>(sqrt(LengthSqr()));
+            const T scale = (1 / length);
             myScalar *= scale;
             myVector *= scale;
             return length;
@@ -96,85 +148,104 @@ namespace CommonUtilities
 
         inline void ToAngleAxis(T* outAngle, Vector3<T>* outAxis) const
         {
-            const Quaternion<T> q = (myScalar > 0) ? *this : Quaternion<T>(-myScalar, -myVector);
+            const Quaternion<T> q = (myScalar > 0) ? *this : Negated();
             q.ToAngleAxisFull(outAngle, outAxis);
         }
 
         inline void ToAngleAxisFull(T* outAngle, Vector3<T>* outAxis) const
         {
-            Vector3<T> axis = myVector;
-            const T axis_length = axis.Normalize();
-            if (axis_length == 0)
+            const T axisLength = myVector.Length();
+            if (axisLength == 0)
             {
                 *outAxis = Vector3<T>(1, 0, 0);
             }
             else
             {
-                *outAxis = axis;
+                *outAxis = myVector / axisLength;
             }
-            *outAngle = 2 * atan2(axis_length, myScalar);
+            *outAngle = static_cast<T>(2 * atan2(axisLength, myScalar));
         }
 
         inline Vector3<T> ToEulerAngles() const
         {
-            Matrix3x3<T> m(ToMatrix());
-            T cos2 = m[0] * m[0] + m[1] * m[1];
+            const T x = myVector.x, y = myVector.y, z = myVector.z, s = myScalar;
+            const T m11 = 1 - 2 * (y * y + z * z);
+            const T m12 = 2 * (x * y + s * z);
+            const T m13 = 2 * (x * z - s * y);
+            const T cos2 = m11 * m11 + m12 * m12;
             if (cos2 < 1e-6f)
             {
+                const T m21 = 2 * (x * y - s * z);
+                const T m22 = 1 - 2 * (x * x + z * z);
                 return Vector3<T>(
                     0,
-                    m[2] < 0 ? static_cast<T>(0.5 * PI) : static_cast<T>(-0.5 * PI),
-                    -std::atan2(m[3], m[4]));
+                    m13 < 0 ? static_cast<T>(0.5 * PI) : static_cast<T>(-0.5 * PI),
+                    static_cast<T>(-atan2(m21, m22)));
             }
             else
             {
-                return Vector3<T>(std::atan2(m[5], m[8]),
-                    std::atan2(-m[2], std::sqrt(cos2)),
-                    std::atan2(m[1], m[0]));
+                const T m23 = 2 * (s * x + y * z);
+                const T m33 = 1 - 2 * (x * x + y * y);
+                return Vector3<T>(static_cast<T>(atan2(m23, m33)),
+                    static_cast<T>(atan2(-m13, sqrt(cos2))),
+                    static_cast<T>(atan2(m12, m11)));
             }
         }
 
+        // Returns the rotation as a matrix for row vectors, so that aVector * q.ToMatrix() == q * aVector.
         inline Matrix3x3<T> ToMatrix() const
         {
-            const T x2 = myVector[0] * myVector[0], y2 = myVector[1] * myVector[1], z2 = myVector[2] * myVector[2];
-            const T sx = myScalar * myVector[0], sy = myScalar * myVector[1], sz = myScalar * myVector[2];
-            const T xz = myVector[0] * myVector[2], yz = myVector[1] * myVector[2], xy = myVector[0] * myVector[1];
+            const T x = myVector.x, y = myVector.y, z = myVector.z;
+            const T x2 = x * x, y2 = y * y, z2 = z * z;
+            const T sx = myScalar * x, sy = myScalar * y, sz = myScalar * z;
+            const T xz = x * z, yz = y * z, xy = x * y;
             return Matrix3x3<T>(1 - 2 * (y2 + z2), 2 * (xy + sz), 2 * (xz - sy),
                 2 * (xy - sz), 1 - 2 * (x2 + z2), 2 * (sx + yz),
                 2 * (sy + xz), 2 * (yz - sx), 1 - 2 * (x2 + y2));
         }
 
+        // Same as ToMatrix but written directly into a 4x4 matrix without going through a 3x3.
         inline Matrix4x4<T> ToMatrix4() const
         {
-            const T x2 = myVector[0] * myVector[0], y2 = myVector[1] * myVector[1], z2 = myVector[2] * myVector[2];
-            const T sx = myScalar * myVector[0], sy = myScalar * myVector[1], sz = myScalar * myVector[2];
-            const T xz = myVector[0] * myVector[2], yz = myVector[1] * myVector[2], xy = myVector[0] * myVector[1];
-            return Matrix4x4<T>(1 - 2 * (y2 + z2), 2 * (xy + sz), 2 * (xz - sy), 0.0f,
-                2 * (xy - sz), 1 - 2 * (x2 + z2), 2 * (sx + yz), 0.0f,
-                2 * (sy + xz), 2 * (yz - sx), 1 - 2 * (x2 + y2), 0.0f,
-                0.0f, 0.0f, 0.0f, 1.0f);
+            const T x = myVector.x, y = myVector.y, z = myVector.z;
+            const T x2 = x * x, y2 = y * y, z2 = z * z;
+            const T sx = myScalar * x, sy = myScalar * y, sz = myScalar * z;
+            const T xz = x * z, yz = y * z, xy = x * y;
+            return Matrix4x4<T>(1 - 2 * (y2 + z2), 2 * (xy + sz), 2 * (xz - sy), 0,
+                2 * (xy - sz), 1 - 2 * (x2 + z2), 2 * (sx + yz), 0,
+                2 * (sy + xz), 2 * (yz - sx), 1 - 2 * (x2 + y2), 0,
+                0, 0, 0, 1);
+        }
+
+        // Builds a 4x4 transform with this rotation and aTranslation in the fourth row.
+        inline Matrix4x4<T> ToMatrix4(const Vector3<T>& aTranslation) const
+        {
+            const T x = myVector.x, y = myVector.y, z = myVector.z;
+            const T x2 = x * x, y2 = y * y, z2 = z * z;
+            const T sx = myScalar * x, sy = myScalar * y, sz = myScalar * z;
+            const T xz = x * z, yz = y * z, xy = x * y;
+            return Matrix4x4<T>(1 - 2 * (y2 + z2), 2 * (xy + sz), 2 * (xz - sy), 0,
+                2 * (xy - sz), 1 - 2 * (x2 + z2), 2 * (sx + yz), 0,
+                2 * (sy + xz), 2 * (yz - sx), 1 - 2 * (x2 + y2), 0,
+                aTranslation.x, aTranslation.y, aTranslation.z, 1);
         }
 
         static Quaternion<T> FromAngleAxis(T angle, const Vector3<T>& axis)
         {
             const T halfAngle = static_cast<T>(0.5) * angle;
-            Vector3<T> localAxis(axis);
             return Quaternion<T>(
-                cos(halfAngle),
-                localAxis.Normalized() * static_cast<T>(sin(halfAngle)));
+                static_cast<T>(cos(halfAngle)),
+                axis.GetNormalized() * static_cast<T>(sin(halfAngle)));
         }
 
         static Quaternion<T> FromEulerAngles(const Vector3<T>& angles)
         {
-            const Vector3<T> halfAngles(static_cast<T>(0.5) * angles[0],
-                static_cast<T>(0.5) * angles[1],
-                static_cast<T>(0.5) * angles[2]);
-            const T sinx = std::sin(halfAngles[0]);
-            const T cosx = std::cos(halfAngles[0]);
-            const T siny = std::sin(halfAngles[1]);
-            const T cosy = std::cos(halfAngles[1]);
-            const T sinz = std::sin(halfAngles[2]);
-            const T cosz = std::cos(halfAngles[2]);
+            const T sinx = static_cast<T>(sin(static_cast<T>(0.5) * angles.x));
+            const T cosx = static_cast<T>(cos(static_cast<T>(0.5) * angles.x));
+            const T siny = static_cast<T>(sin(static_cast<T>(0.5) * angles.y));
+            const T cosy = static_cast<T>(cos(static_cast<T>(0.5) * angles.y));
+            const T sinz = static_cast<T>(sin(static_cast<T>(0.5) * angles.z));
+            const T cosz = static_cast<T>(cos(static_cast<T>(0.5) * angles.z));
             return Quaternion<T>(cosx * cosy * cosz + sinx * siny * sinz,
                 sinx * cosy * cosz - cosx * siny * sinz,
                 cosx * siny * cosz + sinx * cosy * sinz,
@@ -190,100 +261,102 @@ namespace CommonUtilities
 
         static Quaternion<T> FromMatrix(const Matrix3x3<T>& m)
         {
-            const T trace = m(0, 0) + m(1, 1) + m(2, 2);
-            if (trace > 0)
-            {
-                const T s = sqrt(trace + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>(static_cast<T>(0.25) * s, (m[5] - m[7]) * oneOverS,
-                    (m[6] - m[2]) * oneOverS, (m[1] - m[3]) * oneOverS);
-            }
-            else if (m[0] > m[4] && m[0] > m[8])
-            {
-                const T s = sqrt(m[0] - m[4] - m[8] + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>((m[5] - m[7]) * oneOverS, static_cast<T>(0.25) * s,
-                    (m[3] + m[1]) * oneOverS, (m[6] + m[2]) * oneOverS);
-            }
-            else if (m[4] > m[8])
-            {
-                const T s = sqrt(m[4] - m[0] - m[8] + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>((m[6] - m[2]) * oneOverS, (m[3] + m[1]) * oneOverS,
-                    static_cast<T>(0.25) * s, (m[5] + m[7]) * oneOverS);
-            }
-            else
-            {
-                const T s = sqrt(m[8] - m[0] - m[4] + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>((m[1] - m[3]) * oneOverS, (m[6] + m[2]) * oneOverS,
-                    (m[5] + m[7]) * oneOverS, static_cast<T>(0.25) * s);
-            }
+            return FromRotation(m(1, 1), m(1, 2), m(1, 3),
+                m(2, 1), m(2, 2), m(2, 3),
+                m(3, 1), m(3, 2), m(3, 3));
         }
 
         static Quaternion<T> FromMatrix(const Matrix4x4<T>& m)
         {
-            const T trace = m(0, 0) + m(1, 1) + m(2, 2);
-            if (trace > 0)
-            {
-                const T s = sqrt(trace + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>(static_cast<T>(0.25) * s, (m[6] - m[9]) * oneOverS,
-                    (m[8] - m[2]) * oneOverS, (m[1] - m[4]) * oneOverS);
-            }
-            else if (m[0] > m[5] && m[0] > m[10])
-            {
-                const T s = sqrt(m[0] - m[5] - m[10] + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>((m[6] - m[9]) * oneOverS, static_cast<T>(0.25) * s,
-                    (m[4] + m[1]) * oneOverS, (m[8] + m[2]) * oneOverS);
-            }
-            else if (m[5] > m[10])
-            {
-                const T s = sqrt(m[5] - m[0] - m[10] + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>((m[8] - m[2]) * oneOverS, (m[4] + m[1]) * oneOverS,
-                    static_cast<T>(0.25) * s, (m[6] + m[9]) * oneOverS);
-            }
-            else
-            {
-                const T s = sqrt(m[10] - m[0] - m[5] + 1) * 2;
-                const T oneOverS = 1 / s;
-                return Quaternion<T>((m[1] - m[4]) * oneOverS, (m[8] + m[2]) * oneOverS,
-                    (m[6] + m[9]) * oneOverS, static_cast<T>(0.25) * s);
-            }
+            return FromRotation(m(1, 1), m(1, 2), m(1, 3),
+                m(2, 1), m(2, 2), m(2, 3),
+                m(3, 1), m(3, 2), m(3, 3));
         }
 
         static inline T DotProduct(const Quaternion<T>& q1, const Quaternion<T>& q2)
         {
-            return q1.myScalar * q2.myScalar + Vector3<T>::DotProduct(q1.myVector, q2.myVector);
+            return q1.myScalar * q2.myScalar + q1.myVector.Dot(q2.myVector);
         }
 
+        // Normalized linear interpolation along the shortest path. Constant time, no trigonometry,
+        // but the angular velocity is not constant over s1.
+        static inline Quaternion<T> Nlerp(const Quaternion<T>& q1,
+            const Quaternion<T>& q2, T s1)
+        {
+            const T sign = DotProduct(q1, q2) < 0 ? static_cast<T>(-1) : static_cast<T>(1);
+            const T a = 1 - s1;
+            const T b = s1 * sign;
+            Quaternion<T> result(
+                a * q1.myScalar + b * q2.myScalar,
+                a * q1.myVector.x + b * q2.myVector.x,
+                a * q1.myVector.y + b * q2.myVector.y,
+                a * q1.myVector.z + b * q2.myVector.z);
+            result.Normalize();
+            return result;
+        }
+
+        // Spherical linear interpolation along the shortest path.
         static inline Quaternion<T> Slerp(const Quaternion<T>& q1,
             const Quaternion<T>& q2, T s1)
         {
-            if (q1.myScalar * q2.myScalar + Vector3<T>::DotProduct(q1.myVector, q2.myVector) > 0.9999f)
+            T cosTheta = DotProduct(q1, q2);
+            const T sign = cosTheta < 0 ? static_cast<T>(-1) : static_cast<T>(1);
+            cosTheta *= sign;
+
+            if (cosTheta > static_cast<T>(0.9995))
             {
-                return Quaternion<T>(q1.myScalar * (1 - s1) + q2.myScalar * s1,
-                    q1.myVector * (1 - s1) + q2.myVector * s1)
-                    .Normalized();
+                return Nlerp(q1, q2, s1);
             }
-            return q1 * ((q1.Inverse() * q2) * s1);
+
+            const T theta = static_cast<T>(acos(cosTheta));
+            const T oneOverSinTheta = 1 / static_cast<T>(sqrt(1 - cosTheta * cosTheta));
+            const T a = static_cast<T>(sin((1 - s1) * theta)) * oneOverSinTheta;
+            const T b = static_cast<T>(sin(s1 * theta)) * oneOverSinTheta * sign;
+            return Quaternion<T>(
+                a * q1.myScalar + b * q2.myScalar,
+                a * q1.myVector.x + b * q2.myVector.x,
+                a * q1.myVector.y + b * q2.myVector.y,
+                a * q1.myVector.z + b * q2.myVector.z);
         }
 
-        inline T operator[](const int i) const { return i == 0 ? myScalar : myVector[i - 1]; }
+        // Approximate slerp: nlerp with s1 corrected by a polynomial fitted on the angle between the
+        // quaternions. No trigonometry, one square root. For unit inputs the result is within 0.001
+        // radians of the Slerp rotation, the worst case being inputs that are nearly opposite.
+        static inline Quaternion<T> FastSlerp(const Quaternion<T>& q1,
+            const Quaternion<T>& q2, T s1)
+        {
+            return Nlerp(q1, q2, FastSlerpCorrection(Abs(DotProduct(q1, q2)), s1));
+        }
+
+        // Nlerps aCount pairs with the same factor, e.g. blending two poses of a skeleton.
+        static inline void NlerpBatch(const Quaternion<T>* someFrom, const Quaternion<T>* someTo, T s1,
+            Quaternion<T>* someOut, size_t aCount)
+        {
+            for (size_t i = 0; i < aCount; ++i)
+            {
+                someOut[i] = Nlerp(someFrom[i], someTo[i], s1);
+            }
+        }
+
+        // FastSlerps aCount pairs with the same factor.
+        static inline void FastSlerpBatch(const Quaternion<T>* someFrom, const Quaternion<T>* someTo, T s1,
+            Quaternion<T>* someOut, size_t aCount)
+        {
+            for (size_t i = 0; i < aCount; ++i)
+            {
+                someOut[i] = FastSlerp(someFrom[i], someTo[i], s1);
+            }
+        }
+
+        inline T operator[](const int i) const { return i == 0 ? myScalar : (i == 1 ? myVector.x : (i == 2 ? myVector.y : myVector.z)); }
 
         static inline Vector3<T> PerpendicularVector(const Vector3<T>& v)
         {
-            Vector3<T> axis = Vector3<T>::CrossProduct(
-                Vector3<T>(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0)),
-                v);
+            Vector3<T> axis = Vector3<T>(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0)).Cross(v);
 
-            if (axis.LengthSquared() < static_cast<T>(0.05))
+            if (axis.LengthSqr() < static_cast<T>(0.05))
             {
-                axis = Vector3<T>::CrossProduct(
-                    Vector3<T>(static_cast<T>(0), static_cast<T>(1), static_cast<T>(0)),
-                    v);
+                axis = Vector3<T>(static_cast<T>(0), static_cast<T>(1), static_cast<T>(0)).Cross(v);
             }
             return axis;
         }
@@ -292,10 +365,10 @@ namespace CommonUtilities
             const Vector3<T>& v1, const Vector3<T>& v2,
             const Vector3<T>& preferred_axis)
         {
-            Vector3<T> start = v1.Normalized();
-            Vector3<T> end = v2.Normalized();
+            Vector3<T> start = v1.GetNormalized();
+            Vector3<T> end = v2.GetNormalized();
 
-            T dot_product = Vector3<T>::DotProduct(start, end);
+            T dot_product = start.Dot(end);
 
             if (dot_product >= static_cast<T>(0.99999847691))
             {
@@ -307,7 +380,7 @@ namespace CommonUtilities
                 return Quaternion<T>(static_cast<T>(0), preferred_axis);
             }
 
-            Vector3<T> cross_product = Vector3<T>::CrossProduct(start, end);
+            Vector3<T> cross_product = start.Cross(end);
 
             return Quaternion<T>(static_cast<T>(1.0) + dot_product, cross_product)
                 .Normalized();
@@ -316,10 +389,10 @@ namespace CommonUtilities
         static inline Quaternion<T> RotateFromTo(const Vector3<T>& v1,
             const Vector3<T>& v2)
         {
-            Vector3<T> start = v1.Normalized();
-            Vector3<T> end = v2.Normalized();
+            Vector3<T> start = v1.GetNormalized();
+            Vector3<T> end = v2.GetNormalized();
 
-            T dot_product = Vector3<T>::DotProduct(start, end);
+            T dot_product = start.Dot(end);
 
             if (dot_product >= static_cast<T>(0.99999847691))
             {
@@ -328,10 +401,10 @@ namespace CommonUtilities
 
             if (dot_product <= static_cast<T>(-0.99999847691))
             {
-                return Quaternion<T>(0, PerpendicularVector(start));
+                return Quaternion<T>(0, PerpendicularVector(start).GetNormalized());
             }
 
-            Vector3<T> cross_product = Vector3<T>::CrossProduct(start, end);
+            Vector3<T> cross_product = start.Cross(end);
 
             return Quaternion<T>(static_cast<T>(1.0) + dot_product, cross_product)
                 .Normalized();
@@ -340,13 +413,69 @@ namespace CommonUtilities
         static inline Quaternion<T> LookAt(const Vector3<T>& forward,
             const Vector3<T>& up)
         {
-            return FromMatrix(
-                Matrix3x3<T>::LookAt(forward, Vector3<T>(static_cast<T>(0)), up));
+            const Vector3<T> z = forward.GetNormalized();
+            const Vector3<T> x = up.Cross(z).GetNormalized();
+            const Vector3<T> y = z.Cross(x);
+            return FromRotation(x.x, x.y, x.z, y.x, y.y, y.z, z.x, z.y, z.z);
         }
 
         static Quaternion<T> Identity;
 
     private:
+        inline Quaternion<T> Negated() const
+        {
+            return Quaternion<T>(-myScalar, -myVector.x, -myVector.y, -myVector.z);
+        }
+
+        static inline T Abs(T aValue)
+        {
+            return aValue < 0 ? -aValue : aValue;
+        }
+
+        // Remaps s1 so that nlerp follows slerp; aCosTheta is the absolute dot product of the inputs.
+        static inline T FastSlerpCorrection(T aCosTheta, T s1)
+        {
+            const T d = aCosTheta;
+            const T a = static_cast<T>(1.0904) + d * (static_cast<T>(-3.2452) + d * (static_cast<T>(3.55645) - d * static_cast<T>(1.43519)));
+            const T b = static_cast<T>(0.848013) + d * (static_cast<T>(-1.06021) + d * static_cast<T>(0.215638));
+            const T k = a * (s1 - static_cast<T>(0.5)) * (s1 - static_cast<T>(0.5)) + b;
+            return s1 + s1 * (s1 - static_cast<T>(0.5)) * (s1 - 1) * k;
+        }
+
+        // Builds a quaternion from the rows of a row-vector rotation matrix (see ToMatrix).
+        static Quaternion<T> FromRotation(T m11, T m12, T m13, T m21, T m22, T m23, T m31, T m32, T m33)
+        {
+            const T trace = m11 + m22 + m33;
+            if (trace > 0)
+            {
+                const T s = static_cast<T>(sqrt(trace + 1)) * 2;
+                const T oneOverS = 1 / s;
+                return Quaternion<T>(static_cast<T>(0.25) * s, (m23 - m32) * oneOverS,
+                    (m31 - m13) * oneOverS, (m12 - m21) * oneOverS);
+            }
+            else if (m11 > m22 && m11 > m33)
+            {
+                const T s = static_cast<T>(sqrt(m11 - m22 - m33 + 1)) * 2;
+                const T oneOverS = 1 / s;
+                return Quaternion<T>((m23 - m32) * oneOverS, static_cast<T>(0.25) * s,
+                    (m21 + m12) * oneOverS, (m31 + m13) * oneOverS);
+            }
+            else if (m22 > m33)
+            {
+                const T s = static_cast<T>(sqrt(m22 - m11 - m33 + 1)) * 2;
+                const T oneOverS = 1 / s;
+                return Quaternion<T>((m31 - m13) * oneOverS, (m21 + m12) * oneOverS,
+                    static_cast<T>(0.25) * s, (m23 + m32) * oneOverS);
+            }
+            else
+            {
+                const T s = static_cast<T>(sqrt(m33 - m11 - m22 + 1)) * 2;
+                const T oneOverS = 1 / s;
+                return Quaternion<T>((m12 - m21) * oneOverS, (m31 + m13) * oneOverS,
+                    (m23 + m32) * oneOverS, static_cast<T>(0.25) * s);
+            }
+        }
+
         Vector3<T> myVector;
         T myScalar;
     };
@@ -359,4 +488,8 @@ namespace CommonUtilities
     {
         return q * s;
     }
-}  
+
+    using Quaternionf = Quaternion<float>;
+}
+
+namespace CU = CommonUtilities;
@@ -20,9 +20,16 @@ namespace CommonUtilities
 		const Vector3<T>& GetOrigin() const;
 		const Vector3<T>& GetDirection() const;
 
+		// Returns (1 / x, 1 / y, 1 / z) of the direction, kept up to date so slab tests can multiply
+		// instead of divide. Components are infinite for an axis the ray is parallel to.
+		const Vector3<T>& GetInverseDirection() const;
+
 	private:
+		void UpdateInverseDirection();
+
 		Vector3<T> myOrigin;
 		Vector3<T> myDirection;
+		Vector3<T> myInverseDirection;
 
 	};
 
@@ -31,6 +38,7 @@ namespace CommonUtilities
 	{
 		myOrigin = { 0, 0, 0 };
 		myDirection = { 0, 0, 0 };
+		UpdateInverseDirection();
 	}
 
 	template<typename T>
@@ -38,6 +46,7 @@ namespace CommonUtilities
 	{
 		myOrigin = aRay.myOrigin;
 		myDirection = aRay.myDirection;
+		myInverseDirection = aRay.myInverseDirection;
 	}
 
 	template<typename T>
@@ -45,6 +54,7 @@ namespace CommonUtilities
 	{
 		myOrigin = aOrigin;
 		myDirection = aDirection;
+		UpdateInverseDirection();
 	}
 
 	template<typename T>
@@ -53,6 +63,7 @@ namespace CommonUtilities
 		myOrigin = aOrigin;
 		myDirection = aPoint - aOrigin;
 		myDirection.Normalize();
+		UpdateInverseDirection();
 	}
 	template<typename T>
 	inline const Vector3<T>& Ray<T>::GetOrigin() const
@@ -64,6 +75,18 @@ namespace CommonUtilities
 	{
 		return myDirection;
 	}
+	template<typename T>
+	inline const Vector3<T>& Ray<T>::GetInverseDirection() const
+	{
+		return myInverseDirection;
+	}
+	template<typename T>
+	inline void Ray<T>::UpdateInverseDirection()
+	{
+		myInverseDirection.x = static_cast<T>(1) / myDirection.x;
+		myInverseDirection.y = static_cast<T>(1) / myDirection.y;
+		myInverseDirection.z = static_cast<T>(1) / myDirection.z;
+	}
 }
 
 namespace CU = CommonUtilities;
\ No newline at end of file
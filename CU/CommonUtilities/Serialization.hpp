@@ -0,0 +1,264 @@
+#pragma once
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "BinaryArchive.h"
+#include "GrowingArray.hpp"
+#include "HashMap.hpp"
+#include "Matrix.hpp"
+#include "Quaternion.hpp"
+#include "Vector.hpp"
+#include "../include/CU/Array.h"
+#include "../include/CU/GrowingArray.h"
+#include "../include/CU/Map.h"
+
+// Write(aWriter, aValue) and Read(aReader, aValue) for the math types and containers. Vectors, matrices,
+// quaternions and numbers are copied as raw bytes, arrays of them in a single copy. Containers store their
+// element count first.
+//
+//	CU::ArchiveWriter writer;
+//	writer.Open("scene.bin", SceneVersion);
+//	CU::Write(writer, myPositions);
+//
+//	CU::MappedFile file;
+//	file.Open("scene.bin");
+//	CU::ArchiveReader reader(file.GetData(), file.GetSize());
+//	CU::Read(reader, myPositions);
+//	if (!reader.IsValid()) ...
+namespace CommonUtilities
+{
+	// Types an archive copies as raw bytes: trivially copyable and made of nothing but Scalar numbers, so the
+	// byte order can be fixed one Scalar at a time.
+	template<typename T, typename = void>
+	struct ArchiveLayout
+	{
+		static const bool IsRaw = false;
+	};
+
+	template<typename T>
+	struct ArchiveLayout<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>
+	{
+		static const bool IsRaw = true;
+		using Scalar = T;
+	};
+
+	template<typename T, typename ScalarT>
+	struct CompoundArchiveLayout
+	{
+		static const bool IsRaw = std::is_trivially_copyable<T>::value && std::is_arithmetic<ScalarT>::value && sizeof(T) % sizeof(ScalarT) == 0;
+		using Scalar = ScalarT;
+	};
+
+	template<typename T>
+	struct ArchiveLayout<Vector2<T>> : CompoundArchiveLayout<Vector2<T>, T>
+	{};
+
+	template<typename T>
+	struct ArchiveLayout<Vector3<T>> : CompoundArchiveLayout<Vector3<T>, T>
+	{};
+
+	template<typename T>
+	struct ArchiveLayout<Vector4<T>> : CompoundArchiveLayout<Vector4<T>, T>
+	{};
+
+	template<typename T>
+	struct ArchiveLayout<Matrix2x2<T>> : CompoundArchiveLayout<Matrix2x2<T>, T>
+	{};
+
+	template<typename T>
+	struct ArchiveLayout<Matrix3x3<T>> : CompoundArchiveLayout<Matrix3x3<T>, T>
+	{};
+
+	template<typename T>
+	struct ArchiveLayout<Matrix4x4<T>> : CompoundArchiveLayout<Matrix4x4<T>, T>
+	{};
+
+	template<typename T>
+	struct ArchiveLayout<Quaternion<T>> : CompoundArchiveLayout<Quaternion<T>, T>
+	{};
+
+	#pragma region Raw values
+	template<typename T>
+	inline typename std::enable_if<ArchiveLayout<T>::IsRaw>::type Write(ArchiveWriter& aWriter, const T& aValue)
+	{
+		aWriter.WriteBytes(&aValue, sizeof(T));
+	}
+
+	template<typename T>
+	inline typename std::enable_if<ArchiveLayout<T>::IsRaw>::type Read(ArchiveReader& aReader, T& aValue)
+	{
+		using Scalar = typename ArchiveLayout<T>::Scalar;
+		aReader.ReadScalars(reinterpret_cast<Scalar*>(&aValue), sizeof(T) / sizeof(Scalar));
+	}
+
+	template<typename T>
+	inline typename std::enable_if<ArchiveLayout<T>::IsRaw>::type WriteArray(ArchiveWriter& aWriter, const T* someValues, size_t aCount)
+	{
+		aWriter.WriteBytes(someValues, sizeof(T) * aCount);
+	}
+
+	template<typename T>
+	inline typename std::enable_if<ArchiveLayout<T>::IsRaw>::type ReadArray(ArchiveReader& aReader, T* someValues, size_t aCount)
+	{
+		using Scalar = typename ArchiveLayout<T>::Scalar;
+		aReader.ReadScalars(reinterpret_cast<Scalar*>(someValues), sizeof(T) / sizeof(Scalar) * aCount);
+	}
+
+	template<typename T>
+	inline typename std::enable_if<!ArchiveLayout<T>::IsRaw>::type WriteArray(ArchiveWriter& aWriter, const T* someValues, size_t aCount)
+	{
+		for (size_t i = 0; i < aCount; ++i)
+		{
+			Write(aWriter, someValues[i]);
+		}
+	}
+
+	template<typename T>
+	inline typename std::enable_if<!ArchiveLayout<T>::IsRaw>::type ReadArray(ArchiveReader& aReader, T* someValues, size_t aCount)
+	{
+		for (size_t i = 0; i < aCount && aReader.IsValid(); ++i)
+		{
+			Read(aReader, someValues[i]);
+		}
+	}
+
+	// Reads an element count, failing the reader when the rest of the archive is too short to hold that many
+	// raw elements. This keeps a damaged count from allocating gigabytes.
+	template<typename T>
+	inline size_t ReadCount(ArchiveReader& aReader)
+	{
+		const uint64_t count = aReader.ReadValue<uint64_t>();
+		const size_t minimumSize = ArchiveLayout<T>::IsRaw ? sizeof(T) : 1;
+		if (count > aReader.GetRemaining() / minimumSize)
+		{
+			aReader.Fail();
+			return 0;
+		}
+		return static_cast<size_t>(count);
+	}
+	#pragma endregion
+
+	#pragma region Containers
+	template<typename T>
+	void Write(ArchiveWriter& aWriter, const GrowingArray<T>& anArray)
+	{
+		Write(aWriter, static_cast<uint64_t>(anArray.Size()));
+		WriteArray(aWriter, anArray.GetData(), static_cast<size_t>(anArray.Size()));
+	}
+
+	template<typename T>
+	void Read(ArchiveReader& aReader, GrowingArray<T>& anArray)
+	{
+		const size_t count = ReadCount<T>(aReader);
+		// GrowingArray counts in int and reserves one more than its size, a larger count can only come from
+		// another container or bad data.
+		if (count >= static_cast<size_t>(INT_MAX))
+		{
+			aReader.Fail();
+			return;
+		}
+		anArray.Resize(static_cast<int>(count));
+		ReadArray(aReader, anArray.GetData(), count);
+	}
+
+	template<typename Key, typename Value>
+	void Write(ArchiveWriter& aWriter, const HashMap<Key, Value>& aMap)
+	{
+		uint64_t count = 0;
+		aMap.ForEach([&count](const Key&, const Value&) { ++count; });
+		Write(aWriter, count);
+		aMap.ForEach([&aWriter](const Key& aKey, const Value& aValue)
+		{
+			Write(aWriter, aKey);
+			Write(aWriter, aValue);
+		});
+	}
+
+	// Replaces the map's elements, which must fit in its capacity.
+	template<typename Key, typename Value>
+	void Read(ArchiveReader& aReader, HashMap<Key, Value>& aMap)
+	{
+		aMap.Clear();
+		const size_t count = ReadCount<Key>(aReader);
+		for (size_t i = 0; i < count && aReader.IsValid(); ++i)
+		{
+			Key key;
+			Value value;
+			Read(aReader, key);
+			Read(aReader, value);
+			if (!aMap.Insert(key, value))
+			{
+				aReader.Fail();
+			}
+		}
+	}
+	#pragma endregion
+}
+
+namespace cu
+{
+	template<typename T, size_t size>
+	void Write(CU::ArchiveWriter& aWriter, const Array<T, size>& anArray)
+	{
+		CU::Write(aWriter, static_cast<uint64_t>(size));
+		CU::WriteArray(aWriter, anArray.Data(), size);
+	}
+
+	// Fails the reader when the archive holds an array of another size.
+	template<typename T, size_t size>
+	void Read(CU::ArchiveReader& aReader, Array<T, size>& anArray)
+	{
+		if (aReader.ReadValue<uint64_t>() != size)
+		{
+			aReader.Fail();
+			return;
+		}
+		CU::ReadArray(aReader, anArray.Data(), size);
+	}
+
+	template<typename T>
+	void Write(CU::ArchiveWriter& aWriter, const GrowingArray<T>& anArray)
+	{
+		CU::Write(aWriter, static_cast<uint64_t>(anArray.Size()));
+		CU::WriteArray(aWriter, anArray.begin(), anArray.Size());
+	}
+
+	template<typename T>
+	void Read(CU::ArchiveReader& aReader, GrowingArray<T>& anArray)
+	{
+		const size_t count = CU::ReadCount<T>(aReader);
+		anArray.Resize(count);
+		CU::ReadArray(aReader, anArray.begin(), count);
+	}
+
+	template<typename KeyT, typename ValueT>
+	void Write(CU::ArchiveWriter& aWriter, const Map<KeyT, ValueT>& aMap)
+	{
+		CU::Write(aWriter, static_cast<uint64_t>(aMap.Size()));
+		for (const Pair<KeyT, ValueT>& pair : aMap)
+		{
+			Write(aWriter, pair.First());
+			Write(aWriter, pair.Second());
+		}
+	}
+
+	// Replaces the map's elements.
+	template<typename KeyT, typename ValueT>
+	void Read(CU::ArchiveReader& aReader, Map<KeyT, ValueT>& aMap)
+	{
+		aMap.Clear();
+		const size_t count = CU::ReadCount<KeyT>(aReader);
+		for (size_t i = 0; i < count && aReader.IsValid(); ++i)
+		{
+			KeyT key{};
+			ValueT value{};
+			Read(aReader, key);
+			Read(aReader, value);
+			aMap.SetValue(key, value);
+		}
+	}
+}
+
+namespace CU = CommonUtilities;
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "Vector3.hpp"
+#include "Sphere.hpp"
+#include "AABB3D.hpp"
+#include "Hash.hpp"
+
+namespace CommonUtilities
+{
+	// Uniform grid over points where the cells are hashed into a fixed size table. Build sorts the
+	// points by table slot with a counting sort, so every slot is one contiguous range of points and
+	// no memory is allocated per cell. Slots can hold points from several cells, the queries only
+	// report points whose own cell is being visited so nothing is reported twice.
+	template<typename T>
+	class SpatialHashGrid
+	{
+	public:
+		explicit SpatialHashGrid(T aCellSize);
+
+		// Sorts aCount points into the grid, replacing what was there. The table gets at least
+		// aTableSize slots, or one per point when aTableSize is 0. Uses aThreadCount threads,
+		// the calling thread counts as one.
+		void Build(const Vector3<T>* somePositions, int aCount, int aThreadCount = 1, int aTableSize = 0);
+
+		// Calls aCallback(anIndex) for every point inside aSphere, anIndex is the position in the array
+		// given to Build. Return false from aCallback to stop.
+		template<typename Callback>
+		void QueryRadius(const Sphere<T>& aSphere, Callback&& aCallback) const;
+
+		// Writes up to aMaxCount indices of points inside aSphere and returns how many were written.
+		int QueryRadius(const Sphere<T>& aSphere, int* someOutIndices, int aMaxCount) const;
+
+		// Same as QueryRadius for points inside anAABB.
+		template<typename Callback>
+		void QueryAABB(const AABB3D<T>& anAABB, Callback&& aCallback) const;
+
+		int QueryAABB(const AABB3D<T>& anAABB, int* someOutIndices, int aMaxCount) const;
+
+		T GetCellSize() const;
+		int GetPointCount() const;
+
+	private:
+		template<typename Inside, typename Callback>
+		void Query(const Vector3<T>& aMin, const Vector3<T>& aMax, const Inside& anInside, Callback& aCallback) const;
+
+		int GetCell(T aCoordinate) const;
+		static uint64_t GetCellKey(int aX, int aY, int aZ);
+
+		template<typename Function>
+		static void RunParallel(int aCount, int aThreadCount, const Function& aFunction);
+
+		T myCellSize;
+		T myInverseCellSize;
+		uint32_t mySlotMask = 0;
+		// Slot i holds the points from myStarts[i] to myStarts[i + 1].
+		std::vector<uint32_t> myStarts;
+		// Point data in slot order.
+		std::vector<Vector3<T>> myPositions;
+		std::vector<uint64_t> myCellKeys;
+		std::vector<int> myIndices;
+		// Per point slot and per thread slot counts, kept between builds to avoid allocating.
+		std::vector<uint32_t> mySlots;
+		std::vector<uint32_t> myThreadCounts;
+	};
+
+	template<typename T>
+	inline SpatialHashGrid<T>::SpatialHashGrid(T aCellSize)
+		: myCellSize(aCellSize)
+		, myInverseCellSize(static_cast<T>(1) / aCellSize)
+	{
+		assert(aCellSize > 0 && "Cell size must be positive.");
+	}
+
+	template<typename T>
+	inline void SpatialHashGrid<T>::Build(const Vector3<T>* somePositions, int aCount, int aThreadCount, int aTableSize)
+	{
+		uint32_t slotCount = 1;
+		while (slotCount < static_cast<uint32_t>(aTableSize > 0 ? aTableSize : aCount))
+		{
+			slotCount <<= 1;
+		}
+		mySlotMask = slotCount - 1;
+
+		const int threadCount = aThreadCount < 1 ? 1 : aThreadCount;
+		mySlots.resize(aCount);
+		myThreadCounts.assign(static_cast<size_t>(slotCount) * threadCount, 0);
+		myStarts.assign(slotCount + 1, 0);
+		myPositions.resize(aCount);
+		myCellKeys.resize(aCount);
+		myIndices.resize(aCount);
+
+		// Every thread finds the slots of its share of the points and counts them.
+		RunParallel(aCount, threadCount, [&](const int aFirst, const int anEnd, const int aThread)
+		{
+			uint32_t* counts = &myThreadCounts[static_cast<size_t>(slotCount) * aThread];
+			for (int i = aFirst; i < anEnd; ++i)
+			{
+				const Vector3<T>& position = somePositions[i];
+				const uint32_t slot = Hash(GetCell(position.x), GetCell(position.y), GetCell(position.z)) & mySlotMask;
+				mySlots[i] = slot;
+				++counts[slot];
+			}
+		});
+
+		// Turns the counts into where every thread starts writing in every slot, in thread order so the
+		// points in a slot stay in input order.
+		uint32_t offset = 0;
+		for (uint32_t slot = 0; slot < slotCount; ++slot)
+		{
+			myStarts[slot] = offset;
+			for (int thread = 0; thread < threadCount; ++thread)
+			{
+				uint32_t& count = myThreadCounts[static_cast<size_t>(slotCount) * thread + slot];
+				const uint32_t threadOffset = offset;
+				offset += count;
+				count = threadOffset;
+			}
+		}
+		myStarts[slotCount] = offset;
+
+		RunParallel(aCount, threadCount, [&](const int aFirst, const int anEnd, const int aThread)
+		{
+			uint32_t* offsets = &myThreadCounts[static_cast<size_t>(slotCount) * aThread];
+			for (int i = aFirst; i < anEnd; ++i)
+			{
+				const uint32_t target = offsets[mySlots[i]]++;
+				const Vector3<T>& position = somePositions[i];
+				myPositions[target] = position;
+				myCellKeys[target] = GetCellKey(GetCell(position.x), GetCell(position.y), GetCell(position.z));
+				myIndices[target] = i;
+			}
+		});
+	}
+
+	template<typename T>
+	template<typename Callback>
+	inline void SpatialHashGrid<T>::QueryRadius(const Sphere<T>& aSphere, Callback&& aCallback) const
+	{
+		const Vector3<T>& center = aSphere.GetCenter();
+		const T radius = aSphere.GetRadius();
+		const T radiusSqr = radius * radius;
+		const Vector3<T> extent(radius, radius, radius);
+		Query(center - extent, center + extent, [&](const Vector3<T>& aPosition)
+		{
+			return (aPosition - center).LengthSqr() <= radiusSqr;
+		}, aCallback);
+	}
+
+	template<typename T>
+	inline int SpatialHashGrid<T>::QueryRadius(const Sphere<T>& aSphere, int* someOutIndices, int aMaxCount) const
+	{
+		int count = 0;
+		if (aMaxCount <= 0)
+		{
+			return count;
+		}
+
+		QueryRadius(aSphere, [&](const int anIndex)
+		{
+			someOutIndices[count++] = anIndex;
+			return count < aMaxCount;
+		});
+		return count;
+	}
+
+	template<typename T>
+	template<typename Callback>
+	inline void SpatialHashGrid<T>::QueryAABB(const AABB3D<T>& anAABB, Callback&& aCallback) const
+	{
+		Query(anAABB.myMinPoint, anAABB.myMaxPoint, [&](const Vector3<T>& aPosition)
+		{
+			return anAABB.IsInside(aPosition);
+		}, aCallback);
+	}
+
+	template<typename T>
+	inline int SpatialHashGrid<T>::QueryAABB(const AABB3D<T>& anAABB, int* someOutIndices, int aMaxCount) const
+	{
+		int count = 0;
+		if (aMaxCount <= 0)
+		{
+			return count;
+		}
+
+		QueryAABB(anAABB, [&](const int anIndex)
+		{
+			someOutIndices[count++] = anIndex;
+			return count < aMaxCount;
+		});
+		return count;
+	}
+
+	template<typename T>
+	inline T SpatialHashGrid<T>::GetCellSize() const
+	{
+		return myCellSize;
+	}
+
+	template<typename T>
+	inline int SpatialHashGrid<T>::GetPointCount() const
+	{
+		return static_cast<int>(myIndices.size());
+	}
+
+	template<typename T>
+	template<typename Inside, typename Callback>
+	inline void SpatialHashGrid<T>::Query(const Vector3<T>& aMin, const Vector3<T>& aMax, const Inside& anInside, Callback& aCallback) const
+	{
+		if (myIndices.empty())
+		{
+			return;
+		}
+
+		const int minX = GetCell(aMin.x);
+		const int minY = GetCell(aMin.y);
+		const int minZ = GetCell(aMin.z);
+		const int maxX = GetCell(aMax.x);
+		const int maxY = GetCell(aMax.y);
+		const int maxZ = GetCell(aMax.z);
+
+		// Queries covering more cells than there are points are cheaper as a plain scan.
+		const int64_t cellCount = static_cast<int64_t>(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+		if (cellCount > static_cast<int64_t>(myIndices.size()))
+		{
+			for (size_t i = 0; i < myIndices.size(); ++i)
+			{
+				if (anInside(myPositions[i]) && !aCallback(myIndices[i]))
+				{
+					return;
+				}
+			}
+			return;
+		}
+
+		for (int z = minZ; z <= maxZ; ++z)
+		{
+			for (int y = minY; y <= maxY; ++y)
+			{
+				for (int x = minX; x <= maxX; ++x)
+				{
+					const uint32_t slot = Hash(x, y, z) & mySlotMask;
+					const uint64_t key = GetCellKey(x, y, z);
+					for (uint32_t i = myStarts[slot]; i < myStarts[slot + 1]; ++i)
+					{
+						if (myCellKeys[i] == key && anInside(myPositions[i]) && !aCallback(myIndices[i]))
+						{
+							return;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	inline int SpatialHashGrid<T>::GetCell(T aCoordinate) const
+	{
+		return static_cast<int>(std::floor(aCoordinate * myInverseCellSize));
+	}
+
+	template<typename T>
+	inline uint64_t SpatialHashGrid<T>::GetCellKey(int aX, int aY, int aZ)
+	{
+		// 21 bits per axis. Cells 2^21 apart share a key, which only matters for queries that wide.
+		const uint64_t mask = 0x1FFFFF;
+		return (static_cast<uint64_t>(aX) & mask) | ((static_cast<uint64_t>(aY) & mask) << 21) | ((static_cast<uint64_t>(aZ) & mask) << 42);
+	}
+
+	template<typename T>
+	template<typename Function>
+	inline void SpatialHashGrid<T>::RunParallel(int aCount, int aThreadCount, const Function& aFunction)
+	{
+		const int perThread = (aCount + aThreadCount - 1) / aThreadCount;
+		std::vector<std::thread> workers;
+		for (int thread = 1; thread < aThreadCount && thread * perThread < aCount; ++thread)
+		{
+			const int first = thread * perThread;
+			const int end = first + perThread < aCount ? first + perThread : aCount;
+			workers.emplace_back([&aFunction, first, end, thread]() { aFunction(first, end, thread); });
+		}
+		aFunction(0, perThread < aCount ? perThread : aCount, 0);
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+}
+
+namespace CU = CommonUtilities;
@@ -24,7 +24,8 @@ namespace CommonUtilities
 		// sphere surface or inside of the sphere.
 		bool IsInside(const Vector3<T>& aPosition) const;
 
-		const T& GetRadiusSqr() const;
+		T GetRadiusSqr() const;
+		const T& GetRadius() const;
 		const Vector3<T>& GetCenter() const;
 
 	private:
@@ -65,16 +66,19 @@ namespace CommonUtilities
 	inline bool Sphere<T>::IsInside(const Vector3<T>& aPosition) const
 	{
 		Vector3<T> delta = myPosition - aPosition;
-		T distance = delta.Length();
-
-		return (distance < myRadius);
+		return delta.LengthSqr() <= myRadius * myRadius;
 	}
 	template<typename T>
-	inline const T& Sphere<T>::GetRadiusSqr() const
+	inline T Sphere<T>::GetRadiusSqr() const
 	{
 		return myRadius * myRadius;
 	}
 	template<typename T>
+	inline const T& Sphere<T>::GetRadius() const
+	{
+		return myRadius;
+	}
+	template<typename T>
 	inline const Vector3<T>& Sphere<T>::GetCenter() const
 	{
 		return myPosition;
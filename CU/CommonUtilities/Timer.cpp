@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Timer.h"
+#include "FrameStatistics.h"
 
 CommonUtilities::Timer::Timer()
 {
@@ -8,9 +9,17 @@ CommonUtilities::Timer::Timer()
 
 void CommonUtilities::Timer::Update()
 {
-    myDeltaTime = (myClock.now() - myUpdateStart).count() / 1000000000.0f;
-    myUpdateStart = myClock.now();
-    myTotalTime += myDeltaTime;
+    // One clock read per update so no time falls between two frames.
+    const std::chrono::high_resolution_clock::time_point now = myClock.now();
+    myDeltaNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - myUpdateStart).count();
+    myDeltaTime = myDeltaNanoseconds / 1000000000.0f;
+    myUpdateStart = now;
+    myTotalNanoseconds += myDeltaNanoseconds;
+
+    if (myStatistics != nullptr)
+    {
+        myStatistics->AddFrame(myDeltaTime);
+    }
 }
 
 float CommonUtilities::Timer::GetDeltaTime() const
@@ -20,5 +29,20 @@ float CommonUtilities::Timer::GetDeltaTime() const
 
 double CommonUtilities::Timer::GetTotalTime() const
 {
-    return myTotalTime;
+    return myTotalNanoseconds / 1000000000.0;
+}
+
+int64_t CommonUtilities::Timer::GetDeltaNanoseconds() const
+{
+    return myDeltaNanoseconds;
+}
+
+int64_t CommonUtilities::Timer::GetTotalNanoseconds() const
+{
+    return myTotalNanoseconds;
+}
+
+void CommonUtilities::Timer::SetStatistics(FrameStatistics* aStatistics)
+{
+    myStatistics = aStatistics;
 }
@@ -1,8 +1,11 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 
 namespace CommonUtilities
 {
+	class FrameStatistics;
+
 	class Timer
 	{
 	public:
@@ -15,12 +18,21 @@ namespace CommonUtilities
 		float GetDeltaTime() const;
 		double GetTotalTime() const;
 
+		// Exact times in nanoseconds, the total does not drift however long the timer runs.
+		int64_t GetDeltaNanoseconds() const;
+		int64_t GetTotalNanoseconds() const;
+
+		// Every Update adds its delta time to aStatistics, pass nullptr to stop.
+		void SetStatistics(FrameStatistics* aStatistics);
+
 	private:
 
 		std::chrono::high_resolution_clock myClock{};
 		std::chrono::high_resolution_clock::time_point myUpdateStart;
-		double myTotalTime = 0;
+		int64_t myTotalNanoseconds = 0;
+		int64_t myDeltaNanoseconds = 0;
 		float myDeltaTime = 0;
+		FrameStatistics* myStatistics = nullptr;
 	};
 }
 
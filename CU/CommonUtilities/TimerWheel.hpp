@@ -0,0 +1,344 @@
+#pragma once
+
+#include <assert.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Timer.h"
+
+namespace CommonUtilities
+{
+	// Hierarchical timing wheel: four wheels of 256 slots where wheel n holds the timers due within 256^(n + 1)
+	// ticks. Timers sit in intrusive doubly linked lists through a pooled array of entries, so scheduling,
+	// cancelling and rescheduling are O(1) and allocate nothing once the pool has grown. When the low wheel
+	// wraps, the next slot of the wheel above is moved down (cascaded). Timers further away than 2^32 ticks
+	// wait in an overflow list that is looked at every 2^32 ticks.
+	template<typename T>
+	class TimerWheel
+	{
+	public:
+		typedef uint64_t Handle;
+		static const Handle InvalidHandle = 0;
+
+		// aTickNanoseconds is the tick length used by Update.
+		explicit TimerWheel(int64_t aTickNanoseconds = 1000000, int aReserveCount = 0);
+
+		// Adds a timer due aDelayTicks ticks from now, at least 1. The returned handle stays safe to use after
+		// the timer has fired or been cancelled, it then refers to nothing.
+		Handle Schedule(uint64_t aDelayTicks, const T& aPayload);
+		Handle Schedule(uint64_t aDelayTicks, T&& aPayload);
+
+		// Returns false when aHandle no longer refers to a pending timer.
+		bool Cancel(Handle aHandle);
+		bool Reschedule(Handle aHandle, uint64_t aDelayTicks);
+		bool IsPending(Handle aHandle) const;
+
+		// Moves aTickCount ticks forward and calls aCallback(aHandle, aPayload) for every timer that becomes due,
+		// tick by tick. The timers of a tick are detached from the wheel before any is fired, callbacks may
+		// schedule and cancel timers, including others of the same tick.
+		template<typename Callback>
+		void Advance(uint64_t aTickCount, Callback&& aCallback);
+
+		// Advances by as many whole ticks as aTimer's last delta time covers, the rest is kept for later.
+		template<typename Callback>
+		void Update(const Timer& aTimer, Callback&& aCallback);
+
+		uint64_t GetCurrentTick() const;
+		int GetPendingCount() const;
+
+	private:
+		static const int WheelBits = 8;
+		static const int WheelSize = 1 << WheelBits;
+		static const int WheelCount = 4;
+		static const int OverflowList = WheelSize * WheelCount;
+		static const int FiringList = OverflowList + 1;
+		static const int ListCount = FiringList + 1;
+		static const int NullEntry = -1;
+
+		struct Entry
+		{
+			T myPayload;
+			uint64_t myDueTick = 0;
+			int myPrevious = NullEntry;
+			// Next in the list, or the next free entry.
+			int myNext = NullEntry;
+			int myList = NullEntry;
+			uint32_t myGeneration = 1;
+		};
+
+		Handle MakeHandle(int anIndex) const;
+		int GetEntry(Handle aHandle) const;
+		int AllocateEntry();
+		void FreeEntry(int anIndex);
+		int GetList(uint64_t aDueTick) const;
+		void Link(int anIndex, int aList);
+		void Unlink(int anIndex);
+		void Cascade(int aList);
+		Handle Insert(int anIndex, uint64_t aDelayTicks);
+
+		std::vector<Entry> myEntries;
+		int myLists[ListCount];
+		int myFreeEntries = NullEntry;
+		int myPendingCount = 0;
+		uint64_t myCurrentTick = 0;
+		int64_t myTickNanoseconds;
+		int64_t myAccumulatedNanoseconds = 0;
+	};
+
+	template<typename T>
+	inline TimerWheel<T>::TimerWheel(int64_t aTickNanoseconds, int aReserveCount)
+		: myTickNanoseconds(aTickNanoseconds)
+	{
+		assert(aTickNanoseconds > 0 && "Ticks must be at least a nanosecond long.");
+		for (int list = 0; list < ListCount; ++list)
+		{
+			myLists[list] = NullEntry;
+		}
+		myEntries.reserve(aReserveCount > 0 ? aReserveCount : 0);
+	}
+
+	template<typename T>
+	inline typename TimerWheel<T>::Handle TimerWheel<T>::Schedule(uint64_t aDelayTicks, const T& aPayload)
+	{
+		const int index = AllocateEntry();
+		myEntries[index].myPayload = aPayload;
+		return Insert(index, aDelayTicks);
+	}
+
+	template<typename T>
+	inline typename TimerWheel<T>::Handle TimerWheel<T>::Schedule(uint64_t aDelayTicks, T&& aPayload)
+	{
+		const int index = AllocateEntry();
+		myEntries[index].myPayload = std::move(aPayload);
+		return Insert(index, aDelayTicks);
+	}
+
+	template<typename T>
+	inline bool TimerWheel<T>::Cancel(Handle aHandle)
+	{
+		const int index = GetEntry(aHandle);
+		if (index == NullEntry)
+		{
+			return false;
+		}
+
+		Unlink(index);
+		FreeEntry(index);
+		return true;
+	}
+
+	template<typename T>
+	inline bool TimerWheel<T>::Reschedule(Handle aHandle, uint64_t aDelayTicks)
+	{
+		const int index = GetEntry(aHandle);
+		if (index == NullEntry)
+		{
+			return false;
+		}
+
+		Unlink(index);
+		--myPendingCount;
+		Insert(index, aDelayTicks);
+		return true;
+	}
+
+	template<typename T>
+	inline bool TimerWheel<T>::IsPending(Handle aHandle) const
+	{
+		return GetEntry(aHandle) != NullEntry;
+	}
+
+	template<typename T>
+	template<typename Callback>
+	inline void TimerWheel<T>::Advance(uint64_t aTickCount, Callback&& aCallback)
+	{
+		for (uint64_t step = 0; step < aTickCount; ++step)
+		{
+			++myCurrentTick;
+
+			// Higher wheels first, so timers cascaded into a lower wheel's current slot are cascaded again.
+			if ((myCurrentTick & 0xFFFFFFFF) == 0)
+			{
+				Cascade(OverflowList);
+			}
+			for (int wheel = WheelCount - 1; wheel > 0; --wheel)
+			{
+				const int shift = wheel * WheelBits;
+				if ((myCurrentTick & ((static_cast<uint64_t>(1) << shift) - 1)) == 0)
+				{
+					Cascade(wheel * WheelSize + static_cast<int>((myCurrentTick >> shift) & (WheelSize - 1)));
+				}
+			}
+
+			const int slot = static_cast<int>(myCurrentTick & (WheelSize - 1));
+			if (myLists[slot] == NullEntry)
+			{
+				continue;
+			}
+
+			// The whole slot is due, it is moved to the firing list and fired from there.
+			myLists[FiringList] = myLists[slot];
+			myLists[slot] = NullEntry;
+			for (int index = myLists[FiringList]; index != NullEntry; index = myEntries[index].myNext)
+			{
+				myEntries[index].myList = FiringList;
+			}
+
+			while (myLists[FiringList] != NullEntry)
+			{
+				const int index = myLists[FiringList];
+				const Handle handle = MakeHandle(index);
+				Unlink(index);
+				T payload = std::move(myEntries[index].myPayload);
+				FreeEntry(index);
+				aCallback(handle, payload);
+			}
+		}
+	}
+
+	template<typename T>
+	template<typename Callback>
+	inline void TimerWheel<T>::Update(const Timer& aTimer, Callback&& aCallback)
+	{
+		myAccumulatedNanoseconds += aTimer.GetDeltaNanoseconds();
+		const int64_t ticks = myAccumulatedNanoseconds / myTickNanoseconds;
+		myAccumulatedNanoseconds -= ticks * myTickNanoseconds;
+		Advance(static_cast<uint64_t>(ticks), aCallback);
+	}
+
+	template<typename T>
+	inline uint64_t TimerWheel<T>::GetCurrentTick() const
+	{
+		return myCurrentTick;
+	}
+
+	template<typename T>
+	inline int TimerWheel<T>::GetPendingCount() const
+	{
+		return myPendingCount;
+	}
+
+	template<typename T>
+	inline typename TimerWheel<T>::Handle TimerWheel<T>::MakeHandle(int anIndex) const
+	{
+		return (static_cast<Handle>(myEntries[anIndex].myGeneration) << 32) | static_cast<uint32_t>(anIndex);
+	}
+
+	template<typename T>
+	inline int TimerWheel<T>::GetEntry(Handle aHandle) const
+	{
+		const uint32_t index = static_cast<uint32_t>(aHandle);
+		if (index >= myEntries.size())
+		{
+			return NullEntry;
+		}
+
+		const Entry& entry = myEntries[index];
+		if (entry.myGeneration != static_cast<uint32_t>(aHandle >> 32) || entry.myList == NullEntry)
+		{
+			return NullEntry;
+		}
+		return static_cast<int>(index);
+	}
+
+	template<typename T>
+	inline int TimerWheel<T>::AllocateEntry()
+	{
+		if (myFreeEntries == NullEntry)
+		{
+			myEntries.emplace_back();
+			return static_cast<int>(myEntries.size()) - 1;
+		}
+
+		const int index = myFreeEntries;
+		myFreeEntries = myEntries[index].myNext;
+		return index;
+	}
+
+	template<typename T>
+	inline void TimerWheel<T>::FreeEntry(int anIndex)
+	{
+		Entry& entry = myEntries[anIndex];
+		// Whatever the payload holds (a callback's captures, a shared pointer) is released now rather than
+		// when the entry is reused.
+		entry.myPayload = T();
+		// Generation 0 is skipped so no handle is ever InvalidHandle.
+		entry.myGeneration = entry.myGeneration + 1 == 0 ? 1 : entry.myGeneration + 1;
+		entry.myList = NullEntry;
+		entry.myNext = myFreeEntries;
+		myFreeEntries = anIndex;
+		--myPendingCount;
+	}
+
+	template<typename T>
+	inline int TimerWheel<T>::GetList(uint64_t aDueTick) const
+	{
+		// The wheel is picked by the highest byte where the due tick differs from the current tick, so a
+		// timer is cascaded exactly when the current tick reaches the block it is due in.
+		const uint64_t difference = aDueTick ^ myCurrentTick;
+		for (int wheel = 0; wheel < WheelCount; ++wheel)
+		{
+			if ((difference >> ((wheel + 1) * WheelBits)) == 0)
+			{
+				return wheel * WheelSize + static_cast<int>((aDueTick >> (wheel * WheelBits)) & (WheelSize - 1));
+			}
+		}
+		return OverflowList;
+	}
+
+	template<typename T>
+	inline void TimerWheel<T>::Link(int anIndex, int aList)
+	{
+		Entry& entry = myEntries[anIndex];
+		entry.myList = aList;
+		entry.myPrevious = NullEntry;
+		entry.myNext = myLists[aList];
+		if (entry.myNext != NullEntry)
+		{
+			myEntries[entry.myNext].myPrevious = anIndex;
+		}
+		myLists[aList] = anIndex;
+	}
+
+	template<typename T>
+	inline void TimerWheel<T>::Unlink(int anIndex)
+	{
+		const Entry& entry = myEntries[anIndex];
+		if (entry.myPrevious != NullEntry)
+		{
+			myEntries[entry.myPrevious].myNext = entry.myNext;
+		}
+		else
+		{
+			myLists[entry.myList] = entry.myNext;
+		}
+		if (entry.myNext != NullEntry)
+		{
+			myEntries[entry.myNext].myPrevious = entry.myPrevious;
+		}
+	}
+
+	template<typename T>
+	inline void TimerWheel<T>::Cascade(int aList)
+	{
+		int index = myLists[aList];
+		myLists[aList] = NullEntry;
+		while (index != NullEntry)
+		{
+			const int next = myEntries[index].myNext;
+			Link(index, GetList(myEntries[index].myDueTick));
+			index = next;
+		}
+	}
+
+	template<typename T>
+	inline typename TimerWheel<T>::Handle TimerWheel<T>::Insert(int anIndex, uint64_t aDelayTicks)
+	{
+		myEntries[anIndex].myDueTick = myCurrentTick + (aDelayTicks > 0 ? aDelayTicks : 1);
+		Link(anIndex, GetList(myEntries[anIndex].myDueTick));
+		++myPendingCount;
+		return MakeHandle(anIndex);
+	}
+}
+
+namespace CU = CommonUtilities;
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "Win32InputBackend.h"
+
+#ifdef _WIN32
+#include "Input.h"
+#include <windowsx.h>
+
+CommonUtilities::Win32InputBackend::Win32InputBackend(Input& anInput)
+    : myEvents(anInput.GetEventRing())
+{
+}
+
+bool CommonUtilities::Win32InputBackend::HandleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_KEYDOWN:
+        Push(InputEventType::KeyDown, static_cast<int>(wParam), lParam);
+        return true;
+
+    case WM_KEYUP:
+        Push(InputEventType::KeyUp, static_cast<int>(wParam), lParam);
+        return true;
+
+    case WM_MOUSEMOVE:
+        Push(InputEventType::MouseMove, 0, lParam);
+        return true;
+
+    case WM_LBUTTONDOWN:
+        Push(InputEventType::KeyDown, VK_LBUTTON, lParam);
+        return true;
+
+    case WM_LBUTTONUP:
+        Push(InputEventType::KeyUp, VK_LBUTTON, lParam);
+        return true;
+
+    case WM_RBUTTONDOWN:
+        Push(InputEventType::KeyDown, VK_RBUTTON, lParam);
+        return true;
+
+    case WM_RBUTTONUP:
+        Push(InputEventType::KeyUp, VK_RBUTTON, lParam);
+        return true;
+
+    case WM_MBUTTONDOWN:
+        Push(InputEventType::KeyDown, VK_MBUTTON, lParam);
+        return true;
+
+    case WM_MBUTTONUP:
+        Push(InputEventType::KeyUp, VK_MBUTTON, lParam);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void CommonUtilities::Win32InputBackend::Push(InputEventType aType, int aKey, LPARAM lParam)
+{
+    InputEvent event;
+    event.myTimestamp = GetInputTimestamp();
+    event.myType = aType;
+    event.myKey = static_cast<uint8_t>(aKey);
+    // Key messages carry no position, the mouse position is only read from mouse messages.
+    event.myX = aType == InputEventType::MouseMove ? GET_X_LPARAM(lParam) : 0;
+    event.myY = aType == InputEventType::MouseMove ? GET_Y_LPARAM(lParam) : 0;
+    myEvents.Push(event);
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#ifdef _WIN32
+#include "InputEvent.h"
+#include <Windows.h>
+
+namespace CommonUtilities
+{
+	class Input;
+
+	// Turns window messages into input events for an Input. Call HandleMessage from the window procedure,
+	// mouse buttons become key events with their virtual key code.
+	class Win32InputBackend
+	{
+	public:
+		explicit Win32InputBackend(Input& anInput);
+
+		// Returns whether the message was an input message.
+		bool HandleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+	private:
+		void Push(InputEventType aType, int aKey, LPARAM lParam);
+
+		InputEventRing& myEvents;
+	};
+}
+
+namespace CU = CommonUtilities;
+#endif
@@ -0,0 +1,239 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "..\include\CU\Decomposition.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace DecompositionTests
+{
+	// Sizes around the 32 column panels of the factorizations.
+	const size_t Sizes[] = { 1, 2, 7, 31, 32, 33, 63, 64, 65, 150 };
+
+	// Small integers, so products are exact and can be compared with ==.
+	template<typename T>
+	cu::DynamicMatrix<T> MakeMatrix(const size_t aRows, const size_t aColumns, unsigned int aSeed)
+	{
+		cu::DynamicMatrix<T> matrix(aRows, aColumns);
+		for (size_t i = 0; i < aRows * aColumns; ++i)
+		{
+			aSeed = aSeed * 1664525u + 1013904223u;
+			matrix.Data()[i] = static_cast<T>(static_cast<int>((aSeed >> 16) % 17) - 8);
+		}
+		return matrix;
+	}
+
+	template<typename T>
+	cu::DynamicMatrix<T> NaiveProduct(const cu::DynamicMatrix<T>& aLeft, const cu::DynamicMatrix<T>& aRight)
+	{
+		cu::DynamicMatrix<T> product(aLeft.Rows(), aRight.Columns());
+		for (size_t i = 0; i < aLeft.Rows(); ++i)
+		{
+			for (size_t j = 0; j < aRight.Columns(); ++j)
+			{
+				T sum{};
+				for (size_t k = 0; k < aLeft.Columns(); ++k)
+				{
+					sum += aLeft.Coefficient(i, k) * aRight.Coefficient(k, j);
+				}
+				product.Coefficient(i, j) = sum;
+			}
+		}
+		return product;
+	}
+
+	template<typename T>
+	T MaxNorm(const cu::DynamicMatrix<T>& aMatrix)
+	{
+		T norm{};
+		for (size_t i = 0; i < aMatrix.Rows(); ++i)
+		{
+			T sum{};
+			for (size_t j = 0; j < aMatrix.Columns(); ++j)
+			{
+				sum += std::abs(aMatrix.Coefficient(i, j));
+			}
+			norm = sum > norm ? sum : norm;
+		}
+		return norm;
+	}
+
+	// The scaled residual |b - A x| / (n |A| |x| epsilon), which stays small for backward stable solvers.
+	template<typename T>
+	T ScaledResidual(const cu::DynamicMatrix<T>& aMatrix, const cu::DynamicMatrix<T>& aSolutions, const cu::DynamicMatrix<T>& aRightHandSides)
+	{
+		const cu::DynamicMatrix<T> residual = aRightHandSides - NaiveProduct(aMatrix, aSolutions);
+		const T scale = static_cast<T>(aMatrix.Columns()) * MaxNorm(aMatrix) * MaxNorm(aSolutions) * std::numeric_limits<T>::epsilon();
+		return MaxNorm(residual) / scale;
+	}
+
+	// A random matrix with a heavier diagonal, far from singular.
+	template<typename T>
+	cu::DynamicMatrix<T> MakeSystem(const size_t aSize, const unsigned int aSeed)
+	{
+		cu::DynamicMatrix<T> matrix = MakeMatrix<T>(aSize, aSize, aSeed);
+		for (size_t i = 0; i < aSize; ++i)
+		{
+			matrix.Coefficient(i, i) += static_cast<T>(4 * aSize);
+		}
+		return matrix;
+	}
+
+	template<typename T>
+	void CheckLU(const T aThreshold)
+	{
+		for (const size_t size : Sizes)
+		{
+			const cu::DynamicMatrix<T> matrix = MakeSystem<T>(size, static_cast<unsigned int>(size));
+			const cu::DynamicMatrix<T> rightHandSides = MakeMatrix<T>(size, 3, 99);
+			const cu::LUDecomposition<T> lu(matrix);
+			Assert::IsFalse(lu.IsSingular());
+			const cu::DynamicMatrix<T> solutions = lu.Solve(rightHandSides);
+			Assert::IsTrue(ScaledResidual(matrix, solutions, rightHandSides) < aThreshold, L"The LU solution has a large residual.");
+		}
+	}
+
+	TEST_CLASS(DecompositionTests)
+	{
+	public:
+		TEST_METHOD(DynamicMatrixProduct)
+		{
+			for (const size_t size : Sizes)
+			{
+				const cu::DynamicMatrix<float> left = MakeMatrix<float>(size, size + 3, 1);
+				const cu::DynamicMatrix<float> right = MakeMatrix<float>(size + 3, size, 2);
+				const cu::DynamicMatrix<float> expected = NaiveProduct(left, right);
+				Assert::IsTrue(left * right == expected, L"The product does not match the plain loop.");
+				Assert::IsTrue(left.Multiply(right, 2) == expected, L"The threaded product does not match the plain loop.");
+			}
+
+			bool threw = false;
+			try
+			{
+				MakeMatrix<float>(2, 3, 1) * MakeMatrix<float>(2, 3, 1);
+			}
+			catch (const std::invalid_argument&)
+			{
+				threw = true;
+			}
+			Assert::IsTrue(threw, L"Multiplying mismatching sizes did not throw.");
+		}
+
+		TEST_METHOD(LUResiduals)
+		{
+			CheckLU<double>(30.0);
+			CheckLU<float>(30.0f);
+		}
+
+		TEST_METHOD(LUSolveVectorAndDeterminant)
+		{
+			const cu::DynamicMatrix<double> matrix(3, 3, { 0.0, 2.0, 1.0, 1.0, 1.0, 0.0, 3.0, 0.0, 1.0 });
+			const cu::LUDecomposition<double> lu(matrix);
+			Assert::IsTrue(std::abs(lu.Determinant() + 5.0) < 1e-12);
+
+			// x = (1, 2, 3) gives b = (7, 3, 6).
+			double vector[] = { 7.0, 3.0, 6.0 };
+			lu.SolveInPlace(vector);
+			Assert::IsTrue(std::abs(vector[0] - 1.0) < 1e-12 && std::abs(vector[1] - 2.0) < 1e-12 && std::abs(vector[2] - 3.0) < 1e-12);
+		}
+
+		TEST_METHOD(LUSingular)
+		{
+			// Exact zeros.
+			const cu::LUDecomposition<double> exact(cu::DynamicMatrix<double>(2, 2, { 1.0, 2.0, 2.0, 4.0 }));
+			Assert::IsTrue(exact.IsSingular());
+
+			// A row made of others, rounding leaves a tiny pivot instead of a zero.
+			for (const size_t size : { static_cast<size_t>(3), static_cast<size_t>(65) })
+			{
+				cu::DynamicMatrix<double> matrix = MakeSystem<double>(size, 5);
+				for (size_t j = 0; j < size; ++j)
+				{
+					matrix.Coefficient(size - 1, j) = 0.1 * matrix.Coefficient(0, j) + 0.7 * matrix.Coefficient(1, j);
+				}
+				const cu::LUDecomposition<double> lu(matrix);
+				Assert::IsTrue(lu.IsSingular(), L"A singular matrix was not detected.");
+
+				bool threw = false;
+				try
+				{
+					lu.Solve(MakeMatrix<double>(size, 1, 1));
+				}
+				catch (const std::domain_error&)
+				{
+					threw = true;
+				}
+				Assert::IsTrue(threw, L"Solving a singular system did not throw.");
+			}
+
+			// Badly scaled columns are not singular.
+			const cu::LUDecomposition<double> scaled(cu::DynamicMatrix<double>(2, 2, { 1e12, 1.0, 0.0, 1e-12 }));
+			Assert::IsFalse(scaled.IsSingular());
+		}
+
+		TEST_METHOD(CholeskyResiduals)
+		{
+			for (const size_t size : Sizes)
+			{
+				// B^T B plus a diagonal is symmetric positive definite.
+				const cu::DynamicMatrix<double> factor = MakeMatrix<double>(size, size, static_cast<unsigned int>(size));
+				cu::DynamicMatrix<double> matrix = NaiveProduct(factor.Transposed(), factor);
+				for (size_t i = 0; i < size; ++i)
+				{
+					matrix.Coefficient(i, i) += static_cast<double>(size);
+				}
+				const cu::DynamicMatrix<double> rightHandSides = MakeMatrix<double>(size, 2, 7);
+				const cu::CholeskyDecomposition<double> cholesky(matrix);
+				const cu::DynamicMatrix<double> solutions = cholesky.Solve(rightHandSides);
+				Assert::IsTrue(ScaledResidual(matrix, solutions, rightHandSides) < 30.0, L"The Cholesky solution has a large residual.");
+			}
+
+			bool threw = false;
+			try
+			{
+				cu::CholeskyDecomposition<double> cholesky(cu::DynamicMatrix<double>(2, 2, { 1.0, 2.0, 2.0, 1.0 }));
+			}
+			catch (const std::domain_error&)
+			{
+				threw = true;
+			}
+			Assert::IsTrue(threw, L"An indefinite matrix was factorized.");
+		}
+
+		TEST_METHOD(QRResiduals)
+		{
+			for (const size_t size : Sizes)
+			{
+				const cu::DynamicMatrix<double> matrix = MakeSystem<double>(size, static_cast<unsigned int>(size));
+				const cu::DynamicMatrix<double> rightHandSides = MakeMatrix<double>(size, 2, 11);
+				const cu::QRDecomposition<double> qr(matrix);
+				Assert::IsFalse(qr.IsRankDeficient());
+				const cu::DynamicMatrix<double> solutions = qr.Solve(rightHandSides);
+				Assert::IsTrue(ScaledResidual(matrix, solutions, rightHandSides) < 30.0, L"The QR solution has a large residual.");
+			}
+		}
+
+		TEST_METHOD(QRLeastSquares)
+		{
+			// The least squares residual is orthogonal to the columns, A^T (b - A x) = 0.
+			for (const size_t columns : { static_cast<size_t>(5), static_cast<size_t>(33), static_cast<size_t>(64) })
+			{
+				const size_t rows = 2 * columns + 7;
+				const cu::DynamicMatrix<double> matrix = MakeMatrix<double>(rows, columns, static_cast<unsigned int>(columns));
+				const cu::DynamicMatrix<double> rightHandSides = MakeMatrix<double>(rows, 1, 13);
+				const cu::QRDecomposition<double> qr(matrix);
+				const cu::DynamicMatrix<double> solutions = qr.Solve(rightHandSides);
+				Assert::AreEqual(columns, solutions.Rows());
+
+				const cu::DynamicMatrix<double> residual = rightHandSides - NaiveProduct(matrix, solutions);
+				const cu::DynamicMatrix<double> normal = NaiveProduct(matrix.Transposed(), residual);
+				const double scale = static_cast<double>(rows) * MaxNorm(matrix.Transposed()) * MaxNorm(rightHandSides) * std::numeric_limits<double>::epsilon();
+				Assert::IsTrue(MaxNorm(normal) < 30.0 * scale, L"The least squares residual is not orthogonal to the columns.");
+			}
+		}
+	};
+}
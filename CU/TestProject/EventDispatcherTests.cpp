@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "..\include\CU\EventDispatcher.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace EventDispatcherTests
+{
+	struct Hit
+	{
+		int value;
+	};
+
+	struct Resource
+	{
+		std::shared_ptr<int> data;
+	};
+
+	TEST_CLASS(EventDispatcherTests)
+	{
+	public:
+		TEST_METHOD(SubscribeDuringDispatch)
+		{
+			cu::EventChannel<Hit> channel;
+			int outerCalls = 0;
+			int innerCalls = 0;
+			channel.Subscribe([&](const Hit&)
+			{
+				if (++outerCalls == 1)
+				{
+					channel.Subscribe([&](const Hit&) { ++innerCalls; });
+				}
+			});
+
+			channel.Dispatch(Hit{ 1 });
+			Assert::AreEqual(0, innerCalls, L"A listener added during a dispatch was called by it.");
+			Assert::AreEqual(static_cast<size_t>(2), channel.ListenerCount());
+
+			channel.Dispatch(Hit{ 2 });
+			Assert::AreEqual(2, outerCalls);
+			Assert::AreEqual(1, innerCalls);
+		}
+
+		TEST_METHOD(UnsubscribeDuringDispatch)
+		{
+			cu::EventChannel<Hit> channel;
+			int firstCalls = 0;
+			int secondCalls = 0;
+			cu::EventHandle<Hit> first;
+			cu::EventHandle<Hit> second;
+
+			// The first listener removes itself and the one after it.
+			first = channel.Subscribe([&](const Hit&)
+			{
+				++firstCalls;
+				Assert::IsTrue(channel.Unsubscribe(second));
+				Assert::IsTrue(channel.Unsubscribe(first));
+				Assert::IsFalse(channel.Unsubscribe(first), L"A listener was unsubscribed twice.");
+			});
+			second = channel.Subscribe([&](const Hit&) { ++secondCalls; });
+
+			channel.Dispatch(Hit{ 1 });
+			Assert::AreEqual(1, firstCalls);
+			Assert::AreEqual(0, secondCalls, L"A listener removed during a dispatch was called by it.");
+			Assert::AreEqual(static_cast<size_t>(0), channel.ListenerCount());
+
+			channel.Dispatch(Hit{ 2 });
+			Assert::AreEqual(1, firstCalls);
+		}
+
+		TEST_METHOD(AddAndRemoveDuringDispatch)
+		{
+			// A listener added and removed within the same dispatch is never called.
+			cu::EventChannel<Hit> channel;
+			int addedCalls = 0;
+			bool nested = false;
+			channel.Subscribe([&](const Hit&)
+			{
+				if (nested)
+				{
+					return;
+				}
+				nested = true;
+				cu::EventHandle<Hit> handle{ channel.Subscribe([&](const Hit&) { ++addedCalls; }) };
+				channel.Dispatch(Hit{ 0 });
+				Assert::IsTrue(channel.Unsubscribe(handle));
+				nested = false;
+			});
+
+			channel.Dispatch(Hit{ 1 });
+			Assert::AreEqual(0, addedCalls);
+			Assert::AreEqual(static_cast<size_t>(1), channel.ListenerCount());
+		}
+
+		TEST_METHOD(HandleGenerations)
+		{
+			cu::EventChannel<Hit> channel;
+			Assert::IsFalse(channel.IsSubscribed(cu::EventHandle<Hit>{}));
+
+			int calls = 0;
+			const cu::EventHandle<Hit> first{ channel.Subscribe([&](const Hit&) { ++calls; }) };
+			Assert::IsTrue(channel.Unsubscribe(first));
+
+			// The new listener reuses the slot, the old handle must not reach it.
+			const cu::EventHandle<Hit> second{ channel.Subscribe([&](const Hit&) { ++calls; }) };
+			Assert::IsTrue(first != second);
+			Assert::IsFalse(channel.IsSubscribed(first));
+			Assert::IsFalse(channel.Unsubscribe(first), L"A stale handle removed the listener that reused its slot.");
+			Assert::IsTrue(channel.IsSubscribed(second));
+
+			channel.Dispatch(Hit{ 1 });
+			Assert::AreEqual(1, calls);
+		}
+
+		TEST_METHOD(ThrowDuringFlush)
+		{
+			cu::EventChannel<Hit> channel;
+			std::vector<int> received;
+			channel.Subscribe([&](const Hit& hit)
+			{
+				received.push_back(hit.value);
+				if (hit.value == 2)
+				{
+					channel.Queue(Hit{ 10 });
+					throw std::runtime_error{ "Listener failed." };
+				}
+			});
+
+			channel.Queue(Hit{ 1 });
+			channel.Queue(Hit{ 2 });
+			channel.Queue(Hit{ 3 });
+			bool threw = false;
+			try
+			{
+				channel.Flush();
+			}
+			catch (const std::runtime_error&)
+			{
+				threw = true;
+			}
+			Assert::IsTrue(threw);
+			Assert::AreEqual(static_cast<size_t>(2), received.size());
+			Assert::AreEqual(static_cast<size_t>(2), channel.QueuedCount(), L"The events after the throw were not kept.");
+
+			// The channel is usable again, the event that threw is not delivered twice and the rest keep their order.
+			int added = 0;
+			channel.Subscribe([&](const Hit&) { ++added; });
+			Assert::AreEqual(static_cast<size_t>(2), channel.ListenerCount());
+			channel.Flush();
+			Assert::AreEqual(static_cast<size_t>(4), received.size());
+			Assert::AreEqual(3, received[2]);
+			Assert::AreEqual(10, received[3]);
+			Assert::AreEqual(2, added);
+			Assert::AreEqual(static_cast<size_t>(0), channel.QueuedCount());
+		}
+
+		TEST_METHOD(FlushReleasesEvents)
+		{
+			cu::EventChannel<Resource> channel;
+			channel.Subscribe([](const Resource&) {});
+			std::shared_ptr<int> data = std::make_shared<int>(1);
+
+			for (int i = 0; i < 4; ++i)
+			{
+				channel.Queue(Resource{ data });
+			}
+			channel.Flush();
+			Assert::AreEqual(1l, data.use_count(), L"Flushed events kept their resources.");
+
+			// Events put back after a throw are moved to the front, the places they leave are released too.
+			bool first = true;
+			cu::EventChannel<Resource> throwing;
+			throwing.Subscribe([&](const Resource&)
+			{
+				if (first)
+				{
+					first = false;
+					throw std::runtime_error{ "Listener failed." };
+				}
+			});
+			for (int i = 0; i < 4; ++i)
+			{
+				throwing.Queue(Resource{ data });
+			}
+			try
+			{
+				throwing.Flush();
+			}
+			catch (const std::runtime_error&)
+			{
+			}
+			Assert::AreEqual(4l, data.use_count());
+			throwing.Flush();
+			Assert::AreEqual(1l, data.use_count(), L"Flushed events kept their resources.");
+		}
+
+		TEST_METHOD(DispatcherRoutesByType)
+		{
+			cu::EventDispatcher<Hit, Resource> events;
+			int hits = 0;
+			int resources = 0;
+			events.Subscribe<Hit>([&](const Hit& hit) { hits += hit.value; });
+			events.Subscribe<Resource>([&](const Resource&) { ++resources; });
+
+			events.Dispatch(Hit{ 2 });
+			events.Queue(Hit{ 3 });
+			events.Queue(Resource{});
+			Assert::AreEqual(2, hits);
+			events.Flush();
+			Assert::AreEqual(5, hits);
+			Assert::AreEqual(1, resources);
+		}
+	};
+}
@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include "..\include\CU\Function.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FunctionTests
+{
+	// Counts the instances alive and how often they were copied and moved.
+	struct Counters
+	{
+		int alive = 0;
+		int copies = 0;
+		int moves = 0;
+	};
+
+	template<size_t padding, bool nothrowMove>
+	struct Counted
+	{
+		Counters* counters;
+		char bytes[padding];
+
+		Counted(Counters& counters) :
+			counters{ &counters },
+			bytes{}
+		{
+			++counters.alive;
+		}
+
+		Counted(const Counted& counted) :
+			counters{ counted.counters },
+			bytes{}
+		{
+			++counters->alive;
+			++counters->copies;
+		}
+
+		Counted(Counted&& counted) noexcept(nothrowMove) :
+			counters{ counted.counters },
+			bytes{}
+		{
+			++counters->alive;
+			++counters->moves;
+		}
+
+		~Counted()
+		{
+			--counters->alive;
+		}
+
+		int operator()(int value) const
+		{
+			return value + 1;
+		}
+	};
+
+	typedef Counted<8, true> Small;
+	typedef Counted<64, true> Large;
+	typedef Counted<8, false> ThrowingMove;
+	typedef cu::BasicFunction<32, true, true, int, int> HeapFunction;
+
+	struct Adder
+	{
+		int amount;
+
+		int Add(int value)
+		{
+			return value + amount;
+		}
+	};
+
+	int Twice(int value)
+	{
+		return 2 * value;
+	}
+
+	TEST_CLASS(FunctionTests)
+	{
+	public:
+		TEST_METHOD(InlineStorage)
+		{
+			Counters counters;
+			{
+				cu::Function<int, int> function{ Small{ counters } };
+				Assert::AreEqual(1, counters.alive);
+				Assert::AreEqual(4, function(3));
+
+				// A callable kept in the buffer is moved along with the function.
+				const int moves = counters.moves;
+				cu::Function<int, int> moved{ std::move(function) };
+				Assert::IsFalse(static_cast<bool>(function));
+				Assert::IsTrue(counters.moves > moves, L"The inline callable was not moved.");
+				Assert::AreEqual(1, counters.alive);
+				Assert::AreEqual(4, moved(3));
+			}
+			Assert::AreEqual(0, counters.alive, L"The function did not destroy its callable.");
+		}
+
+		TEST_METHOD(HeapStorage)
+		{
+			Counters counters;
+			{
+				HeapFunction function{ Large{ counters } };
+				Assert::AreEqual(1, counters.alive);
+
+				// A callable on the heap stays where it is, only the pointer moves.
+				const int moves = counters.moves;
+				HeapFunction moved{ std::move(function) };
+				Assert::AreEqual(moves, counters.moves);
+
+				HeapFunction copy{ moved };
+				Assert::AreEqual(2, counters.alive);
+				Assert::AreEqual(1, counters.copies);
+				Assert::AreEqual(4, copy(3));
+
+				copy.Swap(moved);
+				Assert::AreEqual(moves, counters.moves);
+			}
+			Assert::AreEqual(0, counters.alive, L"The function did not destroy its callable.");
+		}
+
+		TEST_METHOD(ThrowingMoveOnHeap)
+		{
+			// A callable that can throw when moved is allocated even though it fits, so Swap never moves it.
+			Counters counters;
+			Counters smallCounters;
+			{
+				HeapFunction function{ ThrowingMove{ counters } };
+				const int moves = counters.moves;
+				HeapFunction other{ Small{ smallCounters } };
+				function.Swap(other);
+				HeapFunction moved{ std::move(other) };
+				Assert::AreEqual(moves, counters.moves, L"A callable that can throw when moved was moved.");
+				Assert::AreEqual(4, moved(3));
+				Assert::AreEqual(4, function(3));
+			}
+			Assert::AreEqual(0, counters.alive);
+			Assert::AreEqual(0, smallCounters.alive);
+		}
+
+		TEST_METHOD(MoveOnlyCallable)
+		{
+			std::unique_ptr<int> owned{ new int{ 5 } };
+			cu::MoveOnlyFunction<int, int> function{ [owned = std::move(owned)](int value) { return value + *owned; } };
+			Assert::AreEqual(7, function(2));
+
+			cu::MoveOnlyFunction<int, int> moved;
+			moved = std::move(function);
+			Assert::IsTrue(function == nullptr);
+			Assert::AreEqual(7, moved(2));
+
+			cu::MoveOnlyFunction<int, int> other{ [](int value) { return value; } };
+			moved.Swap(other);
+			Assert::AreEqual(2, moved(2));
+			Assert::AreEqual(7, other(2));
+		}
+
+		TEST_METHOD(CopyFunction)
+		{
+			std::shared_ptr<int> shared = std::make_shared<int>(10);
+			int calls = 0;
+			cu::Function<int, int> function{ [shared, calls](int value) mutable { ++calls; return value + *shared + calls; } };
+			Assert::AreEqual(2l, shared.use_count());
+
+			// Copies hold their own callable, with its own state.
+			cu::Function<int, int> copy{ function };
+			Assert::AreEqual(3l, shared.use_count());
+			Assert::AreEqual(11, function(0));
+			Assert::AreEqual(12, function(0));
+			Assert::AreEqual(11, copy(0));
+
+			cu::Function<int, int> assigned;
+			assigned = copy;
+			Assert::AreEqual(4l, shared.use_count());
+			Assert::AreEqual(12, assigned(0));
+			Assert::AreEqual(12, copy(0));
+
+			assigned = nullptr;
+			copy.Reset();
+			Assert::AreEqual(2l, shared.use_count());
+		}
+
+		TEST_METHOD(EmptyAndBound)
+		{
+			cu::Function<int, int> empty;
+			bool threw = false;
+			try
+			{
+				empty(1);
+			}
+			catch (const std::bad_function_call&)
+			{
+				threw = true;
+			}
+			Assert::IsTrue(threw, L"Calling an empty function did not throw.");
+
+			int(*nullFunction)(int) = nullptr;
+			cu::Function<int, int> fromNull{ nullFunction };
+			Assert::IsFalse(static_cast<bool>(fromNull));
+
+			cu::Function<int, int> pointer{ &Twice };
+			Assert::AreEqual(6, pointer(3));
+
+			Adder adder{ 4 };
+			cu::Function<int, int> bound{ &adder, &Adder::Add };
+			adder.amount = 5;
+			Assert::AreEqual(8, bound(3), L"The bound function does not refer to the object.");
+		}
+
+		TEST_METHOD(FunctionRefLifetime)
+		{
+			// A reference calls the callable itself, not a copy of it.
+			int calls = 0;
+			auto counter = [&calls](int value) { ++calls; return value; };
+			cu::FunctionRef<int, int> reference{ counter };
+			reference(1);
+			reference(2);
+			Assert::AreEqual(2, calls);
+
+			Counters counters;
+			Small small{ counters };
+			cu::FunctionRef<int, int> toSmall{ small };
+			Assert::AreEqual(4, toSmall(3));
+			Assert::AreEqual(0, counters.copies + counters.moves, L"The reference copied its callable.");
+
+			// Function pointers and lambdas without captures are held by their function pointer, so the reference
+			// stays valid after a temporary lambda is gone.
+			cu::FunctionRef<int, int> toPointer{ &Twice };
+			cu::FunctionRef<int, int> toTemporary{ [](int value) { return value - 1; } };
+			Assert::AreEqual(8, toPointer(4));
+			Assert::AreEqual(3, toTemporary(4));
+
+			cu::Function<int, int> function{ &Twice };
+			cu::FunctionRef<int, int> toFunction{ function };
+			function = [](int value) { return value * value; };
+			Assert::AreEqual(25, toFunction(5), L"The reference does not refer to the function.");
+		}
+	};
+}
@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "..\include\CU\Gemm.h"
+#include "..\include\CU\Matrix.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace GemmTests
+{
+	// Small integers, so every product and sum is exact in float and double and results can be compared with ==.
+	template<typename T>
+	std::vector<T> MakeValues(const size_t aCount, unsigned int aSeed)
+	{
+		std::vector<T> values(aCount);
+		for (T& value : values)
+		{
+			aSeed = aSeed * 1664525u + 1013904223u;
+			value = static_cast<T>(static_cast<int>((aSeed >> 16) % 17) - 8);
+		}
+		return values;
+	}
+
+	template<typename T>
+	T NaiveElement(const T* aLeft, const T* aRight, const size_t aRow, const size_t aColumn, const size_t aDepth, const size_t aLeftStride, const size_t aRightStride)
+	{
+		T sum{};
+		for (size_t k = 0; k < aDepth; ++k)
+		{
+			sum += aLeft[aRow * aLeftStride + k] * aRight[k * aRightStride + aColumn];
+		}
+		return sum;
+	}
+
+	// Multiplies aRows x aDepth by aDepth x aColumns with Gemm and compares every element with a plain loop.
+	template<typename T>
+	void CheckProduct(const size_t aRows, const size_t aDepth, const size_t aColumns, const size_t aThreadCount)
+	{
+		const std::vector<T> left = MakeValues<T>(aRows * aDepth, 1);
+		const std::vector<T> right = MakeValues<T>(aDepth * aColumns, 2);
+		// Filled with garbage, Gemm has to overwrite every element.
+		std::vector<T> product(aRows * aColumns, static_cast<T>(99));
+		cu::Gemm(left.data(), right.data(), product.data(), aRows, aDepth, aColumns, aThreadCount);
+
+		for (size_t i = 0; i < aRows; ++i)
+		{
+			for (size_t j = 0; j < aColumns; ++j)
+			{
+				if (product[i * aColumns + j] != NaiveElement(left.data(), right.data(), i, j, aDepth, aDepth, aColumns))
+				{
+					Assert::Fail(L"The product does not match the plain loop.");
+				}
+			}
+		}
+	}
+
+	// Sizes on and around the kernel tiles (4x8 portable, 6x16 and 6x8 AVX2) and the 256 deep, 72 row and
+	// 1024 column blocks.
+	template<typename T>
+	void CheckEdgeSizes()
+	{
+		CheckProduct<T>(1, 1, 1, 1);
+		CheckProduct<T>(7, 5, 3, 1);
+		CheckProduct<T>(6, 300, 16, 1);
+		CheckProduct<T>(72, 256, 24, 1);
+		CheckProduct<T>(73, 257, 25, 1);
+		CheckProduct<T>(5, 3, 1030, 1);
+		CheckProduct<T>(301, 257, 199, 1);
+		CheckProduct<T>(4, 0, 6, 1);
+	}
+
+	template<size_t size>
+	void CheckMatrixProduct()
+	{
+		const std::vector<float> leftValues = MakeValues<float>(size * size, 3);
+		const std::vector<float> rightValues = MakeValues<float>(size * size, 4);
+		cu::Matrix<size, size, float> left;
+		cu::Matrix<size, size, float> right;
+		for (size_t i = 0; i < size; ++i)
+		{
+			for (size_t j = 0; j < size; ++j)
+			{
+				left.Coefficient(i, j) = leftValues[i * size + j];
+				right.Coefficient(i, j) = rightValues[i * size + j];
+			}
+		}
+
+		const cu::Matrix<size, size, float> product = left * right;
+		const cu::Matrix<size, size, float> threaded = cu::Multiply(left, right, 2);
+		for (size_t i = 0; i < size; ++i)
+		{
+			for (size_t j = 0; j < size; ++j)
+			{
+				const float expected = NaiveElement(leftValues.data(), rightValues.data(), i, j, size, size, size);
+				if (product.Coefficient(i, j) != expected || threaded.Coefficient(i, j) != expected)
+				{
+					Assert::Fail(L"The matrix product does not match the plain loop.");
+				}
+			}
+		}
+	}
+
+	TEST_CLASS(GemmTests)
+	{
+	public:
+		// int always runs the portable kernel, float and double the AVX2 ones when the build targets AVX2.
+		TEST_METHOD(EdgeSizesPortableKernel)
+		{
+			CheckEdgeSizes<int>();
+		}
+
+		TEST_METHOD(EdgeSizesFloat)
+		{
+			CheckEdgeSizes<float>();
+		}
+
+		TEST_METHOD(EdgeSizesDouble)
+		{
+			CheckEdgeSizes<double>();
+		}
+
+		TEST_METHOD(Threaded)
+		{
+			// Big enough to be split, with a last thread getting a partial sliver of rows.
+			CheckProduct<float>(301, 257, 199, 3);
+			CheckProduct<double>(301, 257, 199, 4);
+			CheckProduct<int>(301, 257, 199, 0);
+			// Only two slivers of rows, so no more than two threads.
+			CheckProduct<float>(13, 400, 1200, 8);
+		}
+
+		TEST_METHOD(AddWithStrides)
+		{
+			// Multiplies blocks inside larger arrays, the elements outside the product block must not change.
+			const size_t rows = 13;
+			const size_t depth = 11;
+			const size_t columns = 17;
+			const size_t stride = 40;
+			const std::vector<double> left = MakeValues<double>(rows * stride, 5);
+			const std::vector<double> right = MakeValues<double>(depth * stride, 6);
+			std::vector<double> product = MakeValues<double>(rows * stride, 7);
+			const std::vector<double> original = product;
+			cu::GemmAdd(left.data(), right.data(), product.data(), rows, depth, columns, 1, stride, stride, stride);
+
+			for (size_t i = 0; i < rows; ++i)
+			{
+				for (size_t j = 0; j < stride; ++j)
+				{
+					const double expected = j < columns ? original[i * stride + j] + NaiveElement(left.data(), right.data(), i, j, depth, stride, stride) : original[i * stride + j];
+					Assert::AreEqual(expected, product[i * stride + j]);
+				}
+			}
+		}
+
+		TEST_METHOD(FractionalValues)
+		{
+			// Rounding differs from the plain loop, each element has to be within the usual dot product bound.
+			const size_t size = 150;
+			std::vector<float> left(size * size);
+			std::vector<float> right(size * size);
+			for (size_t i = 0; i < left.size(); ++i)
+			{
+				left[i] = std::sin(static_cast<float>(i));
+				right[i] = std::cos(static_cast<float>(3 * i));
+			}
+			std::vector<float> product(size * size);
+			cu::Gemm(left.data(), right.data(), product.data(), size, size, size);
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				for (size_t j = 0; j < size; ++j)
+				{
+					double expected = 0.0;
+					double magnitude = 0.0;
+					for (size_t k = 0; k < size; ++k)
+					{
+						expected += static_cast<double>(left[i * size + k]) * right[k * size + j];
+						magnitude += std::abs(static_cast<double>(left[i * size + k]) * right[k * size + j]);
+					}
+					const double bound = size * std::numeric_limits<float>::epsilon() * magnitude;
+					Assert::IsTrue(std::abs(product[i * size + j] - expected) <= bound, L"The product is further from the exact result than rounding allows.");
+				}
+			}
+		}
+
+		TEST_METHOD(MatrixProducts)
+		{
+			// 3 is unrolled, 20 uses the row loop and the others go through Gemm, with and without partial tiles.
+			CheckMatrixProduct<3>();
+			CheckMatrixProduct<20>();
+			CheckMatrixProduct<63>();
+			CheckMatrixProduct<64>();
+			CheckMatrixProduct<65>();
+			CheckMatrixProduct<150>();
+		}
+	};
+}
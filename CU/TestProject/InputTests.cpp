@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include "..\CommonUtilities\HeadlessInputBackend.h"
+#include "..\CommonUtilities\Input.h"
+#include "..\CommonUtilities\InputRecording.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace InputTests
+{
+	const int KeyA = 'A';
+	const int KeyB = 'B';
+	const char* const ReplayPath = "InputTests_Replay.bin";
+
+	// Records one frame of aMoveCount mouse moves, then a frame with A pressed.
+	void RecordFrames(int aMoveCount)
+	{
+		CU::Input input(4096);
+		CU::HeadlessInputBackend backend(input);
+		CU::InputRecorder recorder;
+		Assert::IsTrue(recorder.Open(ReplayPath));
+		input.SetRecorder(&recorder);
+
+		for (int i = 0; i < aMoveCount; ++i)
+		{
+			backend.MoveMouse(i, 2 * i);
+		}
+		input.Update();
+		backend.PressKey(KeyA);
+		input.Update();
+		Assert::IsTrue(recorder.IsValid());
+		Assert::IsTrue(recorder.Close());
+	}
+
+	TEST_CLASS(InputTests)
+	{
+	public:
+		TEST_METHOD(KeyDownAndUpWithinOneFrame)
+		{
+			CU::Input input;
+			CU::HeadlessInputBackend backend(input);
+
+			backend.PressKey(KeyA);
+			backend.ReleaseKey(KeyA);
+			input.Update();
+			Assert::IsTrue(input.IsKeyDown(KeyA), L"A key pressed and released within the frame did not report its key down.");
+			Assert::IsTrue(input.IsKeyUp(KeyA), L"A key pressed and released within the frame did not report its key up.");
+			Assert::IsFalse(input.IsKeyPressed(KeyA), L"A key released within the frame is still held.");
+			Assert::IsFalse(input.IsKeyDown(KeyB), L"A key that was never pressed went down.");
+
+			input.Update();
+			Assert::IsFalse(input.IsKeyDown(KeyA), L"A key down carried over to the next frame.");
+			Assert::IsFalse(input.IsKeyUp(KeyA), L"A key up carried over to the next frame.");
+		}
+
+		TEST_METHOD(KeyHeldAcrossFrames)
+		{
+			CU::Input input;
+			CU::HeadlessInputBackend backend(input);
+
+			backend.PressKey(KeyA);
+			input.Update();
+			Assert::IsTrue(input.IsKeyDown(KeyA));
+			Assert::IsTrue(input.IsKeyPressed(KeyA));
+
+			input.Update();
+			Assert::IsFalse(input.IsKeyDown(KeyA), L"A held key went down again.");
+			Assert::IsTrue(input.IsKeyPressed(KeyA), L"A held key is no longer pressed.");
+
+			backend.ReleaseKey(KeyA);
+			input.Update();
+			Assert::IsTrue(input.IsKeyUp(KeyA));
+			Assert::IsFalse(input.IsKeyPressed(KeyA));
+		}
+
+		TEST_METHOD(RepeatedKeyDown)
+		{
+			CU::Input input;
+			CU::HeadlessInputBackend backend(input);
+
+			// Held keys repeat their key down messages, within the frame and in the following ones.
+			backend.PressKey(KeyA);
+			backend.PressKey(KeyA);
+			input.Update();
+			Assert::IsTrue(input.IsKeyDown(KeyA));
+
+			backend.PressKey(KeyA);
+			input.Update();
+			Assert::IsFalse(input.IsKeyDown(KeyA), L"A repeated key down counted as the key going down.");
+			Assert::IsTrue(input.IsKeyPressed(KeyA));
+
+			// A key up without a key down before it is not an edge.
+			backend.ReleaseKey(KeyB);
+			input.Update();
+			Assert::IsFalse(input.IsKeyUp(KeyB), L"Releasing a key that was not held reported a key up.");
+		}
+
+		TEST_METHOD(MouseDelta)
+		{
+			CU::Input input;
+			CU::HeadlessInputBackend backend(input);
+
+			backend.MoveMouse(10, 20);
+			input.Update();
+			Assert::AreEqual(10, input.GetSnapshot().GetMouseDelta().GetX());
+			Assert::AreEqual(20, input.GetSnapshot().GetMouseDelta().GetY());
+
+			// Only where the mouse ends up counts, not the path.
+			backend.MoveMouse(15, 18);
+			backend.MoveMouse(30, 5);
+			input.Update();
+			Assert::AreEqual(30, input.GetMousePosition().GetX());
+			Assert::AreEqual(5, input.GetMousePosition().GetY());
+			Assert::AreEqual(20, input.GetSnapshot().GetMouseDelta().GetX());
+			Assert::AreEqual(-15, input.GetSnapshot().GetMouseDelta().GetY());
+
+			input.Update();
+			Assert::AreEqual(0, input.GetSnapshot().GetMouseDelta().GetX(), L"The mouse delta carried over to a frame without moves.");
+			Assert::AreEqual(0, input.GetSnapshot().GetMouseDelta().GetY(), L"The mouse delta carried over to a frame without moves.");
+		}
+
+		TEST_METHOD(DroppedCount)
+		{
+			CU::Input input(4);
+			CU::HeadlessInputBackend backend(input);
+			Assert::AreEqual(4, input.GetEventRing().GetCapacity());
+
+			for (int i = 0; i < 4; ++i)
+			{
+				Assert::IsTrue(backend.MoveMouse(i, i), L"An event was dropped before the ring was full.");
+			}
+			Assert::IsFalse(backend.PressKey(KeyA), L"An event was pushed into a full ring.");
+			Assert::IsFalse(backend.ReleaseKey(KeyA), L"An event was pushed into a full ring.");
+			Assert::AreEqual(static_cast<uint64_t>(2), input.GetEventRing().GetDroppedCount());
+
+			input.Update();
+			Assert::AreEqual(4, input.GetEventCount());
+			Assert::AreEqual(3, input.GetMousePosition().GetX());
+			Assert::IsFalse(input.IsKeyDown(KeyA), L"A dropped key down was applied.");
+
+			// The ring has room again once the frame has taken the events.
+			Assert::IsTrue(backend.PressKey(KeyA));
+			input.Update();
+			Assert::IsTrue(input.IsKeyDown(KeyA));
+			Assert::AreEqual(static_cast<uint64_t>(2), input.GetEventRing().GetDroppedCount());
+		}
+
+		TEST_METHOD(ReplayFrames)
+		{
+			RecordFrames(2000);
+
+			CU::Input input(4096);
+			CU::InputReplay replay;
+			Assert::IsTrue(replay.Open(ReplayPath));
+
+			Assert::IsTrue(replay.PlayFrame(input));
+			input.Update();
+			Assert::AreEqual(2000, input.GetEventCount());
+			Assert::AreEqual(1999, input.GetMousePosition().GetX());
+			Assert::AreEqual(3998, input.GetMousePosition().GetY());
+
+			Assert::IsTrue(replay.PlayFrame(input));
+			input.Update();
+			Assert::IsTrue(input.IsKeyDown(KeyA));
+
+			Assert::IsFalse(replay.PlayFrame(input));
+			Assert::IsTrue(replay.IsFinished());
+			Assert::IsFalse(replay.HasOverflowed());
+			Assert::AreEqual(2, replay.GetPlayedFrameCount());
+			std::remove(ReplayPath);
+		}
+
+		TEST_METHOD(ReplayIntoSmallerRing)
+		{
+			RecordFrames(2000);
+
+			// The default ring holds 1024 events, the first frame does not fit.
+			CU::Input input;
+			CU::InputReplay replay;
+			Assert::IsTrue(replay.Open(ReplayPath));
+
+			Assert::IsFalse(replay.PlayFrame(input), L"A frame that did not fit in the ring was reported as played.");
+			Assert::IsTrue(replay.HasOverflowed());
+			Assert::AreEqual(0, replay.GetPlayedFrameCount());
+			Assert::IsFalse(replay.PlayFrame(input), L"The replay went on after a frame was played in part.");
+
+			replay.Rewind();
+			Assert::IsFalse(replay.HasOverflowed());
+			std::remove(ReplayPath);
+		}
+	};
+}
@@ -0,0 +1,219 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "..\CommonUtilities\IntersectionSIMD.hpp"
+#include "TestUtilities.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace IntersectionTests
+{
+	const int BatchCount = 1003;
+
+	CU::Vector3<float> GetRandomPosition()
+	{
+		return CU::Vector3<float>(TestUtility::GetRandomFloat(-10.0f, 10.0f), TestUtility::GetRandomFloat(-10.0f, 10.0f), TestUtility::GetRandomFloat(-10.0f, 10.0f));
+	}
+
+	bool IsBitSet(const std::vector<uint32_t>& someMask, const int anIndex)
+	{
+		return ((someMask[anIndex / 32] >> (anIndex % 32)) & 1) != 0;
+	}
+
+	// Random spheres and boxes kept both as objects and as structure of arrays.
+	struct Volumes
+	{
+		Volumes()
+		{
+			for (int i = 0; i < BatchCount; ++i)
+			{
+				const CU::Vector3<float> center = GetRandomPosition();
+				const float radius = TestUtility::GetRandomFloat(0.0f, 2.0f);
+				mySpheres.push_back(CU::Sphere<float>(center, radius));
+				myCenterX.push_back(center.x);
+				myCenterY.push_back(center.y);
+				myCenterZ.push_back(center.z);
+				myRadius.push_back(radius);
+
+				const CU::Vector3<float> extent(TestUtility::GetRandomFloat(0.0f, 2.0f), TestUtility::GetRandomFloat(0.0f, 2.0f), TestUtility::GetRandomFloat(0.0f, 2.0f));
+				myAABBs.push_back(CU::AABB3D<float>(center - extent, center + extent));
+				myExtentX.push_back(extent.x);
+				myExtentY.push_back(extent.y);
+				myExtentZ.push_back(extent.z);
+			}
+
+			mySphereArrays.myCenterX = myCenterX.data();
+			mySphereArrays.myCenterY = myCenterY.data();
+			mySphereArrays.myCenterZ = myCenterZ.data();
+			mySphereArrays.myRadius = myRadius.data();
+
+			myAABBArrays.myCenterX = myCenterX.data();
+			myAABBArrays.myCenterY = myCenterY.data();
+			myAABBArrays.myCenterZ = myCenterZ.data();
+			myAABBArrays.myExtentX = myExtentX.data();
+			myAABBArrays.myExtentY = myExtentY.data();
+			myAABBArrays.myExtentZ = myExtentZ.data();
+		}
+
+		std::vector<CU::Sphere<float>> mySpheres;
+		std::vector<CU::AABB3D<float>> myAABBs;
+		std::vector<float> myCenterX;
+		std::vector<float> myCenterY;
+		std::vector<float> myCenterZ;
+		std::vector<float> myRadius;
+		std::vector<float> myExtentX;
+		std::vector<float> myExtentY;
+		std::vector<float> myExtentZ;
+		CU::SphereArrays mySphereArrays;
+		CU::AABBArrays myAABBArrays;
+	};
+
+	TEST_CLASS(OverlapTests)
+	{
+	public:
+		TEST_METHOD(Sphere_IsInside)
+		{
+			CU::Sphere<float> sphere(CU::Vector3<float>(1.0f, 2.0f, 3.0f), 2.0f);
+			Assert::IsTrue(sphere.IsInside(CU::Vector3<float>(1.0f, 2.0f, 3.0f)), L"Center is not inside!");
+			Assert::IsTrue(sphere.IsInside(CU::Vector3<float>(3.0f, 2.0f, 3.0f)), L"Point on the surface is not inside!");
+			Assert::IsFalse(sphere.IsInside(CU::Vector3<float>(3.01f, 2.0f, 3.0f)), L"Point outside is inside!");
+			Assert::AreEqual(4.0f, sphere.GetRadiusSqr(), L"Wrong squared radius!");
+		}
+
+		TEST_METHOD(Scalar_Overlaps)
+		{
+			const CU::Sphere<float> sphere(CU::Vector3<float>(0.0f, 0.0f, 0.0f), 1.0f);
+			Assert::IsTrue(CU::IntersectionSphereSphere(sphere, CU::Sphere<float>(CU::Vector3<float>(2.0f, 0.0f, 0.0f), 1.0f)), L"Touching spheres do not overlap!");
+			Assert::IsFalse(CU::IntersectionSphereSphere(sphere, CU::Sphere<float>(CU::Vector3<float>(2.1f, 0.0f, 0.0f), 1.0f)), L"Separate spheres overlap!");
+
+			const CU::AABB3D<float> aabb(CU::Vector3<float>(1.0f, 1.0f, 1.0f), CU::Vector3<float>(2.0f, 2.0f, 2.0f));
+			Assert::IsTrue(CU::IntersectionAABBAABB(aabb, CU::AABB3D<float>(CU::Vector3<float>(2.0f, 0.0f, 0.0f), CU::Vector3<float>(3.0f, 1.5f, 1.5f))), L"Touching boxes do not overlap!");
+			Assert::IsFalse(CU::IntersectionAABBAABB(aabb, CU::AABB3D<float>(CU::Vector3<float>(2.1f, 0.0f, 0.0f), CU::Vector3<float>(3.0f, 1.5f, 1.5f))), L"Separate boxes overlap!");
+
+			// The corner (1, 1, 1) is sqrt(3) from the sphere center.
+			Assert::IsFalse(CU::IntersectionSphereAABB(sphere, aabb), L"Sphere overlaps the box corner!");
+			Assert::IsTrue(CU::IntersectionSphereAABB(CU::Sphere<float>(sphere.GetCenter(), 1.75f), aabb), L"Sphere misses the box corner!");
+			Assert::IsTrue(CU::IntersectionSphereAABB(CU::Sphere<float>(CU::Vector3<float>(1.5f, 1.5f, 1.5f), 0.1f), aabb), L"Sphere inside the box does not overlap!");
+
+			// Not normalized normal, the plane is y = 1 and inside is below it.
+			const CU::Plane<float> plane(CU::Vector3<float>(0.0f, 1.0f, 0.0f), CU::Vector3<float>(0.0f, 3.0f, 0.0f));
+			Assert::IsTrue(CU::IntersectionSpherePlane(sphere, plane), L"Sphere inside the plane does not overlap!");
+			Assert::IsTrue(CU::IntersectionSpherePlane(CU::Sphere<float>(CU::Vector3<float>(0.0f, 2.0f, 0.0f), 1.0f), plane), L"Sphere touching the plane does not overlap!");
+			Assert::IsFalse(CU::IntersectionSpherePlane(CU::Sphere<float>(CU::Vector3<float>(0.0f, 2.5f, 0.0f), 1.0f), plane), L"Sphere outside the plane overlaps!");
+		}
+
+		TEST_METHOD(Batch_MatchesScalar)
+		{
+			Volumes volumes;
+			std::vector<uint32_t> mask((BatchCount + 31) / 32);
+
+			for (int query = 0; query < 100; ++query)
+			{
+				const CU::Vector3<float> center = GetRandomPosition();
+				const CU::Vector3<float> extent(TestUtility::GetRandomFloat(0.0f, 3.0f), TestUtility::GetRandomFloat(0.0f, 3.0f), TestUtility::GetRandomFloat(0.0f, 3.0f));
+				const CU::Sphere<float> sphere(center, TestUtility::GetRandomFloat(0.0f, 4.0f));
+				const CU::AABB3D<float> aabb(center - extent, center + extent);
+				const CU::Plane<float> plane(GetRandomPosition(), GetRandomPosition());
+
+				CU::IntersectionSphereSphere(sphere, volumes.mySphereArrays, BatchCount, mask.data());
+				for (int i = 0; i < BatchCount; ++i)
+				{
+					Assert::AreEqual(CU::IntersectionSphereSphere(sphere, volumes.mySpheres[i]), IsBitSet(mask, i), L"Sphere-sphere batch differs!");
+				}
+
+				CU::IntersectionAABBAABB(aabb, volumes.myAABBArrays, BatchCount, mask.data());
+				for (int i = 0; i < BatchCount; ++i)
+				{
+					Assert::AreEqual(CU::IntersectionAABBAABB(aabb, volumes.myAABBs[i]), IsBitSet(mask, i), L"AABB-AABB batch differs!");
+				}
+
+				CU::IntersectionSphereAABB(sphere, volumes.myAABBArrays, BatchCount, mask.data());
+				for (int i = 0; i < BatchCount; ++i)
+				{
+					Assert::AreEqual(CU::IntersectionSphereAABB(sphere, volumes.myAABBs[i]), IsBitSet(mask, i), L"Sphere-AABB batch differs!");
+				}
+
+				CU::IntersectionAABBSphere(aabb, volumes.mySphereArrays, BatchCount, mask.data());
+				for (int i = 0; i < BatchCount; ++i)
+				{
+					Assert::AreEqual(CU::IntersectionAABBSphere(aabb, volumes.mySpheres[i]), IsBitSet(mask, i), L"AABB-sphere batch differs!");
+				}
+
+				CU::IntersectionSpherePlane(plane, volumes.mySphereArrays, BatchCount, mask.data());
+				for (int i = 0; i < BatchCount; ++i)
+				{
+					Assert::AreEqual(CU::IntersectionSpherePlane(volumes.mySpheres[i], plane), IsBitSet(mask, i), L"Sphere-plane batch differs!");
+				}
+
+				Assert::IsTrue((mask.back() >> (BatchCount % 32)) == 0, L"Bits set past the last element!");
+			}
+		}
+	};
+
+	TEST_CLASS(SphereRayTests)
+	{
+	public:
+		TEST_METHOD(Scalar_EntryExitNormal)
+		{
+			CU::Ray<float> ray;
+			ray.InitWithOriginAndPoint(CU::Vector3<float>(0.0f, 0.0f, 0.0f), CU::Vector3<float>(0.0f, 0.0f, 10.0f));
+
+			float tEnter;
+			float tExit;
+			CU::Vector3<float> normal;
+			Assert::IsTrue(CU::IntersectionSphereRay(CU::Sphere<float>(CU::Vector3<float>(0.0f, 0.0f, 5.0f), 1.0f), ray, tEnter, tExit, normal), L"Ray misses the sphere in front!");
+			Assert::AreEqual(4.0f, tEnter, L"Wrong entry distance!");
+			Assert::AreEqual(6.0f, tExit, L"Wrong exit distance!");
+			Assert::AreEqual(-1.0f, normal.z, L"Wrong normal at the entry!");
+
+			Assert::IsTrue(CU::IntersectionSphereRay(CU::Sphere<float>(CU::Vector3<float>(0.0f, 0.0f, 0.0f), 2.0f), ray, tEnter, tExit, normal), L"Ray from inside misses the sphere!");
+			Assert::AreEqual(-2.0f, tEnter, L"Wrong entry distance from inside!");
+			Assert::AreEqual(1.0f, normal.z, L"Wrong normal at the exit!");
+
+			Assert::IsFalse(CU::IntersectionSphereRay(CU::Sphere<float>(CU::Vector3<float>(0.0f, 0.0f, -5.0f), 1.0f), ray), L"Ray hits the sphere behind it!");
+			Assert::IsFalse(CU::IntersectionSphereRay(CU::Sphere<float>(CU::Vector3<float>(0.0f, 3.0f, 5.0f), 1.0f), ray), L"Ray hits the sphere beside it!");
+		}
+
+		TEST_METHOD(Batch_ClosestHit)
+		{
+			Volumes volumes;
+
+			for (int query = 0; query < 100; ++query)
+			{
+				CU::Ray<float> ray;
+				ray.InitWithOriginAndPoint(GetRandomPosition(), GetRandomPosition());
+
+				int expectedIndex = -1;
+				float expectedDistance = FLT_MAX;
+				for (int i = 0; i < BatchCount; ++i)
+				{
+					float tEnter;
+					float tExit;
+					if (CU::IntersectionSphereRay(volumes.mySpheres[i], ray, tEnter, tExit))
+					{
+						const float distance = tEnter >= 0.0f ? tEnter : tExit;
+						if (distance < expectedDistance)
+						{
+							expectedIndex = i;
+							expectedDistance = distance;
+						}
+					}
+				}
+
+				int index = -1;
+				float distance = FLT_MAX;
+				CU::Vector3<float> normal;
+				const bool hit = CU::IntersectionSphereRay(volumes.mySphereArrays, BatchCount, ray, index, distance, normal);
+				Assert::AreEqual(expectedIndex >= 0, hit, L"Batch hit differs!");
+				if (hit)
+				{
+					Assert::IsTrue(index == expectedIndex || std::abs(distance - expectedDistance) < 0.001f, L"Batch found another closest sphere!");
+					Assert::IsTrue(std::abs(normal.LengthSqr() - 1.0f) < 0.001f, L"Batch normal is not normalized!");
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <climits>
+#include <cstdio>
+#include <vector>
+#include "..\CommonUtilities\Serialization.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SerializationTests
+{
+	const char* const ArchivePath = "SerializationTests.bin";
+
+	void AddBytes(std::vector<unsigned char>& someBytes, std::initializer_list<unsigned char> aList)
+	{
+		someBytes.insert(someBytes.end(), aList.begin(), aList.end());
+	}
+
+	// The archive header in this machine's byte order, which the tests expect to be little endian.
+	std::vector<unsigned char> MakeHeader()
+	{
+		std::vector<unsigned char> bytes;
+		AddBytes(bytes, { 'C', 'U', 'A', 'R', 1, 0, 2, 1, 0, 0, 0, 0 });
+		return bytes;
+	}
+
+	void AddCount(std::vector<unsigned char>& someBytes, uint64_t aCount)
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			someBytes.push_back(static_cast<unsigned char>(aCount >> (8 * i)));
+		}
+	}
+
+	TEST_CLASS(SerializationTests)
+	{
+	public:
+		TEST_METHOD(RoundTrip)
+		{
+			CU::GrowingArray<CU::Vector3<float>> positions;
+			for (int i = 0; i < 100; ++i)
+			{
+				positions.Add(CU::Vector3<float>(static_cast<float>(i), 0.5f * i, -1.0f * i));
+			}
+			CU::HashMap<int, double> weights(16);
+			weights.Insert(3, 1.5);
+			weights.Insert(9, -2.25);
+			CU::Matrix4x4<float> transform;
+			transform(2, 3) = 9.0f;
+			cu::Map<int, int> names;
+			names.SetValue(1, 2);
+			names.SetValue(4, 5);
+
+			// A small chunk size so the writer flushes several times.
+			CU::ArchiveWriter writer(64);
+			Assert::IsTrue(writer.Open(ArchivePath, 7));
+			CU::Write(writer, 42);
+			CU::Write(writer, positions);
+			CU::Write(writer, weights);
+			CU::Write(writer, transform);
+			cu::Write(writer, names);
+			Assert::IsTrue(writer.IsValid());
+			Assert::IsTrue(writer.Close());
+
+			CU::MappedFile file;
+			Assert::IsTrue(file.Open(ArchivePath));
+			CU::ArchiveReader reader(file.GetData(), file.GetSize());
+			Assert::IsTrue(reader.IsValid());
+			Assert::IsFalse(reader.IsSwapped());
+			Assert::AreEqual(7u, reader.GetVersion());
+
+			int number = 0;
+			CU::GrowingArray<CU::Vector3<float>> readPositions;
+			CU::HashMap<int, double> readWeights(16);
+			CU::Matrix4x4<float> readTransform;
+			cu::Map<int, int> readNames;
+			CU::Read(reader, number);
+			CU::Read(reader, readPositions);
+			CU::Read(reader, readWeights);
+			CU::Read(reader, readTransform);
+			cu::Read(reader, readNames);
+			Assert::IsTrue(reader.IsValid());
+			Assert::AreEqual(static_cast<size_t>(0), reader.GetRemaining(), L"The archive has bytes that were never read.");
+
+			Assert::AreEqual(42, number);
+			Assert::AreEqual(100, readPositions.Size());
+			for (int i = 0; i < 100; ++i)
+			{
+				Assert::IsTrue(readPositions[i].x == positions[i].x && readPositions[i].y == positions[i].y && readPositions[i].z == positions[i].z);
+			}
+			Assert::IsTrue(readWeights.Get(3) != nullptr && *readWeights.Get(3) == 1.5);
+			Assert::IsTrue(readWeights.Get(9) != nullptr && *readWeights.Get(9) == -2.25);
+			Assert::IsTrue(readTransform == transform);
+			Assert::AreEqual(static_cast<size_t>(2), readNames.Size());
+			Assert::AreEqual(5, readNames[4]);
+
+			file.Close();
+			std::remove(ArchivePath);
+		}
+
+		TEST_METHOD(ByteSwap)
+		{
+			// Written on a big endian machine: version 7, a Vector3 (1, 2, -0.5) and a uint32_t.
+			std::vector<unsigned char> bytes;
+			AddBytes(bytes, { 'C', 'U', 'A', 'R', 0, 1, 1, 2, 0, 0, 0, 7 });
+			AddBytes(bytes, { 0x3F, 0x80, 0, 0, 0x40, 0, 0, 0, 0xBF, 0, 0, 0 });
+			AddBytes(bytes, { 0x11, 0x22, 0x33, 0x44 });
+
+			CU::ArchiveReader reader(bytes.data(), bytes.size());
+			Assert::IsTrue(reader.IsValid());
+			Assert::IsTrue(reader.IsSwapped());
+			Assert::AreEqual(7u, reader.GetVersion());
+
+			CU::Vector3<float> position;
+			uint32_t value = 0;
+			CU::Read(reader, position);
+			CU::Read(reader, value);
+			Assert::IsTrue(reader.IsValid());
+			Assert::IsTrue(position.x == 1.0f && position.y == 2.0f && position.z == -0.5f);
+			Assert::AreEqual(0x11223344u, value);
+		}
+
+		TEST_METHOD(Truncated)
+		{
+			std::vector<unsigned char> bytes = MakeHeader();
+			AddCount(bytes, 4);
+			AddBytes(bytes, { 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0 });
+
+			CU::GrowingArray<int> numbers;
+			CU::ArchiveReader whole(bytes.data(), bytes.size());
+			CU::Read(whole, numbers);
+			Assert::IsTrue(whole.IsValid());
+			Assert::AreEqual(4, numbers.Size());
+
+			// Cut off anywhere, the reader fails instead of reading past the end.
+			for (size_t size = 0; size < bytes.size(); ++size)
+			{
+				CU::GrowingArray<int> partial;
+				CU::ArchiveReader reader(bytes.data(), size);
+				CU::Read(reader, partial);
+				Assert::IsFalse(reader.IsValid(), L"A truncated archive was read as valid.");
+			}
+
+			// Reads after a failure give zeroes.
+			CU::ArchiveReader reader(bytes.data(), 6);
+			Assert::AreEqual(0, reader.ReadValue<int>());
+		}
+
+		TEST_METHOD(CountLargerThanData)
+		{
+			std::vector<unsigned char> bytes = MakeHeader();
+			AddCount(bytes, 1ull << 40);
+			AddBytes(bytes, { 1, 0, 0, 0 });
+
+			CU::GrowingArray<int> numbers;
+			CU::ArchiveReader reader(bytes.data(), bytes.size());
+			CU::Read(reader, numbers);
+			Assert::IsFalse(reader.IsValid(), L"A count larger than the archive was accepted.");
+			Assert::AreEqual(0, numbers.Size());
+		}
+
+		TEST_METHOD(CountLargerThanIntMax)
+		{
+			std::vector<unsigned char> bytes = MakeHeader();
+			// GrowingArray reserves one element more than its size, so INT_MAX itself does not fit either.
+			AddCount(bytes, static_cast<uint64_t>(INT_MAX));
+
+			// The reader is told there is enough data behind the count, it has to fail on the count alone
+			// before reading any element.
+			CU::GrowingArray<char> characters;
+			CU::ArchiveReader reader(bytes.data(), bytes.size() + static_cast<size_t>(INT_MAX) + 1);
+			CU::Read(reader, characters);
+			Assert::IsFalse(reader.IsValid(), L"A count GrowingArray can not hold was accepted.");
+			Assert::AreEqual(0, characters.Size());
+		}
+	};
+}
@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include <memory>
+#include <vector>
+#include "..\CommonUtilities\TimerWheel.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TimerWheelTests
+{
+	typedef CU::TimerWheel<uint64_t> Wheel;
+
+	// Delays just below, at and above the block size of every wheel.
+	const uint64_t BoundaryDelays[] = { 1, 2, 255, 256, 257, 511, 512, 65535, 65536, 65537, 70000, 16777215, 16777216, 16777217, 16777216 + 300 };
+
+	// Schedules a timer at every boundary delay with its due tick as payload, then advances past all of them and
+	// checks every timer fired once, at its due tick and in order.
+	void CheckBoundaries(Wheel& aWheel)
+	{
+		const uint64_t start = aWheel.GetCurrentTick();
+		for (const uint64_t delay : BoundaryDelays)
+		{
+			aWheel.Schedule(delay, start + delay);
+		}
+
+		std::vector<uint64_t> fired;
+		aWheel.Advance(16777216 + 301, [&](Wheel::Handle, uint64_t& aDueTick)
+		{
+			Assert::AreEqual(aDueTick, aWheel.GetCurrentTick(), L"A timer fired at the wrong tick.");
+			fired.push_back(aDueTick);
+		});
+
+		Assert::AreEqual(sizeof(BoundaryDelays) / sizeof(BoundaryDelays[0]), fired.size());
+		for (size_t i = 1; i < fired.size(); ++i)
+		{
+			Assert::IsTrue(fired[i - 1] <= fired[i], L"Timers fired out of order.");
+		}
+		Assert::AreEqual(0, aWheel.GetPendingCount());
+	}
+
+	TEST_CLASS(TimerWheelTests)
+	{
+	public:
+		TEST_METHOD(FiresAcrossWheelBoundaries)
+		{
+			Wheel wheel;
+			CheckBoundaries(wheel);
+		}
+
+		TEST_METHOD(FiresAcrossWheelBoundariesFromUnalignedTick)
+		{
+			// Cascades depend on where the current tick is within each wheel's block.
+			Wheel wheel;
+			wheel.Advance(65536 + 300 + 7, [](Wheel::Handle, uint64_t&) {});
+			CheckBoundaries(wheel);
+		}
+
+		TEST_METHOD(FarTimerWaitsInOverflow)
+		{
+			Wheel wheel;
+			const Wheel::Handle handle = wheel.Schedule(1ull << 33, 0);
+			int firedCount = 0;
+			wheel.Advance(1 << 20, [&](Wheel::Handle, uint64_t&) { ++firedCount; });
+			Assert::AreEqual(0, firedCount);
+			Assert::IsTrue(wheel.IsPending(handle));
+			Assert::IsTrue(wheel.Cancel(handle));
+			Assert::AreEqual(0, wheel.GetPendingCount());
+		}
+
+		TEST_METHOD(StaleHandles)
+		{
+			Wheel wheel;
+			Assert::IsFalse(wheel.Cancel(Wheel::InvalidHandle));
+
+			const Wheel::Handle first = wheel.Schedule(10, 1);
+			Assert::IsTrue(wheel.Cancel(first));
+			Assert::IsFalse(wheel.Cancel(first), L"A timer was cancelled twice.");
+			Assert::IsFalse(wheel.IsPending(first));
+
+			// The freed entry is reused, the old handle must not reach the new timer.
+			const Wheel::Handle second = wheel.Schedule(10, 2);
+			Assert::IsTrue(second != first);
+			Assert::IsFalse(wheel.Cancel(first), L"A stale handle cancelled the timer that reused its entry.");
+			Assert::IsFalse(wheel.Reschedule(first, 5), L"A stale handle rescheduled the timer that reused its entry.");
+			Assert::IsTrue(wheel.IsPending(second));
+
+			uint64_t firedPayload = 0;
+			wheel.Advance(10, [&](Wheel::Handle aHandle, uint64_t& aPayload)
+			{
+				Assert::IsTrue(aHandle == second);
+				firedPayload = aPayload;
+			});
+			Assert::AreEqual(static_cast<uint64_t>(2), firedPayload);
+			Assert::IsFalse(wheel.IsPending(second));
+			Assert::IsFalse(wheel.Cancel(second), L"A fired timer was cancelled.");
+		}
+
+		TEST_METHOD(Reschedule)
+		{
+			Wheel wheel;
+			const Wheel::Handle handle = wheel.Schedule(300, 0);
+			wheel.Advance(100, [](Wheel::Handle, uint64_t&) {});
+			Assert::IsTrue(wheel.Reschedule(handle, 50));
+
+			uint64_t firedAt = 0;
+			wheel.Advance(1000, [&](Wheel::Handle, uint64_t&) { firedAt = wheel.GetCurrentTick(); });
+			Assert::AreEqual(static_cast<uint64_t>(150), firedAt);
+		}
+
+		TEST_METHOD(RearmFromCallback)
+		{
+			Wheel wheel;
+			std::vector<uint64_t> ticks;
+			Wheel::Handle victim = wheel.Schedule(3, 100);
+			wheel.Schedule(3, 0);
+
+			// Each firing schedules the next one tick later, and the first one cancels the other timer of its tick.
+			wheel.Advance(20, [&](Wheel::Handle, uint64_t& aCount)
+			{
+				Assert::IsTrue(aCount < 100, L"A timer cancelled by another of its tick fired.");
+				ticks.push_back(wheel.GetCurrentTick());
+				wheel.Cancel(victim);
+				if (aCount < 4)
+				{
+					wheel.Schedule(1, aCount + 1);
+				}
+			});
+
+			Assert::AreEqual(static_cast<size_t>(5), ticks.size());
+			for (size_t i = 0; i < ticks.size(); ++i)
+			{
+				Assert::AreEqual(static_cast<uint64_t>(3 + i), ticks[i]);
+			}
+			Assert::AreEqual(0, wheel.GetPendingCount());
+		}
+
+		TEST_METHOD(PayloadReleased)
+		{
+			CU::TimerWheel<std::shared_ptr<int>> wheel;
+			std::shared_ptr<int> resource = std::make_shared<int>(1);
+
+			const CU::TimerWheel<std::shared_ptr<int>>::Handle cancelled = wheel.Schedule(5, resource);
+			wheel.Schedule(2, resource);
+			Assert::IsTrue(wheel.Cancel(cancelled));
+			Assert::AreEqual(2l, resource.use_count(), L"A cancelled timer kept its payload.");
+
+			wheel.Advance(3, [](CU::TimerWheel<std::shared_ptr<int>>::Handle, std::shared_ptr<int>&) {});
+			Assert::AreEqual(1l, resource.use_count(), L"A fired timer kept its payload.");
+		}
+	};
+}
@@ -7,12 +7,16 @@
 #include <stdio.h>
 #include "guicon.h"
 #include <Input.h>
+#include <Win32InputBackend.h>
 #include "Resource.h"
 
 #define MAX_LOADSTRING 100
 
 #define ConsoleOutput(x) _RPT0(_CRT_WARN, x);
 
+// Input is updated at most this often.
+const ULONGLONG FrameMilliseconds = 16;
+
 // Global Variables:
 HINSTANCE hInst;                                // current instance
 WCHAR szTitle[MAX_LOADSTRING];                  // The title bar text
@@ -24,7 +28,8 @@ BOOL                InitInstance(HINSTANCE, int);
 LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK    About(HWND, UINT, WPARAM, LPARAM);
 
-CU::Input myInput = CU::Input();
+CU::Input myInput;
+CU::Win32InputBackend myInputBackend(myInput);
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
@@ -48,7 +53,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_WINDOWSAPP));
 
-    MSG msg;
+    MSG msg = {};
 
     RedirectIOToConsole();
 
@@ -56,16 +61,42 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
     _CrtSetReportFile(_CRT_WARN, _CRTDBG_FILE_STDERR);
 
-    // Main message loop:
+    // Main loop: messages are handled as they arrive, one input snapshot is built per frame. In between the
+    // thread sleeps until a message arrives or the next frame is due.
     bool running = true;
-    while (GetMessage(&msg, nullptr, 0, 0))
+    ULONGLONG nextFrame = GetTickCount64();
+    while (running)
     {
-        if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+        {
+            if (msg.message == WM_QUIT)
+            {
+                running = false;
+                break;
+            }
+
+            if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+        }
+
+        if (!running)
         {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
+            break;
         }
 
+        const ULONGLONG now = GetTickCount64();
+        if (now < nextFrame)
+        {
+            MsgWaitForMultipleObjects(0, nullptr, FALSE, static_cast<DWORD>(nextFrame - now), QS_ALLINPUT);
+            continue;
+        }
+        nextFrame = now + FrameMilliseconds;
+
+        myInput.Update();
+
         if (myInput.IsKeyDown('S'))
         {
             ConsoleOutput("S Down\n");
@@ -153,7 +184,7 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 //
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
-    if (myInput.UpdateEvents(message, wParam, lParam))
+    if (myInputBackend.HandleMessage(message, wParam, lParam))
     {
         return 0;
     }
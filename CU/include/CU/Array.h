@@ -3,6 +3,7 @@
 
 #include <initializer_list>
 #include <stdexcept>
+#include <type_traits>
 
 namespace cu
 {
@@ -10,10 +11,15 @@ namespace cu
 	class Array
 	{
 	private:
-		T* elements;
+		// Arithmetic arrays filling whole 16 byte blocks are aligned for SIMD loads, others keep the alignment
+		// of T so nested arrays (matrix rows) stay contiguous.
+		static constexpr size_t alignment{ (std::is_arithmetic<T>::value && size > 0 && (sizeof(T) * size) % 16 == 0 && alignof(T) < 16) ? 16 : alignof(T) };
+
+		// Stored inline, an empty array still holds one element since C++ has no zero-length arrays.
+		alignas(alignment) T elements[size > 0 ? size : 1];
 
 		// Validates index to prevent out of range access.
-		inline static void ValidateIndex(const size_t& index)
+		inline static constexpr void ValidateIndex(const size_t& index)
 		{
 			if (index >= size)
 			{
@@ -23,28 +29,19 @@ namespace cu
 
 	public:
 		#pragma region Constructors
-		Array() :
-			elements{ new T[size]{} }
+		constexpr Array() :
+			elements{}
 		{}
 
-		Array(const Array& array) :
-			elements{ new T[size] }
-		{
-			for (size_t i{ 0 }; i < size; ++i)
-			{
-				elements[i] = array.elements[i];
-			}
-		}
-
-		Array(const std::initializer_list<T>& elements) :
-			elements{ new T[size] }
+		constexpr Array(const std::initializer_list<T>& elements) :
+			elements{}
 		{
 			if (elements.size() != size)
 			{
 				throw std::invalid_argument((elements.size() < size) ? "Too few elements in initializer list" : "Too many elements in initializer list");
 			}
 			size_t i{ 0 };
-			for (T element : elements)
+			for (const T& element : elements)
 			{
 				this->elements[i] = element;
 				++i;
@@ -52,13 +49,11 @@ namespace cu
 		}
 		#pragma endregion
 
-		virtual ~Array()
-		{
-			delete[] elements;
-		}
+		// Copying, assignment and destruction are left to the compiler so the array is trivially copyable
+		// whenever T is.
 
 		// Fills the array with the specified element.
-		void Fill(const T& element)
+		constexpr void Fill(const T& element)
 		{
 			for (size_t i{ 0 }; i < size; ++i)
 			{
@@ -67,7 +62,7 @@ namespace cu
 		}
 
 		// Checks if the array contains the specified element.
-		bool Contains(const T& element) const
+		constexpr bool Contains(const T& element) const
 		{
 			for (size_t i{ 0 }; i < size; ++i)
 			{
@@ -80,17 +75,32 @@ namespace cu
 		}
 
 		// Gets a pointer to the data stored in the array.
-		T* Data()
+		constexpr T* Data()
 		{
 			return elements;
 		}
 
 		// Gets a pointer to the data stored in the array.
-		const T* Data() const
+		constexpr const T* Data() const
 		{
 			return elements;
 		}
 
+		// Gets an element with the index checked at compile time instead of on every access.
+		template<size_t index>
+		constexpr T& Get()
+		{
+			static_assert(index < size, "Index is out of range.");
+			return elements[index];
+		}
+
+		template<size_t index>
+		constexpr const T& Get() const
+		{
+			static_assert(index < size, "Index is out of range.");
+			return elements[index];
+		}
+
 		#pragma region Static
 		// The size of the array.
 		inline static constexpr size_t Size()
@@ -106,19 +116,19 @@ namespace cu
 		#pragma endregion
 
 		#pragma region Operators
-		inline T& operator[](const size_t& index)
+		inline constexpr T& operator[](const size_t& index)
 		{
 			ValidateIndex(index);
 			return elements[index];
 		}
 
-		inline const T& operator[](const size_t& index) const
+		inline constexpr const T& operator[](const size_t& index) const
 		{
 			ValidateIndex(index);
 			return elements[index];
 		}
 
-		bool operator==(const Array& array) const
+		constexpr bool operator==(const Array& array) const
 		{
 			for (size_t i{ 0 }; i < size; ++i)
 			{
@@ -130,43 +140,34 @@ namespace cu
 			return true;
 		}
 
-		inline bool operator!=(const Array& array) const
+		inline constexpr bool operator!=(const Array& array) const
 		{
 			return !(*this == array);
 		}
-
-		Array& operator=(const Array& array)
-		{
-			for (size_t i{ 0 }; i < size; ++i)
-			{
-				elements[i] = array.elements[i];
-			}
-			return *this;
-		}
 		#pragma endregion
 
 		#pragma region Iterators
-		inline T* begin()
+		inline constexpr T* begin()
 		{
 			return elements;
 		}
 
-		inline const T* begin() const
+		inline constexpr const T* begin() const
 		{
 			return elements;
 		}
 
-		inline T* end()
+		inline constexpr T* end()
 		{
-			return &elements[size];
+			return elements + size;
 		}
 
-		inline const T* end() const
+		inline constexpr const T* end() const
 		{
-			return &elements[size];
+			return elements + size;
 		}
 		#pragma endregion
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,606 @@
+#ifndef CU_DECOMPOSITION_H
+#define CU_DECOMPOSITION_H
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "DynamicMatrix.h"
+#include "Gemm.h"
+
+namespace cu
+{
+	// Factorizations of a DynamicMatrix for solving linear systems. A factorization is computed once in the
+	// constructor and reused by every solve, right-hand sides are the columns of a matrix and are solved in
+	// place. The factorizations are blocked: a narrow panel is factorized element by element and the rest of
+	// the matrix is updated with one matrix product per panel, so most of the work runs in cu::Gemm.
+	namespace detail
+	{
+		// Columns per panel of the blocked factorizations.
+		constexpr size_t decompositionBlock{ 32 };
+
+		inline void ValidateSquare(const size_t& rows, const size_t& columns)
+		{
+			if (rows != columns)
+			{
+				throw std::invalid_argument{ "Matrix must be square." };
+			}
+		}
+
+		// Copies a rows x columns block, optionally negated or transposed, into a packed matrix for Gemm.
+		template<typename T>
+		inline void CopyBlock(const T* source, const size_t& stride, const size_t& rows, const size_t& columns, const bool& negate, const bool& transpose, T* destination)
+		{
+			for (size_t i{ 0 }; i < rows; ++i)
+			{
+				for (size_t j{ 0 }; j < columns; ++j)
+				{
+					const T value{ negate ? -source[i * stride + j] : source[i * stride + j] };
+					destination[transpose ? j * rows + i : i * columns + j] = value;
+				}
+			}
+		}
+
+		// row(target) -= factor * row(source) over the right-hand sides.
+		template<typename T>
+		inline void SubtractRow(T* target, const T* source, const T& factor, const size_t& count)
+		{
+			for (size_t j{ 0 }; j < count; ++j)
+			{
+				target[j] -= factor * source[j];
+			}
+		}
+
+		template<typename T>
+		inline void ScaleRow(T* target, const T& factor, const size_t& count)
+		{
+			for (size_t j{ 0 }; j < count; ++j)
+			{
+				target[j] *= factor;
+			}
+		}
+	}
+
+	// PA = LU with partial pivoting, for square systems. A pivot no larger than size * epsilon times the largest
+	// element of its column in the matrix counts as zero, since rounding rarely leaves exact zeros in a
+	// singular matrix. Nearly singular matrices above that still factorize, check the residual of the
+	// solution when that matters.
+	template<typename T = MatrixDefaultType>
+	class LUDecomposition
+	{
+	private:
+		// L below the diagonal (its diagonal is 1) and U on and above it.
+		DynamicMatrix<T> factors;
+		// Row swapped with row i at step i.
+		std::vector<size_t> pivots;
+		bool singular;
+
+	public:
+		LUDecomposition(const DynamicMatrix<T>& matrix) :
+			factors{ matrix },
+			pivots(matrix.Rows(), 0),
+			singular{ false }
+		{
+			detail::ValidateSquare(matrix.Rows(), matrix.Columns());
+			const size_t size{ matrix.Rows() };
+			T* a{ factors.Data() };
+			std::vector<T> left;
+
+			// Relative to the column so scaling a column scales its tolerance along with its pivot.
+			std::vector<T> tolerances(size, T{});
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				for (size_t j{ 0 }; j < size; ++j)
+				{
+					tolerances[j] = std::abs(a[i * size + j]) > tolerances[j] ? std::abs(a[i * size + j]) : tolerances[j];
+				}
+			}
+			for (T& tolerance : tolerances)
+			{
+				tolerance *= static_cast<T>(size) * std::numeric_limits<T>::epsilon();
+			}
+
+			for (size_t block{ 0 }; block < size; block += detail::decompositionBlock)
+			{
+				const size_t width{ size - block < detail::decompositionBlock ? size - block : detail::decompositionBlock };
+				const size_t end{ block + width };
+
+				// Factorizes the panel of columns block to end.
+				for (size_t k{ block }; k < end; ++k)
+				{
+					size_t pivot{ k };
+					for (size_t i{ k + 1 }; i < size; ++i)
+					{
+						pivot = std::abs(a[i * size + k]) > std::abs(a[pivot * size + k]) ? i : pivot;
+					}
+					pivots[k] = pivot;
+					if (pivot != k)
+					{
+						for (size_t j{ 0 }; j < size; ++j)
+						{
+							std::swap(a[k * size + j], a[pivot * size + j]);
+						}
+					}
+					if (!(std::abs(a[k * size + k]) > tolerances[k]))
+					{
+						singular = true;
+						continue;
+					}
+
+					const T inverse{ T{ 1 } / a[k * size + k] };
+					for (size_t i{ k + 1 }; i < size; ++i)
+					{
+						a[i * size + k] *= inverse;
+						detail::SubtractRow(a + i * size + k + 1, a + k * size + k + 1, a[i * size + k], end - k - 1);
+					}
+				}
+
+				if (end == size)
+				{
+					break;
+				}
+
+				// U12 = L11^-1 A12.
+				for (size_t k{ block }; k < end; ++k)
+				{
+					for (size_t i{ k + 1 }; i < end; ++i)
+					{
+						detail::SubtractRow(a + i * size + end, a + k * size + end, a[i * size + k], size - end);
+					}
+				}
+
+				// A22 -= L21 U12.
+				const size_t rest{ size - end };
+				left.resize(rest * width);
+				detail::CopyBlock(a + end * size + block, size, rest, width, true, false, left.data());
+				GemmAdd(left.data(), a + block * size + end, a + end * size + end, rest, width, rest, 1, width, size, size);
+			}
+		}
+
+		bool IsSingular() const
+		{
+			return singular;
+		}
+
+		T Determinant() const
+		{
+			T determinant{ 1 };
+			for (size_t i{ 0 }; i < factors.Rows(); ++i)
+			{
+				determinant *= pivots[i] != i ? -factors.Coefficient(i, i) : factors.Coefficient(i, i);
+			}
+			return determinant;
+		}
+
+		const DynamicMatrix<T>& GetFactors() const
+		{
+			return factors;
+		}
+
+		// Replaces the columns of rightHandSides (one per system) with the solutions.
+		void SolveInPlace(DynamicMatrix<T>& rightHandSides) const
+		{
+			if (rightHandSides.Rows() != factors.Rows())
+			{
+				throw std::invalid_argument{ "Matrix sizes do not match." };
+			}
+			Solve(rightHandSides.Data(), rightHandSides.Columns());
+		}
+
+		// Replaces a vector of Rows() elements with the solution.
+		void SolveInPlace(T* vector) const
+		{
+			Solve(vector, 1);
+		}
+
+		DynamicMatrix<T> Solve(const DynamicMatrix<T>& rightHandSides) const
+		{
+			DynamicMatrix<T> solutions{ rightHandSides };
+			SolveInPlace(solutions);
+			return solutions;
+		}
+
+	private:
+		void Solve(T* b, const size_t& count) const
+		{
+			if (singular)
+			{
+				throw std::domain_error{ "Matrix is singular." };
+			}
+
+			const size_t size{ factors.Rows() };
+			const T* a{ factors.Data() };
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				if (pivots[i] != i)
+				{
+					for (size_t j{ 0 }; j < count; ++j)
+					{
+						std::swap(b[i * count + j], b[pivots[i] * count + j]);
+					}
+				}
+			}
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				for (size_t k{ 0 }; k < i; ++k)
+				{
+					detail::SubtractRow(b + i * count, b + k * count, a[i * size + k], count);
+				}
+			}
+			for (size_t i{ size }; i-- > 0;)
+			{
+				for (size_t k{ i + 1 }; k < size; ++k)
+				{
+					detail::SubtractRow(b + i * count, b + k * count, a[i * size + k], count);
+				}
+				detail::ScaleRow(b + i * count, T{ 1 } / a[i * size + i], count);
+			}
+		}
+	};
+
+	// A = L L^T for symmetric positive definite matrices, about twice as fast as LU. Only the lower triangle
+	// of the matrix is read.
+	template<typename T = MatrixDefaultType>
+	class CholeskyDecomposition
+	{
+	private:
+		// L on and below the diagonal.
+		DynamicMatrix<T> factor;
+
+	public:
+		// Throws std::domain_error when the matrix is not positive definite.
+		CholeskyDecomposition(const DynamicMatrix<T>& matrix) :
+			factor{ matrix }
+		{
+			detail::ValidateSquare(matrix.Rows(), matrix.Columns());
+			const size_t size{ matrix.Rows() };
+			T* a{ factor.Data() };
+			std::vector<T> left;
+			std::vector<T> right;
+
+			for (size_t block{ 0 }; block < size; block += detail::decompositionBlock)
+			{
+				const size_t width{ size - block < detail::decompositionBlock ? size - block : detail::decompositionBlock };
+				const size_t end{ block + width };
+
+				// L11 and L21 from the panel, the columns left of it are already subtracted.
+				for (size_t j{ block }; j < end; ++j)
+				{
+					T diagonal{ a[j * size + j] };
+					for (size_t p{ block }; p < j; ++p)
+					{
+						diagonal -= a[j * size + p] * a[j * size + p];
+					}
+					if (!(diagonal > T{}))
+					{
+						throw std::domain_error{ "Matrix is not positive definite." };
+					}
+					a[j * size + j] = std::sqrt(diagonal);
+
+					const T inverse{ T{ 1 } / a[j * size + j] };
+					for (size_t i{ j + 1 }; i < size; ++i)
+					{
+						T value{ a[i * size + j] };
+						for (size_t p{ block }; p < j; ++p)
+						{
+							value -= a[i * size + p] * a[j * size + p];
+						}
+						a[i * size + j] = value * inverse;
+					}
+				}
+
+				if (end == size)
+				{
+					break;
+				}
+
+				// A22 -= L21 L21^T.
+				const size_t rest{ size - end };
+				left.resize(rest * width);
+				right.resize(width * rest);
+				detail::CopyBlock(a + end * size + block, size, rest, width, true, false, left.data());
+				detail::CopyBlock(a + end * size + block, size, rest, width, false, true, right.data());
+				GemmAdd(left.data(), right.data(), a + end * size + end, rest, width, rest, 1, width, rest, size);
+			}
+
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				for (size_t j{ i + 1 }; j < size; ++j)
+				{
+					a[i * size + j] = T{};
+				}
+			}
+		}
+
+		const DynamicMatrix<T>& GetFactor() const
+		{
+			return factor;
+		}
+
+		// Replaces the columns of rightHandSides (one per system) with the solutions.
+		void SolveInPlace(DynamicMatrix<T>& rightHandSides) const
+		{
+			if (rightHandSides.Rows() != factor.Rows())
+			{
+				throw std::invalid_argument{ "Matrix sizes do not match." };
+			}
+			Solve(rightHandSides.Data(), rightHandSides.Columns());
+		}
+
+		// Replaces a vector of Rows() elements with the solution.
+		void SolveInPlace(T* vector) const
+		{
+			Solve(vector, 1);
+		}
+
+		DynamicMatrix<T> Solve(const DynamicMatrix<T>& rightHandSides) const
+		{
+			DynamicMatrix<T> solutions{ rightHandSides };
+			SolveInPlace(solutions);
+			return solutions;
+		}
+
+	private:
+		void Solve(T* b, const size_t& count) const
+		{
+			const size_t size{ factor.Rows() };
+			const T* a{ factor.Data() };
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				for (size_t k{ 0 }; k < i; ++k)
+				{
+					detail::SubtractRow(b + i * count, b + k * count, a[i * size + k], count);
+				}
+				detail::ScaleRow(b + i * count, T{ 1 } / a[i * size + i], count);
+			}
+			for (size_t i{ size }; i-- > 0;)
+			{
+				detail::ScaleRow(b + i * count, T{ 1 } / a[i * size + i], count);
+				for (size_t k{ 0 }; k < i; ++k)
+				{
+					detail::SubtractRow(b + k * count, b + i * count, a[i * size + k], count);
+				}
+			}
+		}
+	};
+
+	// A = QR with Householder reflections, for square or overdetermined (least squares) systems. Each panel's
+	// reflections are combined into I - V T V^T (compact WY) so they are applied to the rest of the matrix
+	// with matrix products.
+	template<typename T = MatrixDefaultType>
+	class QRDecomposition
+	{
+	private:
+		// R on and above the diagonal, the reflection vectors below it (their first element is 1).
+		DynamicMatrix<T> factors;
+		std::vector<T> scales;
+
+	public:
+		// Throws std::invalid_argument when the matrix has fewer rows than columns.
+		QRDecomposition(const DynamicMatrix<T>& matrix) :
+			factors{ matrix },
+			scales(matrix.Columns(), T{})
+		{
+			if (matrix.Rows() < matrix.Columns())
+			{
+				throw std::invalid_argument{ "Matrix must have at least as many rows as columns." };
+			}
+
+			const size_t rows{ matrix.Rows() };
+			const size_t columns{ matrix.Columns() };
+			T* a{ factors.Data() };
+			std::vector<T> reflections;
+			std::vector<T> transposed;
+			std::vector<T> triangle;
+			std::vector<T> products;
+
+			for (size_t block{ 0 }; block < columns; block += detail::decompositionBlock)
+			{
+				const size_t width{ columns - block < detail::decompositionBlock ? columns - block : detail::decompositionBlock };
+				const size_t end{ block + width };
+
+				for (size_t k{ block }; k < end; ++k)
+				{
+					T norm{};
+					for (size_t i{ k }; i < rows; ++i)
+					{
+						norm += a[i * columns + k] * a[i * columns + k];
+					}
+					norm = std::sqrt(norm);
+					const T first{ a[k * columns + k] };
+					if (norm == T{})
+					{
+						scales[k] = T{};
+						continue;
+					}
+
+					// Reflects the column onto -sign(first) * norm, which avoids cancellation.
+					const T diagonal{ first > T{} ? -norm : norm };
+					scales[k] = (diagonal - first) / diagonal;
+					const T inverse{ T{ 1 } / (first - diagonal) };
+					for (size_t i{ k + 1 }; i < rows; ++i)
+					{
+						a[i * columns + k] *= inverse;
+					}
+					a[k * columns + k] = diagonal;
+
+					// Applies the reflection to the rest of the panel.
+					for (size_t j{ k + 1 }; j < end; ++j)
+					{
+						T dot{ a[k * columns + j] };
+						for (size_t i{ k + 1 }; i < rows; ++i)
+						{
+							dot += a[i * columns + k] * a[i * columns + j];
+						}
+						dot *= scales[k];
+						a[k * columns + j] -= dot;
+						for (size_t i{ k + 1 }; i < rows; ++i)
+						{
+							a[i * columns + j] -= dot * a[i * columns + k];
+						}
+					}
+				}
+
+				if (end == columns)
+				{
+					break;
+				}
+
+				// V with the implicit ones and zeros written out, and V^T.
+				const size_t height{ rows - block };
+				const size_t rest{ columns - end };
+				reflections.assign(height * width, T{});
+				transposed.resize(width * height);
+				for (size_t i{ 0 }; i < height; ++i)
+				{
+					for (size_t j{ 0 }; j < width && j <= i; ++j)
+					{
+						reflections[i * width + j] = i == j ? T{ 1 } : a[(block + i) * columns + block + j];
+					}
+				}
+				detail::CopyBlock(reflections.data(), width, height, width, false, true, transposed.data());
+
+				// T is upper triangular with H1 ... Hn = I - V T V^T.
+				triangle.assign(width * width, T{});
+				for (size_t j{ 0 }; j < width; ++j)
+				{
+					for (size_t i{ 0 }; i < j; ++i)
+					{
+						T dot{};
+						for (size_t p{ j }; p < height; ++p)
+						{
+							dot += transposed[i * height + p] * transposed[j * height + p];
+						}
+						triangle[i * width + j] = -scales[block + j] * dot;
+					}
+					// Multiplies column j above the diagonal by the triangle computed so far.
+					for (size_t i{ 0 }; i < j; ++i)
+					{
+						T value{};
+						for (size_t p{ i }; p < j; ++p)
+						{
+							value += triangle[i * width + p] * triangle[p * width + j];
+						}
+						triangle[i * width + j] = value;
+					}
+					triangle[j * width + j] = scales[block + j];
+				}
+
+				// A2 -= V (T^T (V^T A2)).
+				T* trailing{ a + block * columns + end };
+				products.resize(width * rest);
+				Gemm(transposed.data(), trailing, products.data(), width, height, rest, 1, height, columns, rest);
+				for (size_t i{ width }; i-- > 0;)
+				{
+					// Row i of T^T W only depends on rows up to i, so it is computed in place bottom up.
+					detail::ScaleRow(products.data() + i * rest, triangle[i * width + i], rest);
+					for (size_t p{ 0 }; p < i; ++p)
+					{
+						detail::SubtractRow(products.data() + i * rest, products.data() + p * rest, -triangle[p * width + i], rest);
+					}
+				}
+				for (T& value : reflections)
+				{
+					value = -value;
+				}
+				GemmAdd(reflections.data(), products.data(), trailing, height, width, rest, 1, width, rest, columns);
+			}
+		}
+
+		// True when R has a zero on its diagonal, the least squares solution is then not unique.
+		bool IsRankDeficient() const
+		{
+			for (size_t i{ 0 }; i < factors.Columns(); ++i)
+			{
+				if (factors.Coefficient(i, i) == T{})
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		const DynamicMatrix<T>& GetFactors() const
+		{
+			return factors;
+		}
+
+		// Solves every column of rightHandSides (Rows() elements each) in the least squares sense. The
+		// solutions are left in the first Columns() rows.
+		void SolveInPlace(DynamicMatrix<T>& rightHandSides) const
+		{
+			if (rightHandSides.Rows() != factors.Rows())
+			{
+				throw std::invalid_argument{ "Matrix sizes do not match." };
+			}
+			Solve(rightHandSides.Data(), rightHandSides.Columns());
+		}
+
+		// Solves a vector of Rows() elements, the solution is left in the first Columns() elements.
+		void SolveInPlace(T* vector) const
+		{
+			Solve(vector, 1);
+		}
+
+		// Returns the Columns() x rightHandSides.Columns() solutions.
+		DynamicMatrix<T> Solve(const DynamicMatrix<T>& rightHandSides) const
+		{
+			DynamicMatrix<T> work{ rightHandSides };
+			SolveInPlace(work);
+			DynamicMatrix<T> solutions{ factors.Columns(), rightHandSides.Columns() };
+			for (size_t i{ 0 }; i < solutions.Rows() * solutions.Columns(); ++i)
+			{
+				solutions.Data()[i] = work.Data()[i];
+			}
+			return solutions;
+		}
+
+	private:
+		void Solve(T* b, const size_t& count) const
+		{
+			if (IsRankDeficient())
+			{
+				throw std::domain_error{ "Matrix is rank deficient." };
+			}
+
+			const size_t rows{ factors.Rows() };
+			const size_t columns{ factors.Columns() };
+			const T* a{ factors.Data() };
+			std::vector<T> dots(count);
+
+			// b = Q^T b, one reflection at a time.
+			for (size_t k{ 0 }; k < columns; ++k)
+			{
+				for (size_t j{ 0 }; j < count; ++j)
+				{
+					dots[j] = b[k * count + j];
+				}
+				for (size_t i{ k + 1 }; i < rows; ++i)
+				{
+					for (size_t j{ 0 }; j < count; ++j)
+					{
+						dots[j] += a[i * columns + k] * b[i * count + j];
+					}
+				}
+				detail::ScaleRow(dots.data(), scales[k], count);
+				detail::SubtractRow(b + k * count, dots.data(), T{ 1 }, count);
+				for (size_t i{ k + 1 }; i < rows; ++i)
+				{
+					detail::SubtractRow(b + i * count, dots.data(), a[i * columns + k], count);
+				}
+			}
+
+			for (size_t i{ columns }; i-- > 0;)
+			{
+				for (size_t k{ i + 1 }; k < columns; ++k)
+				{
+					detail::SubtractRow(b + i * count, b + k * count, a[i * columns + k], count);
+				}
+				detail::ScaleRow(b + i * count, T{ 1 } / a[i * columns + i], count);
+			}
+		}
+	};
+}
+
+#endif
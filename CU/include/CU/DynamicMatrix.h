@@ -0,0 +1,284 @@
+#ifndef CU_DYNAMIC_MATRIX_H
+#define CU_DYNAMIC_MATRIX_H
+
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+#include "Gemm.h"
+#include "Matrix.h"
+
+namespace cu
+{
+	namespace detail
+	{
+		// Allocates on 64 byte boundaries so rows start aligned for SIMD loads.
+		template<typename T>
+		struct AlignedAllocator
+		{
+			using value_type = T;
+			static constexpr size_t alignment{ 64 };
+
+			AlignedAllocator() = default;
+
+			template<typename U>
+			AlignedAllocator(const AlignedAllocator<U>&)
+			{}
+
+			T* allocate(const size_t& count)
+			{
+				// The distance to the start of the block is kept in the byte before the aligned memory.
+				unsigned char* memory{ static_cast<unsigned char*>(::operator new(count * sizeof(T) + alignment)) };
+				const size_t offset{ alignment - reinterpret_cast<size_t>(memory) % alignment };
+				memory[offset - 1] = static_cast<unsigned char>(offset);
+				return reinterpret_cast<T*>(memory + offset);
+			}
+
+			void deallocate(T* elements, const size_t&)
+			{
+				unsigned char* memory{ reinterpret_cast<unsigned char*>(elements) };
+				::operator delete(memory - memory[-1]);
+			}
+
+			template<typename U>
+			bool operator==(const AlignedAllocator<U>&) const
+			{
+				return true;
+			}
+
+			template<typename U>
+			bool operator!=(const AlignedAllocator<U>&) const
+			{
+				return false;
+			}
+		};
+	}
+
+	// A matrix sized at runtime, stored row by row in one aligned block. Element access and operators match
+	// cu::Matrix, operators on mismatching sizes throw std::invalid_argument.
+	template<typename T = MatrixDefaultType>
+	class DynamicMatrix
+	{
+	private:
+		size_t rows;
+		size_t columns;
+		std::vector<T, detail::AlignedAllocator<T>> elements;
+
+		// Validates index to prevent out of range access.
+		inline void ValidateRow(const size_t& row) const
+		{
+			if (row >= rows)
+			{
+				throw std::out_of_range{ "Index is out of range." };
+			}
+		}
+
+		inline void ValidateSize(const DynamicMatrix& matrix) const
+		{
+			if (rows != matrix.rows || columns != matrix.columns)
+			{
+				throw std::invalid_argument{ "Matrix sizes do not match." };
+			}
+		}
+
+	public:
+		#pragma region Constructors
+		DynamicMatrix() :
+			rows{ 0 },
+			columns{ 0 },
+			elements{}
+		{}
+
+		// Creates a rows x columns matrix of zeros.
+		DynamicMatrix(const size_t& rows, const size_t& columns) :
+			rows{ rows },
+			columns{ columns },
+			elements(rows * columns, T{})
+		{}
+
+		// Creates a matrix from elements listed row by row.
+		DynamicMatrix(const size_t& rows, const size_t& columns, const std::initializer_list<T>& elements) :
+			rows{ rows },
+			columns{ columns },
+			elements(elements)
+		{
+			if (elements.size() != rows * columns)
+			{
+				throw std::invalid_argument((elements.size() < rows * columns) ? "Too few elements in initializer list" : "Too many elements in initializer list");
+			}
+		}
+
+		template<size_t matrixRows, size_t matrixColumns>
+		DynamicMatrix(const Matrix<matrixRows, matrixColumns, T>& matrix) :
+			rows{ matrixRows },
+			columns{ matrixColumns },
+			elements(matrix.Data(), matrix.Data() + matrixRows * matrixColumns)
+		{}
+		#pragma endregion
+
+		// Creates an identity matrix of specified size.
+		static DynamicMatrix Identity(const size_t& size)
+		{
+			DynamicMatrix matrix{ size, size };
+			for (size_t i{ 0 }; i < size; ++i)
+			{
+				matrix.Coefficient(i, i) = 1;
+			}
+			return matrix;
+		}
+
+		inline size_t Rows() const
+		{
+			return rows;
+		}
+
+		inline size_t Columns() const
+		{
+			return columns;
+		}
+
+		// The elements row by row, rows are stored back to back.
+		inline T* Data()
+		{
+			return elements.data();
+		}
+
+		inline const T* Data() const
+		{
+			return elements.data();
+		}
+
+		// Unchecked element access.
+		inline T& Coefficient(const size_t& row, const size_t& column)
+		{
+			return elements[row * columns + column];
+		}
+
+		inline const T& Coefficient(const size_t& row, const size_t& column) const
+		{
+			return elements[row * columns + column];
+		}
+
+		DynamicMatrix Transposed() const
+		{
+			DynamicMatrix newMatrix{ columns, rows };
+			for (size_t i{ 0 }; i < rows; ++i)
+			{
+				for (size_t j{ 0 }; j < columns; ++j)
+				{
+					newMatrix.Coefficient(j, i) = Coefficient(i, j);
+				}
+			}
+			return newMatrix;
+		}
+
+		// Matrix product where large products are split over threadCount threads, 0 uses every hardware thread.
+		DynamicMatrix Multiply(const DynamicMatrix& matrix, const size_t& threadCount) const
+		{
+			if (columns != matrix.rows)
+			{
+				throw std::invalid_argument{ "Matrix sizes do not match." };
+			}
+			DynamicMatrix product{ rows, matrix.columns };
+			Gemm(Data(), matrix.Data(), product.Data(), rows, columns, matrix.columns, threadCount);
+			return product;
+		}
+
+		#pragma region Operators
+		// Gets a row, indexed as matrix[row][column] like cu::Matrix.
+		inline T* operator[](const size_t& row)
+		{
+			ValidateRow(row);
+			return elements.data() + row * columns;
+		}
+
+		inline const T* operator[](const size_t& row) const
+		{
+			ValidateRow(row);
+			return elements.data() + row * columns;
+		}
+
+		bool operator==(const DynamicMatrix& matrix) const
+		{
+			return rows == matrix.rows && columns == matrix.columns && elements == matrix.elements;
+		}
+
+		bool operator!=(const DynamicMatrix& matrix) const
+		{
+			return !(*this == matrix);
+		}
+
+		void operator+=(const DynamicMatrix& matrix)
+		{
+			ValidateSize(matrix);
+			for (size_t i{ 0 }; i < elements.size(); ++i)
+			{
+				elements[i] += matrix.elements[i];
+			}
+		}
+
+		inline DynamicMatrix operator+(const DynamicMatrix& matrix) const
+		{
+			DynamicMatrix newMatrix{ *this };
+			newMatrix += matrix;
+			return newMatrix;
+		}
+
+		void operator-=(const DynamicMatrix& matrix)
+		{
+			ValidateSize(matrix);
+			for (size_t i{ 0 }; i < elements.size(); ++i)
+			{
+				elements[i] -= matrix.elements[i];
+			}
+		}
+
+		inline DynamicMatrix operator-(const DynamicMatrix& matrix) const
+		{
+			DynamicMatrix newMatrix{ *this };
+			newMatrix -= matrix;
+			return newMatrix;
+		}
+
+		template<typename N>
+		void operator*=(const N& scalar)
+		{
+			for (T& element : elements)
+			{
+				element = detail::Multiply::Apply(element, scalar);
+			}
+		}
+
+		template<typename N, typename = typename std::enable_if<std::is_arithmetic<N>::value>::type>
+		inline DynamicMatrix operator*(const N& scalar) const
+		{
+			DynamicMatrix newMatrix{ *this };
+			newMatrix *= scalar;
+			return newMatrix;
+		}
+
+		template<typename N>
+		void operator/=(const N& scalar)
+		{
+			for (T& element : elements)
+			{
+				element = detail::Divide::Apply(element, scalar);
+			}
+		}
+
+		template<typename N>
+		inline DynamicMatrix operator/(const N& scalar) const
+		{
+			DynamicMatrix newMatrix{ *this };
+			newMatrix /= scalar;
+			return newMatrix;
+		}
+
+		inline DynamicMatrix operator*(const DynamicMatrix& matrix) const
+		{
+			return Multiply(matrix, 1);
+		}
+		#pragma endregion
+	};
+}
+
+#endif
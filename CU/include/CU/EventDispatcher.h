@@ -0,0 +1,407 @@
+#ifndef CU_EVENT_DISPATCHER_H
+#define CU_EVENT_DISPATCHER_H
+
+#include <tuple>
+#include <utility>
+#include "Function.h"
+#include "GrowingArray.h"
+
+namespace cu
+{
+	template<typename EventT>
+	class EventChannel;
+
+	// Identifies a listener of EventT. A default constructed handle, or one whose listener was unsubscribed,
+	// refers to nothing.
+	template<typename EventT>
+	class EventHandle
+	{
+	private:
+		friend class EventChannel<EventT>;
+
+		static constexpr unsigned int invalidSlot{ ~0u };
+
+		unsigned int slot;
+		unsigned int generation;
+
+		EventHandle(const unsigned int& slot, const unsigned int& generation) :
+			slot{ slot },
+			generation{ generation }
+		{}
+
+	public:
+		EventHandle() :
+			slot{ invalidSlot },
+			generation{ 0 }
+		{}
+
+		inline bool operator==(const EventHandle& handle) const
+		{
+			return slot == handle.slot && generation == handle.generation;
+		}
+
+		inline bool operator!=(const EventHandle& handle) const
+		{
+			return !(*this == handle);
+		}
+	};
+
+	// Broadcasts events of one type to its listeners. Listeners are stored back to back and called in a single
+	// pass, unsubscribing moves the last listener into the freed place so the call order is not kept.
+	// Listeners may subscribe, unsubscribe and dispatch from within a dispatch. Listeners added during a dispatch
+	// are first called by the next one, removed listeners are not called again.
+	template<typename EventT>
+	class EventChannel
+	{
+	public:
+		using Callback = Function<void, const EventT&>;
+
+	private:
+		struct Listener
+		{
+			Callback callback;
+			unsigned int slot;
+			bool alive;
+		};
+
+		// Where the listener of a handle is, the generation is bumped every time the slot is freed.
+		struct Slot
+		{
+			size_t index;
+			unsigned int generation;
+			bool added;
+		};
+
+		// Decrements the dispatch depth even when a listener throws.
+		class DispatchScope
+		{
+		private:
+			EventChannel& channel;
+
+		public:
+			DispatchScope(EventChannel& channel) :
+				channel{ channel }
+			{
+				++channel.dispatchDepth;
+			}
+
+			~DispatchScope()
+			{
+				if (--channel.dispatchDepth == 0)
+				{
+					channel.Settle();
+				}
+			}
+		};
+
+		// Removes the flushed events and ends the flush even when a listener throws. The events the flush did
+		// not reach are put back in front of the ones queued since, so the next Flush delivers them.
+		class FlushScope
+		{
+		private:
+			EventChannel& channel;
+			const size_t queue;
+
+		public:
+			size_t dispatched;
+
+			FlushScope(EventChannel& channel) :
+				channel{ channel },
+				queue{ channel.activeQueue },
+				dispatched{ 0 }
+			{
+				channel.flushing = true;
+				channel.activeQueue = 1 - queue;
+			}
+
+			~FlushScope()
+			{
+				GrowingArray<EventT>& flushed{ channel.queues[queue] };
+				RemoveEvents(flushed, dispatched);
+				if (!flushed.Empty())
+				{
+					GrowingArray<EventT>& queued{ channel.queues[1 - queue] };
+					for (const EventT& event : queued)
+					{
+						Append(flushed, event);
+					}
+					RemoveEvents(queued, queued.Size());
+					channel.activeQueue = queue;
+				}
+				channel.flushing = false;
+			}
+		};
+
+		// Callbacks are not trivially copyable, so every array runs in safe mode.
+		GrowingArray<Listener> listeners;
+		// Listeners subscribed during a dispatch wait here, so the array being iterated never reallocates.
+		GrowingArray<Listener> added;
+		GrowingArray<Slot> slots;
+		GrowingArray<unsigned int> freeSlots;
+		// Queued events go to queues[activeQueue], the other queue is the one being flushed.
+		GrowingArray<EventT> queues[2];
+		size_t activeQueue;
+		size_t dispatchDepth;
+		size_t deadCount;
+		bool flushing;
+
+		// GrowingArray grows by a fixed amount, doubling the growth instead keeps thousands of listeners from
+		// being copied into a new array over and over.
+		template<typename T>
+		inline static void Append(GrowingArray<T>& array, const T& element)
+		{
+			if (array.Size() == array.Capacity())
+			{
+				array.SetGrowthSize(array.Capacity());
+			}
+			array.Add(element);
+		}
+
+		// Removes the first count events. The places left behind the new size are reset, so events holding
+		// resources release them instead of waiting to be overwritten by later events.
+		static void RemoveEvents(GrowingArray<EventT>& queue, const size_t& count)
+		{
+			const size_t size{ queue.Size() };
+			queue.RemoveRange(0, count);
+			EventT* const elements{ queue.begin() };
+			for (size_t i{ queue.Size() }; i < size; ++i)
+			{
+				elements[i] = EventT{};
+			}
+		}
+
+		void FreeSlot(const unsigned int& slot)
+		{
+			++slots[slot].generation;
+			Append(freeSlots, slot);
+		}
+
+		// Moves the last listener into index, alive listeners that are moved have their slot updated.
+		void RemoveListener(GrowingArray<Listener>& array, const size_t& index)
+		{
+			const size_t last{ array.Size() - 1 };
+			if (index != last)
+			{
+				array[index] = std::move(array[last]);
+				if (array[index].alive)
+				{
+					slots[array[index].slot].index = index;
+				}
+			}
+			array[last].callback = nullptr;
+			array.RemoveAt(last);
+		}
+
+		// Applies the changes made during a dispatch once the outermost dispatch returns.
+		void Settle()
+		{
+			if (deadCount > 0)
+			{
+				size_t i{ 0 };
+				while (i < listeners.Size())
+				{
+					if (listeners[i].alive)
+					{
+						++i;
+					}
+					else
+					{
+						RemoveListener(listeners, i);
+					}
+				}
+				deadCount = 0;
+			}
+
+			for (Listener& listener : added)
+			{
+				if (listener.alive)
+				{
+					slots[listener.slot].index = listeners.Size();
+					slots[listener.slot].added = false;
+					Append(listeners, listener);
+				}
+				listener.callback = nullptr;
+			}
+			if (!added.Empty())
+			{
+				added.RemoveRange(0, added.Size());
+			}
+		}
+
+	public:
+		EventChannel(const size_t& growthSize = 64) :
+			listeners(growthSize, true),
+			added(growthSize, true),
+			slots(growthSize, true),
+			freeSlots(growthSize, true),
+			queues{ GrowingArray<EventT>(growthSize, true), GrowingArray<EventT>(growthSize, true) },
+			activeQueue{ 0 },
+			dispatchDepth{ 0 },
+			deadCount{ 0 },
+			flushing{ false }
+		{}
+
+		// Listeners usually refer to the channel, so it stays where it is.
+		EventChannel(const EventChannel& channel) = delete;
+		EventChannel& operator=(const EventChannel& channel) = delete;
+
+		// Adds a listener, lambdas and member functions bound with { &object, &Type::Method } both work.
+		EventHandle<EventT> Subscribe(const Callback& callback)
+		{
+			unsigned int slot;
+			if (freeSlots.Empty())
+			{
+				slot = static_cast<unsigned int>(slots.Size());
+				Append(slots, Slot{ 0, 0, false });
+			}
+			else
+			{
+				slot = freeSlots[freeSlots.Size() - 1];
+				freeSlots.RemoveAt(freeSlots.Size() - 1);
+			}
+
+			GrowingArray<Listener>& array{ dispatchDepth > 0 ? added : listeners };
+			slots[slot].index = array.Size();
+			slots[slot].added = dispatchDepth > 0;
+			Append(array, Listener{ callback, slot, true });
+			return EventHandle<EventT>{ slot, slots[slot].generation };
+		}
+
+		// Removes a listener in constant time, and returns whether the handle referred to one.
+		bool Unsubscribe(const EventHandle<EventT>& handle)
+		{
+			if (!IsSubscribed(handle))
+			{
+				return false;
+			}
+
+			const Slot& slot{ slots[handle.slot] };
+			if (dispatchDepth > 0)
+			{
+				// The listener may be running, so it is only marked and removed once the dispatch is done.
+				(slot.added ? added : listeners)[slot.index].alive = false;
+				++deadCount;
+			}
+			else
+			{
+				RemoveListener(listeners, slot.index);
+			}
+			FreeSlot(handle.slot);
+			return true;
+		}
+
+		inline bool IsSubscribed(const EventHandle<EventT>& handle) const
+		{
+			return handle.slot < slots.Size() && slots[handle.slot].generation == handle.generation;
+		}
+
+		// Calls every listener now.
+		void Dispatch(const EventT& event)
+		{
+			DispatchScope scope{ *this };
+			Listener* const first{ listeners.begin() };
+			const size_t count{ listeners.Size() };
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				if (first[i].alive)
+				{
+					first[i].callback(event);
+				}
+			}
+		}
+
+		// Stores a copy of event for the next Flush.
+		inline void Queue(const EventT& event)
+		{
+			Append(queues[activeQueue], event);
+		}
+
+		// Dispatches the queued events in the order they were queued. Events queued by listeners during the
+		// flush wait for the next one, flushing from within a listener does nothing. When a listener throws,
+		// the events after the one it threw on stay queued.
+		void Flush()
+		{
+			if (flushing)
+			{
+				return;
+			}
+
+			const GrowingArray<EventT>& queue{ queues[activeQueue] };
+			FlushScope scope{ *this };
+			while (scope.dispatched < queue.Size())
+			{
+				// Counted first, an event whose listener throws is not delivered again.
+				Dispatch(queue[scope.dispatched++]);
+			}
+		}
+
+		inline size_t ListenerCount() const
+		{
+			return listeners.Size() + added.Size() - deadCount;
+		}
+
+		inline size_t QueuedCount() const
+		{
+			return queues[activeQueue].Size();
+		}
+	};
+
+	// Routes each of the event types to its own channel, picked at compile time. Dispatching a type that is not
+	// listed does not compile.
+	//
+	// cu::EventDispatcher<KeyEvent, MouseEvent> events;
+	// auto handle = events.Subscribe<KeyEvent>([](const KeyEvent& event) { ... });
+	// events.Dispatch(KeyEvent{ ... });
+	template<typename... EventT>
+	class EventDispatcher
+	{
+	private:
+		std::tuple<EventChannel<EventT>...> channels;
+
+	public:
+		template<typename E>
+		inline EventChannel<E>& Channel()
+		{
+			return std::get<EventChannel<E>>(channels);
+		}
+
+		template<typename E>
+		inline const EventChannel<E>& Channel() const
+		{
+			return std::get<EventChannel<E>>(channels);
+		}
+
+		template<typename E>
+		inline EventHandle<E> Subscribe(const typename EventChannel<E>::Callback& callback)
+		{
+			return Channel<E>().Subscribe(callback);
+		}
+
+		template<typename E>
+		inline bool Unsubscribe(const EventHandle<E>& handle)
+		{
+			return Channel<E>().Unsubscribe(handle);
+		}
+
+		template<typename E>
+		inline void Dispatch(const E& event)
+		{
+			Channel<E>().Dispatch(event);
+		}
+
+		template<typename E>
+		inline void Queue(const E& event)
+		{
+			Channel<E>().Queue(event);
+		}
+
+		// Flushes every channel, in the order the event types are listed.
+		void Flush()
+		{
+			using Expand = int[];
+			(void)Expand{ 0, (Channel<EventT>().Flush(), 0)... };
+		}
+	};
+}
+
+#endif
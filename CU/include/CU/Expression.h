@@ -0,0 +1,311 @@
+#ifndef CU_EXPRESSION_H
+#define CU_EXPRESSION_H
+
+#include <cstddef>
+#include <type_traits>
+
+namespace cu
+{
+	template<size_t rows, size_t columns, typename T>
+	class Matrix;
+
+	template<typename T, size_t size>
+	class Vector;
+
+	// The element-wise matrix and vector operators return expressions instead of results. A chain like
+	// a + b * s - c is then computed in a single loop when it is assigned, with no temporaries in between.
+	// Expressions refer to their matrix and vector operands, so keep them within the statement (no auto).
+	namespace detail
+	{
+		// Element counts up to this are computed with fully unrolled code.
+		constexpr size_t maxUnrolledCount{ 16 };
+
+		#pragma region Unrolling
+		template<size_t index, size_t count>
+		struct Unrolled
+		{
+			template<typename Function>
+			inline static void Run(const Function& function)
+			{
+				function(index);
+				Unrolled<index + 1, count>::Run(function);
+			}
+		};
+
+		template<size_t count>
+		struct Unrolled<count, count>
+		{
+			template<typename Function>
+			inline static void Run(const Function&)
+			{}
+		};
+
+		template<size_t count, typename Function>
+		inline void ForEachIndex(const Function& function, std::true_type)
+		{
+			Unrolled<0, count>::Run(function);
+		}
+
+		template<size_t count, typename Function>
+		inline void ForEachIndex(const Function& function, std::false_type)
+		{
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				function(i);
+			}
+		}
+
+		// Calls function(index) for every index below count.
+		template<size_t count, typename Function>
+		inline void ForEachIndex(const Function& function)
+		{
+			ForEachIndex<count>(function, std::integral_constant<bool, (count <= maxUnrolledCount)>{});
+		}
+
+		template<size_t rows, size_t columns, typename Function>
+		inline void ForEachElement(const Function& function, std::true_type)
+		{
+			// The row and column are constants once unrolled, so the division costs nothing.
+			Unrolled<0, rows * columns>::Run([&function](const size_t& index) { function(index / columns, index % columns); });
+		}
+
+		template<size_t rows, size_t columns, typename Function>
+		inline void ForEachElement(const Function& function, std::false_type)
+		{
+			for (size_t i{ 0 }; i < rows; ++i)
+			{
+				for (size_t j{ 0 }; j < columns; ++j)
+				{
+					function(i, j);
+				}
+			}
+		}
+
+		// Calls function(row, column) for every element of a rows x columns matrix.
+		template<size_t rows, size_t columns, typename Function>
+		inline void ForEachElement(const Function& function)
+		{
+			ForEachElement<rows, columns>(function, std::integral_constant<bool, (rows * columns <= maxUnrolledCount)>{});
+		}
+		#pragma endregion
+
+		#pragma region Operations
+		struct Add
+		{
+			template<typename T>
+			inline static T Apply(const T& left, const T& right)
+			{
+				return left + right;
+			}
+		};
+
+		struct Subtract
+		{
+			template<typename T>
+			inline static T Apply(const T& left, const T& right)
+			{
+				return left - right;
+			}
+		};
+
+		struct Multiply
+		{
+			template<typename T, typename N>
+			inline static T Apply(const T& value, const N& scalar)
+			{
+				return static_cast<T>(value * scalar);
+			}
+		};
+
+		struct Divide
+		{
+			template<typename T, typename N>
+			inline static T Apply(const T& value, const N& scalar)
+			{
+				return static_cast<T>(value / scalar);
+			}
+		};
+		#pragma endregion
+
+		// Matrices and vectors are held by reference, expressions are small and held by value.
+		template<typename E>
+		struct Operand
+		{
+			using Type = const E;
+		};
+
+		template<size_t rows, size_t columns, typename T>
+		struct Operand<Matrix<rows, columns, T>>
+		{
+			using Type = const Matrix<rows, columns, T>&;
+		};
+
+		template<typename T, size_t size>
+		struct Operand<Vector<T, size>>
+		{
+			using Type = const Vector<T, size>&;
+		};
+	}
+
+	#pragma region Matrix expressions
+	template<typename E, size_t rows, size_t columns, typename T>
+	class MatrixExpression
+	{
+	public:
+		inline const E& Self() const
+		{
+			return static_cast<const E&>(*this);
+		}
+
+		// Computes the expression into a matrix.
+		inline Matrix<rows, columns, T> Evaluated() const
+		{
+			return Matrix<rows, columns, T>(*this);
+		}
+	};
+
+	template<typename Left, typename Right, typename Operation, size_t rows, size_t columns, typename T>
+	class MatrixBinaryExpression : public MatrixExpression<MatrixBinaryExpression<Left, Right, Operation, rows, columns, T>, rows, columns, T>
+	{
+	private:
+		typename detail::Operand<Left>::Type left;
+		typename detail::Operand<Right>::Type right;
+
+	public:
+		MatrixBinaryExpression(const Left& left, const Right& right) :
+			left{ left },
+			right{ right }
+		{}
+
+		inline T Coefficient(const size_t& row, const size_t& column) const
+		{
+			return Operation::Apply(left.Coefficient(row, column), right.Coefficient(row, column));
+		}
+	};
+
+	template<typename E, typename N, typename Operation, size_t rows, size_t columns, typename T>
+	class MatrixScalarExpression : public MatrixExpression<MatrixScalarExpression<E, N, Operation, rows, columns, T>, rows, columns, T>
+	{
+	private:
+		typename detail::Operand<E>::Type expression;
+		N scalar;
+
+	public:
+		MatrixScalarExpression(const E& expression, const N& scalar) :
+			expression{ expression },
+			scalar{ scalar }
+		{}
+
+		inline T Coefficient(const size_t& row, const size_t& column) const
+		{
+			return Operation::Apply(expression.Coefficient(row, column), scalar);
+		}
+	};
+
+	template<typename Left, typename Right, size_t rows, size_t columns, typename T>
+	inline MatrixBinaryExpression<Left, Right, detail::Add, rows, columns, T> operator+(const MatrixExpression<Left, rows, columns, T>& left, const MatrixExpression<Right, rows, columns, T>& right)
+	{
+		return { left.Self(), right.Self() };
+	}
+
+	template<typename Left, typename Right, size_t rows, size_t columns, typename T>
+	inline MatrixBinaryExpression<Left, Right, detail::Subtract, rows, columns, T> operator-(const MatrixExpression<Left, rows, columns, T>& left, const MatrixExpression<Right, rows, columns, T>& right)
+	{
+		return { left.Self(), right.Self() };
+	}
+
+	template<typename E, size_t rows, size_t columns, typename T, typename N, typename = typename std::enable_if<std::is_arithmetic<N>::value>::type>
+	inline MatrixScalarExpression<E, N, detail::Multiply, rows, columns, T> operator*(const MatrixExpression<E, rows, columns, T>& expression, const N& scalar)
+	{
+		return { expression.Self(), scalar };
+	}
+
+	template<typename E, size_t rows, size_t columns, typename T, typename N, typename = typename std::enable_if<std::is_arithmetic<N>::value>::type>
+	inline MatrixScalarExpression<E, N, detail::Divide, rows, columns, T> operator/(const MatrixExpression<E, rows, columns, T>& expression, const N& scalar)
+	{
+		return { expression.Self(), scalar };
+	}
+	#pragma endregion
+
+	#pragma region Vector expressions
+	template<typename E, size_t size, typename T>
+	class VectorExpression
+	{
+	public:
+		inline const E& Self() const
+		{
+			return static_cast<const E&>(*this);
+		}
+
+		// Computes the expression into a vector.
+		inline Vector<T, size> Evaluated() const
+		{
+			return Vector<T, size>(*this);
+		}
+	};
+
+	template<typename Left, typename Right, typename Operation, size_t size, typename T>
+	class VectorBinaryExpression : public VectorExpression<VectorBinaryExpression<Left, Right, Operation, size, T>, size, T>
+	{
+	private:
+		typename detail::Operand<Left>::Type left;
+		typename detail::Operand<Right>::Type right;
+
+	public:
+		VectorBinaryExpression(const Left& left, const Right& right) :
+			left{ left },
+			right{ right }
+		{}
+
+		inline T Coefficient(const size_t& index) const
+		{
+			return Operation::Apply(left.Coefficient(index), right.Coefficient(index));
+		}
+	};
+
+	template<typename E, typename N, typename Operation, size_t size, typename T>
+	class VectorScalarExpression : public VectorExpression<VectorScalarExpression<E, N, Operation, size, T>, size, T>
+	{
+	private:
+		typename detail::Operand<E>::Type expression;
+		N scalar;
+
+	public:
+		VectorScalarExpression(const E& expression, const N& scalar) :
+			expression{ expression },
+			scalar{ scalar }
+		{}
+
+		inline T Coefficient(const size_t& index) const
+		{
+			return Operation::Apply(expression.Coefficient(index), scalar);
+		}
+	};
+
+	template<typename Left, typename Right, size_t size, typename T>
+	inline VectorBinaryExpression<Left, Right, detail::Add, size, T> operator+(const VectorExpression<Left, size, T>& left, const VectorExpression<Right, size, T>& right)
+	{
+		return { left.Self(), right.Self() };
+	}
+
+	template<typename Left, typename Right, size_t size, typename T>
+	inline VectorBinaryExpression<Left, Right, detail::Subtract, size, T> operator-(const VectorExpression<Left, size, T>& left, const VectorExpression<Right, size, T>& right)
+	{
+		return { left.Self(), right.Self() };
+	}
+
+	template<typename E, size_t size, typename T, typename N, typename = typename std::enable_if<std::is_arithmetic<N>::value>::type>
+	inline VectorScalarExpression<E, N, detail::Multiply, size, T> operator*(const VectorExpression<E, size, T>& expression, const N& scalar)
+	{
+		return { expression.Self(), scalar };
+	}
+
+	template<typename E, size_t size, typename T, typename N, typename = typename std::enable_if<std::is_arithmetic<N>::value>::type>
+	inline VectorScalarExpression<E, N, detail::Divide, size, T> operator/(const VectorExpression<E, size, T>& expression, const N& scalar)
+	{
+		return { expression.Self(), scalar };
+	}
+	#pragma endregion
+}
+
+#endif
@@ -1,68 +1,394 @@
 #ifndef CU_FUNCTION_H
 #define CU_FUNCTION_H
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 namespace cu
 {
-	template<typename ReturnT, typename... ArgumentT>
-	class Function
+	// Inline storage of Function and MoveOnlyFunction, room for a lambda capturing four pointers or a bound
+	// member function.
+	constexpr size_t defaultFunctionSize{ 32 };
+
+	namespace detail
+	{
+		enum class FunctionOperation
+		{
+			Move,
+			Copy,
+			Destroy
+		};
+
+		// Stands in for the copy constructor of move-only functions so the compiler deletes the real one.
+		struct NotCopyable
+		{};
+
+		// A member function bound to an object.
+		template<typename ObjectT, typename MethodT>
+		struct BoundMethod
+		{
+			ObjectT* object;
+			MethodT method;
+
+			template<typename... ArgumentT>
+			inline auto operator()(ArgumentT&&... arguments) const -> decltype((object->*method)(std::forward<ArgumentT>(arguments)...))
+			{
+				return (object->*method)(std::forward<ArgumentT>(arguments)...);
+			}
+		};
+	}
+
+	// Holds any callable taking ArgumentT... and returning ReturnT. Callables of up to bufferSize bytes that can
+	// not throw when moved are stored inline, others only compile when heapFallback is set and are then
+	// allocated. Calling is a single indirect call, an empty function throws std::bad_function_call. Use the
+	// Function and MoveOnlyFunction aliases unless a different buffer size or the heap fallback is needed.
+	template<size_t bufferSize, bool heapFallback, bool copyable, typename ReturnT, typename... ArgumentT>
+	class BasicFunction
 	{
 	private:
-		using FunctionPointer = ReturnT(*)(ArgumentT...);
+		using Invoker = ReturnT(*)(void*, ArgumentT&&...);
+		using Manager = void(*)(detail::FunctionOperation, void*, void*);
+		using CopySource = typename std::conditional<copyable, BasicFunction, detail::NotCopyable>::type;
+
+		// Swap and moves are noexcept, so only callables that can not throw when moved are kept in the buffer.
+		template<typename F>
+		using IsInline = std::integral_constant<bool, (sizeof(F) <= bufferSize && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<F>::value)>;
+
+		static_assert(!heapFallback || bufferSize >= sizeof(void*), "The buffer must hold a pointer for the heap fallback.");
+
+		alignas(std::max_align_t) mutable unsigned char buffer[bufferSize > 0 ? bufferSize : 1];
+		Invoker invoker;
+		// Moves, copies and destroys the callable, null when empty.
+		Manager manager;
+
+		#pragma region Type erasure
+		template<typename F>
+		inline static F* Target(void* buffer, std::true_type)
+		{
+			return static_cast<F*>(buffer);
+		}
+
+		template<typename F>
+		inline static F* Target(void* buffer, std::false_type)
+		{
+			return *static_cast<F**>(buffer);
+		}
 
-		FunctionPointer function;
+		template<typename F>
+		static ReturnT Invoke(void* buffer, ArgumentT&&... arguments)
+		{
+			return static_cast<ReturnT>((*Target<F>(buffer, IsInline<F>{}))(std::forward<ArgumentT>(arguments)...));
+		}
+
+		static ReturnT InvokeEmpty(void*, ArgumentT&&...)
+		{
+			throw std::bad_function_call{};
+		}
+
+		template<typename F>
+		inline static void CopyConstruct(void* destination, const F& callable, std::true_type)
+		{
+			new (destination) F(callable);
+		}
+
+		template<typename F>
+		inline static F* CopyAllocate(const F& callable, std::true_type)
+		{
+			return new F(callable);
+		}
+
+		// Move-only functions never copy, this only keeps F's copy constructor from being needed.
+		template<typename F>
+		inline static void CopyConstruct(void*, const F&, std::false_type)
+		{}
+
+		template<typename F>
+		inline static F* CopyAllocate(const F&, std::false_type)
+		{
+			return nullptr;
+		}
+
+		template<typename F>
+		static void Manage(detail::FunctionOperation operation, void* destination, void* source)
+		{
+			Manage<F>(operation, destination, source, IsInline<F>{});
+		}
+
+		template<typename F>
+		inline static void Manage(detail::FunctionOperation operation, void* destination, void* source, std::true_type)
+		{
+			switch (operation)
+			{
+			case detail::FunctionOperation::Move:
+				new (destination) F(std::move(*static_cast<F*>(source)));
+				static_cast<F*>(source)->~F();
+				break;
+			case detail::FunctionOperation::Copy:
+				CopyConstruct(destination, *static_cast<const F*>(source), std::integral_constant<bool, copyable>{});
+				break;
+			case detail::FunctionOperation::Destroy:
+				static_cast<F*>(destination)->~F();
+				break;
+			}
+		}
+
+		template<typename F>
+		inline static void Manage(detail::FunctionOperation operation, void* destination, void* source, std::false_type)
+		{
+			switch (operation)
+			{
+			case detail::FunctionOperation::Move:
+				*static_cast<F**>(destination) = *static_cast<F**>(source);
+				break;
+			case detail::FunctionOperation::Copy:
+				*static_cast<F**>(destination) = CopyAllocate(**static_cast<F**>(source), std::integral_constant<bool, copyable>{});
+				break;
+			case detail::FunctionOperation::Destroy:
+				delete *static_cast<F**>(destination);
+				break;
+			}
+		}
+
+		template<typename F, typename C>
+		inline void Store(C&& callable, std::true_type)
+		{
+			new (buffer) F(std::forward<C>(callable));
+		}
+
+		template<typename F, typename C>
+		inline void Store(C&& callable, std::false_type)
+		{
+			*reinterpret_cast<F**>(buffer) = new F(std::forward<C>(callable));
+		}
+
+		template<typename F>
+		inline static bool IsNull(const F&)
+		{
+			return false;
+		}
+
+		template<typename R, typename... A>
+		inline static bool IsNull(R(* const& function)(A...))
+		{
+			return function == nullptr;
+		}
+		#pragma endregion
 
 	public:
-		Function() :
-			function{}
+		#pragma region Constructors
+		BasicFunction() noexcept :
+			invoker{ &InvokeEmpty },
+			manager{ nullptr }
+		{}
+
+		BasicFunction(std::nullptr_t) noexcept :
+			BasicFunction{}
 		{}
 
-		Function(const FunctionPointer& function) :
-			function{ function }
+		// Stores a copy of callable, a lambda, functor or function pointer.
+		template<typename F, typename = typename std::enable_if<!std::is_base_of<BasicFunction, typename std::decay<F>::type>::value>::type>
+		BasicFunction(F&& callable) :
+			BasicFunction{}
+		{
+			using Callable = typename std::decay<F>::type;
+			static_assert(IsInline<Callable>::value || heapFallback, "Callable does not fit in the function buffer or can throw when moved, use a larger bufferSize or the heap fallback.");
+			static_assert(!copyable || std::is_copy_constructible<Callable>::value, "Callable can not be copied, use MoveOnlyFunction.");
+
+			if (IsNull(callable))
+			{
+				return;
+			}
+			Store<Callable>(std::forward<F>(callable), IsInline<Callable>{});
+			invoker = &Invoke<Callable>;
+			manager = &Manage<Callable>;
+		}
+
+		// Binds a member function to an object, the object must outlive the function.
+		template<typename ObjectT, typename MethodT, typename = typename std::enable_if<std::is_member_function_pointer<MethodT>::value>::type>
+		BasicFunction(ObjectT* object, MethodT method) :
+			BasicFunction{ detail::BoundMethod<ObjectT, MethodT>{ object, method } }
 		{}
 
-		~Function() = default;
+		BasicFunction(const CopySource& function) :
+			BasicFunction{}
+		{
+			if (function.manager)
+			{
+				function.manager(detail::FunctionOperation::Copy, buffer, function.buffer);
+				invoker = function.invoker;
+				manager = function.manager;
+			}
+		}
 
-		// Gets the target function.
-		FunctionPointer& Target()
+		BasicFunction(BasicFunction&& function) noexcept :
+			BasicFunction{}
 		{
-			return function;
+			Swap(function);
 		}
+		#pragma endregion
 
-		// Sets the target function.
-		void SetFunction(const FunctionPointer& function)
+		~BasicFunction()
 		{
-			this->function = function;
+			Reset();
+		}
+
+		// Removes the callable, the function is then empty.
+		void Reset()
+		{
+			if (manager)
+			{
+				manager(detail::FunctionOperation::Destroy, buffer, nullptr);
+				invoker = &InvokeEmpty;
+				manager = nullptr;
+			}
+		}
+
+		void Swap(BasicFunction& function) noexcept
+		{
+			if (this == &function)
+			{
+				return;
+			}
+
+			alignas(std::max_align_t) unsigned char temporary[sizeof(buffer)];
+			if (function.manager)
+			{
+				function.manager(detail::FunctionOperation::Move, temporary, function.buffer);
+			}
+			if (manager)
+			{
+				manager(detail::FunctionOperation::Move, function.buffer, buffer);
+			}
+			if (function.manager)
+			{
+				function.manager(detail::FunctionOperation::Move, buffer, temporary);
+			}
+			std::swap(invoker, function.invoker);
+			std::swap(manager, function.manager);
 		}
 
 		#pragma region Operators
-		inline ReturnT operator()(ArgumentT&... argument)
+		inline ReturnT operator()(ArgumentT... arguments) const
 		{
-			return function(argument...);
+			return invoker(buffer, std::forward<ArgumentT>(arguments)...);
 		}
 
-		inline Function& operator=(const Function& function)
+		inline explicit operator bool() const noexcept
 		{
-			this->function = function.function;
+			return manager != nullptr;
+		}
+
+		BasicFunction& operator=(const CopySource& function)
+		{
+			BasicFunction copy{ function };
+			Swap(copy);
+			return *this;
+		}
+
+		BasicFunction& operator=(BasicFunction&& function) noexcept
+		{
+			BasicFunction moved{ std::move(function) };
+			Swap(moved);
 			return *this;
 		}
 
-		inline Function& operator=(const FunctionPointer& function)
+		BasicFunction& operator=(std::nullptr_t) noexcept
 		{
-			this->function = function;
+			Reset();
 			return *this;
 		}
 
-		inline bool operator==(const Function& function) const
+		template<typename F, typename = typename std::enable_if<!std::is_base_of<BasicFunction, typename std::decay<F>::type>::value>::type>
+		BasicFunction& operator=(F&& callable)
 		{
-			return this->function == function.function;
+			BasicFunction function{ std::forward<F>(callable) };
+			Swap(function);
+			return *this;
 		}
 
-		inline bool operator==(const FunctionPointer& function) const
+		inline bool operator==(std::nullptr_t) const noexcept
 		{
-			return this->function == function;
+			return manager == nullptr;
+		}
+
+		inline bool operator!=(std::nullptr_t) const noexcept
+		{
+			return manager != nullptr;
 		}
 		#pragma endregion
 	};
+
+	template<typename ReturnT, typename... ArgumentT>
+	using Function = BasicFunction<defaultFunctionSize, false, true, ReturnT, ArgumentT...>;
+
+	// Like Function but can not be copied, so it also holds move-only callables such as lambdas owning a
+	// std::unique_ptr.
+	template<typename ReturnT, typename... ArgumentT>
+	using MoveOnlyFunction = BasicFunction<defaultFunctionSize, false, false, ReturnT, ArgumentT...>;
+
+	// A non-owning reference to a callable, two pointers in size and never allocating. The callable must outlive
+	// the reference, which makes it best suited for parameters.
+	template<typename ReturnT, typename... ArgumentT>
+	class FunctionRef
+	{
+	private:
+		using FunctionPointer = ReturnT(*)(ArgumentT...);
+
+		union Target
+		{
+			void* object;
+			FunctionPointer function;
+		};
+
+		using Invoker = ReturnT(*)(Target, ArgumentT&&...);
+
+		Target target;
+		Invoker invoker;
+
+		template<typename F>
+		static ReturnT InvokeObject(Target target, ArgumentT&&... arguments)
+		{
+			return static_cast<ReturnT>((*static_cast<F*>(target.object))(std::forward<ArgumentT>(arguments)...));
+		}
+
+		static ReturnT InvokeFunction(Target target, ArgumentT&&... arguments)
+		{
+			return static_cast<ReturnT>(target.function(std::forward<ArgumentT>(arguments)...));
+		}
+
+		template<typename F>
+		inline void Bind(F&& callable, std::true_type)
+		{
+			target.function = callable;
+			invoker = &InvokeFunction;
+		}
+
+		template<typename F>
+		inline void Bind(F&& callable, std::false_type)
+		{
+			target.object = const_cast<void*>(static_cast<const void*>(std::addressof(callable)));
+			invoker = &InvokeObject<typename std::remove_reference<F>::type>;
+		}
+
+	public:
+		// Function pointers and lambdas without captures are referred to by their function pointer.
+		template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, FunctionRef>::value>::type>
+		FunctionRef(F&& callable) :
+			target{},
+			invoker{ nullptr }
+		{
+			Bind(std::forward<F>(callable), std::is_convertible<F, FunctionPointer>{});
+		}
+
+		inline ReturnT operator()(ArgumentT... arguments) const
+		{
+			return invoker(target, std::forward<ArgumentT>(arguments)...);
+		}
+	};
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,390 @@
+#ifndef CU_GEMM_H
+#define CU_GEMM_H
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+// MSVC has no __FMA__, /arch:AVX2 implies FMA.
+#define CU_GEMM_AVX2
+#endif
+
+namespace cu
+{
+	// Cache blocked matrix multiply. Blocks of the right matrix are packed into panels of microkernel width,
+	// copied row by row so no transpose is needed, and blocks of the left matrix into slivers of microkernel
+	// height. The microkernel keeps its whole tile of the product in registers, with AVX2 FMA kernels for
+	// float and double when the build targets AVX2.
+	namespace detail
+	{
+		template<typename T>
+		struct GemmKernel
+		{
+			static constexpr size_t rows{ 4 };
+			static constexpr size_t columns{ 8 };
+
+			// product (stride apart) = or += the rows x columns tile of the packed slivers.
+			inline static void Run(const size_t& depth, const T* left, const T* right, T* product, const size_t& stride, const bool& accumulate)
+			{
+				T sums[rows][columns]{};
+				for (size_t p{ 0 }; p < depth; ++p)
+				{
+					for (size_t i{ 0 }; i < rows; ++i)
+					{
+						for (size_t j{ 0 }; j < columns; ++j)
+						{
+							sums[i][j] += left[i] * right[j];
+						}
+					}
+					left += rows;
+					right += columns;
+				}
+
+				for (size_t i{ 0 }; i < rows; ++i)
+				{
+					for (size_t j{ 0 }; j < columns; ++j)
+					{
+						product[i * stride + j] = accumulate ? product[i * stride + j] + sums[i][j] : sums[i][j];
+					}
+				}
+			}
+		};
+
+		#ifdef CU_GEMM_AVX2
+		template<>
+		struct GemmKernel<float>
+		{
+			static constexpr size_t rows{ 6 };
+			static constexpr size_t columns{ 16 };
+
+			// 12 accumulators, 2 loads of the right sliver and 1 broadcast fit in the 16 registers. Written out
+			// since compilers keep an array of accumulators in memory.
+			inline static void Run(const size_t& depth, const float* left, const float* right, float* product, const size_t& stride, const bool& accumulate)
+			{
+				__m256 sum00, sum01, sum10, sum11, sum20, sum21, sum30, sum31, sum40, sum41, sum50, sum51;
+				sum00 = sum01 = sum10 = sum11 = sum20 = sum21 = sum30 = sum31 = sum40 = sum41 = sum50 = sum51 = _mm256_setzero_ps();
+
+				for (size_t p{ 0 }; p < depth; ++p)
+				{
+					const __m256 right0{ _mm256_load_ps(right) };
+					const __m256 right1{ _mm256_load_ps(right + 8) };
+					__m256 value;
+					value = _mm256_broadcast_ss(left + 0);
+					sum00 = _mm256_fmadd_ps(value, right0, sum00);
+					sum01 = _mm256_fmadd_ps(value, right1, sum01);
+					value = _mm256_broadcast_ss(left + 1);
+					sum10 = _mm256_fmadd_ps(value, right0, sum10);
+					sum11 = _mm256_fmadd_ps(value, right1, sum11);
+					value = _mm256_broadcast_ss(left + 2);
+					sum20 = _mm256_fmadd_ps(value, right0, sum20);
+					sum21 = _mm256_fmadd_ps(value, right1, sum21);
+					value = _mm256_broadcast_ss(left + 3);
+					sum30 = _mm256_fmadd_ps(value, right0, sum30);
+					sum31 = _mm256_fmadd_ps(value, right1, sum31);
+					value = _mm256_broadcast_ss(left + 4);
+					sum40 = _mm256_fmadd_ps(value, right0, sum40);
+					sum41 = _mm256_fmadd_ps(value, right1, sum41);
+					value = _mm256_broadcast_ss(left + 5);
+					sum50 = _mm256_fmadd_ps(value, right0, sum50);
+					sum51 = _mm256_fmadd_ps(value, right1, sum51);
+					left += rows;
+					right += columns;
+				}
+
+				Store(product, sum00, sum01, accumulate);
+				Store(product + 1 * stride, sum10, sum11, accumulate);
+				Store(product + 2 * stride, sum20, sum21, accumulate);
+				Store(product + 3 * stride, sum30, sum31, accumulate);
+				Store(product + 4 * stride, sum40, sum41, accumulate);
+				Store(product + 5 * stride, sum50, sum51, accumulate);
+			}
+
+			inline static void Store(float* row, const __m256& first, const __m256& second, const bool& accumulate)
+			{
+				if (accumulate)
+				{
+					_mm256_storeu_ps(row, _mm256_add_ps(first, _mm256_loadu_ps(row)));
+					_mm256_storeu_ps(row + 8, _mm256_add_ps(second, _mm256_loadu_ps(row + 8)));
+					return;
+				}
+				_mm256_storeu_ps(row, first);
+				_mm256_storeu_ps(row + 8, second);
+			}
+		};
+
+		template<>
+		struct GemmKernel<double>
+		{
+			static constexpr size_t rows{ 6 };
+			static constexpr size_t columns{ 8 };
+
+			inline static void Run(const size_t& depth, const double* left, const double* right, double* product, const size_t& stride, const bool& accumulate)
+			{
+				__m256d sum00, sum01, sum10, sum11, sum20, sum21, sum30, sum31, sum40, sum41, sum50, sum51;
+				sum00 = sum01 = sum10 = sum11 = sum20 = sum21 = sum30 = sum31 = sum40 = sum41 = sum50 = sum51 = _mm256_setzero_pd();
+
+				for (size_t p{ 0 }; p < depth; ++p)
+				{
+					const __m256d right0{ _mm256_load_pd(right) };
+					const __m256d right1{ _mm256_load_pd(right + 4) };
+					__m256d value;
+					value = _mm256_broadcast_sd(left + 0);
+					sum00 = _mm256_fmadd_pd(value, right0, sum00);
+					sum01 = _mm256_fmadd_pd(value, right1, sum01);
+					value = _mm256_broadcast_sd(left + 1);
+					sum10 = _mm256_fmadd_pd(value, right0, sum10);
+					sum11 = _mm256_fmadd_pd(value, right1, sum11);
+					value = _mm256_broadcast_sd(left + 2);
+					sum20 = _mm256_fmadd_pd(value, right0, sum20);
+					sum21 = _mm256_fmadd_pd(value, right1, sum21);
+					value = _mm256_broadcast_sd(left + 3);
+					sum30 = _mm256_fmadd_pd(value, right0, sum30);
+					sum31 = _mm256_fmadd_pd(value, right1, sum31);
+					value = _mm256_broadcast_sd(left + 4);
+					sum40 = _mm256_fmadd_pd(value, right0, sum40);
+					sum41 = _mm256_fmadd_pd(value, right1, sum41);
+					value = _mm256_broadcast_sd(left + 5);
+					sum50 = _mm256_fmadd_pd(value, right0, sum50);
+					sum51 = _mm256_fmadd_pd(value, right1, sum51);
+					left += rows;
+					right += columns;
+				}
+
+				Store(product, sum00, sum01, accumulate);
+				Store(product + 1 * stride, sum10, sum11, accumulate);
+				Store(product + 2 * stride, sum20, sum21, accumulate);
+				Store(product + 3 * stride, sum30, sum31, accumulate);
+				Store(product + 4 * stride, sum40, sum41, accumulate);
+				Store(product + 5 * stride, sum50, sum51, accumulate);
+			}
+
+			inline static void Store(double* row, const __m256d& first, const __m256d& second, const bool& accumulate)
+			{
+				if (accumulate)
+				{
+					_mm256_storeu_pd(row, _mm256_add_pd(first, _mm256_loadu_pd(row)));
+					_mm256_storeu_pd(row + 4, _mm256_add_pd(second, _mm256_loadu_pd(row + 4)));
+					return;
+				}
+				_mm256_storeu_pd(row, first);
+				_mm256_storeu_pd(row + 4, second);
+			}
+		};
+		#endif
+
+		// Depth, left rows and right columns of the packed blocks, sized for L1, L2 and L3.
+		constexpr size_t gemmDepthBlock{ 256 };
+		constexpr size_t gemmRowBlock{ 72 };
+		constexpr size_t gemmColumnBlock{ 1024 };
+
+		// Products with fewer multiply-adds than this per thread are not split.
+		constexpr size_t gemmThreadWork{ 128 * 128 * 128 };
+
+		// Packing buffer aligned for the kernel's loads.
+		template<typename T>
+		class GemmBuffer
+		{
+		private:
+			static constexpr size_t alignment{ 64 };
+			std::unique_ptr<unsigned char[]> memory;
+			T* elements;
+
+		public:
+			GemmBuffer(const size_t& size) :
+				memory{ new unsigned char[size * sizeof(T) + alignment] },
+				elements{ nullptr }
+			{
+				void* data{ memory.get() };
+				size_t space{ size * sizeof(T) + alignment };
+				elements = static_cast<T*>(std::align(alignment, size * sizeof(T), data, space));
+			}
+
+			inline T* Data()
+			{
+				return elements;
+			}
+		};
+
+		// Packs rows x depth of left into slivers of kernel height, each stored depth-major.
+		template<typename T>
+		inline void PackLeft(const T* left, const size_t& leftStride, const size_t& rows, const size_t& depth, T* packed)
+		{
+			constexpr size_t height{ GemmKernel<T>::rows };
+			for (size_t sliver{ 0 }; sliver < rows; sliver += height)
+			{
+				const size_t count{ rows - sliver < height ? rows - sliver : height };
+				for (size_t p{ 0 }; p < depth; ++p)
+				{
+					for (size_t i{ 0 }; i < height; ++i)
+					{
+						*packed++ = i < count ? left[(sliver + i) * leftStride + p] : T{};
+					}
+				}
+			}
+		}
+
+		// Packs depth x columns of right into panels of kernel width. Each panel row is a contiguous copy of
+		// part of a row of right.
+		template<typename T>
+		inline void PackRight(const T* right, const size_t& rightStride, const size_t& depth, const size_t& columns, T* packed)
+		{
+			constexpr size_t width{ GemmKernel<T>::columns };
+			for (size_t panel{ 0 }; panel < columns; panel += width)
+			{
+				const size_t count{ columns - panel < width ? columns - panel : width };
+				for (size_t p{ 0 }; p < depth; ++p)
+				{
+					const T* row{ right + p * rightStride + panel };
+					for (size_t j{ 0 }; j < width; ++j)
+					{
+						*packed++ = j < count ? row[j] : T{};
+					}
+				}
+			}
+		}
+
+		template<typename T>
+		void GemmRange(const T* left, const T* right, T* product, const size_t& rows, const size_t& columns, const size_t& secondColumns, const size_t& leftStride, const size_t& rightStride, const size_t& productStride, const bool& add)
+		{
+			using Kernel = GemmKernel<T>;
+			constexpr size_t height{ Kernel::rows };
+			constexpr size_t width{ Kernel::columns };
+			constexpr size_t rowBlock{ (gemmRowBlock + height - 1) / height * height };
+			constexpr size_t columnBlock{ (gemmColumnBlock + width - 1) / width * width };
+
+			// The packing buffers only need to hold the largest block this product has, not a full size one.
+			const size_t depthBlock{ columns < gemmDepthBlock ? columns : gemmDepthBlock };
+			const size_t leftRows{ (rows + height - 1) / height * height };
+			const size_t rightColumns{ (secondColumns + width - 1) / width * width };
+			GemmBuffer<T> packedLeft{ (leftRows < rowBlock ? leftRows : rowBlock) * depthBlock };
+			GemmBuffer<T> packedRight{ depthBlock * (rightColumns < columnBlock ? rightColumns : columnBlock) };
+			T edge[height * width];
+
+			for (size_t jc{ 0 }; jc < secondColumns; jc += columnBlock)
+			{
+				const size_t nc{ secondColumns - jc < columnBlock ? secondColumns - jc : columnBlock };
+				for (size_t pc{ 0 }; pc < columns; pc += gemmDepthBlock)
+				{
+					const size_t kc{ columns - pc < gemmDepthBlock ? columns - pc : gemmDepthBlock };
+					// The first depth block writes the product unless adding to it, the others add.
+					const bool accumulate{ add || pc > 0 };
+					PackRight(right + pc * rightStride + jc, rightStride, kc, nc, packedRight.Data());
+
+					for (size_t ic{ 0 }; ic < rows; ic += rowBlock)
+					{
+						const size_t mc{ rows - ic < rowBlock ? rows - ic : rowBlock };
+						PackLeft(left + ic * leftStride + pc, leftStride, mc, kc, packedLeft.Data());
+
+						for (size_t jr{ 0 }; jr < nc; jr += width)
+						{
+							const size_t nr{ nc - jr < width ? nc - jr : width };
+							const T* rightSliver{ packedRight.Data() + jr * kc };
+							for (size_t ir{ 0 }; ir < mc; ir += height)
+							{
+								const size_t mr{ mc - ir < height ? mc - ir : height };
+								const T* leftSliver{ packedLeft.Data() + ir * kc };
+								T* tile{ product + (ic + ir) * productStride + jc + jr };
+								if (mr == height && nr == width)
+								{
+									Kernel::Run(kc, leftSliver, rightSliver, tile, productStride, accumulate);
+									continue;
+								}
+
+								// Partial tiles at the edges go through a full size tile on the stack.
+								Kernel::Run(kc, leftSliver, rightSliver, edge, width, false);
+								for (size_t i{ 0 }; i < mr; ++i)
+								{
+									for (size_t j{ 0 }; j < nr; ++j)
+									{
+										tile[i * productStride + j] = accumulate ? tile[i * productStride + j] + edge[i * width + j] : edge[i * width + j];
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		template<typename T>
+		void GemmThreaded(const T* left, const T* right, T* product, const size_t& rows, const size_t& columns, const size_t& secondColumns, size_t threadCount, const size_t& leftStride, const size_t& rightStride, const size_t& productStride, const bool& add)
+		{
+			if (columns == 0)
+			{
+				if (add)
+				{
+					return;
+				}
+				for (size_t i{ 0 }; i < rows; ++i)
+				{
+					for (size_t j{ 0 }; j < secondColumns; ++j)
+					{
+						product[i * productStride + j] = T{};
+					}
+				}
+				return;
+			}
+
+			threadCount = threadCount > 0 ? threadCount : std::thread::hardware_concurrency();
+			const size_t work{ rows * columns * secondColumns };
+			size_t maxThreads{ work / gemmThreadWork };
+			maxThreads = maxThreads < rows / GemmKernel<T>::rows ? maxThreads : rows / GemmKernel<T>::rows;
+			threadCount = threadCount < maxThreads ? threadCount : maxThreads;
+			if (threadCount <= 1)
+			{
+				GemmRange(left, right, product, rows, columns, secondColumns, leftStride, rightStride, productStride, add);
+				return;
+			}
+
+			// Every thread computes whole rows of the product, split on kernel height.
+			const size_t slivers{ (rows + GemmKernel<T>::rows - 1) / GemmKernel<T>::rows };
+			std::vector<std::thread> threads;
+			threads.reserve(threadCount - 1);
+			size_t firstRow{ 0 };
+			for (size_t thread{ 0 }; thread < threadCount; ++thread)
+			{
+				size_t lastRow{ (slivers * (thread + 1) / threadCount) * GemmKernel<T>::rows };
+				lastRow = lastRow < rows ? lastRow : rows;
+				const T* threadLeft{ left + firstRow * leftStride };
+				T* threadProduct{ product + firstRow * productStride };
+				const size_t threadRows{ lastRow - firstRow };
+				if (thread + 1 < threadCount)
+				{
+					threads.emplace_back([=]() { GemmRange(threadLeft, right, threadProduct, threadRows, columns, secondColumns, leftStride, rightStride, productStride, add); });
+				}
+				else
+				{
+					GemmRange(threadLeft, right, threadProduct, threadRows, columns, secondColumns, leftStride, rightStride, productStride, add);
+				}
+				firstRow = lastRow;
+			}
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+	}
+
+	// Computes product = left * right for row-major data, left being rows x columns and right columns x
+	// secondColumns. The strides are the distances between rows and default to the widths. Products big enough
+	// are split by rows over threadCount threads, 0 uses every hardware thread. product may not overlap the
+	// inputs.
+	template<typename T>
+	void Gemm(const T* left, const T* right, T* product, const size_t& rows, const size_t& columns, const size_t& secondColumns, const size_t& threadCount = 1, const size_t& leftStride = 0, const size_t& rightStride = 0, const size_t& productStride = 0)
+	{
+		detail::GemmThreaded(left, right, product, rows, columns, secondColumns, threadCount, leftStride > 0 ? leftStride : columns, rightStride > 0 ? rightStride : secondColumns, productStride > 0 ? productStride : secondColumns, false);
+	}
+
+	// Computes product += left * right, otherwise like Gemm.
+	template<typename T>
+	void GemmAdd(const T* left, const T* right, T* product, const size_t& rows, const size_t& columns, const size_t& secondColumns, const size_t& threadCount = 1, const size_t& leftStride = 0, const size_t& rightStride = 0, const size_t& productStride = 0)
+	{
+		detail::GemmThreaded(left, right, product, rows, columns, secondColumns, threadCount, leftStride > 0 ? leftStride : columns, rightStride > 0 ? rightStride : secondColumns, productStride > 0 ? productStride : secondColumns, true);
+	}
+}
+
+#endif
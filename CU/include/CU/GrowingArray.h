@@ -357,6 +357,16 @@ namespace cu
 			return false;
 		}
 
+		// Sets the size, growing the array if needed. Elements beyond the old size keep whatever they last held.
+		void Resize(const size_t& size)
+		{
+			if (size > this->size)
+			{
+				ValidateSize(size - this->size);
+			}
+			this->size = size;
+		}
+
 		// Clears the array and resets its capacity.
 		void Clear()
 		{
@@ -115,6 +115,17 @@ namespace cu
 			}
 		}
 
+		inline size_t Size() const
+		{
+			return elements.Size();
+		}
+
+		// Removes every element.
+		void Clear()
+		{
+			elements.RemoveRange(0, elements.Size());
+		}
+
 		ValueT& operator[](const KeyT& key)
 		{
 			const Pair<bool, KeyValuePair*> valueData{ FindValue(key) };
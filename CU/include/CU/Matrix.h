@@ -2,30 +2,40 @@
 #define CU_MATRIX_H
 
 #include "Array.h"
+#include "Expression.h"
+#include "Gemm.h"
 
 namespace cu
 {
     using MatrixDefaultType = float;
 
+    // A matrix sized at compile time. The elements are stored inline, so a Matrix<512, 512, float> is 1 MB
+    // wherever it lives, which already fills MSVC's default 1 MB stack. Use DynamicMatrix for large sizes.
     template<size_t rows, size_t columns, typename T = MatrixDefaultType>
-    class Matrix
+    class Matrix : public MatrixExpression<Matrix<rows, columns, T>, rows, columns, T>
     {
     private:
         Array<Array<T, columns>, rows> elements;
 
     public:
         #pragma region Constructors
-        Matrix() :
+        constexpr Matrix() :
             elements{}
         {}
 
-        Matrix(const Matrix& matrix) :
-            elements{ matrix.elements }
-        {}
+        Matrix(const Matrix& matrix) = default;
 
         Matrix(const Array<Array<T, columns>, rows>& elements) :
             elements{ elements }
         {}
+
+        // Computes an expression such as a + b * s into the new matrix.
+        template<typename E>
+        Matrix(const MatrixExpression<E, rows, columns, T>& expression) :
+            elements{}
+        {
+            *this = expression;
+        }
         #pragma endregion
 
         ~Matrix() = default;
@@ -53,6 +63,30 @@ namespace cu
             return newMatrix;
         }
 
+        // Unchecked element access, used by expressions.
+        inline T& Coefficient(const size_t& row, const size_t& column)
+        {
+            return elements.Data()[row].Data()[column];
+        }
+
+        inline const T& Coefficient(const size_t& row, const size_t& column) const
+        {
+            return elements.Data()[row].Data()[column];
+        }
+
+        // The elements row by row, rows are stored back to back.
+        inline T* Data()
+        {
+            static_assert(sizeof(Array<T, columns>) == sizeof(T) * columns, "Matrix rows must be contiguous.");
+            return elements.Data()->Data();
+        }
+
+        inline const T* Data() const
+        {
+            static_assert(sizeof(Array<T, columns>) == sizeof(T) * columns, "Matrix rows must be contiguous.");
+            return elements.Data()->Data();
+        }
+
         #pragma region Operators
         inline Array<T, columns>& operator[](const size_t& row)
         {
@@ -84,100 +118,142 @@ namespace cu
             return !(*this == matrix);
         }
 
-        void operator+=(const Matrix& matrix)
+        Matrix& operator=(const Matrix& matrix) = default;
+
+        // Computes an expression straight into this matrix.
+        template<typename E>
+        Matrix& operator=(const MatrixExpression<E, rows, columns, T>& expression)
         {
-            for (size_t i{ 0 }; i < rows; ++i)
+            const E& source{ expression.Self() };
+            detail::ForEachElement<rows, columns>([this, &source](const size_t& row, const size_t& column)
             {
-                for (size_t j{ 0 }; j < columns; ++j)
-                {
-                    elements[i][j] += matrix.elements[i][j];
-                }
-            }
+                Coefficient(row, column) = source.Coefficient(row, column);
+            });
+            return *this;
         }
 
-        inline Matrix operator+(const Matrix& matrix) const
+        template<typename E>
+        void operator+=(const MatrixExpression<E, rows, columns, T>& expression)
         {
-            Matrix newMatrix{ matrix };
-            newMatrix += *this;
-            return newMatrix;
+            const E& source{ expression.Self() };
+            detail::ForEachElement<rows, columns>([this, &source](const size_t& row, const size_t& column)
+            {
+                Coefficient(row, column) += source.Coefficient(row, column);
+            });
         }
 
-        void operator-=(const Matrix& matrix)
+        template<typename E>
+        void operator-=(const MatrixExpression<E, rows, columns, T>& expression)
         {
-            for (size_t i{ 0 }; i < rows; ++i)
+            const E& source{ expression.Self() };
+            detail::ForEachElement<rows, columns>([this, &source](const size_t& row, const size_t& column)
             {
-                for (size_t j{ 0 }; j < columns; ++j)
-                {
-                    elements[i][j] -= matrix.elements[i][j];
-                }
-            }
+                Coefficient(row, column) -= source.Coefficient(row, column);
+            });
         }
 
-        inline Matrix operator-(const Matrix& matrix) const
+        template<typename N>
+        void operator*=(const N& scalar)
         {
-            Matrix newMatrix{ matrix };
-            newMatrix -= *this;
-            return newMatrix;
+            detail::ForEachElement<rows, columns>([this, &scalar](const size_t& row, const size_t& column)
+            {
+                Coefficient(row, column) = detail::Multiply::Apply(Coefficient(row, column), scalar);
+            });
         }
 
         template<typename N>
-        void operator*=(const N& scalar)
+        void operator/=(const N& scalar)
         {
-            for (size_t i{ 0 }; i < rows; ++i)
+            detail::ForEachElement<rows, columns>([this, &scalar](const size_t& row, const size_t& column)
             {
-                for (size_t j{ 0 }; j < columns; ++j)
-                {
-                    elements[i][j] *= scalar;
-                }
-            }
+                Coefficient(row, column) = detail::Divide::Apply(Coefficient(row, column), scalar);
+            });
         }
+        #pragma endregion
+    };
 
-        template<typename N>
-        inline Matrix operator*(const N& scalar) const
+    namespace detail
+    {
+        // Matrices are used as they are, other expressions are computed once so the product does not
+        // compute every element of them several times.
+        template<size_t rows, size_t columns, typename T>
+        inline const Matrix<rows, columns, T>& Evaluate(const Matrix<rows, columns, T>& matrix)
         {
-            Matrix newMatrix{ *this };
-            newMatrix *= scalar;
-            return newMatrix;
+            return matrix;
         }
 
-        template<typename N>
-        void operator/=(const N& scalar)
+        template<typename E, size_t rows, size_t columns, typename T>
+        inline Matrix<rows, columns, T> Evaluate(const MatrixExpression<E, rows, columns, T>& expression)
         {
-            for (size_t i{ 0 }; i < rows; ++i)
-            {
-                for (size_t j{ 0 }; j < columns; ++j)
-                {
-                    elements[i][j] /= scalar;
-                }
-            }
+            return expression.Evaluated();
         }
 
-        template<typename N>
-        inline Matrix operator/(const N& scalar) const
+        // Products with at least this many multiply-adds use the blocked multiply.
+        constexpr size_t blockedMultiplyWork{ 32 * 32 * 32 };
+
+        template<size_t rows, size_t columns, size_t secondColumns>
+        using MultiplyMethod = std::integral_constant<int, (rows * secondColumns <= maxUnrolledCount) ? 0 : (rows * columns * secondColumns < blockedMultiplyWork ? 1 : 2)>;
+
+        template<size_t rows, size_t columns, size_t secondColumns, typename T>
+        inline void MultiplyMatrices(const Matrix<rows, columns, T>& left, const Matrix<columns, secondColumns, T>& right, Matrix<rows, secondColumns, T>& product, const size_t&, std::integral_constant<int, 0>)
         {
-            Matrix newMatrix{ *this };
-            newMatrix /= scalar;
-            return newMatrix;
+            // Fully unrolled dot products for small matrices.
+            ForEachElement<rows, secondColumns>([&left, &right, &product](const size_t& row, const size_t& column)
+            {
+                T sum{};
+                ForEachIndex<columns>([&left, &right, &sum, &row, &column](const size_t& k)
+                {
+                    sum += left.Coefficient(row, k) * right.Coefficient(k, column);
+                });
+                product.Coefficient(row, column) = sum;
+            });
         }
 
-        template<size_t secondColumns>
-        Matrix<rows, secondColumns, T> operator*(const Matrix<columns, secondColumns, T> & matrix) const
+        template<size_t rows, size_t columns, size_t secondColumns, typename T>
+        inline void MultiplyMatrices(const Matrix<rows, columns, T>& left, const Matrix<columns, secondColumns, T>& right, Matrix<rows, secondColumns, T>& product, const size_t&, std::integral_constant<int, 1>)
         {
-            Matrix<rows, secondColumns, T> newMatrix{};
+            // Row by row so the inner loop walks both matrices in memory order.
             for (size_t i{ 0 }; i < rows; ++i)
             {
-                for (size_t j{ 0 }; j < secondColumns; ++j)
+                for (size_t k{ 0 }; k < columns; ++k)
                 {
-                    for (size_t k{ 0 }; k < columns; ++k)
+                    const T value{ left.Coefficient(i, k) };
+                    for (size_t j{ 0 }; j < secondColumns; ++j)
                     {
-                        newMatrix[i][j] += elements[i][k] * matrix[k][j];
+                        product.Coefficient(i, j) += value * right.Coefficient(k, j);
                     }
                 }
             }
-            return newMatrix;
         }
-        #pragma endregion
-    };
+
+        template<size_t rows, size_t columns, size_t secondColumns, typename T>
+        inline void MultiplyMatrices(const Matrix<rows, columns, T>& left, const Matrix<columns, secondColumns, T>& right, Matrix<rows, secondColumns, T>& product, const size_t& threadCount, std::integral_constant<int, 2>)
+        {
+            Gemm(left.Data(), right.Data(), product.Data(), rows, columns, secondColumns, threadCount);
+        }
+    }
+
+    // Matrix product, computed right away since every element depends on a whole row and column.
+    template<typename Left, typename Right, size_t rows, size_t columns, size_t secondColumns, typename T>
+    Matrix<rows, secondColumns, T> operator*(const MatrixExpression<Left, rows, columns, T>& left, const MatrixExpression<Right, columns, secondColumns, T>& right)
+    {
+        const auto& leftMatrix = detail::Evaluate(left.Self());
+        const auto& rightMatrix = detail::Evaluate(right.Self());
+        Matrix<rows, secondColumns, T> product{};
+        detail::MultiplyMatrices(leftMatrix, rightMatrix, product, 1, detail::MultiplyMethod<rows, columns, secondColumns>{});
+        return product;
+    }
+
+    // Matrix product where large products are split over threadCount threads, 0 uses every hardware thread.
+    template<typename Left, typename Right, size_t rows, size_t columns, size_t secondColumns, typename T>
+    Matrix<rows, secondColumns, T> Multiply(const MatrixExpression<Left, rows, columns, T>& left, const MatrixExpression<Right, columns, secondColumns, T>& right, const size_t& threadCount)
+    {
+        const auto& leftMatrix = detail::Evaluate(left.Self());
+        const auto& rightMatrix = detail::Evaluate(right.Self());
+        Matrix<rows, secondColumns, T> product{};
+        detail::MultiplyMatrices(leftMatrix, rightMatrix, product, threadCount, detail::MultiplyMethod<rows, columns, secondColumns>{});
+        return product;
+    }
 
     #pragma region Aliases
     template<size_t size, typename T = MatrixDefaultType>
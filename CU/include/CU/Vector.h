@@ -1,27 +1,102 @@
 #ifndef CU_VECTOR_H
 #define CU_VECTOR_H
 
+#include <cmath>
 #include "Array.h"
+#include "Expression.h"
 #include "Matrix.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CU_VECTOR_SSE
+#endif
+
 namespace cu
 {
+	namespace detail
+	{
+		template<size_t size, typename T, typename Left, typename Right>
+		inline T DotProduct(const Left& left, const Right& right, std::true_type)
+		{
+			T sum{};
+			ForEachIndex<size>([&left, &right, &sum](const size_t& index)
+			{
+				sum += left.Coefficient(index) * right.Coefficient(index);
+			});
+			return sum;
+		}
+
+		template<size_t size, typename T, typename Left, typename Right>
+		inline T DotProduct(const Left& left, const Right& right, std::false_type)
+		{
+			// Four independent sums so long vectors are added four lanes at a time.
+			T sums[4]{};
+			constexpr size_t blocked{ size / 4 * 4 };
+			for (size_t i{ 0 }; i < blocked; i += 4)
+			{
+				sums[0] += left.Coefficient(i) * right.Coefficient(i);
+				sums[1] += left.Coefficient(i + 1) * right.Coefficient(i + 1);
+				sums[2] += left.Coefficient(i + 2) * right.Coefficient(i + 2);
+				sums[3] += left.Coefficient(i + 3) * right.Coefficient(i + 3);
+			}
+			for (size_t i{ blocked }; i < size; ++i)
+			{
+				sums[0] += left.Coefficient(i) * right.Coefficient(i);
+			}
+			return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+		}
+
+		// Sum of left[i] * right[i], unrolled for small sizes.
+		template<size_t size, typename T, typename Left, typename Right>
+		inline T DotProduct(const Left& left, const Right& right)
+		{
+			return DotProduct<size, T>(left, right, std::integral_constant<bool, (size <= maxUnrolledCount)>{});
+		}
+
+		template<typename T>
+		inline T InverseSqrt(const T& value)
+		{
+			return T{ 1 } / std::sqrt(value);
+		}
+
+		#ifdef CU_VECTOR_SSE
+		// Hardware estimate refined by one Newton-Raphson step, about 22 bits exact instead of 12.
+		inline __m128 InverseSqrt(const __m128& value)
+		{
+			const __m128 estimate{ _mm_rsqrt_ps(value) };
+			const __m128 correction{ _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), value), _mm_mul_ps(estimate, estimate))) };
+			return _mm_mul_ps(estimate, correction);
+		}
+
+		inline float InverseSqrt(const float& value)
+		{
+			return _mm_cvtss_f32(InverseSqrt(_mm_set_ss(value)));
+		}
+		#endif
+	}
+
 	template<typename T, size_t size>
-	class Vector : protected Array<T, size>
+	class Vector : public VectorExpression<Vector<T, size>, size, T>, protected Array<T, size>
 	{
 	public:
 		Vector() :
 			Array<T, size>{}
 		{}
 
-		Vector(const Vector& vector) :
-			Array<T, size>{ vector }
-		{}
+		Vector(const Vector& vector) = default;
 
 		Vector(const std::initializer_list<T>& elements) :
 			Array<T, size>{ elements }
 		{}
 
+		// Computes an expression such as a + b * s into the new vector.
+		template<typename E>
+		Vector(const VectorExpression<E, size, T>& expression) :
+			Array<T, size>{}
+		{
+			*this = expression;
+		}
+
 		~Vector() = default;
 
 		inline T& Element(const size_t& index)
@@ -65,101 +140,168 @@ namespace cu
 		}
 
 		// Calculates the dot product of this vector and another vector.
-		T Dot(const Vector& vector)
+		T Dot(const Vector& vector) const
 		{
-			T dotProduct{};
-			for (size_t i{ 0 }; i < size; ++i)
-			{
-				dotProduct += (*this)[i] * vector[i];
-			}
-			return dotProduct;
+			return detail::DotProduct<size, T>(*this, vector);
 		}
 
-		#pragma region Operators
-		void operator+=(const Vector& vector)
+		// Unchecked element access, used by expressions.
+		inline T& Coefficient(const size_t& index)
 		{
-			for (size_t i{ 0 }; i < size; ++i)
-			{
-				(*this)[i] += vector[i];
-			}
+			return this->Data()[index];
 		}
 
-		inline Vector operator+(const Vector& vector)
+		inline const T& Coefficient(const size_t& index) const
 		{
-			Vector resultVector{ vector };
-			resultVector += *this;
-			return resultVector;
+			return this->Data()[index];
 		}
 
-		void operator-=(const Vector& vector)
+		#pragma region Operators
+		Vector& operator=(const Vector& vector) = default;
+
+		// Computes an expression straight into this vector.
+		template<typename E>
+		Vector& operator=(const VectorExpression<E, size, T>& expression)
 		{
-			for (size_t i{ 0 }; i < size; ++i)
+			const E& source{ expression.Self() };
+			detail::ForEachIndex<size>([this, &source](const size_t& index)
 			{
-				(*this)[i] -= vector[i];
-			}
+				Coefficient(index) = source.Coefficient(index);
+			});
+			return *this;
 		}
 
-		inline Vector operator-(const Vector& vector)
+		template<typename E>
+		void operator+=(const VectorExpression<E, size, T>& expression)
 		{
-			Vector resultVector{ vector };
-			resultVector -= *this;
-			return resultVector;
+			const E& source{ expression.Self() };
+			detail::ForEachIndex<size>([this, &source](const size_t& index)
+			{
+				Coefficient(index) += source.Coefficient(index);
+			});
 		}
 
-		template<typename N>
-		void operator*=(const N& scalar)
+		template<typename E>
+		void operator-=(const VectorExpression<E, size, T>& expression)
 		{
-			for (size_t i{ 0 }; i < size; ++i)
+			const E& source{ expression.Self() };
+			detail::ForEachIndex<size>([this, &source](const size_t& index)
 			{
-				(*this)[i] *= scalar;
-			}
+				Coefficient(index) -= source.Coefficient(index);
+			});
 		}
 
 		template<typename N>
-		inline Vector operator*(const N& scalar)
+		void operator*=(const N& scalar)
 		{
-			Vector resultVector{ *this };
-			resultVector *= scalar;
-			return resultVector;
+			detail::ForEachIndex<size>([this, &scalar](const size_t& index)
+			{
+				Coefficient(index) = detail::Multiply::Apply(Coefficient(index), scalar);
+			});
 		}
 
 		template<typename N>
 		void operator/=(const N& scalar)
 		{
-			for (size_t i{ 0 }; i < size; ++i)
+			detail::ForEachIndex<size>([this, &scalar](const size_t& index)
 			{
-				(*this)[i] /= scalar;
-			}
-		}
-
-		template<typename N>
-		inline Vector operator/(const N& scalar)
-		{
-			Vector resultVector{ *this };
-			resultVector /= scalar;
-			return resultVector;
+				Coefficient(index) = detail::Divide::Apply(Coefficient(index), scalar);
+			});
 		}
 		#pragma endregion
 	};
 
+	// Calculates the squared length of a vector, cheaper than Length when only comparing lengths.
+	template<typename E, size_t size, typename T>
+	inline T LengthSqr(const VectorExpression<E, size, T>& vector)
+	{
+		// The expression is computed once per element.
+		const Vector<T, size> values{ vector };
+		return detail::DotProduct<size, T>(values, values);
+	}
+
+	template<typename T, size_t size>
+	inline T LengthSqr(const Vector<T, size>& vector)
+	{
+		return detail::DotProduct<size, T>(vector, vector);
+	}
+
 	// Calculates the length of a vector.
-	template<typename N = float, typename T, size_t size>
-	N Length(const Vector<T, size>& vector)
+	template<typename N = float, typename E, size_t size, typename T>
+	inline N Length(const VectorExpression<E, size, T>& vector)
+	{
+		return static_cast<N>(std::sqrt(LengthSqr(vector.Self())));
+	}
+
+	template<typename E, size_t size, typename T, typename F>
+	inline T DistanceSqr(const VectorExpression<E, size, T>& vector, const VectorExpression<F, size, T>& otherVector)
+	{
+		return LengthSqr(vector - otherVector);
+	}
+
+	// Calculates the distance between two points.
+	template<typename N = float, typename E, size_t size, typename T, typename F>
+	inline N Distance(const VectorExpression<E, size, T>& vector, const VectorExpression<F, size, T>& otherVector)
 	{
-		N sum{};
-		for (size_t i{ 0 }; i < size; ++i)
+		return static_cast<N>(std::sqrt(DistanceSqr(vector, otherVector)));
+	}
+
+	// Calculates a normalized (length 1) version of a vector, scaling by one inverse square root. A zero vector
+	// stays zero.
+	template<typename E, size_t size, typename T>
+	Vector<T, size> Normalized(const VectorExpression<E, size, T>& vector)
+	{
+		Vector<T, size> normalized{ vector };
+		const T lengthSqr{ LengthSqr(normalized) };
+		if (lengthSqr > T{})
 		{
-			sum += pow(vector.Element(i), 2);
+			normalized *= detail::InverseSqrt(lengthSqr);
 		}
-		return sqrt(sum);
+		return normalized;
 	}
 
-	// Calculates a normalized (length 1) version of a vector.
+	// Normalizes count vectors in place, zero vectors stay zero.
 	template<typename T, size_t size>
-	Vector<T, size> Normalized(const Vector<T, size>& vector)
+	void NormalizeAll(Vector<T, size>* vectors, const size_t& count)
 	{
-		return vector / Length<T>(vector);
+		for (size_t i{ 0 }; i < count; ++i)
+		{
+			const T lengthSqr{ LengthSqr(vectors[i]) };
+			if (lengthSqr > T{})
+			{
+				vectors[i] *= detail::InverseSqrt(lengthSqr);
+			}
+		}
+	}
+
+	#ifdef CU_VECTOR_SSE
+	// Float vectors get their inverse lengths four at a time.
+	template<size_t size>
+	void NormalizeAll(Vector<float, size>* vectors, const size_t& count)
+	{
+		size_t i{ 0 };
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 lengthSqr{ _mm_setr_ps(LengthSqr(vectors[i]), LengthSqr(vectors[i + 1]), LengthSqr(vectors[i + 2]), LengthSqr(vectors[i + 3])) };
+			// Zero lengths get a factor of zero instead of infinity.
+			const __m128 factors{ _mm_and_ps(detail::InverseSqrt(lengthSqr), _mm_cmpgt_ps(lengthSqr, _mm_setzero_ps())) };
+			alignas(16) float scales[4];
+			_mm_store_ps(scales, factors);
+			vectors[i] *= scales[0];
+			vectors[i + 1] *= scales[1];
+			vectors[i + 2] *= scales[2];
+			vectors[i + 3] *= scales[3];
+		}
+		for (; i < count; ++i)
+		{
+			const float lengthSqr{ LengthSqr(vectors[i]) };
+			if (lengthSqr > 0.0f)
+			{
+				vectors[i] *= detail::InverseSqrt(lengthSqr);
+			}
+		}
 	}
+	#endif
 }
 
 #endif
\ No newline at end of file